@@ -0,0 +1,76 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/Automation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+// Measures the cost per block of LinearAutomation with a few automated parameters, as the total number of parameters
+// grows. Built once for each number of parameters, see CMakeLists.txt.
+
+using namespace unplug;
+
+int main()
+{
+  constexpr Index numParameters = NumParameters::value;
+  constexpr Index numSamples = 256;
+  constexpr Index numBlocks = 20000;
+  constexpr Index numRuns = 7;
+  constexpr Index numAutomated = std::min<Index>(4, numParameters / 2);
+
+  auto storage = ParameterStorage{};
+  for (Index i = 0; i < numParameters; ++i) {
+    storage.set(static_cast<ParamIndex>(i), 0.5);
+  }
+  auto automation = LinearAutomation<float>{ storage };
+
+  // a few automated parameters spread over the list, and the same number of static ones read at every sample
+  auto automated = std::array<ParamIndex, numAutomated>{};
+  auto notAutomated = std::array<ParamIndex, numAutomated>{};
+  for (Index i = 0; i < numAutomated; ++i) {
+    automated[i] = static_cast<ParamIndex>(i * numParameters / numAutomated);
+    notAutomated[i] = static_cast<ParamIndex>(automated[i] + 1);
+  }
+
+  double output = 0.0;
+  auto bestTime = std::chrono::nanoseconds::max();
+  for (Index run = 0; run < numRuns; ++run) {
+    auto const start = std::chrono::steady_clock::now();
+    for (Index block = 0; block < numBlocks; ++block) {
+      automation.prepare();
+      for (auto paramIndex : automated) {
+        setParameterAutomation(automation, AutomationEvent<float>(paramIndex, 0, 0.f, numSamples, 1.f));
+      }
+      for (Index sample = 0; sample < numSamples; ++sample) {
+        for (Index i = 0; i < numAutomated; ++i) {
+          output += automation.next(automated[i]) * automation.next(notAutomated[i]);
+        }
+      }
+      // like the processing engine, store the last point of each automated parameter at the end of the block
+      for (auto paramIndex : automated) {
+        storage.set(paramIndex, 1.0);
+      }
+    }
+    bestTime = std::min(bestTime, std::chrono::steady_clock::now() - start);
+  }
+  auto const nanosecondsPerBlock = static_cast<double>(bestTime.count()) / numBlocks;
+  std::printf("%5d parameters, %d automated: %8.1f ns per block of %d samples (%g)\n",
+              static_cast<int>(numParameters),
+              static_cast<int>(numAutomated),
+              nanosecondsPerBlock,
+              static_cast<int>(numSamples),
+              output);
+  return 0;
+}
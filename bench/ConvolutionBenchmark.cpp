@@ -0,0 +1,116 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/Convolution.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Measures Convolution with impulse responses from 1 to 10 seconds, at 48 kHz in stereo. The audio is processed in
+// real time, one host block at a time, so that the worker runs against the same deadlines as in a plugin. For each
+// impulse response it prints the time spent on the audio thread, on average and in the slowest block, the time spent
+// by the worker, both as a fraction of the duration of the audio, and the number of missed deadlines.
+
+using namespace unplug;
+
+namespace {
+
+constexpr double sampleRate = 48000.0;
+constexpr Index numChannels = 2;
+constexpr Index hostBlockSize = 128;
+constexpr Index headBlockSize = 128;
+constexpr Index tailBlockSize = 4096;
+constexpr double secondsPerRun = 5.0;
+
+// exponentially decaying noise, like a reverb
+std::vector<float> makeImpulseResponse(double seconds, unsigned seed)
+{
+  auto generator = std::mt19937{ seed };
+  auto distribution = std::uniform_real_distribution<float>{ -1.f, 1.f };
+  auto impulseResponse = std::vector<float>(static_cast<std::size_t>(seconds * sampleRate));
+  auto const decay = std::log(0.001) / static_cast<double>(impulseResponse.size());
+  for (std::size_t i = 0; i < impulseResponse.size(); ++i) {
+    impulseResponse[i] = 0.01f * distribution(generator) * static_cast<float>(std::exp(decay * static_cast<double>(i)));
+  }
+  return impulseResponse;
+}
+
+} // namespace
+
+int main()
+{
+  using Clock = std::chrono::steady_clock;
+  auto const blockDuration = std::chrono::duration<double>(static_cast<double>(hostBlockSize) / sampleRate);
+  auto const numBlocks = static_cast<Index>(secondsPerRun * sampleRate) / hostBlockSize;
+  auto const audioNanoseconds = static_cast<double>(numBlocks * hostBlockSize) / sampleRate * 1e9;
+
+  auto buffers = std::vector<std::vector<float>>(numChannels, std::vector<float>(hostBlockSize));
+  auto channels = std::vector<float*>{};
+  for (auto& buffer : buffers) {
+    channels.push_back(buffer.data());
+  }
+  auto generator = std::mt19937{ 1 };
+  auto distribution = std::uniform_real_distribution<float>{ -1.f, 1.f };
+  float checksum = 0.f;
+
+  std::printf("%d Hz, %d channels, host blocks of %d samples, head blocks of %d, tail blocks of %d\n",
+              static_cast<int>(sampleRate),
+              static_cast<int>(numChannels),
+              static_cast<int>(hostBlockSize),
+              static_cast<int>(headBlockSize),
+              static_cast<int>(tailBlockSize));
+  for (double seconds : { 1.0, 2.0, 5.0, 10.0 }) {
+    auto convolution = Convolution{};
+    auto const impulseResponse = std::vector<std::vector<float>>{ makeImpulseResponse(seconds, 1),
+                                                                  makeImpulseResponse(seconds, 2) };
+    auto const prepareStart = Clock::now();
+    convolution.setImpulseResponse(impulseResponse, numChannels, headBlockSize, tailBlockSize);
+    auto const prepareTime = std::chrono::duration<double, std::milli>(Clock::now() - prepareStart);
+
+    auto audioThreadTime = Clock::duration::zero();
+    auto maxBlockTime = Clock::duration::zero();
+    auto const start = Clock::now();
+    for (Index block = 0; block < numBlocks; ++block) {
+      for (auto& buffer : buffers) {
+        std::generate(buffer.begin(), buffer.end(), [&] { return distribution(generator); });
+      }
+      auto const blockStart = Clock::now();
+      convolution.process(channels.data(), channels.data(), numChannels, hostBlockSize);
+      auto const blockTime = Clock::now() - blockStart;
+      audioThreadTime += blockTime;
+      maxBlockTime = std::max(maxBlockTime, blockTime);
+      checksum += buffers[0][0];
+      std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(blockDuration * (block + 1)));
+    }
+    auto const audioThreadNanoseconds = static_cast<double>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(audioThreadTime).count());
+    auto const maxBlockNanoseconds =
+      static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(maxBlockTime).count());
+    auto const blockNanoseconds = std::chrono::duration<double, std::nano>(blockDuration).count();
+    std::printf("%4.1f s impulse response: audio thread %5.2f%% (slowest block %6.2f%%), worker %5.2f%%, %llu missed "
+                "deadlines, prepared in %.1f ms\n",
+                seconds,
+                100.0 * audioThreadNanoseconds / audioNanoseconds,
+                100.0 * maxBlockNanoseconds / blockNanoseconds,
+                100.0 * static_cast<double>(convolution.getWorkerNanoseconds()) / audioNanoseconds,
+                static_cast<unsigned long long>(convolution.getNumMissedDeadlines()),
+                prepareTime.count());
+  }
+  std::printf("(%g)\n", checksum);
+  return 0;
+}
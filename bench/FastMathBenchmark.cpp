@@ -0,0 +1,95 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/FastMath.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Measures the array versions of the FastMath functions against loops calling the standard functions on the same
+// buffers. The accuracy of the approximations is checked by tests/core/FastMath.cpp.
+
+using namespace unplug;
+
+namespace {
+
+constexpr Index numSamples = 256;
+constexpr Index numBlocks = 20000;
+constexpr Index numRuns = 7;
+
+// read after each block, so that the compiler can not drop the computation
+float checksum = 0.f;
+
+template<class Function>
+double measure(std::vector<float> const& input, std::vector<float>& output, Function function)
+{
+  auto bestTime = std::chrono::nanoseconds::max();
+  for (Index run = 0; run < numRuns; ++run) {
+    auto const start = std::chrono::steady_clock::now();
+    for (Index block = 0; block < numBlocks; ++block) {
+      function(input.data(), output.data(), numSamples);
+      checksum += output[block % numSamples];
+    }
+    bestTime = std::min(bestTime, std::chrono::steady_clock::now() - start);
+  }
+  return static_cast<double>(bestTime.count()) / static_cast<double>(numBlocks * numSamples);
+}
+
+template<class Fast, class Standard>
+void compare(const char* name, float min, float max, Fast fast, Standard standard)
+{
+  auto input = std::vector<float>(numSamples);
+  for (Index i = 0; i < numSamples; ++i) {
+    input[i] = min + (max - min) * static_cast<float>(i) / static_cast<float>(numSamples - 1);
+  }
+  auto output = std::vector<float>(numSamples);
+  auto const fastTime = measure(input, output, fast);
+  auto const standardTime = measure(input, output, [&](float const* in, float* out, Index size) {
+    for (Index i = 0; i < size; ++i) {
+      out[i] = standard(in[i]);
+    }
+  });
+  std::printf("%-12s %6.2f ns per sample, standard %6.2f ns per sample, %5.1fx\n",
+              name,
+              fastTime,
+              standardTime,
+              standardTime / fastTime);
+}
+
+} // namespace
+
+int main()
+{
+  compare("log2", 1e-3f, 1e3f, [](auto... args) { FastMath::log2(args...); }, [](float x) { return std::log2(x); });
+  compare("exp2", -20.f, 20.f, [](auto... args) { FastMath::exp2(args...); }, [](float x) { return std::exp2(x); });
+  compare("log", 1e-3f, 1e3f, [](auto... args) { FastMath::log(args...); }, [](float x) { return std::log(x); });
+  compare("exp", -20.f, 20.f, [](auto... args) { FastMath::exp(args...); }, [](float x) { return std::exp(x); });
+  compare(
+    "linearToDB",
+    -2.f,
+    2.f,
+    [](auto... args) { FastMath::linearToDB(args...); },
+    [](float x) { return 20.f * std::log10(std::abs(x) + 1.1920929e-7f); });
+  compare(
+    "dBToLinear",
+    -120.f,
+    24.f,
+    [](auto... args) { FastMath::dBToLinear(args...); },
+    [](float x) { return std::pow(10.f, x / 20.f); });
+  compare("tanh", -5.f, 5.f, [](auto... args) { FastMath::tanh(args...); }, [](float x) { return std::tanh(x); });
+  std::printf("(%g)\n", checksum);
+  return 0;
+}
@@ -0,0 +1,112 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/RingBuffer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// Measures the two layouts of RingBuffer with 2, 8 and 16 channels: writing one second of audio with sendToRingBuffer,
+// and reading every channel of the read block once per frame for one second, as PlotRingBuffer does.
+
+using namespace unplug;
+
+namespace {
+
+constexpr Index blockSize = 512;
+constexpr float sampleRate = 48000.f;
+constexpr Index numBlocks = static_cast<Index>(sampleRate) / blockSize;
+constexpr Index numFrames = 60;
+constexpr Index numRuns = 7;
+
+RingBufferSettings makeSettings(Index numChannels, float pointsPerSecond)
+{
+  auto settings = RingBufferSettings{};
+  settings.context.sampleRate = sampleRate;
+  settings.context.maxAudioBlockSize = blockSize;
+  settings.context.numIO.numOuts = numChannels;
+  settings.context.userInterfaceRefreshRate = static_cast<float>(numFrames);
+  settings.pointsPerSecond = pointsPerSecond;
+  settings.durationInSeconds = 4.f;
+  settings.readerTimeoutInSeconds = 1e9f;
+  return settings;
+}
+
+template<class Process>
+double measure(Process process)
+{
+  auto bestTime = std::chrono::nanoseconds::max();
+  for (Index run = 0; run < numRuns; ++run) {
+    auto const start = std::chrono::steady_clock::now();
+    process();
+    bestTime = std::min(bestTime, std::chrono::steady_clock::now() - start);
+  }
+  return static_cast<double>(bestTime.count()) * 1e-6;
+}
+
+template<RingBufferLayout layout>
+void run(char const* layoutName, Index numChannels, float pointsPerSecond, double& checksum)
+{
+  auto ringBuffer = RingBuffer<float, std::allocator<float>, layout>{ makeSettings(numChannels, pointsPerSecond) };
+  ringBuffer.markAsRead();
+  auto channels = std::vector<std::vector<float>>(numChannels, std::vector<float>(blockSize, 0.25f));
+  auto pointers = std::vector<float*>(numChannels);
+  for (Index channel = 0; channel < numChannels; ++channel) {
+    pointers[channel] = channels[channel].data();
+  }
+
+  auto const writeTime = measure([&] {
+    for (Index block = 0; block < numBlocks; ++block) {
+      sendToRingBuffer(ringBuffer, pointers.data(), numChannels, 0, blockSize);
+    }
+  });
+
+  auto const readTime = measure([&] {
+    auto const& buffer = ringBuffer.getBuffer();
+    auto const pointStride = ringBuffer.getPointStride();
+    for (Index frame = 0; frame < numFrames; ++frame) {
+      for (Index channel = 0; channel < numChannels; ++channel) {
+        auto const channelOffset = ringBuffer.getChannelOffset(channel);
+        float sum = 0.f;
+        for (Index point = 0; point < ringBuffer.getReadBlockSize(); ++point) {
+          sum += buffer[channelOffset + point * pointStride];
+        }
+        checksum += sum;
+      }
+    }
+  });
+
+  std::printf("%-11s %2d channels, %5.0f points per second: write %6.2f ms, read %6.2f ms\n",
+              layoutName,
+              static_cast<int>(numChannels),
+              pointsPerSecond,
+              writeTime,
+              readTime);
+}
+
+} // namespace
+
+int main()
+{
+  double checksum = 0.0;
+  for (float pointsPerSecond : { 128.f, 12000.f }) {
+    for (Index numChannels : { 2, 8, 16 }) {
+      run<RingBufferLayout::interleaved>("interleaved", numChannels, pointsPerSecond, checksum);
+      run<RingBufferLayout::planar>("planar", numChannels, pointsPerSecond, checksum);
+    }
+  }
+  std::printf("(%g)\n", checksum);
+  return 0;
+}
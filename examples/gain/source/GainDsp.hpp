@@ -15,11 +15,14 @@
 #include "Meters.hpp"
 #include "Parameters.hpp"
 #include "SharedData.hpp"
+#include "unplug/Arena.hpp"
 #include "unplug/Automation.hpp"
+#include "unplug/FastMath.hpp"
 #include "unplug/IO.hpp"
 #include "unplug/Math.hpp"
 #include "unplug/PluginState.hpp"
 #include <numeric>
+#include <type_traits>
 
 namespace GainDsp {
 
@@ -33,7 +36,8 @@ using Automation = unplug::LinearAutomation<SampleType>;
 
 struct MeteringCache final
 {
-  std::vector<float> levels;
+  using Levels = std::vector<float, unplug::ArenaAllocator<float>>;
+  Levels levels;
   float levelSmoothingAlpha = 0.0;
   float invNumChannels = 1.f;
 
@@ -43,9 +47,9 @@ struct MeteringCache final
     levelSmoothingAlpha = 1.f - static_cast<float>(std::exp(-2 * M_PI / (sampleRate * levelSmoothingTime)));
   }
 
-  void setNumChannels(Index outputChannels)
+  void setNumChannels(Index outputChannels, unplug::Arena& arena)
   {
-    levels.resize(outputChannels, 0.f);
+    levels = Levels(outputChannels, 0.f, unplug::ArenaAllocator<float>{ arena });
     invNumChannels = 1.f / static_cast<float>(outputChannels);
   }
 
@@ -59,9 +63,13 @@ struct State final
 {
   unplug::PluginState& pluginState;
   MeteringCache metering;
+  Automation<float> automationFloat;
+  Automation<double> automationDouble;
 
   explicit State(unplug::PluginState& pluginState)
     : pluginState{ pluginState }
+    , automationFloat{ pluginState.parameters }
+    , automationDouble{ pluginState.parameters }
   {}
 };
 
@@ -70,38 +78,53 @@ void levelMetering(State& state, IO<SampleType> io, Index numSamples)
 {
   auto outputs = io.getOut(0).buffers;
   auto numOutputChannels = io.getOut(0).numChannels;
-  bool const wantsLevelMetering = state.pluginState.meters && state.pluginState.isUserInterfaceOpen;
-  if (wantsLevelMetering) {
-    assert(state.metering.levels.size() == numOutputChannels);
-    state.metering.levels.resize(numOutputChannels);
-    auto& sharedData = *state.pluginState.sharedData;
-    unplug::sendToRingBuffer(
-      sharedData.levelRingBuffer,
-      outputs,
-      numOutputChannels,
-      0,
-      numSamples,
-      [&](auto sampleValue, Index channel) {
-        auto memory = state.metering.levels[channel];
-        memory += state.metering.levelSmoothingAlpha * static_cast<float>(std::abs(sampleValue) - memory);
-        state.metering.levels[channel] = memory;
-        return memory;
-      },
-      [](auto x, float weight) { return static_cast<float>(x) * weight; },
-      [&](auto accumulatedValue, auto elementValue) { return accumulatedValue + elementValue; },
-      [](auto weightedValue) { return std::max(-90.f, unplug::linearToDB(weightedValue)); });
-
-    unplug::sendToWaveformRingBuffer(sharedData.waveformRingBuffer, outputs, numOutputChannels, 0, numSamples);
+  assert(state.metering.levels.size() == numOutputChannels);
+  state.metering.levels.resize(numOutputChannels);
+  auto& sharedData = *state.pluginState.sharedData;
+  auto const smoothLevel = [&](auto sampleValue, Index channel) {
+    auto memory = state.metering.levels[channel];
+    memory += state.metering.levelSmoothingAlpha * static_cast<float>(std::abs(sampleValue) - memory);
+    state.metering.levels[channel] = memory;
+    return memory;
+  };
+  // the ring buffers skip the work by themselves when their plots have not been shown for a while
+  bool const isLevelSent = unplug::sendToRingBuffer(
+    sharedData.levelRingBuffer,
+    outputs,
+    numOutputChannels,
+    0,
+    numSamples,
+    smoothLevel,
+    [](auto x, float weight) { return static_cast<float>(x) * weight; },
+    [&](auto accumulatedValue, auto elementValue) { return accumulatedValue + elementValue; },
+    [](auto weightedValue) { return std::max(-90.f, unplug::FastMath::linearToDB(weightedValue)); });
+  // the level meter is not a ring buffer, so it still needs the levels while the user interface is open
+  if (!isLevelSent && state.pluginState.isUserInterfaceOpen) {
+    for (Index channel = 0; channel < numOutputChannels; ++channel) {
+      for (Index sample = 0; sample < numSamples; ++sample) {
+        smoothLevel(outputs[channel][sample], channel);
+      }
+    }
   }
+  unplug::sendToWaveformRingBuffer(sharedData.waveformRingBuffer, outputs, numOutputChannels, 0, numSamples);
   auto const level =
     std::reduce(state.metering.levels.begin(), state.metering.levels.end()) * state.metering.invNumChannels;
   state.pluginState.meters->set(Meter::level, level);
 }
 
 template<class SampleType>
-unplug::LinearAutomation<SampleType> prepareAutomation(State& state)
+Automation<SampleType>& prepareAutomation(State& state)
 {
-  return unplug::LinearAutomation<SampleType>(state.pluginState.parameters);
+  auto& automation = [&]() -> Automation<SampleType>& {
+    if constexpr (std::is_same_v<SampleType, float>) {
+      return state.automationFloat;
+    }
+    else {
+      return state.automationDouble;
+    }
+  }();
+  automation.prepare();
+  return automation;
 }
 
 template<class SampleType>
@@ -139,7 +162,7 @@ void automatedProcessing(State& state,
                          Index startSample,
                          Index endSample)
 {
-  bool const bypass = automation.parameters[Param::bypass].currentValue > 0.0;
+  bool const bypass = automation.get(Param::bypass) > 0.0;
   auto in = io.getIn(0);
   auto out = io.getOut(0);
   auto const numInputChannels = in.numChannels;
@@ -204,7 +227,7 @@ void automatedProcessingOversampled(State& state,
                                     Index startSample,
                                     Index endSample)
 {
-  bool const bypass = automation.parameters[Param::bypass].currentValue > 0.0;
+  bool const bypass = automation.get(Param::bypass) > 0.0;
   if (bypass)
     return;
   auto& oversampling = state.pluginState.sharedData->oversampling;
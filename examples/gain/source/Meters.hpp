@@ -17,6 +17,7 @@ namespace Meter {
 enum
 {
   level,
+  effectiveOversamplingOrder,
   numMeters
 };
 }
@@ -28,6 +28,7 @@ std::vector<ParameterDescription> getParameterDescriptions()
       .EditPolicy(ParamEditPolicy::notAutomatableAndMayChangeLatencyOnEdit));
   parameters.push_back(ParameterDescription(Param::oversamplingLinearPhase, "Linear Phase", 0, 1, 0, 1)
                          .EditPolicy(ParamEditPolicy::notAutomatableAndMayChangeLatencyOnEdit));
+  parameters.push_back(ParameterDescription(Param::adaptiveQuality, "Adaptive Quality", 0, 1, 0, 1));
   return parameters;
 }
 
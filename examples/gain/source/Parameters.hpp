@@ -20,6 +20,7 @@ enum
   gain,
   oversamplingOrder,
   oversamplingLinearPhase,
+  adaptiveQuality,
   numParams
 };
 }
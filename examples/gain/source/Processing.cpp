@@ -17,6 +17,7 @@ namespace Steinberg::Vst {
 
 tresult PLUGIN_API Processor::process(ProcessData& data)
 {
+  auto const dspLoadMeasurement = measureDspLoad(data);
   if (data.symbolicSampleSize == kSample64) {
     TProcess<double>(data);
   }
@@ -31,9 +32,18 @@ void Processor::TProcess(ProcessData& data)
 {
   updateNotAutomatableParameters(data);
   constexpr bool wantsSamplePreciseAutomation = true;
-  auto const oversamplingOrder =
-    static_cast<uint32_t>(std::round(pluginState.parameters.get(Param::oversamplingOrder)));
+  auto const requestedOversamplingOrder =
+    static_cast<int>(std::round(pluginState.parameters.get(Param::oversamplingOrder)));
   auto const oversamplingLinearPhase = pluginState.parameters.get(Param::oversamplingLinearPhase) > 0.5;
+  // with linear phase the latency depends on the order, so it can not be changed from the audio thread. Offline there
+  // is no deadline to meet, so the requested quality is always used.
+  bool const isQualityGoverned = pluginState.parameters.get(Param::adaptiveQuality) > 0.5 && !oversamplingLinearPhase &&
+                                 !getContextInfo().isOffline();
+  // the load measured up to the previous block, as the measurement of this one ends with the call to process
+  qualityGovernor.update(getDspLoad().getLoad(), data.numSamples, isQualityGoverned ? requestedOversamplingOrder : 0);
+  auto const oversamplingOrder = static_cast<uint32_t>(
+    isQualityGoverned ? qualityGovernor.getEffectiveQuality(requestedOversamplingOrder) : requestedOversamplingOrder);
+  pluginState.meters->set(Meter::effectiveOversamplingOrder, static_cast<float>(oversamplingOrder));
   bool const hasLatency = oversamplingLinearPhase && oversamplingOrder > 0;
   bool const useSamplePreciseAutomation = !hasLatency && wantsSamplePreciseAutomation;
 
@@ -56,7 +66,7 @@ void Processor::TProcess(ProcessData& data)
       processWithSamplePreciseAutomation<SampleType>(
         data,
         [this](IO<SampleType> io, Index numSamples) { GainDsp::staticProcessingOversampled(dspState, io, numSamples); },
-        [this]() { return GainDsp::prepareAutomation<SampleType>(dspState); },
+        [this]() -> auto& { return GainDsp::prepareAutomation<SampleType>(dspState); },
         [&](auto& automation, IO<SampleType> io, Index startSample, Index endSample) {
           GainDsp::automatedProcessingOversampled(dspState, automation, io, startSample, endSample);
         },
@@ -81,7 +91,7 @@ void Processor::TProcess(ProcessData& data)
       processWithSamplePreciseAutomation<SampleType>(
         data,
         [this](IO<SampleType> io, Index numSamples) { GainDsp::staticProcessing(dspState, io, numSamples); },
-        [this]() { return GainDsp::prepareAutomation<SampleType>(dspState); },
+        [this]() -> auto& { return GainDsp::prepareAutomation<SampleType>(dspState); },
         [this](auto& automation, IO<SampleType> io, Index startSample, Index endSample) {
           GainDsp::automatedProcessing(dspState, automation, io, startSample, endSample);
         },
@@ -94,6 +104,9 @@ void Processor::TProcess(ProcessData& data)
   }
   auto io = IO<SampleType>(ioCache);
   GainDsp::levelMetering(dspState, io, data.numSamples);
+  // the smoothed levels decay towards zero outside of the processing helpers, which flush the denormals
+  auto const& levels = dspState.metering.levels;
+  getDenormalCounter().count(levels.data(), static_cast<Index>(levels.size()));
 }
 
 } // namespace Steinberg::Vst
\ No newline at end of file
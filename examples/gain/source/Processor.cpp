@@ -20,12 +20,14 @@ Processor::Processor()
   : dspState{ pluginState }
 {
   setControllerClass(kControllerUID);
+  enableDspLoadMeasurement(true);
 }
 
 bool Processor::onSetup(ContextInfo const& context)
 {
-  dspState.metering.setNumChannels(context.numIO.numOuts);
+  dspState.metering.setNumChannels(context.numIO.numOuts, sharedDataWrapped->get().arena);
   dspState.metering.setSampleRate(context.sampleRate);
+  qualityGovernor.setSampleRate(context.sampleRate);
   return true;
 }
 
@@ -33,6 +35,7 @@ tresult PLUGIN_API Processor::setProcessing(TBool state)
 {
   dspState.metering.reset();
   sharedDataWrapped->get().oversampling.reset();
+  qualityGovernor.reset();
   return kResultOk;
 }
 
@@ -14,6 +14,7 @@
 #pragma once
 
 #include "GainDsp.hpp"
+#include "unplug/QualityGovernor.hpp"
 #include "unplug/UnplugProcessor.hpp"
 
 namespace Steinberg::Vst {
@@ -42,5 +43,6 @@ private:
   void updateLatency(unplug::ParamIndex paramIndex, ParamValue value) override;
 
   GainDsp::State dspState;
+  unplug::QualityGovernor qualityGovernor;
 };
 } // namespace Steinberg::Vst
\ No newline at end of file
@@ -13,6 +13,7 @@
 
 #pragma once
 #include "oversimple/Oversampling.hpp"
+#include "unplug/Arena.hpp"
 #include "unplug/ContextInfo.hpp"
 #include "unplug/IO.hpp"
 #include "unplug/NumIO.hpp"
@@ -22,12 +23,16 @@
 
 struct SharedData final
 {
+  // the arena must be declared before the members that allocate from it, so that it is destroyed after them
+  unplug::Arena arena{ unplug::Arena::defaultChunkSize, true };
   oversimple::Oversampling oversampling;
-  unplug::RingBuffer<float> levelRingBuffer;
-  unplug::WaveformRingBuffer<float> waveformRingBuffer;
+  unplug::RingBuffer<float, unplug::ArenaAllocator<float>> levelRingBuffer;
+  unplug::WaveformRingBuffer<float, unplug::ArenaAllocator<unplug::WaveformElement<float>>> waveformRingBuffer;
 
   SharedData()
     : oversampling{ oversamplingSettings() }
+    , levelRingBuffer{ {}, unplug::ArenaAllocator<float>{ arena } }
+    , waveformRingBuffer{ {}, unplug::ArenaAllocator<unplug::WaveformElement<float>>{ arena } }
   {}
 
   void setup(unplug::ContextInfo const& context)
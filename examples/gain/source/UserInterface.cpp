@@ -37,6 +37,11 @@ void paint()
   LevelMeter(Meter::level, "LevelMeter", { widgetWidth, levelMeterHeight });
   Combo(Param::oversamplingOrder);
   Checkbox(Param::oversamplingLinearPhase);
+  Checkbox(Param::adaptiveQuality);
+  DspLoadMeter("DSP Load", { widgetWidth, levelMeterHeight });
+  MeterValueLabelCentered(Meter::effectiveOversamplingOrder, "Effective OverSampling: ", [](float order) {
+    return std::to_string(1 << static_cast<int>(order)) + "x";
+  });
   ImGui::EndGroup();
 
   ImGui::SameLine();
@@ -45,6 +50,11 @@ void paint()
   ImGui::TableNextColumn();
   PlotRingBuffer("Level", sharedData.levelRingBuffer);
   PlotWaveformRingBuffer("Waveform", sharedData.waveformRingBuffer);
+  auto const arenaFootprint = sharedData.arena.getFootprint();
+  ImGui::Text("Audio Memory: %.1f KiB used, %.1f KiB reserved, %.1f KiB locked",
+              static_cast<double>(arenaFootprint.usedBytes) / 1024.0,
+              static_cast<double>(arenaFootprint.reservedBytes) / 1024.0,
+              static_cast<double>(arenaFootprint.lockedBytes) / 1024.0);
   ImGui::EndGroup();
 }
 
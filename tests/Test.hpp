@@ -0,0 +1,66 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include <cstdio>
+#include <vector>
+
+namespace unplug::test {
+
+/**
+ * A minimal test registry: the tests register themselves with UNPLUG_TEST, and TestMain.cpp runs the tests of the
+ * source files whose name contains its first argument, or all of them if there is no argument.
+ * */
+struct TestCase final
+{
+  char const* name;
+  char const* file;
+  void (*function)();
+};
+
+inline std::vector<TestCase>& getTestCases()
+{
+  static auto testCases = std::vector<TestCase>();
+  return testCases;
+}
+
+inline int& getNumFailures()
+{
+  static int numFailures = 0;
+  return numFailures;
+}
+
+struct RegisterTest final
+{
+  RegisterTest(char const* name, char const* file, void (*function)())
+  {
+    getTestCases().push_back({ name, file, function });
+  }
+};
+
+inline void reportFailure(char const* expression, char const* file, int line)
+{
+  std::printf("%s:%d: check failed: %s\n", file, line, expression);
+  ++getNumFailures();
+}
+
+} // namespace unplug::test
+
+#define UNPLUG_TEST(name)                                                                                              \
+  static void name();                                                                                                  \
+  static ::unplug::test::RegisterTest name##Registration{ #name, __FILE__, name };                                     \
+  static void name()
+
+#define UNPLUG_CHECK(condition)                                                                                        \
+  ((condition) ? (void)0 : ::unplug::test::reportFailure(#condition, __FILE__, __LINE__))
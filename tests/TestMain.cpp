@@ -0,0 +1,37 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Test.hpp"
+#include <cstring>
+
+int main(int argc, char** argv)
+{
+  using namespace unplug::test;
+  char const* filter = argc > 1 ? argv[1] : "";
+  int numTests = 0;
+  for (auto const& testCase : getTestCases()) {
+    if (std::strstr(testCase.file, filter) == nullptr) {
+      continue;
+    }
+    int const numFailuresBefore = getNumFailures();
+    testCase.function();
+    std::printf("%s %s\n", getNumFailures() == numFailuresBefore ? "passed" : "FAILED", testCase.name);
+    ++numTests;
+  }
+  if (numTests == 0) {
+    std::printf("no test matches %s\n", filter);
+    return 1;
+  }
+  return getNumFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Test.hpp"
+#include "unplug/Arena.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+using namespace unplug;
+
+// a multiple of any page size, so that each chunk has exactly this size
+constexpr std::size_t chunkSize = 1 << 16;
+
+bool isAligned(void* pointer, std::size_t alignment)
+{
+  return reinterpret_cast<std::uintptr_t>(pointer) % alignment == 0;
+}
+
+} // namespace
+
+UNPLUG_TEST(allocationsAreAligned)
+{
+  auto arena = Arena{ chunkSize };
+  struct Allocation
+  {
+    void* pointer;
+    std::size_t bytes;
+    std::size_t alignment;
+  };
+  auto allocations = std::vector<Allocation>{};
+  std::size_t totalBytes = 0;
+  for (std::size_t alignment = 1; alignment <= 4096; alignment *= 2) {
+    // an odd size, so that the next allocation starts misaligned
+    auto const bytes = alignment + 3;
+    auto const pointer = arena.allocate(bytes, alignment);
+    UNPLUG_CHECK(pointer != nullptr);
+    UNPLUG_CHECK(isAligned(pointer, alignment));
+    allocations.push_back({ pointer, bytes, alignment });
+    totalBytes += bytes;
+  }
+  UNPLUG_CHECK(arena.getFootprint().usedBytes == totalBytes);
+  for (auto const& allocation : allocations) {
+    arena.deallocate(allocation.pointer, allocation.bytes, allocation.alignment);
+  }
+  auto const footprint = arena.getFootprint();
+  UNPLUG_CHECK(footprint.usedBytes == 0);
+  UNPLUG_CHECK(footprint.peakUsedBytes == totalBytes);
+  UNPLUG_CHECK(footprint.heapFallbackBytes == 0);
+}
+
+UNPLUG_TEST(freedNeighboursAreCoalescedInAnyOrder)
+{
+  constexpr std::size_t numRanges = 4;
+  constexpr std::size_t rangeSize = chunkSize / numRanges;
+  auto order = std::array<std::size_t, numRanges>{ 0, 1, 2, 3 };
+  do {
+    auto arena = Arena{ chunkSize };
+    auto ranges = std::array<void*, numRanges>{};
+    for (auto& range : ranges) {
+      range = arena.allocate(rangeSize, 1);
+    }
+    UNPLUG_CHECK(arena.getFootprint().numChunks == 1);
+    for (std::size_t i = 1; i < numRanges; ++i) {
+      UNPLUG_CHECK(static_cast<std::byte*>(ranges[i]) == static_cast<std::byte*>(ranges[i - 1]) + rangeSize);
+    }
+    for (auto i : order) {
+      arena.deallocate(ranges[i], rangeSize, 1);
+    }
+    // the whole chunk fits again only if the freed ranges have been merged
+    auto const whole = arena.allocate(chunkSize, 1);
+    UNPLUG_CHECK(whole == ranges[0]);
+    auto const footprint = arena.getFootprint();
+    UNPLUG_CHECK(footprint.numChunks == 1);
+    UNPLUG_CHECK(footprint.reservedBytes == chunkSize);
+    UNPLUG_CHECK(footprint.usedBytes == chunkSize);
+    arena.deallocate(whole, chunkSize, 1);
+    UNPLUG_CHECK(arena.getFootprint().usedBytes == 0);
+  } while (std::next_permutation(order.begin(), order.end()));
+}
+
+UNPLUG_TEST(freedMemoryIsReused)
+{
+  auto arena = Arena{ chunkSize };
+  auto const first = arena.allocate(1000, 16);
+  arena.deallocate(first, 1000, 16);
+  auto const second = arena.allocate(1000, 16);
+  UNPLUG_CHECK(second == first);
+  arena.deallocate(second, 1000, 16);
+  UNPLUG_CHECK(arena.getFootprint().numChunks == 1);
+}
+
+UNPLUG_TEST(reservedMemoryNeedsNoNewChunks)
+{
+  auto arena = Arena{ chunkSize };
+  arena.reserve(4 * chunkSize);
+  auto const reservedBytes = arena.getFootprint().reservedBytes;
+  UNPLUG_CHECK(reservedBytes >= 4 * chunkSize);
+  auto const pointer = arena.allocate(3 * chunkSize, 64);
+  UNPLUG_CHECK(isAligned(pointer, 64));
+  UNPLUG_CHECK(arena.getFootprint().reservedBytes == reservedBytes);
+  arena.deallocate(pointer, 3 * chunkSize, 64);
+}
+
+UNPLUG_TEST(containersGiveTheirMemoryBack)
+{
+  auto arena = Arena{ chunkSize };
+  {
+    auto values = std::vector<double, ArenaAllocator<double>>{ ArenaAllocator<double>{ arena } };
+    for (int i = 0; i < 10000; ++i) {
+      values.push_back(i);
+    }
+    UNPLUG_CHECK(isAligned(values.data(), alignof(double)));
+    UNPLUG_CHECK(arena.getFootprint().usedBytes >= values.size() * sizeof(double));
+  }
+  auto const footprint = arena.getFootprint();
+  UNPLUG_CHECK(footprint.usedBytes == 0);
+  UNPLUG_CHECK(footprint.heapFallbackBytes == 0);
+}
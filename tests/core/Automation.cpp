@@ -0,0 +1,89 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Test.hpp"
+#include "unplug/Automation.hpp"
+
+// the snapshot of the parameters kept by LinearAutomation across blocks
+namespace {
+
+using namespace unplug;
+
+struct Fixture final
+{
+  Fixture()
+  {
+    for (Index i = 0; i < NumParameters::value; ++i) {
+      storage.set(static_cast<ParamIndex>(i), 0.0);
+    }
+    automation.prepare();
+  }
+
+  ParameterStorage storage;
+  LinearAutomation<float> automation{ storage };
+};
+
+} // namespace
+
+UNPLUG_TEST(firstBlockReadsAllTheParameters)
+{
+  auto storage = ParameterStorage{};
+  for (Index i = 0; i < NumParameters::value; ++i) {
+    storage.set(static_cast<ParamIndex>(i), 0.5);
+  }
+  auto automation = LinearAutomation<float>{ storage };
+  automation.prepare();
+  for (Index i = 0; i < NumParameters::value; ++i) {
+    UNPLUG_CHECK(automation.get(static_cast<ParamIndex>(i)) == 0.5f);
+  }
+}
+
+UNPLUG_TEST(parametersSetBetweenBlocksAreRefreshed)
+{
+  auto fixture = Fixture{};
+  fixture.storage.set(3, 0.75);
+  fixture.automation.prepare();
+  UNPLUG_CHECK(fixture.automation.get(3) == 0.75f);
+  UNPLUG_CHECK(fixture.automation.get(2) == 0.f);
+  // the snapshot persists across blocks without changes
+  fixture.automation.prepare();
+  UNPLUG_CHECK(fixture.automation.get(3) == 0.75f);
+}
+
+UNPLUG_TEST(automatedParametersGoBackToTheStorage)
+{
+  auto fixture = Fixture{};
+  setParameterAutomation(fixture.automation, AutomationEvent<float>(1, 0, 0.f, 4, 1.f));
+  for (int sample = 0; sample < 4; ++sample) {
+    fixture.automation.next(1);
+  }
+  UNPLUG_CHECK(fixture.automation.get(1) == 1.f);
+  // the host did not store the last point, so the next block starts again from the stored value
+  fixture.automation.prepare();
+  UNPLUG_CHECK(fixture.automation.get(1) == 0.f);
+  UNPLUG_CHECK(fixture.automation.next(1) == 0.f);
+}
+
+UNPLUG_TEST(moreChangesThanTheLogRefreshAllTheParameters)
+{
+  auto fixture = Fixture{};
+  fixture.storage.set(0, 0.25);
+  // pushes the first change out of the log
+  for (uint32_t change = 0; change < ParameterStorage::changeLogSize; ++change) {
+    fixture.storage.set(1, 0.5);
+  }
+  fixture.automation.prepare();
+  UNPLUG_CHECK(fixture.automation.get(0) == 0.25f);
+  UNPLUG_CHECK(fixture.automation.get(1) == 0.5f);
+}
@@ -0,0 +1,126 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Test.hpp"
+#include "unplug/Convolution.hpp"
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace unplug;
+
+namespace {
+
+std::vector<float> makeNoise(Index size, unsigned seed)
+{
+  auto generator = std::mt19937{ seed };
+  auto distribution = std::uniform_real_distribution<float>{ -1.f, 1.f };
+  auto noise = std::vector<float>(size);
+  for (auto& sample : noise) {
+    sample = distribution(generator);
+  }
+  return noise;
+}
+
+std::vector<float> convolveDirectly(std::vector<float> const& input, std::vector<float> const& impulseResponse)
+{
+  auto output = std::vector<float>(input.size(), 0.f);
+  for (std::size_t i = 0; i < input.size(); ++i) {
+    for (std::size_t j = 0; j < impulseResponse.size() && j <= i; ++j) {
+      output[i] += input[i - j] * impulseResponse[j];
+    }
+  }
+  return output;
+}
+
+// processes a mono signal in blocks, waiting after each one if given a pause, so that the worker is never late
+std::vector<float> convolve(Convolution& convolution,
+                            std::vector<float> const& input,
+                            Index blockSize,
+                            std::chrono::milliseconds pause)
+{
+  auto output = std::vector<float>(input.size());
+  for (std::size_t start = 0; start < input.size(); start += blockSize) {
+    auto const numSamples = std::min(blockSize, static_cast<Index>(input.size() - start));
+    float const* in = input.data() + start;
+    float* out = output.data() + start;
+    convolution.process(&in, &out, 1, numSamples);
+    std::this_thread::sleep_for(pause);
+  }
+  return output;
+}
+
+float getMaxError(std::vector<float> const& output, std::vector<float> const& expected)
+{
+  float maxError = 0.f;
+  for (std::size_t i = 0; i < output.size(); ++i) {
+    maxError = std::max(maxError, std::abs(output[i] - expected[i]));
+  }
+  return maxError;
+}
+
+} // namespace
+
+UNPLUG_TEST(headAndTailMatchTheDirectConvolution)
+{
+  auto const impulseResponse = makeNoise(1500, 1);
+  auto const input = makeNoise(3000, 2);
+  Convolution convolution;
+  UNPLUG_CHECK(convolution.setImpulseResponse({ impulseResponse }, 1, 16, 256));
+  // 64 samples every 5ms give the worker, which polls every millisecond, plenty of time for each tail block
+  auto const output = convolve(convolution, input, 64, std::chrono::milliseconds(5));
+  UNPLUG_CHECK(convolution.getNumMissedDeadlines() == 0);
+  UNPLUG_CHECK(getMaxError(output, convolveDirectly(input, impulseResponse)) < 1e-3f);
+}
+
+UNPLUG_TEST(lateTailBlocksDoNotBlockTheAudioThread)
+{
+  auto const impulseResponse = makeNoise(8192, 3);
+  auto const input = makeNoise(1 << 16, 4);
+  Convolution convolution;
+  UNPLUG_CHECK(convolution.setImpulseResponse({ impulseResponse }, 1, 16, 64));
+  // without pauses the worker falls behind: the late tail blocks are silent, and nothing waits for them
+  auto const output = convolve(convolution, input, 64, std::chrono::milliseconds(0));
+  for (auto const sample : output) {
+    UNPLUG_CHECK(std::isfinite(sample));
+  }
+}
+
+UNPLUG_TEST(everyNewImpulseResponseIsPickedUpByTheNextBlock)
+{
+  auto const input = makeNoise(64, 5);
+  Convolution convolution;
+  for (int i = 1; i <= 16; ++i) {
+    auto const gain = static_cast<float>(i);
+    UNPLUG_CHECK(convolution.setImpulseResponse({ { gain } }, 1, 16, 64));
+    auto const output = convolve(convolution, input, 64, std::chrono::milliseconds(0));
+    for (std::size_t j = 0; j < input.size(); ++j) {
+      UNPLUG_CHECK(std::abs(output[j] - gain * input[j]) < 1e-4f * gain);
+    }
+  }
+}
+
+UNPLUG_TEST(channelsBeyondTheProcessedOnesAreLeftAlone)
+{
+  auto const impulseResponse = makeNoise(1000, 6);
+  auto const input = makeNoise(2048, 7);
+  Convolution convolution;
+  // prepared for two channels, processed as one: only the first channel posts tail blocks
+  UNPLUG_CHECK(convolution.setImpulseResponse({ impulseResponse }, 2, 16, 128));
+  auto const output = convolve(convolution, input, 128, std::chrono::milliseconds(5));
+  UNPLUG_CHECK(convolution.getNumMissedDeadlines() == 0);
+  UNPLUG_CHECK(getMaxError(output, convolveDirectly(input, impulseResponse)) < 1e-3f);
+}
@@ -0,0 +1,46 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Test.hpp"
+#include "unplug/DenormalFlusher.hpp"
+#include <limits>
+
+using namespace unplug;
+
+UNPLUG_TEST(denormalsAreCountedOnlyInSampledBlocks)
+{
+  auto counter = DenormalCounter{ 2 };
+  float const denormal = std::numeric_limits<float>::denorm_min();
+  float state[3] = { 0.f, denormal, 1.f };
+  float channel[4] = { denormal, denormal, 0.f, 0.f };
+  float* channels[2] = { channel, nullptr };
+  for (int block = 0; block < 4; ++block) {
+    counter.isBlockSampled();
+    counter.count(state, 3);
+    counter.count(channels, 2, 4);
+  }
+  UNPLUG_CHECK(counter.getNumSampledBlocks() == 2);
+  UNPLUG_CHECK(counter.getNumDenormals() == 6);
+  // each sampled block counts once, however many times count found denormals in it
+  UNPLUG_CHECK(counter.getNumBlocksWithDenormals() == 2);
+}
+
+UNPLUG_TEST(denormalsAreNotCountedBeforeTheFirstBlock)
+{
+  auto counter = DenormalCounter{};
+  double const state = std::numeric_limits<double>::denorm_min();
+  counter.count(&state, 1);
+  UNPLUG_CHECK(counter.getNumDenormals() == 0);
+  UNPLUG_CHECK(!isDenormal(0.0) && !isDenormal(1e-30f) && isDenormal(1e-40f) && isDenormal(-state));
+}
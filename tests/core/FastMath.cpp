@@ -0,0 +1,140 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Test.hpp"
+#include "unplug/FastMath.hpp"
+#include <cmath>
+#include <vector>
+
+// checks the maximum errors documented in FastMath.hpp against the double precision standard functions
+namespace {
+
+// numPoints floats log-spaced in [min, max] with both ends included, min and max positive
+std::vector<float> makeLogSpaced(double min, double max, int numPoints)
+{
+  auto values = std::vector<float>{};
+  for (int i = 0; i < numPoints; ++i) {
+    values.push_back(static_cast<float>(min * std::pow(max / min, i / static_cast<double>(numPoints - 1))));
+  }
+  return values;
+}
+
+std::vector<float> makeLinSpaced(double min, double max, int numPoints)
+{
+  auto values = std::vector<float>{};
+  for (int i = 0; i < numPoints; ++i) {
+    values.push_back(static_cast<float>(min + (max - min) * i / static_cast<double>(numPoints - 1)));
+  }
+  return values;
+}
+
+template<class Approximation, class Reference>
+double getMaxRelativeError(std::vector<float> const& inputs, Approximation approximation, Reference reference)
+{
+  double maxError = 0.0;
+  for (auto const x : inputs) {
+    auto const expected = reference(static_cast<double>(x));
+    maxError = std::max(maxError, std::abs((approximation(x) - expected) / expected));
+  }
+  return maxError;
+}
+
+template<class Approximation, class Reference>
+double getMaxAbsoluteError(std::vector<float> const& inputs, Approximation approximation, Reference reference)
+{
+  double maxError = 0.0;
+  for (auto const x : inputs) {
+    maxError = std::max(maxError, std::abs(approximation(x) - reference(static_cast<double>(x))));
+  }
+  return maxError;
+}
+
+constexpr int numPoints = 200000;
+
+auto const positiveNormals = makeLogSpaced(1.2e-38, 3.4e38, numPoints);
+auto const aroundOne = makeLinSpaced(0.5, 2.0, numPoints);
+
+} // namespace
+
+UNPLUG_TEST(log2AndLogAreWithinTheirErrorBounds)
+{
+  auto const log2 = [](float x) { return unplug::FastMath::log2(x); };
+  auto const log = [](float x) { return unplug::FastMath::log(x); };
+  auto const referenceLog2 = [](double x) { return std::log2(x); };
+  auto const referenceLog = [](double x) { return std::log(x); };
+  // the relative error is meaningless around 1, where the logarithm crosses 0
+  auto const awayFromOne = makeLogSpaced(2.0, 3.4e38, numPoints);
+  UNPLUG_CHECK(getMaxRelativeError(awayFromOne, log2, referenceLog2) < 1.3e-7);
+  UNPLUG_CHECK(getMaxAbsoluteError(aroundOne, log2, referenceLog2) < 1.6e-7);
+  UNPLUG_CHECK(getMaxRelativeError(awayFromOne, log, referenceLog) < 1.6e-7);
+  UNPLUG_CHECK(getMaxAbsoluteError(aroundOne, log, referenceLog) < 1.2e-7);
+}
+
+UNPLUG_TEST(exp2AndExpAreWithinTheirErrorBounds)
+{
+  auto const exp2 = [](float x) { return unplug::FastMath::exp2(x); };
+  auto const exp = [](float x) { return unplug::FastMath::exp(x); };
+  UNPLUG_CHECK(getMaxRelativeError(makeLinSpaced(-126.0, 127.99, numPoints), exp2, [](double x) {
+                 return std::exp2(x);
+               }) < 1.1e-7);
+  auto const referenceExp = [](double x) { return std::exp(x); };
+  UNPLUG_CHECK(getMaxRelativeError(makeLinSpaced(-10.0, 10.0, numPoints), exp, referenceExp) < 5.5e-7);
+  UNPLUG_CHECK(getMaxRelativeError(makeLinSpaced(-87.3, 88.7, numPoints), exp, referenceExp) < 4e-6);
+  // out of range inputs are clamped to finite normal results
+  UNPLUG_CHECK(std::isnormal(unplug::FastMath::exp2(-1000.f)));
+  UNPLUG_CHECK(std::isnormal(unplug::FastMath::exp2(1000.f)));
+}
+
+UNPLUG_TEST(decibelConversionsAreWithinTheirErrorBounds)
+{
+  auto const linearToDB = [](float x) { return unplug::FastMath::linearToDB(x); };
+  auto const referenceLinearToDB = [](double x) { return 20.0 * std::log10(std::abs(x) + 1.1920929e-7); };
+  UNPLUG_CHECK(getMaxAbsoluteError(aroundOne, linearToDB, referenceLinearToDB) < 1.1e-6);
+  UNPLUG_CHECK(getMaxAbsoluteError(makeLogSpaced(1.2e-38, 1e3, numPoints), linearToDB, referenceLinearToDB) < 1.6e-5);
+  UNPLUG_CHECK(getMaxAbsoluteError(positiveNormals, linearToDB, referenceLinearToDB) < 6.3e-5);
+  // the sign is ignored and 0 is mapped to the floor
+  UNPLUG_CHECK(unplug::FastMath::linearToDB(-0.5f) == unplug::FastMath::linearToDB(0.5f));
+  UNPLUG_CHECK(std::abs(unplug::FastMath::linearToDB(0.f) - referenceLinearToDB(0.0)) < 1e-4);
+  auto const dBToLinear = [](float x) { return unplug::FastMath::dBToLinear(x); };
+  UNPLUG_CHECK(getMaxRelativeError(makeLinSpaced(-758.0, 770.0, numPoints), dBToLinear, [](double x) {
+                 return std::pow(10.0, x / 20.0);
+               }) < 3.1e-6);
+}
+
+UNPLUG_TEST(tanhIsWithinItsErrorBound)
+{
+  auto const tanh = [](float x) { return unplug::FastMath::tanh(x); };
+  auto const referenceTanh = [](double x) { return std::tanh(x); };
+  UNPLUG_CHECK(getMaxAbsoluteError(makeLinSpaced(-20.0, 20.0, numPoints), tanh, referenceTanh) < 1.4e-7);
+}
+
+UNPLUG_TEST(arrayVersionsMatchTheScalarOnes)
+{
+  auto const input = makeLinSpaced(0.01, 10.0, 1001);
+  auto output = std::vector<float>(input.size());
+  unplug::FastMath::log2(input.data(), output.data(), static_cast<unplug::Index>(input.size()));
+  for (std::size_t i = 0; i < input.size(); ++i) {
+    UNPLUG_CHECK(output[i] == unplug::FastMath::log2(input[i]));
+  }
+  unplug::FastMath::tanh(input.data(), output.data(), static_cast<unplug::Index>(input.size()));
+  for (std::size_t i = 0; i < input.size(); ++i) {
+    UNPLUG_CHECK(output[i] == unplug::FastMath::tanh(input[i]));
+  }
+  // in place
+  output = input;
+  unplug::FastMath::dBToLinear(output.data(), output.data(), static_cast<unplug::Index>(output.size()));
+  for (std::size_t i = 0; i < input.size(); ++i) {
+    UNPLUG_CHECK(output[i] == unplug::FastMath::dBToLinear(input[i]));
+  }
+}
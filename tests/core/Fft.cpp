@@ -0,0 +1,76 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Test.hpp"
+#include "unplug/Fft.hpp"
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace unplug;
+
+namespace {
+
+std::vector<float> makeNoise(Index size)
+{
+  auto generator = std::mt19937{ 1 };
+  auto distribution = std::uniform_real_distribution<float>{ -1.f, 1.f };
+  auto noise = std::vector<float>(size);
+  for (auto& sample : noise) {
+    sample = distribution(generator);
+  }
+  return noise;
+}
+
+} // namespace
+
+UNPLUG_TEST(forwardMatchesTheDiscreteFourierTransform)
+{
+  constexpr Index size = 64;
+  auto fft = Fft{ size };
+  auto const input = makeNoise(size);
+  auto real = std::vector<float>(fft.getNumBins());
+  auto imaginary = std::vector<float>(fft.getNumBins());
+  fft.forward(input.data(), real.data(), imaginary.data());
+  for (Index k = 0; k < fft.getNumBins(); ++k) {
+    double expectedReal = 0.0;
+    double expectedImaginary = 0.0;
+    for (Index n = 0; n < size; ++n) {
+      auto const angle = -2.0 * M_PI * static_cast<double>(k * n) / static_cast<double>(size);
+      expectedReal += input[n] * std::cos(angle);
+      expectedImaginary += input[n] * std::sin(angle);
+    }
+    UNPLUG_CHECK(std::abs(real[k] - expectedReal) < 1e-4);
+    UNPLUG_CHECK(std::abs(imaginary[k] - expectedImaginary) < 1e-4);
+  }
+}
+
+UNPLUG_TEST(transformsOfTheSameSizeShareTheirTablesAndStayIndependent)
+{
+  constexpr Index size = 256;
+  auto first = Fft{ size };
+  auto second = Fft{ size };
+  auto const input = makeNoise(size);
+  auto real = std::vector<float>(first.getNumBins());
+  auto imaginary = std::vector<float>(first.getNumBins());
+  auto output = std::vector<float>(size);
+  first.forward(input.data(), real.data(), imaginary.data());
+  // the second transform has its own buffers, so it can run while the first one holds a spectrum
+  second.forward(output.data(), real.data(), imaginary.data());
+  first.forward(input.data(), real.data(), imaginary.data());
+  second.inverse(real.data(), imaginary.data(), output.data());
+  for (Index i = 0; i < size; ++i) {
+    UNPLUG_CHECK(std::abs(output[i] - input[i]) < 1e-5f);
+  }
+}
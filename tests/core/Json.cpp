@@ -0,0 +1,87 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Test.hpp"
+#include "unplug/renderer/Json.hpp"
+#include <string>
+
+namespace {
+
+using namespace unplug::renderer;
+
+bool parse(std::string_view text, JsonValue& value)
+{
+  auto error = std::string{};
+  return parseJson(text, value, error);
+}
+
+bool isRejected(std::string_view text)
+{
+  auto value = JsonValue{};
+  auto error = std::string{};
+  return !parseJson(text, value, error) && error.find("at offset") != std::string::npos;
+}
+
+} // namespace
+
+UNPLUG_TEST(scalarsAreParsed)
+{
+  auto value = JsonValue{};
+  UNPLUG_CHECK(parse(" null ", value) && value.type == JsonValue::Type::null);
+  UNPLUG_CHECK(parse("true", value) && value.type == JsonValue::Type::boolean && value.boolean);
+  UNPLUG_CHECK(parse("false", value) && value.type == JsonValue::Type::boolean && !value.boolean);
+  UNPLUG_CHECK(parse("-2.5e2", value) && value.type == JsonValue::Type::number && value.number == -250.0);
+  UNPLUG_CHECK(parse("0", value) && value.type == JsonValue::Type::number && value.number == 0.0);
+}
+
+UNPLUG_TEST(stringEscapesAreDecoded)
+{
+  auto value = JsonValue{};
+  UNPLUG_CHECK(parse(R"("a\"b\\c\/d\n\t")", value) && value.string == "a\"b\\c/d\n\t");
+  // U+00E9 and U+1F600, the latter as a surrogate pair, encoded as UTF-8
+  UNPLUG_CHECK(parse(R"("\u00e9\ud83d\ude00")", value) && value.string == "\xC3\xA9\xF0\x9F\x98\x80");
+}
+
+UNPLUG_TEST(objectMembersKeepTheirOrder)
+{
+  auto value = JsonValue{};
+  UNPLUG_CHECK(parse(R"({ "b": 1, "a": [true, null, "x"], "c": {} })", value));
+  UNPLUG_CHECK(value.type == JsonValue::Type::object && value.object.size() == 3);
+  UNPLUG_CHECK(value.object[0].first == "b" && value.object[1].first == "a" && value.object[2].first == "c");
+  auto const array = value.find("a");
+  UNPLUG_CHECK(array && array->type == JsonValue::Type::array && array->array.size() == 3);
+  UNPLUG_CHECK(array->array[2].string == "x");
+  UNPLUG_CHECK(value.find("c")->object.empty());
+  UNPLUG_CHECK(!value.find("d"));
+  UNPLUG_CHECK(!array->find("a"));
+}
+
+UNPLUG_TEST(malformedDocumentsAreRejected)
+{
+  UNPLUG_CHECK(isRejected(""));
+  UNPLUG_CHECK(isRejected("{"));
+  UNPLUG_CHECK(isRejected("[1, 2"));
+  UNPLUG_CHECK(isRejected("[1 2]"));
+  UNPLUG_CHECK(isRejected(R"({"a" 1})"));
+  UNPLUG_CHECK(isRejected(R"({1: 2})"));
+  UNPLUG_CHECK(isRejected(R"("unterminated)"));
+  UNPLUG_CHECK(isRejected(R"("\x")"));
+  UNPLUG_CHECK(isRejected(R"("\u12")"));
+  UNPLUG_CHECK(isRejected(R"("\ud83d\u0041")"));
+  UNPLUG_CHECK(isRejected("tru"));
+  UNPLUG_CHECK(isRejected("nul"));
+  UNPLUG_CHECK(isRejected("1 2"));
+  UNPLUG_CHECK(isRejected("{} x"));
+  UNPLUG_CHECK(isRejected(std::string(1000, '[')));
+}
@@ -0,0 +1,112 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Test.hpp"
+#include "unplug/renderer/ParameterSettings.hpp"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+// the parameter settings files of the offline renderer, and the interpolation of their automation lanes
+namespace {
+
+using namespace unplug::renderer;
+
+bool load(std::string const& text, ParameterSettings& settings, std::string& error)
+{
+  auto const path = (std::filesystem::temp_directory_path() / "unplug-test-parameter-settings.json").string();
+  {
+    auto file = std::ofstream(path, std::ios::binary);
+    file << text;
+  }
+  bool const isOk = loadParameterSettings(path, settings, error);
+  std::filesystem::remove(path);
+  return isOk;
+}
+
+bool isRejected(std::string const& text)
+{
+  auto settings = ParameterSettings{};
+  auto error = std::string{};
+  return !load(text, settings, error) && !error.empty();
+}
+
+} // namespace
+
+UNPLUG_TEST(documentedSchemaIsLoaded)
+{
+  auto settings = ParameterSettings{};
+  auto error = std::string{};
+  UNPLUG_CHECK(load(R"({
+    "preset": "Default",
+    "parameters": { "Gain": -6.0, "3": 1 },
+    "automation": { "Gain": [[2.5, 0.0], [0.0, -6.0]] }
+  })",
+                    settings,
+                    error));
+  UNPLUG_CHECK(settings.preset == "Default");
+  UNPLUG_CHECK(settings.values.size() == 2);
+  UNPLUG_CHECK(settings.values[0].parameter == "Gain" && settings.values[0].value == -6.0);
+  UNPLUG_CHECK(settings.values[1].parameter == "3" && settings.values[1].value == 1.0);
+  UNPLUG_CHECK(settings.lanes.size() == 1 && settings.lanes[0].parameter == "Gain");
+  // the points are sorted by time
+  auto const& points = settings.lanes[0].points;
+  UNPLUG_CHECK(points.size() == 2);
+  UNPLUG_CHECK(points[0].time == 0.0 && points[0].value == -6.0);
+  UNPLUG_CHECK(points[1].time == 2.5 && points[1].value == 0.0);
+}
+
+UNPLUG_TEST(allMembersAreOptional)
+{
+  auto settings = ParameterSettings{};
+  auto error = std::string{};
+  UNPLUG_CHECK(load("{}", settings, error));
+  UNPLUG_CHECK(settings.preset.empty() && settings.values.empty() && settings.lanes.empty());
+  UNPLUG_CHECK(load(R"({ "preset": 2 })", settings, error) && settings.preset == "2");
+}
+
+UNPLUG_TEST(invalidSettingsAreRejected)
+{
+  UNPLUG_CHECK(isRejected("[]"));
+  UNPLUG_CHECK(isRejected(R"({ "parameters": { "Gain": -6.0 )"));
+  UNPLUG_CHECK(isRejected(R"({ "preset": -1 })"));
+  UNPLUG_CHECK(isRejected(R"({ "preset": 1.5 })"));
+  UNPLUG_CHECK(isRejected(R"({ "parameters": [1] })"));
+  UNPLUG_CHECK(isRejected(R"({ "parameters": { "Gain": "loud" } })"));
+  UNPLUG_CHECK(isRejected(R"({ "automation": [] })"));
+  UNPLUG_CHECK(isRejected(R"({ "automation": { "Gain": [] } })"));
+  UNPLUG_CHECK(isRejected(R"({ "automation": { "Gain": [[0.0]] } })"));
+  UNPLUG_CHECK(isRejected(R"({ "automation": { "Gain": [[0.0, "x"]] } })"));
+  auto settings = ParameterSettings{};
+  auto error = std::string{};
+  UNPLUG_CHECK(!loadParameterSettings("/nonexistent/settings.json", settings, error) && !error.empty());
+}
+
+UNPLUG_TEST(lanesAreInterpolatedLinearly)
+{
+  auto const points = std::vector<std::pair<double, double>>{ { 100.0, 0.2 }, { 200.0, 0.6 }, { 200.0, 1.0 },
+                                                              { 300.0, 0.0 } };
+  // held before the first point and after the last one
+  UNPLUG_CHECK(interpolateLinearly(points, 0.0) == 0.2);
+  UNPLUG_CHECK(interpolateLinearly(points, 100.0) == 0.2);
+  UNPLUG_CHECK(interpolateLinearly(points, 300.0) == 0.0);
+  UNPLUG_CHECK(interpolateLinearly(points, 1000.0) == 0.0);
+  UNPLUG_CHECK(std::abs(interpolateLinearly(points, 150.0) - 0.4) < 1e-12);
+  // a jump: the last of the points at the same position is used from there on
+  UNPLUG_CHECK(interpolateLinearly(points, 200.0) == 1.0);
+  UNPLUG_CHECK(std::abs(interpolateLinearly(points, 250.0) - 0.5) < 1e-12);
+  auto const single = std::vector<std::pair<double, double>>{ { 10.0, 0.7 } };
+  UNPLUG_CHECK(interpolateLinearly(single, 0.0) == 0.7 && interpolateLinearly(single, 20.0) == 0.7);
+}
@@ -0,0 +1,188 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Test.hpp"
+#include "unplug/ProcessingEngine.hpp"
+#include <string>
+#include <vector>
+
+// the timeline that the ProcessingEngine builds from the automation points and the MIDI events of a block, recorded
+// as a string of the calls it makes to the processing callbacks
+namespace {
+
+using namespace unplug;
+
+constexpr Index blockSize = 64;
+
+struct Automation final
+{
+  std::string log;
+};
+
+std::string toString(AutomationEvent<float> const& event)
+{
+  return "a" + std::to_string(event.paramIndex) + ":" + std::to_string(static_cast<int>(event.firstSample)) + "-" +
+         std::to_string(static_cast<int>(event.lastSample)) + "=" + std::to_string(event.valueAtLastSample) + " ";
+}
+
+struct Fixture final
+{
+  Fixture()
+  {
+    ioCache.resize(1, 1);
+    for (Index i = 0; i < NumParameters::value; ++i) {
+      parameters.set(static_cast<ParamIndex>(i), 0.0);
+    }
+  }
+
+  // a block without inputs and outputs is a flush
+  void setupIO(bool isFlushing)
+  {
+    auto const bus = AudioBus<float>{ channels, 1 };
+    if (isFlushing) {
+      engine.setupIO<float>(nullptr, 0, nullptr, 0);
+    }
+    else {
+      engine.setupIO(&bus, 1, &bus, 1);
+    }
+  }
+
+  template<class MidiEvents>
+  void process(ParameterEventSpan const& parameterChanges,
+               MidiEvents const& midiEvents,
+               detail::MidiMapping const* midiMapping = nullptr,
+               float oversamplingRate = 1.f,
+               bool isFlushing = false)
+  {
+    setupIO(isFlushing);
+    auto const numUpsampledSamples = static_cast<Index>(blockSize * oversamplingRate);
+    engine.processWithEvents<float>(
+      blockSize,
+      parameterChanges,
+      midiEvents,
+      midiMapping,
+      [&](IO<float>, Index numSamples) { log += "static:" + std::to_string(numSamples) + " "; },
+      [&]() -> Automation& {
+        automation.log.clear();
+        return automation;
+      },
+      [&](Automation& automation_, IO<float>, Index start, Index end) {
+        log += automation_.log + "[" + std::to_string(start) + "," + std::to_string(end) + ") ";
+        automation_.log.clear();
+      },
+      [](Automation& automation_, AutomationEvent<float> const& event) { automation_.log += toString(event); },
+      [&](MidiEvent const& event) { log += "midi" + std::to_string(event.number) + " "; },
+      [=](IO<float>, Index) { return numUpsampledSamples; },
+      [](IO<float>, Index, Index) {},
+      oversamplingRate);
+  }
+
+  ParameterStorage parameters;
+  detail::CachedIO ioCache;
+  ProcessingEngine engine{ parameters, ioCache };
+  std::vector<float> buffer = std::vector<float>(2 * blockSize);
+  float* channels[1] = { buffer.data() };
+  Automation automation;
+  std::string log;
+};
+
+MidiEvent makeNoteOn(Index sampleOffset, int pitch)
+{
+  auto event = MidiEvent{};
+  event.type = MidiEvent::Type::noteOn;
+  event.sampleOffset = sampleOffset;
+  event.number = pitch;
+  event.value = 1.f;
+  return event;
+}
+
+} // namespace
+
+UNPLUG_TEST(blockWithoutChangesIsProcessedStatically)
+{
+  Fixture fixture;
+  fixture.process(ParameterEventSpan{}, MidiEventSpan{});
+  UNPLUG_CHECK(fixture.log == "static:64 ");
+}
+
+UNPLUG_TEST(blockIsSplitAtEachAutomationPoint)
+{
+  Fixture fixture;
+  ParameterEvent const changes[] = { { 1, 16, 0.5 }, { 1, 48, 1.0 } };
+  fixture.process(ParameterEventSpan{ changes, 2 }, MidiEventSpan{});
+  // a ramp from the current value to the first point, a segment to the second point, and a hold to the end
+  UNPLUG_CHECK(fixture.log == "a1:0-16=0.500000 [0,16) "
+                              "a1:16-48=1.000000 [16,48) "
+                              "a1:48-64=1.000000 [48,64) ");
+  UNPLUG_CHECK(fixture.parameters.get(1) == 1.0);
+}
+
+UNPLUG_TEST(pointsOfDifferentParametersShareTheSplits)
+{
+  Fixture fixture;
+  ParameterEvent const changes[] = { { 1, 0, 0.25 }, { 1, 32, 0.75 }, { 2, 16, 0.5 } };
+  fixture.process(ParameterEventSpan{ changes, 3 }, MidiEventSpan{});
+  UNPLUG_CHECK(fixture.log == "a2:0-16=0.500000 a1:0-32=0.750000 [0,16) "
+                              "a2:16-64=0.500000 [16,32) "
+                              "a1:32-64=0.750000 [32,64) ");
+}
+
+UNPLUG_TEST(midiEventsAndAutomationShareOneTimeline)
+{
+  Fixture fixture;
+  ParameterEvent const changes[] = { { 1, 16, 0.5 } };
+  MidiEvent const events[] = { makeNoteOn(0, 60), makeNoteOn(32, 64), makeNoteOn(32, 67) };
+  fixture.process(ParameterEventSpan{ changes, 1 }, MidiEventSpan{ events, 3 });
+  // the events of a sample are dispatched before the segment that starts there
+  UNPLUG_CHECK(fixture.log == "midi60 a1:0-16=0.500000 [0,16) "
+                              "a1:16-64=0.500000 [16,32) "
+                              "midi64 midi67 [32,64) ");
+}
+
+UNPLUG_TEST(mappedControllersSetTheirParameterInsteadOfBeingDispatched)
+{
+  Fixture fixture;
+  auto midiMapping = detail::MidiMapping{};
+  midiMapping.mapParameter(3, 7, 0);
+  auto controlChange = MidiEvent{};
+  controlChange.type = MidiEvent::Type::controlChange;
+  controlChange.sampleOffset = 10;
+  controlChange.number = 7;
+  controlChange.value = 0.25f;
+  MidiEvent const events[] = { controlChange, makeNoteOn(20, 60) };
+  fixture.process(ParameterEventSpan{}, MidiEventSpan{ events, 2 }, &midiMapping);
+  UNPLUG_CHECK(fixture.log == "[0,10) a3:10-64=0.250000 [10,20) midi60 [20,64) ");
+  UNPLUG_CHECK(fixture.parameters.get(3) == 0.25);
+}
+
+UNPLUG_TEST(pointsAndEventsAreScaledToTheOversampledBlock)
+{
+  Fixture fixture;
+  ParameterEvent const changes[] = { { 1, 16, 0.5 } };
+  MidiEvent const events[] = { makeNoteOn(40, 60) };
+  fixture.process(ParameterEventSpan{ changes, 1 }, MidiEventSpan{ events, 1 }, nullptr, 2.f);
+  UNPLUG_CHECK(fixture.log == "a1:0-32=0.500000 [0,32) "
+                              "a1:32-128=0.500000 [32,80) "
+                              "midi60 [80,128) ");
+}
+
+UNPLUG_TEST(flushingDispatchesTheEventsAndUpdatesTheParameters)
+{
+  Fixture fixture;
+  ParameterEvent const changes[] = { { 1, 16, 0.5 }, { 1, 48, 0.75 } };
+  MidiEvent const events[] = { makeNoteOn(8, 60) };
+  fixture.process(ParameterEventSpan{ changes, 2 }, MidiEventSpan{ events, 1 }, nullptr, 1.f, true);
+  UNPLUG_CHECK(fixture.log == "midi60 ");
+  UNPLUG_CHECK(fixture.parameters.get(1) == 0.75);
+}
@@ -0,0 +1,71 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Test.hpp"
+#include "unplug/DspLoad.hpp"
+#include "unplug/QualityGovernor.hpp"
+#include <chrono>
+
+using namespace unplug;
+
+namespace {
+
+// processes blocks of 480 samples at 48kHz (10ms), each taking the given fraction of its duration
+void process(DspLoad& dspLoad, QualityGovernor& governor, double blockLoad, double seconds, int maxReduction)
+{
+  constexpr Index blockSize = 480;
+  auto const elapsed =
+    std::chrono::duration_cast<DspLoad::Clock::duration>(std::chrono::duration<double>(0.01 * blockLoad));
+  for (int block = 0; block < static_cast<int>(seconds * 100.0); ++block) {
+    governor.update(dspLoad.getLoad(), blockSize, maxReduction);
+    dspLoad.update(elapsed, blockSize);
+  }
+}
+
+} // namespace
+
+UNPLUG_TEST(qualityIsLoweredOneStepAtATimeAndRestoredAfterTheHoldTime)
+{
+  DspLoad dspLoad;
+  dspLoad.setSampleRate(48000.0);
+  QualityGovernor governor;
+  governor.setSampleRate(48000.0);
+  process(dspLoad, governor, 0.1, 1.0, 3);
+  UNPLUG_CHECK(governor.getReduction() == 0);
+  // an overload lowers the quality, but not faster than the settling time allows
+  process(dspLoad, governor, 0.9, 0.6, 3);
+  UNPLUG_CHECK(governor.getReduction() == 1);
+  process(dspLoad, governor, 0.9, 1.0, 3);
+  UNPLUG_CHECK(governor.getReduction() == 3);
+  UNPLUG_CHECK(governor.getEffectiveQuality(4) == 1);
+  // the reduction is limited by the lowest quality
+  UNPLUG_CHECK(governor.getEffectiveQuality(2) == 0);
+  // a moderate load holds the quality
+  process(dspLoad, governor, 0.4, 5.0, 3);
+  UNPLUG_CHECK(governor.getReduction() == 3);
+  process(dspLoad, governor, 0.05, 3.0, 3);
+  UNPLUG_CHECK(governor.getReduction() == 2);
+}
+
+UNPLUG_TEST(qualityIsRestoredWhenItCanNotBeLowered)
+{
+  DspLoad dspLoad;
+  dspLoad.setSampleRate(48000.0);
+  QualityGovernor governor;
+  governor.setSampleRate(48000.0);
+  process(dspLoad, governor, 0.9, 2.0, 2);
+  UNPLUG_CHECK(governor.getReduction() == 2);
+  process(dspLoad, governor, 0.9, 0.01, 0);
+  UNPLUG_CHECK(governor.getReduction() == 0);
+}
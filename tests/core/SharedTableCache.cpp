@@ -0,0 +1,82 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Test.hpp"
+#include "unplug/SharedTableCache.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace unplug;
+
+namespace {
+
+struct Key final
+{
+  double sampleRate;
+  int order;
+  auto operator<=>(Key const&) const = default;
+};
+
+struct Table final
+{
+  std::vector<float> coefficients;
+};
+
+using Cache = SharedTableCache<Key, Table>;
+
+} // namespace
+
+UNPLUG_TEST(tablesAreBuiltOncePerKeyAndReleasedWithTheLastReference)
+{
+  int numBuilds = 0;
+  auto const build = [&] {
+    ++numBuilds;
+    return Table{ std::vector<float>(16, 1.f) };
+  };
+  {
+    auto first = Cache::get({ 48000.0, 2 }, build);
+    auto second = Cache::get({ 48000.0, 2 }, build);
+    auto other = Cache::get({ 44100.0, 2 }, build);
+    UNPLUG_CHECK(first == second);
+    UNPLUG_CHECK(first != other);
+    UNPLUG_CHECK(numBuilds == 2);
+    UNPLUG_CHECK(Cache::getNumTables() == 2);
+  }
+  UNPLUG_CHECK(Cache::getNumTables() == 0);
+  auto rebuilt = Cache::get({ 48000.0, 2 }, build);
+  UNPLUG_CHECK(numBuilds == 3);
+}
+
+UNPLUG_TEST(concurrentRequestsBuildTheTableOnce)
+{
+  std::atomic<int> numBuilds = 0;
+  auto tables = std::vector<Cache::TablePtr>(16);
+  auto threads = std::vector<std::thread>{};
+  for (auto& table : tables) {
+    threads.emplace_back([&] {
+      table = Cache::get({ 96000.0, 4 }, [&] {
+        ++numBuilds;
+        return Table{ std::vector<float>(1024, 1.f) };
+      });
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  UNPLUG_CHECK(numBuilds == 1);
+  for (auto const& table : tables) {
+    UNPLUG_CHECK(table == tables.front());
+  }
+}
@@ -0,0 +1,128 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Test.hpp"
+#include "unplug/TripleBuffer.hpp"
+#include <array>
+#include <thread>
+
+namespace {
+
+using namespace unplug;
+
+// the producer and the consumer must never hold the same copy
+bool areSlotsDistinct(TripleBuffer<int>& tripleBuffer)
+{
+  return &tripleBuffer.getWriteBuffer() != &tripleBuffer.getReadBuffer();
+}
+
+} // namespace
+
+UNPLUG_TEST(nothingIsReadBeforePublishing)
+{
+  auto tripleBuffer = TripleBuffer<int>{ 7 };
+  UNPLUG_CHECK(!tripleBuffer.hasNewData());
+  UNPLUG_CHECK(!tripleBuffer.update());
+  UNPLUG_CHECK(tripleBuffer.getReadBuffer() == 7);
+  UNPLUG_CHECK(areSlotsDistinct(tripleBuffer));
+}
+
+UNPLUG_TEST(publishedValueIsReadAfterUpdate)
+{
+  auto tripleBuffer = TripleBuffer<int>{};
+  tripleBuffer.publish(1);
+  UNPLUG_CHECK(tripleBuffer.hasNewData());
+  // the read buffer does not change until update
+  UNPLUG_CHECK(tripleBuffer.getReadBuffer() == 0);
+  UNPLUG_CHECK(tripleBuffer.update());
+  UNPLUG_CHECK(tripleBuffer.getReadBuffer() == 1);
+  UNPLUG_CHECK(!tripleBuffer.hasNewData());
+  UNPLUG_CHECK(!tripleBuffer.update());
+  UNPLUG_CHECK(tripleBuffer.getReadBuffer() == 1);
+}
+
+UNPLUG_TEST(lastPublishedValueWins)
+{
+  auto tripleBuffer = TripleBuffer<int>{};
+  for (int value = 1; value <= 5; ++value) {
+    tripleBuffer.publish(value);
+    UNPLUG_CHECK(areSlotsDistinct(tripleBuffer));
+  }
+  UNPLUG_CHECK(tripleBuffer.update());
+  UNPLUG_CHECK(tripleBuffer.getReadBuffer() == 5);
+  UNPLUG_CHECK(!tripleBuffer.update());
+}
+
+UNPLUG_TEST(writeBufferIsNeverTheLastPublishedOne)
+{
+  auto tripleBuffer = TripleBuffer<int>{};
+  tripleBuffer.getWriteBuffer() = 1;
+  tripleBuffer.publish();
+  // writing to the next copy does not change the published one
+  tripleBuffer.getWriteBuffer() = 2;
+  UNPLUG_CHECK(tripleBuffer.update());
+  UNPLUG_CHECK(tripleBuffer.getReadBuffer() == 1);
+}
+
+UNPLUG_TEST(slotsAreDistinctInAnyOrderOfCalls)
+{
+  // every sequence of 10 calls, each bit choosing between publish and update
+  for (int sequence = 0; sequence < (1 << 10); ++sequence) {
+    auto tripleBuffer = TripleBuffer<int>{};
+    int lastPublished = 0;
+    bool isPending = false;
+    for (int call = 0; call < 10; ++call) {
+      if (sequence & (1 << call)) {
+        tripleBuffer.publish(++lastPublished);
+        isPending = true;
+      }
+      else {
+        UNPLUG_CHECK(tripleBuffer.update() == isPending);
+        UNPLUG_CHECK(tripleBuffer.getReadBuffer() == lastPublished);
+        isPending = false;
+      }
+      UNPLUG_CHECK(tripleBuffer.hasNewData() == isPending);
+      UNPLUG_CHECK(areSlotsDistinct(tripleBuffer));
+    }
+  }
+}
+
+UNPLUG_TEST(concurrentSnapshotsAreComplete)
+{
+  // each snapshot is filled with a single value, so a torn read would show different values
+  using Snapshot = std::array<int, 64>;
+  constexpr int numSnapshots = 100000;
+  auto tripleBuffer = TripleBuffer<Snapshot>{};
+  auto producer = std::thread([&] {
+    for (int value = 1; value <= numSnapshots; ++value) {
+      tripleBuffer.getWriteBuffer().fill(value);
+      tripleBuffer.publish();
+    }
+  });
+  bool isOk = true;
+  int lastValue = 0;
+  while (isOk && lastValue < numSnapshots) {
+    if (!tripleBuffer.update()) {
+      continue;
+    }
+    auto const& snapshot = tripleBuffer.getReadBuffer();
+    isOk = snapshot[0] > lastValue;
+    for (auto value : snapshot) {
+      isOk = isOk && value == snapshot[0];
+    }
+    lastValue = snapshot[0];
+  }
+  producer.join();
+  UNPLUG_CHECK(isOk);
+}
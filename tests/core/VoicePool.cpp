@@ -0,0 +1,132 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Test.hpp"
+#include "unplug/VoicePool.hpp"
+#include <cstdint>
+#include <vector>
+
+using namespace unplug;
+
+namespace {
+
+using Voices = VoicePool<16, float, 4>;
+
+MidiEvent makeEvent(MidiEvent::Type type, int number)
+{
+  auto event = MidiEvent{};
+  event.type = type;
+  event.number = number;
+  event.value = 1.f;
+  return event;
+}
+
+} // namespace
+
+UNPLUG_TEST(notesTakeTheFreeVoiceWithTheLowestIndex)
+{
+  Voices voices;
+  UNPLUG_CHECK(voices.noteOn(0, 60, 1.f).voice == 0);
+  UNPLUG_CHECK(voices.noteOn(0, 62, 1.f).voice == 1);
+  UNPLUG_CHECK(voices.noteOn(0, 64, 1.f).voice == 2);
+  UNPLUG_CHECK(voices.getNumActiveVoices() == 3);
+  voices.noteOff(0, 62);
+  // a released voice is still active, until the plugin frees it
+  UNPLUG_CHECK(voices.isActive(1));
+  UNPLUG_CHECK(voices.getGates()[1] == 0.f);
+  UNPLUG_CHECK(voices.noteOn(0, 65, 1.f).voice == 3);
+  voices.freeVoice(1);
+  UNPLUG_CHECK(!voices.isActive(1));
+  UNPLUG_CHECK(voices.noteOn(0, 67, 1.f).voice == 1);
+  UNPLUG_CHECK(voices.getPitches()[1] == 67);
+}
+
+UNPLUG_TEST(stealingPrefersTheOldestReleasedVoice)
+{
+  Voices voices;
+  voices.setPolyphony(3);
+  voices.noteOn(0, 60, 1.f);
+  voices.noteOn(0, 62, 1.f);
+  voices.noteOn(0, 64, 1.f);
+  voices.noteOff(0, 64);
+  voices.noteOff(0, 62);
+  auto const allocation = voices.noteOn(0, 65, 1.f);
+  UNPLUG_CHECK(allocation.isStolen);
+  UNPLUG_CHECK(allocation.voice == 1);
+  UNPLUG_CHECK(voices.noteOn(0, 67, 1.f).voice == 2);
+  // with all the voices held, the oldest one is stolen
+  auto const held = voices.noteOn(0, 69, 1.f);
+  UNPLUG_CHECK(held.isStolen);
+  UNPLUG_CHECK(held.voice == 0);
+  UNPLUG_CHECK(voices.noteOn(0, 71, 1.f).voice == 1);
+  UNPLUG_CHECK(voices.getNumActiveVoices() == 3);
+}
+
+UNPLUG_TEST(noteOffMatchesByNoteIdOrByChannelAndPitch)
+{
+  Voices voices;
+  voices.noteOn(0, 60, 1.f, 7);
+  voices.noteOn(0, 60, 1.f, 8);
+  voices.noteOn(1, 60, 1.f);
+  UNPLUG_CHECK(voices.noteOff(0, 60, 8) == 1);
+  UNPLUG_CHECK(voices.getGates()[0] == 1.f);
+  UNPLUG_CHECK(voices.getGates()[1] == 0.f);
+  // without a note id, the voices of the channel and pitch are released
+  UNPLUG_CHECK(voices.noteOff(1, 60) == 1);
+  UNPLUG_CHECK(voices.getGates()[2] == 0.f);
+  UNPLUG_CHECK(voices.noteOff(0, 60) == 1);
+}
+
+UNPLUG_TEST(onlyGroupsWithActiveVoicesAreProcessed)
+{
+  Voices voices;
+  for (int i = 0; i < 10; ++i) {
+    voices.noteOn(0, 60 + i, 1.f);
+  }
+  for (Index voice = 0; voice < 9; ++voice) {
+    voices.freeVoice(voice);
+  }
+  auto groups = std::vector<Index>{};
+  voices.forEachActiveGroup([&](Index firstVoice) { groups.push_back(firstVoice); });
+  UNPLUG_CHECK((groups == std::vector<Index>{ 8 }));
+  UNPLUG_CHECK(voices.getActiveMask()[9] == 1.f);
+  UNPLUG_CHECK(voices.getActiveMask()[8] == 0.f);
+}
+
+UNPLUG_TEST(voiceArraysAreAlignedAndPadded)
+{
+  VoicePool<10, float, 8> voices;
+  static_assert(VoicePool<10, float, 8>::capacity == 16);
+  UNPLUG_CHECK(reinterpret_cast<std::uintptr_t>(voices.getGates()) % 64 == 0);
+  UNPLUG_CHECK(reinterpret_cast<std::uintptr_t>(voices.getVelocities()) % 64 == 0);
+  UNPLUG_CHECK(reinterpret_cast<std::uintptr_t>(voices.getActiveMask()) % 64 == 0);
+}
+
+UNPLUG_TEST(midiEventsStartAndStopTheVoices)
+{
+  Voices voices;
+  int numNotesOn = 0;
+  auto const onNoteOn = [&](Voices::Allocation, MidiEvent const&) { ++numNotesOn; };
+  UNPLUG_CHECK(voices.handleMidiEvent(makeEvent(MidiEvent::Type::noteOn, 60), onNoteOn));
+  UNPLUG_CHECK(voices.handleMidiEvent(makeEvent(MidiEvent::Type::noteOn, 64), onNoteOn));
+  UNPLUG_CHECK(numNotesOn == 2);
+  UNPLUG_CHECK(voices.handleMidiEvent(makeEvent(MidiEvent::Type::noteOff, 60), onNoteOn));
+  UNPLUG_CHECK(voices.getGates()[0] == 0.f);
+  UNPLUG_CHECK(!voices.handleMidiEvent(makeEvent(MidiEvent::Type::controlChange, 1), onNoteOn));
+  UNPLUG_CHECK(voices.handleMidiEvent(makeEvent(MidiEvent::Type::controlChange, MidiCC::AllNotesOff), onNoteOn));
+  UNPLUG_CHECK(voices.getGates()[1] == 0.f);
+  UNPLUG_CHECK(voices.getNumActiveVoices() == 2);
+  UNPLUG_CHECK(voices.handleMidiEvent(makeEvent(MidiEvent::Type::controlChange, MidiCC::AllSoundOff), onNoteOn));
+  UNPLUG_CHECK(voices.getNumActiveVoices() == 0);
+}
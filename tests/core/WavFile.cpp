@@ -0,0 +1,192 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Test.hpp"
+#include "unplug/renderer/WavFile.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// files written by WavWriter and read back by WavReader, in blocks, in every sample format
+namespace {
+
+using namespace unplug;
+using namespace unplug::renderer;
+
+constexpr Index numFrames = 1000;
+constexpr Index blockSize = 300;
+
+std::string getTemporaryPath(std::string const& name)
+{
+  return (std::filesystem::temp_directory_path() / ("unplug-test-" + name + ".wav")).string();
+}
+
+struct Signal final
+{
+  std::vector<std::vector<double>> buffers;
+  std::vector<double*> channels;
+
+  explicit Signal(Index numChannels)
+    : buffers(numChannels, std::vector<double>(numFrames))
+  {
+    for (auto& buffer : buffers) {
+      channels.push_back(buffer.data());
+    }
+  }
+
+  static Signal makeSine(Index numChannels)
+  {
+    auto signal = Signal{ numChannels };
+    for (Index channel = 0; channel < numChannels; ++channel) {
+      for (Index frame = 0; frame < numFrames; ++frame) {
+        signal.buffers[channel][frame] = 0.9 * std::sin(0.01 * static_cast<double>(frame * (channel + 1)));
+      }
+    }
+    return signal;
+  }
+};
+
+bool write(std::string const& path, WavInfo const& info, Signal const& signal)
+{
+  auto writer = WavWriter{};
+  if (!writer.open(path, info)) {
+    return false;
+  }
+  for (Index frame = 0; frame < numFrames; frame += blockSize) {
+    auto channels = std::vector<double const*>{};
+    for (auto channel : signal.channels) {
+      channels.push_back(channel + frame);
+    }
+    if (!writer.write(channels.data(), std::min(blockSize, numFrames - frame))) {
+      return false;
+    }
+  }
+  return writer.getNumFramesWritten() == static_cast<uint64_t>(numFrames) && writer.close();
+}
+
+bool read(std::string const& path, WavInfo& info, Signal& signal)
+{
+  auto reader = WavReader{};
+  if (!reader.open(path)) {
+    return false;
+  }
+  info = reader.getInfo();
+  Index numFramesRead = 0;
+  while (true) {
+    auto channels = std::vector<double*>{};
+    for (auto channel : signal.channels) {
+      channels.push_back(channel + numFramesRead);
+    }
+    auto const numFramesInBlock = reader.read(channels.data(), std::min(blockSize, numFrames - numFramesRead));
+    numFramesRead += numFramesInBlock;
+    if (numFramesInBlock == 0 || numFramesRead == numFrames) {
+      break;
+    }
+  }
+  return numFramesRead == numFrames;
+}
+
+bool roundTrip(SampleFormat format, Index numChannels, double tolerance)
+{
+  auto const path = getTemporaryPath("round-trip");
+  auto const info = WavInfo{ numChannels, 48000.0, 0, format };
+  auto const written = Signal::makeSine(numChannels);
+  auto readInfo = WavInfo{};
+  auto readSignal = Signal{ numChannels };
+  bool isOk = write(path, info, written) && read(path, readInfo, readSignal);
+  std::filesystem::remove(path);
+  isOk = isOk && readInfo.numChannels == numChannels && readInfo.sampleRate == 48000.0 &&
+         readInfo.numFrames == static_cast<uint64_t>(numFrames) && readInfo.format == format;
+  for (Index channel = 0; isOk && channel < numChannels; ++channel) {
+    for (Index frame = 0; isOk && frame < numFrames; ++frame) {
+      isOk = std::abs(readSignal.buffers[channel][frame] - written.buffers[channel][frame]) <= tolerance;
+    }
+  }
+  return isOk;
+}
+
+} // namespace
+
+UNPLUG_TEST(pcm16RoundTrip)
+{
+  UNPLUG_CHECK(roundTrip(SampleFormat::pcm16, 2, 1.0 / 32768.0));
+}
+
+UNPLUG_TEST(pcm24RoundTrip)
+{
+  UNPLUG_CHECK(roundTrip(SampleFormat::pcm24, 2, 1.0 / 8388608.0));
+}
+
+UNPLUG_TEST(pcm32RoundTrip)
+{
+  UNPLUG_CHECK(roundTrip(SampleFormat::pcm32, 1, 1.0 / 2147483648.0));
+}
+
+UNPLUG_TEST(float32RoundTrip)
+{
+  UNPLUG_CHECK(roundTrip(SampleFormat::float32, 2, 1e-7));
+}
+
+UNPLUG_TEST(float64RoundTrip)
+{
+  UNPLUG_CHECK(roundTrip(SampleFormat::float64, 2, 0.0));
+}
+
+UNPLUG_TEST(extensibleHeaderRoundTrip)
+{
+  // more than two channels are written with the WAVE_FORMAT_EXTENSIBLE header
+  UNPLUG_CHECK(roundTrip(SampleFormat::pcm24, 3, 1.0 / 8388608.0));
+  UNPLUG_CHECK(roundTrip(SampleFormat::float32, 6, 1e-7));
+}
+
+UNPLUG_TEST(integerSamplesAreClipped)
+{
+  auto const path = getTemporaryPath("clipping");
+  auto signal = Signal{ 1 };
+  signal.buffers[0].assign(numFrames, 2.0);
+  signal.buffers[0][1] = -2.0;
+  auto readInfo = WavInfo{};
+  auto readSignal = Signal{ 1 };
+  bool const isOk = write(path, WavInfo{ 1, 44100.0, 0, SampleFormat::pcm16 }, signal) &&
+                    read(path, readInfo, readSignal);
+  std::filesystem::remove(path);
+  UNPLUG_CHECK(isOk);
+  UNPLUG_CHECK(readSignal.buffers[0][0] == 32767.0 / 32768.0);
+  UNPLUG_CHECK(readSignal.buffers[0][1] == -1.0);
+}
+
+UNPLUG_TEST(invalidFilesAreRejected)
+{
+  auto reader = WavReader{};
+  UNPLUG_CHECK(!reader.open(getTemporaryPath("missing")));
+  auto const path = getTemporaryPath("invalid");
+  {
+    auto file = std::ofstream(path, std::ios::binary);
+    // a RIFF header without any chunk
+    file.write("RIFF\x04\0\0\0WAVE", 12);
+  }
+  UNPLUG_CHECK(!reader.open(path));
+  std::filesystem::remove(path);
+}
+
+UNPLUG_TEST(sampleFormatNames)
+{
+  auto format = SampleFormat::pcm16;
+  UNPLUG_CHECK(getSampleFormatFromName("float64", format) && format == SampleFormat::float64);
+  UNPLUG_CHECK(getSampleFormatFromName("pcm24", format) && format == SampleFormat::pcm24);
+  UNPLUG_CHECK(!getSampleFormatFromName("pcm8", format));
+}
@@ -0,0 +1,191 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Test.hpp"
+#include "unplug/detail/Vst3BlockAdapter.hpp"
+#include <string>
+
+// splitting and re-blocking of the audio, the parameter changes, the events and the process context
+namespace {
+
+using namespace Steinberg;
+using namespace Steinberg::Vst;
+
+struct Host final
+{
+  static constexpr int32 maxBlockSize = 256;
+
+  Host()
+  {
+    events.setCapacity(64);
+    changes.setCapacity(8, 64);
+    inputChannel = buffer;
+    outputChannel = buffer;
+    input.numChannels = 1;
+    input.channelBuffers32 = &inputChannel;
+    output.numChannels = 1;
+    output.channelBuffers32 = &outputChannel;
+    context.state = ProcessContext::kTempoValid | ProcessContext::kProjectTimeMusicValid;
+    context.sampleRate = 48000.0;
+    context.tempo = 120.0;
+  }
+
+  ProcessData makeBlock(int32 numSamples, int64 projectTimeSamples)
+  {
+    context.projectTimeSamples = projectTimeSamples;
+    context.projectTimeMusic = static_cast<double>(projectTimeSamples) / context.sampleRate * context.tempo / 60.0;
+    auto data = ProcessData{};
+    data.symbolicSampleSize = kSample32;
+    data.numSamples = numSamples;
+    data.numInputs = 1;
+    data.numOutputs = 1;
+    data.inputs = &input;
+    data.outputs = &output;
+    data.inputEvents = &events;
+    data.inputParameterChanges = &changes;
+    data.processContext = &context;
+    return data;
+  }
+
+  void addNoteOn(int32 sampleOffset, int16 pitch)
+  {
+    auto event = Event{};
+    event.type = Event::kNoteOnEvent;
+    event.sampleOffset = sampleOffset;
+    event.noteOn.pitch = pitch;
+    events.addEvent(event);
+  }
+
+  void addPoint(ParamID id, int32 sampleOffset, ParamValue value)
+  {
+    int32 index = 0;
+    auto queue = changes.addParameterData(id, index);
+    queue->addPoint(sampleOffset, value, index);
+  }
+
+  void clear()
+  {
+    events.clear();
+    changes.clear();
+  }
+
+  float buffer[maxBlockSize]{};
+  float* inputChannel;
+  float* outputChannel;
+  AudioBusBuffers input;
+  AudioBusBuffers output;
+  PreallocatedEventList events;
+  PreallocatedParameterChanges changes;
+  ProcessContext context{};
+};
+
+// what a block received by the processing code looks like, as "size@projectTime notes:pitch@offset ..."
+std::string describe(ProcessData& data, bool withChanges = false)
+{
+  auto text = std::to_string(data.numSamples) + "@" + std::to_string(data.processContext->projectTimeSamples);
+  if (data.inputEvents) {
+    for (int32 i = 0; i < data.inputEvents->getEventCount(); ++i) {
+      Event event{};
+      data.inputEvents->getEvent(i, event);
+      text += " n" + std::to_string(event.noteOn.pitch) + "@" + std::to_string(event.sampleOffset);
+    }
+  }
+  if (withChanges && data.inputParameterChanges) {
+    for (int32 i = 0; i < data.inputParameterChanges->getParameterCount(); ++i) {
+      auto queue = data.inputParameterChanges->getParameterData(i);
+      text += " p" + std::to_string(queue->getParameterId()) + ":";
+      for (int32 point = 0; point < queue->getPointCount(); ++point) {
+        int32 offset = 0;
+        ParamValue value = 0.0;
+        queue->getPoint(point, offset, value);
+        text += std::to_string(static_cast<int>(value * 100.0)) + "@" + std::to_string(offset) + ",";
+      }
+    }
+  }
+  return text + "|";
+}
+
+} // namespace
+
+UNPLUG_TEST(subBlocksReceiveTheirEventsAndTime)
+{
+  auto parameters = unplug::ParameterStorage{};
+  auto adapter = BlockAdapter{};
+  adapter.setMode(BlockAdapter::Mode::maxBlockSize, 32);
+  adapter.setup({ 1 }, { 1 }, unplug::FloatingPointPrecision::float32);
+  Host host;
+  host.addNoteOn(0, 60);
+  host.addNoteOn(31, 61);
+  host.addNoteOn(32, 62);
+  host.addNoteOn(70, 63);
+  host.addNoteOn(99, 64);
+  auto data = host.makeBlock(100, 1000);
+  auto blocks = std::string{};
+  adapter.process<float>(data, parameters, [&](ProcessData& block) { blocks += describe(block); });
+  UNPLUG_CHECK(blocks == "32@1000 n60@0 n61@31|32@1032 n62@0|32@1064 n63@6|4@1096 n64@3|");
+  // the host context is left untouched
+  UNPLUG_CHECK(host.context.projectTimeSamples == 1000);
+}
+
+UNPLUG_TEST(fixedBlocksDelayEventsWithTheAudio)
+{
+  auto parameters = unplug::ParameterStorage{};
+  auto adapter = BlockAdapter{};
+  adapter.setMode(BlockAdapter::Mode::fixedBlockSize, 64);
+  adapter.setup({ 1 }, { 1 }, unplug::FloatingPointPrecision::float32);
+  Host host;
+  auto blocks = std::string{};
+  auto const processing = [&](ProcessData& block) { blocks += describe(block); };
+  for (int32 hostBlock = 0; hostBlock < 4; ++hostBlock) {
+    host.clear();
+    if (hostBlock == 0) {
+      host.addNoteOn(10, 60);
+    }
+    if (hostBlock == 1) {
+      // the memory of a SysEx event is only valid during this call, so it can not be delayed
+      auto sysEx = Event{};
+      sysEx.type = Event::kDataEvent;
+      sysEx.sampleOffset = 5;
+      host.events.addEvent(sysEx);
+      host.addNoteOn(30, 61);
+    }
+    auto data = host.makeBlock(40, 1000 + 40 * hostBlock);
+    adapter.process<float>(data, parameters, processing);
+  }
+  // the first fixed block holds the first 64 samples: it is processed during the second host block
+  UNPLUG_CHECK(blocks == "64@1000 n60@10|64@1064 n61@6|");
+}
+
+UNPLUG_TEST(fixedBlocksGroupThePointsOfEachParameter)
+{
+  auto parameters = unplug::ParameterStorage{};
+  auto adapter = BlockAdapter{};
+  adapter.setMode(BlockAdapter::Mode::fixedBlockSize, 64);
+  adapter.setup({ 1 }, { 1 }, unplug::FloatingPointPrecision::float32);
+  Host host;
+  auto blocks = std::string{};
+  auto const processing = [&](ProcessData& block) { blocks += describe(block, true); };
+  host.addPoint(2, 10, 0.2);
+  host.addPoint(2, 50, 0.6);
+  host.addPoint(2, 100, 1.0);
+  host.addPoint(1, 20, 0.5);
+  auto data = host.makeBlock(128, 0);
+  adapter.process<float>(data, parameters, processing);
+  host.clear();
+  host.addPoint(1, 0, 1.0);
+  data = host.makeBlock(64, 128);
+  adapter.process<float>(data, parameters, processing);
+  // the automation of parameter 2 is interpolated at the end of the first fixed block
+  UNPLUG_CHECK(blocks == "64@0 p1:50@20, p2:20@10,60@50,71@64,|64@64 p2:100@36,|64@128 p1:100@0,|");
+}
@@ -0,0 +1,211 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Controller.hpp"
+#include "Parameters.hpp"
+#include "Processor.hpp"
+#include "Test.hpp"
+#include "base/source/fobject.h"
+#include "base/source/fstreamer.h"
+#include "public.sdk/source/common/memorystream.h"
+#include "public.sdk/source/vst/hosting/hostclasses.h"
+#include "unplug/Serialization.hpp"
+#include <vector>
+
+// the midi mapping saved and restored with the state of the processor, and loaded by the controller
+namespace {
+
+using namespace Steinberg;
+using namespace Steinberg::Vst;
+using namespace unplug::Serialization;
+
+class CountingComponentHandler final
+  : public FObject
+  , public IComponentHandler
+{
+public:
+  tresult PLUGIN_API beginEdit(ParamID /*id*/) override
+  {
+    return kResultTrue;
+  }
+
+  tresult PLUGIN_API performEdit(ParamID /*id*/, ParamValue /*valueNormalized*/) override
+  {
+    return kResultTrue;
+  }
+
+  tresult PLUGIN_API endEdit(ParamID /*id*/) override
+  {
+    return kResultTrue;
+  }
+
+  tresult PLUGIN_API restartComponent(int32 flags) override
+  {
+    restartFlags.push_back(flags);
+    return kResultTrue;
+  }
+
+  std::vector<int32> restartFlags;
+
+  OBJ_METHODS(CountingComponentHandler, FObject)
+  DEFINE_INTERFACES
+  DEF_INTERFACE(IComponentHandler)
+  END_DEFINE_INTERFACES(FObject)
+  REFCOUNT_METHODS(FObject)
+};
+
+struct Fixture final
+{
+  Fixture()
+  {
+    processor->initialize(host);
+    controller->initialize(host);
+    controller->setComponentHandler(handler);
+  }
+
+  ~Fixture()
+  {
+    controller->setComponentHandler(nullptr);
+    controller->terminate();
+    processor->terminate();
+  }
+
+  bool isMapped(int controllerNumber) const
+  {
+    ParamID id = 0;
+    return controller->getMidiControllerAssignment(0, 0, static_cast<CtrlNumber>(controllerNumber), id) == kResultTrue &&
+           id == Param::gain;
+  }
+
+  IPtr<IHostApplication> host = owned(static_cast<IHostApplication*>(new HostApplication));
+  IPtr<Processor> processor = owned(new Processor);
+  IPtr<Controller> controller = owned(new Controller);
+  IPtr<CountingComponentHandler> handler = owned(new CountingComponentHandler);
+};
+
+// a chunked state with the values of numParameters parameters, and a midi mapping chunk if given one
+void writeState(MemoryStream& memory,
+                unplug::detail::MidiMapping const* midiMapping,
+                unplug::Index numParameters = NumParameters::value)
+{
+  auto stream = IBStreamer(&memory, kLittleEndian);
+  UNPLUG_CHECK(writeStateHeader(stream, { 1, 0, 0, 0 }));
+  auto const values = std::vector<double>(numParameters, 0.5);
+  UNPLUG_CHECK(writeChunk(stream, ChunkTag::parameters, [&] { return writeParameterBlock(stream, values); }));
+  if (midiMapping) {
+    UNPLUG_CHECK(
+      writeChunk(stream, ChunkTag::midiMapping, [&] { return writeMidiMappingBlock(stream, *midiMapping); }));
+  }
+  UNPLUG_CHECK(writeEndChunk(stream));
+  memory.seek(0, IBStream::kIBSeekSet, nullptr);
+}
+
+// the midi mapping chunk of the state saved by the processor
+unplug::detail::MidiMapping readSavedMidiMapping(Processor& processor)
+{
+  MemoryStream memory;
+  UNPLUG_CHECK(processor.getState(&memory) == kResultOk);
+  memory.seek(0, IBStream::kIBSeekSet, nullptr);
+  auto stream = IBStreamer(&memory, kLittleEndian);
+  auto version = std::array<int, 4>{};
+  auto format = StateFormat::legacy;
+  UNPLUG_CHECK(readStateHeader(stream, version, format));
+  UNPLUG_CHECK(format == StateFormat::chunked);
+  auto midiMapping = unplug::detail::MidiMapping{};
+  UNPLUG_CHECK(readChunks(stream, [&](uint32_t tag, int64_t) {
+    return tag == ChunkTag::midiMapping ? readMidiMappingBlock(stream, midiMapping, NumParameters::value) : true;
+  }));
+  return midiMapping;
+}
+
+} // namespace
+
+UNPLUG_TEST(processorRoundTripsTheMidiMapping)
+{
+  Fixture fixture;
+  auto saved = unplug::detail::MidiMapping{};
+  saved.mapParameter(Param::gain, 7, 0);
+  saved.mapParameter(Param::adaptiveQuality, 11, 3);
+  MemoryStream memory;
+  writeState(memory, &saved);
+  UNPLUG_CHECK(fixture.processor->setState(&memory) == kResultOk);
+  auto const loaded = readSavedMidiMapping(*fixture.processor);
+  UNPLUG_CHECK(loaded == saved);
+  UNPLUG_CHECK(loaded.getParameter(7, 0) == Param::gain);
+  UNPLUG_CHECK(loaded.getParameter(11, 3) == Param::adaptiveQuality);
+}
+
+UNPLUG_TEST(assignmentsOfParametersThatNoLongerExistAreDropped)
+{
+  Fixture fixture;
+  // saved by a version of the plugin with more parameters
+  auto const numSavedParameters = NumParameters::value + 3;
+  auto saved = unplug::detail::MidiMapping{};
+  saved.mapParameter(Param::gain, 7, 0);
+  saved.mapParameter(static_cast<unplug::ParamIndex>(numSavedParameters - 1), 12, 0);
+  MemoryStream memory;
+  writeState(memory, &saved, numSavedParameters);
+  UNPLUG_CHECK(fixture.processor->setState(&memory) == kResultOk);
+  auto const loaded = readSavedMidiMapping(*fixture.processor);
+  UNPLUG_CHECK(loaded.getParameter(7, 0) == Param::gain);
+  UNPLUG_CHECK(loaded.getParameter(12, 0) == unplug::detail::MidiMapping::unmapped);
+  UNPLUG_CHECK(loaded.getAssignments().size() == 1);
+  memory.seek(0, IBStream::kIBSeekSet, nullptr);
+  UNPLUG_CHECK(fixture.controller->setComponentState(&memory) == kResultOk);
+  UNPLUG_CHECK(fixture.isMapped(7));
+  ParamID id = 0;
+  UNPLUG_CHECK(fixture.controller->getMidiControllerAssignment(0, 0, 12, id) != kResultTrue);
+}
+
+UNPLUG_TEST(loadingAStateRestartsTheComponentOnce)
+{
+  Fixture fixture;
+  auto saved = unplug::detail::MidiMapping{};
+  saved.mapParameter(Param::gain, 11, 0);
+  MemoryStream memory;
+  writeState(memory, &saved);
+  // both the latency parameters and the mapping change
+  UNPLUG_CHECK(fixture.controller->setComponentState(&memory) == kResultOk);
+  UNPLUG_CHECK(fixture.handler->restartFlags.size() == 1);
+  UNPLUG_CHECK(fixture.handler->restartFlags[0] == (kLatencyChanged | kMidiCCAssignmentChanged));
+  // nothing changes when the same state is loaded again
+  memory.seek(0, IBStream::kIBSeekSet, nullptr);
+  UNPLUG_CHECK(fixture.controller->setComponentState(&memory) == kResultOk);
+  UNPLUG_CHECK(fixture.handler->restartFlags.size() == 1);
+}
+
+UNPLUG_TEST(stateWithMidiMappingReplacesTheLearnedOne)
+{
+  Fixture fixture;
+  fixture.controller->midiMapping.mapParameter(Param::gain, 7, 0);
+  auto saved = unplug::detail::MidiMapping{};
+  saved.mapParameter(Param::gain, 11, 0);
+  MemoryStream memory;
+  writeState(memory, &saved);
+  UNPLUG_CHECK(fixture.controller->setComponentState(&memory) == kResultOk);
+  UNPLUG_CHECK(!fixture.isMapped(7));
+  UNPLUG_CHECK(fixture.isMapped(11));
+}
+
+UNPLUG_TEST(stateWithoutMidiMappingRestoresTheDefaultOne)
+{
+  Fixture fixture;
+  fixture.controller->midiMapping.mapParameter(Param::gain, 7, 0);
+  UNPLUG_CHECK(fixture.isMapped(7));
+  MemoryStream memory;
+  writeState(memory, nullptr);
+  UNPLUG_CHECK(fixture.controller->setComponentState(&memory) == kResultOk);
+  // the parameters of the gain example have no default midi mapping
+  UNPLUG_CHECK(!fixture.isMapped(7));
+}
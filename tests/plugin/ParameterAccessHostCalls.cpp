@@ -0,0 +1,158 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Controller.hpp"
+#include "Parameters.hpp"
+#include "Test.hpp"
+#include "base/source/fobject.h"
+#include "unplug/detail/Vst3ParameterAccess.hpp"
+#include <string>
+
+// counts the calls that the ParameterAccess makes to the host while the user interface edits the parameters
+namespace {
+
+using namespace Steinberg;
+using namespace Steinberg::Vst;
+
+class CountingComponentHandler final
+  : public FObject
+  , public IComponentHandler
+{
+public:
+  tresult PLUGIN_API beginEdit(ParamID id) override
+  {
+    calls += "b" + std::to_string(id) + " ";
+    return kResultTrue;
+  }
+
+  tresult PLUGIN_API performEdit(ParamID id, ParamValue /*valueNormalized*/) override
+  {
+    calls += "p" + std::to_string(id) + " ";
+    return kResultTrue;
+  }
+
+  tresult PLUGIN_API endEdit(ParamID id) override
+  {
+    calls += "e" + std::to_string(id) + " ";
+    return kResultTrue;
+  }
+
+  tresult PLUGIN_API restartComponent(int32 /*flags*/) override
+  {
+    return kResultTrue;
+  }
+
+  std::string calls;
+
+  OBJ_METHODS(CountingComponentHandler, FObject)
+  DEFINE_INTERFACES
+  DEF_INTERFACE(IComponentHandler)
+  END_DEFINE_INTERFACES(FObject)
+  REFCOUNT_METHODS(FObject)
+};
+
+struct Fixture final
+{
+  Fixture()
+  {
+    controller->initialize(nullptr);
+    controller->setComponentHandler(handler);
+  }
+
+  ~Fixture()
+  {
+    controller->setComponentHandler(nullptr);
+    controller->terminate();
+  }
+
+  IPtr<Controller> controller = owned(new Controller);
+  IPtr<CountingComponentHandler> handler = owned(new CountingComponentHandler);
+  unplug::vst3::ParameterAccess parameters{ *controller, controller->midiMapping };
+};
+
+auto const gain = std::to_string(Param::gain);
+auto const quality = std::to_string(Param::adaptiveQuality);
+constexpr auto control = unplug::ControlId{ 1 };
+constexpr auto otherControl = unplug::ControlId{ 2 };
+
+} // namespace
+
+UNPLUG_TEST(eachEditOutsideOfBatchesReachesTheHost)
+{
+  Fixture fixture;
+  auto& parameters = fixture.parameters;
+  parameters.beginEdit(Param::gain, control);
+  parameters.setValueNormalized(Param::gain, 0.1);
+  parameters.setValueNormalized(Param::gain, 0.2);
+  parameters.endEdit(Param::gain);
+  UNPLUG_CHECK(fixture.handler->calls == "b" + gain + " p" + gain + " p" + gain + " e" + gain + " ");
+  UNPLUG_CHECK(fixture.controller->getParamNormalized(Param::gain) == 0.2);
+}
+
+UNPLUG_TEST(batchCoalescesEditsToOnePerformEditPerParameter)
+{
+  Fixture fixture;
+  auto& parameters = fixture.parameters;
+  parameters.beginBatchEdit();
+  parameters.beginEdit(Param::gain, control);
+  parameters.beginEdit(Param::adaptiveQuality, otherControl);
+  for (int i = 0; i < 10; ++i) {
+    parameters.setValueNormalized(Param::adaptiveQuality, 0.1 * i);
+    parameters.setValueNormalized(Param::gain, 0.05 * i);
+  }
+  UNPLUG_CHECK(fixture.handler->calls == "b" + gain + " b" + quality + " ");
+  // the pending value is visible to the user interface before it reaches the host
+  UNPLUG_CHECK(parameters.getValueNormalized(Param::gain) == 0.05 * 9);
+  parameters.endBatchEdit();
+  // flushed in the order of the first edit of each parameter
+  UNPLUG_CHECK(fixture.handler->calls == "b" + gain + " b" + quality + " p" + quality + " p" + gain + " ");
+  parameters.endEdit(Param::gain);
+  parameters.endEdit(Param::adaptiveQuality);
+  UNPLUG_CHECK(fixture.handler->calls.ends_with("e" + gain + " e" + quality + " "));
+  UNPLUG_CHECK(fixture.controller->getParamNormalized(Param::gain) == 0.05 * 9);
+}
+
+UNPLUG_TEST(endEditInsideOfBatchFlushesBeforeClosingTheGesture)
+{
+  Fixture fixture;
+  auto& parameters = fixture.parameters;
+  parameters.beginBatchEdit();
+  parameters.beginEdit(Param::gain, control);
+  parameters.setValueNormalized(Param::gain, 0.3);
+  parameters.setValueNormalized(Param::gain, 0.4);
+  parameters.endEdit(Param::gain);
+  parameters.endBatchEdit();
+  UNPLUG_CHECK(fixture.handler->calls == "b" + gain + " p" + gain + " e" + gain + " ");
+  UNPLUG_CHECK(fixture.controller->getParamNormalized(Param::gain) == 0.4);
+}
+
+UNPLUG_TEST(nestedBatchesFlushOnlyAtTheOutermostEnd)
+{
+  Fixture fixture;
+  auto& parameters = fixture.parameters;
+  parameters.beginEdit(Param::gain, control);
+  parameters.beginBatchEdit();
+  parameters.beginBatchEdit();
+  parameters.setValueNormalized(Param::gain, 0.5);
+  parameters.endBatchEdit();
+  UNPLUG_CHECK(fixture.handler->calls == "b" + gain + " ");
+  parameters.setValueNormalized(Param::gain, 0.6);
+  parameters.endBatchEdit();
+  UNPLUG_CHECK(fixture.handler->calls == "b" + gain + " p" + gain + " ");
+  // a new batch starts from a clean state
+  parameters.beginBatchEdit();
+  parameters.endBatchEdit();
+  parameters.endEdit(Param::gain);
+  UNPLUG_CHECK(fixture.handler->calls == "b" + gain + " p" + gain + " e" + gain + " ");
+}
@@ -0,0 +1,183 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Test.hpp"
+#include "unplug/RingBuffer.hpp"
+#include <cstdint>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+// the planar layout of RingBuffer holds the same points as the interleaved one
+namespace {
+
+using namespace unplug;
+
+using InterleavedBuffer = RingBuffer<float>;
+using PlanarBuffer = RingBuffer<float, std::allocator<float>, RingBufferLayout::planar>;
+using InterleavedWaveform = WaveformRingBuffer<float>;
+using PlanarWaveform = WaveformRingBuffer<float, std::allocator<WaveformElement<float>>, RingBufferLayout::planar>;
+
+RingBufferSettings makeSettings(Index numChannels, float durationInSeconds = 4.f)
+{
+  auto settings = RingBufferSettings{};
+  settings.context.sampleRate = 48000.f;
+  settings.context.maxAudioBlockSize = 512;
+  settings.context.numIO.numOuts = numChannels;
+  settings.context.userInterfaceRefreshRate = 30.f;
+  settings.pointsPerSecond = 1000.f;
+  settings.durationInSeconds = durationInSeconds;
+  settings.readerTimeoutInSeconds = 1e9f;
+  return settings;
+}
+
+// random blocks of random length, sent to every ring buffer
+class Signal final
+{
+public:
+  explicit Signal(Index numChannels)
+    : channels(numChannels, std::vector<float>(512))
+    , pointers(numChannels)
+  {}
+
+  template<class... RingBuffers>
+  void send(int numBlocks, RingBuffers&... ringBuffers)
+  {
+    auto const numChannels = static_cast<Index>(channels.size());
+    for (int block = 0; block < numBlocks; ++block) {
+      for (Index channel = 0; channel < numChannels; ++channel) {
+        for (auto& sample : channels[channel]) {
+          sample = distribution(generator);
+        }
+        pointers[channel] = channels[channel].data();
+      }
+      auto const numSamples = static_cast<Index>(1 + generator() % 512);
+      (send(ringBuffers, numChannels, numSamples), ...);
+    }
+  }
+
+private:
+  template<class RingBuffer>
+  void send(RingBuffer& ringBuffer, Index numChannels, Index numSamples)
+  {
+    if constexpr (std::is_same_v<typename RingBuffer::Buffer::value_type, float>) {
+      UNPLUG_CHECK(sendToRingBuffer(ringBuffer, pointers.data(), numChannels, 0, numSamples));
+    }
+    else {
+      UNPLUG_CHECK(sendToWaveformRingBuffer(ringBuffer, pointers.data(), numChannels, 0, numSamples));
+    }
+  }
+
+  std::vector<std::vector<float>> channels;
+  std::vector<float*> pointers;
+  std::mt19937 generator{ 1 };
+  std::uniform_real_distribution<float> distribution{ -1.f, 1.f };
+};
+
+bool haveTheSamePoints(InterleavedBuffer& interleaved, PlanarBuffer& planar, Index endPoint, Index firstPoint = 0)
+{
+  if (interleaved.getWritePosition() != planar.getWritePosition()) {
+    return false;
+  }
+  for (Index channel = 0; channel < interleaved.getNumChannels(); ++channel) {
+    for (Index point = firstPoint; point < endPoint; ++point) {
+      if (interleaved.at(channel, point) != planar.at(channel, point)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+UNPLUG_TEST(planarAndInterleavedLayoutsHoldTheSamePoints)
+{
+  for (Index numChannels : { 1, 2, 3, 8 }) {
+    auto interleaved = InterleavedBuffer{ makeSettings(numChannels) };
+    auto planar = PlanarBuffer{ makeSettings(numChannels) };
+    auto interleavedWaveform = InterleavedWaveform{ makeSettings(numChannels) };
+    auto planarWaveform = PlanarWaveform{ makeSettings(numChannels) };
+    interleaved.markAsRead();
+    planar.markAsRead();
+    interleavedWaveform.markAsRead();
+    planarWaveform.markAsRead();
+    Signal{ numChannels }.send(500, interleaved, planar, interleavedWaveform, planarWaveform);
+    UNPLUG_CHECK(haveTheSamePoints(interleaved, planar, interleaved.getBufferCapacity()));
+    for (Index channel = 0; channel < numChannels; ++channel) {
+      for (Index point = 0; point < interleavedWaveform.getBufferCapacity(); ++point) {
+        UNPLUG_CHECK(interleavedWaveform.at(channel, point).positive == planarWaveform.at(channel, point).positive);
+        UNPLUG_CHECK(interleavedWaveform.at(channel, point).negative == planarWaveform.at(channel, point).negative);
+      }
+    }
+  }
+}
+
+UNPLUG_TEST(planarChannelsStartOnACacheLine)
+{
+  for (Index numChannels : { 1, 2, 3, 8 }) {
+    auto planar = PlanarBuffer{ makeSettings(numChannels) };
+    auto planarWaveform = PlanarWaveform{ makeSettings(numChannels) };
+    for (Index channel = 0; channel < numChannels; ++channel) {
+      UNPLUG_CHECK(reinterpret_cast<std::uintptr_t>(&planar.at(channel, 0)) % 64 == 0);
+      UNPLUG_CHECK(reinterpret_cast<std::uintptr_t>(&planarWaveform.at(channel, 0)) % 64 == 0);
+      UNPLUG_CHECK(planar.getPointStride() == 1);
+    }
+  }
+}
+
+UNPLUG_TEST(resizingKeepsTheSamePointsInBothLayouts)
+{
+  for (Index numChannels : { 1, 2, 3, 8 }) {
+    auto interleaved = InterleavedBuffer{ makeSettings(numChannels) };
+    auto planar = PlanarBuffer{ makeSettings(numChannels) };
+    interleaved.markAsRead();
+    planar.markAsRead();
+    Signal{ numChannels }.send(500, interleaved, planar);
+    // smaller than the write position, so that the newest points are moved to the start
+    interleaved.setResolution(1000.f, 1.f);
+    planar.setResolution(1000.f, 1.f);
+    UNPLUG_CHECK(interleaved.getBufferCapacity() == planar.getBufferCapacity());
+    UNPLUG_CHECK(haveTheSamePoints(interleaved, planar, interleaved.getBufferCapacity()));
+    auto const previousCapacity = interleaved.getBufferCapacity();
+    interleaved.setResolution(1000.f, 8.f);
+    planar.setResolution(1000.f, 8.f);
+    UNPLUG_CHECK(haveTheSamePoints(interleaved, planar, previousCapacity));
+    // new channels after a context change
+    auto settings = makeSettings(numChannels + 1, 8.f);
+    interleaved.setContext(settings.context);
+    planar.setContext(settings.context);
+    UNPLUG_CHECK(planar.getNumChannels() == numChannels + 1);
+    // the interleaved layout does not move the old points to the new channels, so only the new ones are compared
+    auto const firstNewPoint = planar.getWritePosition();
+    Signal{ numChannels + 1 }.send(100, interleaved, planar);
+    UNPLUG_CHECK(haveTheSamePoints(interleaved, planar, planar.getWritePosition(), firstNewPoint));
+  }
+}
+
+UNPLUG_TEST(markAsReadReturnsThePointsWrittenSinceThePreviousRead)
+{
+  auto planar = PlanarBuffer{ makeSettings(2) };
+  UNPLUG_CHECK(planar.markAsRead() == 0);
+  auto left = std::vector<float>(480, 0.5f);
+  auto right = std::vector<float>(480, 0.5f);
+  float* channels[] = { left.data(), right.data() };
+  UNPLUG_CHECK(sendToRingBuffer(planar, channels, 2, 0, 480));
+  auto const firstWritePosition = planar.getWritePosition();
+  UNPLUG_CHECK(firstWritePosition > 0);
+  UNPLUG_CHECK(planar.markAsRead() == firstWritePosition);
+  UNPLUG_CHECK(planar.markAsRead() == 0);
+  UNPLUG_CHECK(sendToRingBuffer(planar, channels, 2, 0, 480));
+  UNPLUG_CHECK(planar.markAsRead() == planar.getWritePosition() - firstWritePosition);
+}
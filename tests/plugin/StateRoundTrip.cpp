@@ -0,0 +1,187 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "Controller.hpp"
+#include "Parameters.hpp"
+#include "Processor.hpp"
+#include "Test.hpp"
+#include "base/source/fstreamer.h"
+#include "public.sdk/source/common/memorystream.h"
+#include "public.sdk/source/vst/hosting/hostclasses.h"
+#include "unplug/Serialization.hpp"
+
+// the chunked state format through the processor and the controller, and its tolerance to states saved by other
+// versions of a plugin
+namespace {
+
+using namespace Steinberg;
+using namespace Steinberg::Vst;
+using namespace unplug::Serialization;
+
+constexpr auto unknownTag = makeChunkTag('N', 'E', 'W', '!');
+
+struct Fixture final
+{
+  Fixture()
+  {
+    processor->initialize(host);
+    controller->initialize(host);
+  }
+
+  ~Fixture()
+  {
+    controller->terminate();
+    processor->terminate();
+  }
+
+  IPtr<IHostApplication> host = owned(static_cast<IHostApplication*>(new HostApplication));
+  IPtr<Processor> processor = owned(new Processor);
+  IPtr<Controller> controller = owned(new Controller);
+};
+
+// a state with a parameter block holding the values, and an unknown chunk after it if requested
+void writeState(MemoryStream& memory, std::vector<double> const& values, bool withUnknownChunk = false)
+{
+  auto stream = IBStreamer(&memory, kLittleEndian);
+  UNPLUG_CHECK(writeStateHeader(stream, { 1, 2, 3, 4 }));
+  UNPLUG_CHECK(writeChunk(stream, ChunkTag::parameters, [&] { return writeParameterBlock(stream, values); }));
+  if (withUnknownChunk) {
+    UNPLUG_CHECK(
+      writeChunk(stream, unknownTag, [&] { return stream.writeInt64(42) && stream.writeStr8("from the future"); }));
+  }
+  UNPLUG_CHECK(writeEndChunk(stream));
+  memory.seek(0, IBStream::kIBSeekSet, nullptr);
+}
+
+// the values in the parameter block of the state saved by the processor
+std::vector<double> readSavedValues(Processor& processor)
+{
+  MemoryStream memory;
+  UNPLUG_CHECK(processor.getState(&memory) == kResultOk);
+  memory.seek(0, IBStream::kIBSeekSet, nullptr);
+  auto stream = IBStreamer(&memory, kLittleEndian);
+  auto version = std::array<int, 4>{};
+  auto format = StateFormat::legacy;
+  UNPLUG_CHECK(readStateHeader(stream, version, format));
+  UNPLUG_CHECK(format == StateFormat::chunked);
+  auto values = std::vector<double>(unplug::NumParameters::value, -1.0);
+  UNPLUG_CHECK(readChunks(stream, [&](uint32_t tag, int64_t) {
+    return tag == ChunkTag::parameters ? readParameterBlock(stream, values) : true;
+  }));
+  return values;
+}
+
+std::vector<double> getControllerValues(Controller& controller)
+{
+  auto values = std::vector<double>(unplug::NumParameters::value);
+  for (int i = 0; i < unplug::NumParameters::value; ++i) {
+    values[i] = controller.getParamNormalized(static_cast<ParamID>(i));
+  }
+  return values;
+}
+
+// values that are all different from the defaults, and valid steps of the discrete parameters
+std::vector<double> makeValues()
+{
+  auto values = std::vector<double>(unplug::NumParameters::value);
+  values[Param::bypass] = 1.0;
+  values[Param::gain] = 0.25;
+  values[Param::oversamplingOrder] = 0.4;
+  values[Param::oversamplingLinearPhase] = 1.0;
+  values[Param::adaptiveQuality] = 1.0;
+  return values;
+}
+
+} // namespace
+
+UNPLUG_TEST(stateRoundTrip)
+{
+  Fixture fixture;
+  auto const values = makeValues();
+  MemoryStream memory;
+  writeState(memory, values);
+  UNPLUG_CHECK(fixture.processor->setState(&memory) == kResultOk);
+  UNPLUG_CHECK(readSavedValues(*fixture.processor) == values);
+  // the host gives the state saved by the processor to the controller
+  MemoryStream saved;
+  UNPLUG_CHECK(fixture.processor->getState(&saved) == kResultOk);
+  saved.seek(0, IBStream::kIBSeekSet, nullptr);
+  UNPLUG_CHECK(fixture.controller->setComponentState(&saved) == kResultOk);
+  UNPLUG_CHECK(getControllerValues(*fixture.controller) == values);
+}
+
+UNPLUG_TEST(unknownChunksAreSkipped)
+{
+  Fixture fixture;
+  auto const values = makeValues();
+  MemoryStream memory;
+  writeState(memory, values, true);
+  UNPLUG_CHECK(fixture.processor->setState(&memory) == kResultOk);
+  UNPLUG_CHECK(readSavedValues(*fixture.processor) == values);
+  memory.seek(0, IBStream::kIBSeekSet, nullptr);
+  UNPLUG_CHECK(fixture.controller->setComponentState(&memory) == kResultOk);
+  UNPLUG_CHECK(getControllerValues(*fixture.controller) == values);
+}
+
+UNPLUG_TEST(stateFromVersionWithMoreParameters)
+{
+  Fixture fixture;
+  auto values = makeValues();
+  values.push_back(0.5);
+  values.push_back(0.75);
+  MemoryStream memory;
+  writeState(memory, values);
+  UNPLUG_CHECK(fixture.processor->setState(&memory) == kResultOk);
+  memory.seek(0, IBStream::kIBSeekSet, nullptr);
+  UNPLUG_CHECK(fixture.controller->setComponentState(&memory) == kResultOk);
+  // the values of the parameters that no longer exist are ignored
+  auto const existingValues = std::vector<double>(values.begin(), values.begin() + unplug::NumParameters::value);
+  UNPLUG_CHECK(readSavedValues(*fixture.processor) == existingValues);
+  UNPLUG_CHECK(getControllerValues(*fixture.controller) == existingValues);
+}
+
+UNPLUG_TEST(stateFromVersionWithLessParameters)
+{
+  Fixture fixture;
+  auto const defaultValues = getControllerValues(*fixture.controller);
+  auto values = makeValues();
+  values.pop_back();
+  MemoryStream memory;
+  writeState(memory, values);
+  UNPLUG_CHECK(fixture.processor->setState(&memory) == kResultOk);
+  memory.seek(0, IBStream::kIBSeekSet, nullptr);
+  UNPLUG_CHECK(fixture.controller->setComponentState(&memory) == kResultOk);
+  // the parameters added since then keep their current value
+  values.push_back(defaultValues.back());
+  UNPLUG_CHECK(readSavedValues(*fixture.processor) == values);
+  UNPLUG_CHECK(getControllerValues(*fixture.controller) == values);
+}
+
+UNPLUG_TEST(legacyStateIsLoadedByTheController)
+{
+  Fixture fixture;
+  auto const values = makeValues();
+  MemoryStream memory;
+  {
+    auto stream = IBStreamer(&memory, kLittleEndian);
+    auto const version = std::array<int, 4>{ 0, 9, 0, 1 };
+    UNPLUG_CHECK(stream.writeInt32Array(version.data(), 4));
+    for (auto value : values) {
+      UNPLUG_CHECK(stream.writeDouble(value));
+    }
+  }
+  memory.seek(0, IBStream::kIBSeekSet, nullptr);
+  UNPLUG_CHECK(fixture.controller->setComponentState(&memory) == kResultOk);
+  UNPLUG_CHECK(getControllerValues(*fixture.controller) == values);
+}
@@ -0,0 +1,163 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include "unplug/Index.hpp"
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace unplug {
+
+/**
+ * A report of the memory used by an Arena.
+ * */
+struct ArenaFootprint final
+{
+  /** The memory obtained from the operating system, pre-faulted. */
+  std::size_t reservedBytes = 0;
+  /** The memory currently allocated from the arena. */
+  std::size_t usedBytes = 0;
+  /** The maximum value reached by usedBytes. */
+  std::size_t peakUsedBytes = 0;
+  /** The part of reservedBytes that is locked in physical memory. */
+  std::size_t lockedBytes = 0;
+  /** The memory currently allocated from the general heap because the operating system refused to give more. */
+  std::size_t heapFallbackBytes = 0;
+  Index numChunks = 0;
+};
+
+/**
+ * An allocator for the buffers used on the audio thread. It obtains memory from the operating system in chunks, writes
+ * to every page of a chunk as soon as it is obtained, so that page faults happen on the thread that allocates (during
+ * setActive) and not on the audio thread, and optionally locks the chunks in physical memory so that they are not
+ * paged out. Freed memory is kept by the arena and reused by the next allocations; chunks are given back to the
+ * operating system only on destruction.
+ * Allocation and deallocation take a lock and are not meant to be used on the audio thread.
+ * */
+class Arena final
+{
+public:
+  static constexpr std::size_t defaultChunkSize = 1 << 20;
+
+  /**
+   * @chunkSize the minimum size of the memory chunks requested to the operating system
+   * @lockMemory whether to lock the chunks in physical memory. If the operating system refuses to lock them, for
+   * example because of the RLIMIT_MEMLOCK limit, they are used unlocked, see ArenaFootprint::lockedBytes.
+   * */
+  explicit Arena(std::size_t chunkSize = defaultChunkSize, bool lockMemory = false);
+
+  ~Arena();
+
+  Arena(Arena const&) = delete;
+
+  Arena& operator=(Arena const&) = delete;
+
+  /**
+   * Makes sure that at least the specified amount of contiguous memory is available, so that the next allocations up
+   * to that size will not need to request memory to the operating system.
+   * */
+  void reserve(std::size_t bytes);
+
+  void* allocate(std::size_t bytes, std::size_t alignment);
+
+  /**
+   * Gives back memory obtained with allocate, with the same size and alignment.
+   * */
+  void deallocate(void* pointer, std::size_t bytes, std::size_t alignment);
+
+  ArenaFootprint getFootprint() const;
+
+private:
+  struct Chunk final
+  {
+    std::byte* memory;
+    std::size_t size;
+    bool isLocked;
+  };
+
+  bool addChunk(std::size_t minSize);
+  void addFreeRange(std::byte* begin, std::size_t size);
+  bool owns(void* pointer) const;
+
+  std::size_t const chunkSize;
+  bool const lockMemory;
+  mutable std::mutex mutex;
+  std::vector<Chunk> chunks;
+  std::map<std::byte*, std::size_t> freeRanges;
+  ArenaFootprint footprint;
+};
+
+/**
+ * A standard allocator that gets its memory from an Arena. It can be used as the Allocator template argument of
+ * RingBuffer and of standard containers. A default constructed ArenaAllocator is not bound to any arena and uses the
+ * general heap. It is not final because the standard containers may derive from their allocator.
+ * */
+template<class T>
+class ArenaAllocator
+{
+public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  ArenaAllocator() noexcept = default;
+
+  explicit ArenaAllocator(Arena& arena) noexcept
+    : arena{ &arena }
+  {}
+
+  template<class U>
+  ArenaAllocator(ArenaAllocator<U> const& other) noexcept
+    : arena{ other.getArena() }
+  {}
+
+  T* allocate(std::size_t n)
+  {
+    if (arena) {
+      return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{ alignof(T) }));
+  }
+
+  void deallocate(T* pointer, std::size_t n) noexcept
+  {
+    if (arena) {
+      arena->deallocate(pointer, n * sizeof(T), alignof(T));
+    }
+    else {
+      ::operator delete(pointer, std::align_val_t{ alignof(T) });
+    }
+  }
+
+  Arena* getArena() const noexcept
+  {
+    return arena;
+  }
+
+  template<class U>
+  bool operator==(ArenaAllocator<U> const& other) const noexcept
+  {
+    return arena == other.getArena();
+  }
+
+private:
+  Arena* arena = nullptr;
+};
+
+} // namespace unplug
@@ -19,7 +19,13 @@
 
 namespace unplug {
 /**
- * LinearAutomation provides the logic and the buffer to automate the plugin parameters using linear interpolation
+ * LinearAutomation provides the logic and the buffer to automate the plugin parameters using linear interpolation.
+ * It is meant to be owned by the dsp state and reused across processing blocks. It keeps a snapshot of the parameter
+ * storage, so the parameters that are not automated hold the same value for the whole block and reading them costs no
+ * more than reading an automated one. At the start of each block prepare refreshes the snapshot reading only the
+ * parameters that have been set since the previous block, see ParameterStorage::getNumChanges. Only the parameters that
+ * receive automation events in the current block are tracked, so the cost of a block depends on the number of automated
+ * and changed parameters and not on the total number of parameters.
  * */
 template<class SampleType>
 struct LinearAutomation
@@ -30,7 +36,14 @@ struct LinearAutomation
     SampleType delta = 0.f;
   };
 
+  ParameterStorage const* parameterStorage = nullptr;
   std::array<ParameterCache, unplug::NumParameters::value> parameters;
+  std::array<bool, unplug::NumParameters::value> isAutomated{};
+  std::array<ParamIndex, unplug::NumParameters::value> automatedParameters;
+  Index numAutomatedParameters = 0;
+  // the number of changes of the parameter storage already in the snapshot
+  uint32_t numSeenChanges = 0;
+  bool hasSnapshot = false;
 
   /**
    * Computes the next value of the parameter. Call this one per frame.
@@ -39,21 +52,75 @@ struct LinearAutomation
    * */
   SampleType next(ParamIndex paramIndex)
   {
+    // the delta of the parameters that are not automated is zero
     auto& parameter = parameters[paramIndex];
     parameter.currentValue += parameter.delta;
     return parameter.currentValue;
   }
 
   /**
-   * Constructor
-   * @parameterStorage a reference to the parameter storage owned by the plugin processor
+   * @paramIndex the index of the parameter
+   * @return the current value of the parameter, without advancing the automation
    * */
-  explicit LinearAutomation(ParameterStorage const& parameterStorage)
+  SampleType get(ParamIndex paramIndex) const
+  {
+    return parameters[paramIndex].currentValue;
+  }
+
+  /**
+   * Starts a new processing block, forgetting the parameters automated in the previous one and refreshing the snapshot
+   * of the parameters that have been set since the previous block. The first time, or if more parameters have been set
+   * than the storage can log, all the parameters are read.
+   * */
+  void prepare()
+  {
+    // the parameters automated in the previous block are back to the value of their last point in the storage
+    for (Index i = 0; i < numAutomatedParameters; ++i) {
+      auto const paramIndex = automatedParameters[i];
+      isAutomated[paramIndex] = false;
+      parameters[paramIndex] = { static_cast<SampleType>(parameterStorage->get(paramIndex)), 0.f };
+    }
+    numAutomatedParameters = 0;
+    auto const numChanges = parameterStorage->getNumChanges();
+    bool isLogComplete = hasSnapshot && numChanges - numSeenChanges <= ParameterStorage::changeLogSize;
+    for (auto change = numSeenChanges; isLogComplete && change != numChanges; ++change) {
+      ParamIndex paramIndex = 0;
+      isLogComplete = parameterStorage->getChangedParameter(change, paramIndex);
+      if (isLogComplete) {
+        parameters[paramIndex].currentValue = static_cast<SampleType>(parameterStorage->get(paramIndex));
+      }
+    }
+    if (!isLogComplete) {
+      for (ParamIndex i = 0; i < unplug::NumParameters::value; ++i) {
+        parameters[i].currentValue = static_cast<SampleType>(parameterStorage->get(i));
+      }
+    }
+    numSeenChanges = numChanges;
+    hasSnapshot = true;
+  }
+
+  /**
+   * Sets the automation of a parameter for the following samples
+   * @paramIndex the index of the parameter
+   * @currentValue the value of the parameter at the current sample
+   * @delta the increment of the value of the parameter per sample
+   * */
+  void set(ParamIndex paramIndex, SampleType currentValue, SampleType delta)
   {
-    for (ParamIndex paramIndex = 0; paramIndex < unplug::NumParameters::value; ++paramIndex) {
-      parameters[paramIndex].currentValue = parameterStorage.get(paramIndex);
+    if (!isAutomated[paramIndex]) {
+      isAutomated[paramIndex] = true;
+      automatedParameters[numAutomatedParameters++] = paramIndex;
     }
+    parameters[paramIndex] = { currentValue, delta };
   }
+
+  /**
+   * Constructor
+   * @parameterStorage a reference to the parameter storage owned by the plugin processor
+   * */
+  explicit LinearAutomation(ParameterStorage const& parameterStorage)
+    : parameterStorage{ &parameterStorage }
+  {}
 };
 
 /**
@@ -65,10 +132,10 @@ template<class SampleType>
 void setParameterAutomation(LinearAutomation<SampleType>& automation,
                             AutomationEvent<SampleType> const& automationEvent)
 {
-  auto& parameter = automation.parameters[automationEvent.paramIndex];
-  parameter.currentValue = automationEvent.valueAtFirstSample;
-  parameter.delta = (automationEvent.valueAtLastSample - automationEvent.valueAtFirstSample) /
-                    (automationEvent.lastSample - automationEvent.firstSample);
+  automation.set(automationEvent.paramIndex,
+                 automationEvent.valueAtFirstSample,
+                 (automationEvent.valueAtLastSample - automationEvent.valueAtFirstSample) /
+                   (automationEvent.lastSample - automationEvent.firstSample));
 }
 
-} // namespace unplug
\ No newline at end of file
+} // namespace unplug
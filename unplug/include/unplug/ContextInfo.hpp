@@ -23,10 +23,23 @@ enum class FloatingPointPrecision
   float64
 };
 
+/**
+ * The mode in which the host is going to call process. In realtime mode, the processing has to keep up with the audio
+ * device. In prefetch mode, the host processes ahead of time, so the deadlines are more relaxed but still present. In
+ * offline mode there are no deadlines, as when the host renders a mixdown.
+ * */
+enum class ProcessMode
+{
+  realtime,
+  prefetch,
+  offline
+};
+
 /**
  * A struct holding the information about the context in which the process is happening, such as the audio block size,
  * the sample rate, the number inputs/outputs and their number of channels, the floating point precision, the current
- * amount of oversampling and the user interface framerate - which can be useful to resize ring buffers.
+ * amount of oversampling, the process mode and the user interface framerate - which can be useful to resize ring
+ * buffers.
  */
 struct ContextInfo final
 {
@@ -35,7 +48,29 @@ struct ContextInfo final
   float userInterfaceRefreshRate = 30;
   Index maxAudioBlockSize = 128;
   FloatingPointPrecision precision = FloatingPointPrecision::float32;
+  ProcessMode processMode = ProcessMode::realtime;
+
+  /**
+   * @return true if there are no deadlines for the processing, so that the most expensive settings can be used
+   * */
+  bool isOffline() const noexcept
+  {
+    return processMode == ProcessMode::offline;
+  }
 
+  /**
+   * Chooses a setting according to the process mode, for example a higher oversampling order or a larger FFT size for
+   * offline rendering. Call it from onSetup: the host can only change the process mode while the processor is not
+   * active, so the setting never changes while the audio is flowing. Keep in mind that a setting that changes the
+   * latency has to be reported with setLatency from onSetup as well.
+   * @param realtimeValue the setting used in the realtime and prefetch modes
+   * @param offlineValue the setting used in offline mode
+   * */
+  template<class T>
+  T chooseForProcessMode(T realtimeValue, T offlineValue) const
+  {
+    return isOffline() ? offlineValue : realtimeValue;
+  }
 
   bool operator==(ContextInfo const& other) const noexcept = default;
 };
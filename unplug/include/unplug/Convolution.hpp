@@ -0,0 +1,109 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include "unplug/Index.hpp"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace unplug {
+
+/**
+ * Convolution with long impulse responses, partitioned non-uniformly in two stages:
+ * - the head, the first 2 * tailBlockSize samples of the impulse response, is convolved on the audio thread with
+ * partitions of headBlockSize samples, so that there is no latency;
+ * - the tail, the rest of the impulse response, is convolved on a worker thread with partitions of tailBlockSize
+ * samples. Each tail block is posted when a block of input is complete, and it is needed a whole block later: this is
+ * its deadline. The worker polls for posted blocks every millisecond, so a tail block should last several
+ * milliseconds, and runs the pending blocks of all the channels earliest deadline first.
+ * The audio thread never waits for the worker: a tail block that is not ready by its deadline is replaced by silence
+ * and counted as a missed deadline. An input block that finds the queue of its channel full is not posted, so its
+ * tail is silent too.
+ * The impulse responses are prepared by setImpulseResponse on any thread but the audio one, and the audio thread picks
+ * them up at the start of the next process call, with no crossfade. The replaced ones are deleted by the worker.
+ * */
+class Convolution final
+{
+public:
+  Convolution();
+
+  ~Convolution();
+
+  Convolution(Convolution const&) = delete;
+  Convolution& operator=(Convolution const&) = delete;
+
+  /**
+   * Prepares an impulse response and publishes it to the audio thread. Allocates memory, so it is not to be called
+   * on the audio thread.
+   * @impulseResponse one impulse response for each channel; if there are fewer impulse responses than channels, they
+   * are repeated
+   * @numChannels the number of channels that process will be called with
+   * @headBlockSize the size of the partitions of the head, a power of 2
+   * @tailBlockSize the size of the partitions of the tail, a power of 2 not smaller than headBlockSize
+   * @return false if the arguments are not valid
+   * */
+  bool setImpulseResponse(std::vector<std::vector<float>> const& impulseResponse,
+                          Index numChannels,
+                          Index headBlockSize = 128,
+                          Index tailBlockSize = 4096);
+
+  /**
+   * Convolves the input with the current impulse response, to be called on the audio thread. The output is silent
+   * until an impulse response is set. The input and the output can be the same buffers.
+   * */
+  void process(float const* const* input, float* const* output, Index numChannels, Index numSamples);
+
+  /**
+   * @return the number of tail blocks that were replaced by silence because the worker was late
+   * */
+  uint64_t getNumMissedDeadlines() const
+  {
+    return numMissedDeadlines.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @return the time spent by the worker convolving tail blocks, in nanoseconds, to measure its load
+   * */
+  uint64_t getWorkerNanoseconds() const
+  {
+    return numWorkerNanoseconds.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Engine;
+
+  void runWorker();
+
+  void runTailBlocks(Engine& engine);
+
+  void deleteRetiredEngines();
+
+  void exchangeTailBlock(Engine& engine, Index channel);
+
+  // the engine prepared by setImpulseResponse, until the audio thread picks it up
+  std::atomic<Engine*> pending{ nullptr };
+  // the engine used by the audio thread
+  Engine* active = nullptr;
+  std::atomic<Engine*> activeForWorker{ nullptr };
+  // the engines replaced by the audio thread, linked through Engine::nextRetired, deleted by the worker between runs
+  std::atomic<Engine*> retired{ nullptr };
+  std::atomic<uint64_t> numMissedDeadlines{ 0 };
+  std::atomic<uint64_t> numWorkerNanoseconds{ 0 };
+  std::atomic<bool> isStopping{ false };
+  std::thread worker;
+};
+
+} // namespace unplug
@@ -11,65 +11,239 @@
 // PERFORMANCE OF THIS SOFTWARE.
 //------------------------------------------------------------------------
 
+
 #pragma once
 
-#ifdef _MSC_VER
+#include "unplug/Index.hpp"
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define UNPLUG_DENORMALS_X86 1
+#include <xmmintrin.h>
+#elif defined(__aarch64__) && !defined(_MSC_VER)
+#define UNPLUG_DENORMALS_AARCH64 1
+#elif defined(_MSC_VER)
+#define UNPLUG_DENORMALS_MSVC 1
+#include <float.h>
+#endif
+
+/**
+ * UNPLUG_COUNT_DENORMALS enables the DenormalCounter used by the processing helpers of UnplugProcessor. By default it
+ * is enabled only in debug builds.
+ * */
+#ifndef UNPLUG_COUNT_DENORMALS
+#ifdef NDEBUG
+#define UNPLUG_COUNT_DENORMALS 0
+#else
+#define UNPLUG_COUNT_DENORMALS 1
+#endif
+#endif
 
 namespace unplug {
 
+/**
+ * A scoped guard that makes the floating point unit of the current thread flush denormals to zero (FTZ) and treat
+ * denormal inputs as zero (DAZ), restoring the previous state when destroyed. It uses the MXCSR register on x86 and the
+ * FPCR register on AArch64, where only flush to zero is available. On other architectures it does nothing.
+ * */
 class DenormalFlusher final
 {
 public:
   DenormalFlusher()
   {
-    _controlfp_s(&prev_word, 0, 0);
-
-    unsigned int new_word;
-    _controlfp_s(&new_word, _DN_FLUSH, _MCW_DN);
-
-    word_was_changed = (prev_word != new_word);
+#if defined(UNPLUG_DENORMALS_X86)
+    previousState = _mm_getcsr();
+    auto const state = previousState | flushToZeroBit | denormalsAreZeroBit;
+    isStateChanged = state != previousState;
+    if (isStateChanged) {
+      _mm_setcsr(state);
+    }
+#elif defined(UNPLUG_DENORMALS_AARCH64)
+    uint64_t fpcr;
+    asm volatile("mrs %0, fpcr" : "=r"(fpcr));
+    previousState = fpcr;
+    fpcr |= flushToZeroBit;
+    isStateChanged = fpcr != previousState;
+    if (isStateChanged) {
+      asm volatile("msr fpcr, %0" : : "r"(fpcr));
+    }
+#elif defined(UNPLUG_DENORMALS_MSVC)
+    unsigned int state;
+    _controlfp_s(&previousState, 0, 0);
+    _controlfp_s(&state, _DN_FLUSH, _MCW_DN);
+    isStateChanged = state != previousState;
+#endif
   }
 
   ~DenormalFlusher()
   {
-    if (word_was_changed) {
-      unsigned int word;
-      _controlfp_s(&word, _DN_SAVE, _MCW_DN);
-      assert(word == prev_word);
+#if defined(UNPLUG_DENORMALS_X86)
+    if (isStateChanged) {
+      _mm_setcsr(previousState);
     }
+#elif defined(UNPLUG_DENORMALS_AARCH64)
+    if (isStateChanged) {
+      asm volatile("msr fpcr, %0" : : "r"(previousState));
+    }
+#elif defined(UNPLUG_DENORMALS_MSVC)
+    if (isStateChanged) {
+      unsigned int state;
+      _controlfp_s(&state, previousState, _MCW_DN);
+    }
+#endif
   }
 
+  DenormalFlusher(DenormalFlusher const&) = delete;
+  DenormalFlusher& operator=(DenormalFlusher const&) = delete;
+
 private:
-  bool word_was_changed;
-  unsigned int prev_word;
+#if defined(UNPLUG_DENORMALS_X86)
+  static constexpr unsigned int flushToZeroBit = 0x8000;
+  static constexpr unsigned int denormalsAreZeroBit = 0x0040;
+  unsigned int previousState{ 0 };
+#elif defined(UNPLUG_DENORMALS_AARCH64)
+  static constexpr uint64_t flushToZeroBit = uint64_t(1) << 24;
+  uint64_t previousState{ 0 };
+#elif defined(UNPLUG_DENORMALS_MSVC)
+  unsigned int previousState{ 0 };
+#endif
+  bool isStateChanged{ false };
 };
 
-} // namespace unplug
+/**
+ * @return true if the value is a denormal number. It inspects the bits of the value, so it works also when denormals
+ * are treated as zero by the floating point unit.
+ * */
+template<class SampleType>
+bool isDenormal(SampleType value)
+{
+  static_assert(std::is_same_v<SampleType, float> || std::is_same_v<SampleType, double>);
+  if constexpr (std::is_same_v<SampleType, float>) {
+    auto const bits = std::bit_cast<uint32_t>(value);
+    return (bits & 0x7f800000u) == 0 && (bits & 0x007fffffu) != 0;
+  }
+  else {
+    auto const bits = std::bit_cast<uint64_t>(value);
+    return (bits & 0x7ff0000000000000ull) == 0 && (bits & 0x000fffffffffffffull) != 0;
+  }
+}
+
+/**
+ * A debugging aid that counts the denormal values found in the audio buffers and in the state of the dsp, checking only
+ * one block every samplingPeriod blocks to keep its cost low. The processing helpers of UnplugProcessor sample the
+ * blocks and count the denormals in their inputs; the dsp can call count on its own outputs and state in every block,
+ * and it only costs a branch in the blocks that are not sampled. The counts can be read from any thread.
+ * */
+class DenormalCounter final
+{
+public:
+  explicit DenormalCounter(uint32_t samplingPeriod = 64)
+    : samplingPeriod{ samplingPeriod > 0 ? samplingPeriod : 1 }
+  {}
+
+  /**
+   * Starts a new block. Called once per block by the processing helpers, before counting the denormals in it.
+   * @return true if the new block should be checked
+   * */
+  bool isBlockSampled()
+  {
+    isSampled = blockCounter == 0;
+    isDenormalFoundInBlock = false;
+    blockCounter = blockCounter + 1 == samplingPeriod ? 0 : blockCounter + 1;
+    if (isSampled) {
+      numSampledBlocks.fetch_add(1, std::memory_order_relaxed);
+    }
+    return isSampled;
+  }
 
-#else
+  /**
+   * @return true if the current block is checked, see isBlockSampled
+   * */
+  bool isCurrentBlockSampled() const
+  {
+    return isSampled;
+  }
+
+  /**
+   * Counts the denormals in an array of values, for example the state of a filter. Does nothing if the current block
+   * is not sampled.
+   * @values the values to check
+   * @numValues the number of values
+   * */
+  template<class SampleType>
+  void count(SampleType const* values, Index numValues)
+  {
+    if (!isSampled || !values) {
+      return;
+    }
+    uint64_t numDenormalsFound = 0;
+    for (Index i = 0; i < numValues; ++i) {
+      numDenormalsFound += isDenormal(values[i]) ? 1 : 0;
+    }
+    addToCount(numDenormalsFound);
+  }
 
-#include <fenv.h>
+  /**
+   * Counts the denormals in a set of channels, for example the outputs of the dsp. Does nothing if the current block is
+   * not sampled.
+   * @channels the channels to check
+   * @numChannels the number of channels
+   * @numSamples the number of samples of each channel
+   * */
+  template<class SampleType>
+  void count(SampleType* const* channels, Index numChannels, Index numSamples)
+  {
+    if (!isSampled || !channels) {
+      return;
+    }
+    for (Index channel = 0; channel < numChannels; ++channel) {
+      count(static_cast<SampleType const*>(channels[channel]), numSamples);
+    }
+  }
 
-namespace unplug {
+  uint64_t getNumDenormals() const
+  {
+    return numDenormals.load(std::memory_order_relaxed);
+  }
 
-class DenormalFlusher final
-{
-public:
-  DenormalFlusher()
+  uint64_t getNumSampledBlocks() const
   {
-    fegetenv(&prev_env);
-    fesetenv(FE_DFL_DISABLE_SSE_DENORMS_ENV);
+    return numSampledBlocks.load(std::memory_order_relaxed);
   }
 
-  ~DenormalFlusher()
+  /**
+   * @return the number of sampled blocks in which count found at least one denormal, however many times it was called
+   * in each of them
+   * */
+  uint64_t getNumBlocksWithDenormals() const
   {
-    fesetenv(&prev_env);
+    return numBlocksWithDenormals.load(std::memory_order_relaxed);
   }
 
 private:
-  fenv_t prev_env;
+  void addToCount(uint64_t numDenormalsFound)
+  {
+    if (numDenormalsFound == 0) {
+      return;
+    }
+    numDenormals.fetch_add(numDenormalsFound, std::memory_order_relaxed);
+    if (!isDenormalFoundInBlock) {
+      isDenormalFoundInBlock = true;
+      numBlocksWithDenormals.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  uint32_t samplingPeriod;
+  uint32_t blockCounter{ 0 };
+  bool isSampled{ false };
+  bool isDenormalFoundInBlock{ false };
+  std::atomic<uint64_t> numDenormals{ 0 };
+  std::atomic<uint64_t> numSampledBlocks{ 0 };
+  std::atomic<uint64_t> numBlocksWithDenormals{ 0 };
 };
 
 } // namespace unplug
-
-#endif
\ No newline at end of file
@@ -0,0 +1,116 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+
+#include "unplug/Index.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace unplug {
+
+/**
+ * DspLoad computes the load of the processing as the ratio between the time spent processing a block and the duration
+ * of the block, with smoothing and peak-hold. UnplugProcessor owns one, see UnplugProcessor::measureDspLoad: its load
+ * is shown by the DspLoadMeter widget and can drive a QualityGovernor.
+ * */
+class DspLoad final
+{
+public:
+  struct Settings final
+  {
+    /** the smoothing time of the load, in seconds */
+    double smoothingTime = 0.3;
+    /** how long the peak is held, in seconds */
+    double peakHoldTime = 2.0;
+    /** how fast the peak decays after the hold time, in units of load per second */
+    double peakReleaseRate = 0.5;
+  };
+
+  using Clock = std::chrono::steady_clock;
+
+  DspLoad() = default;
+
+  explicit DspLoad(Settings settings_)
+    : settings{ settings_ }
+  {}
+
+  /**
+   * Sets the sample rate of the processing, and resets the load. Not to be called on the audio thread.
+   * @sampleRate_ the sample rate
+   * */
+  void setSampleRate(double sampleRate_)
+  {
+    sampleRate = sampleRate_;
+    reset();
+  }
+
+  void reset()
+  {
+    load = 0.0;
+    peak = 0.0;
+    timeSincePeak = 0.0;
+  }
+
+  /**
+   * Updates the load with the measurement of a block
+   * @elapsed the time spent processing the block
+   * @numSamples the number of samples of the block
+   * */
+  void update(Clock::duration elapsed, Index numSamples)
+  {
+    if (numSamples == 0 || sampleRate <= 0.0) {
+      return;
+    }
+    auto const duration = static_cast<double>(numSamples) / sampleRate;
+    auto const blockLoad = std::chrono::duration<double>(elapsed).count() / duration;
+    auto const alpha = std::min(1.0, duration / std::max(settings.smoothingTime, duration));
+    load += alpha * (blockLoad - load);
+    if (blockLoad >= peak) {
+      peak = blockLoad;
+      timeSincePeak = 0.0;
+    }
+    else {
+      timeSincePeak += duration;
+      if (timeSincePeak > settings.peakHoldTime) {
+        peak = std::max(load, peak - settings.peakReleaseRate * duration);
+      }
+    }
+  }
+
+  /**
+   * @return the smoothed load
+   * */
+  double getLoad() const
+  {
+    return load;
+  }
+
+  /**
+   * @return the peak of the load
+   * */
+  double getPeak() const
+  {
+    return peak;
+  }
+
+private:
+  Settings settings;
+  double sampleRate{ 44100.0 };
+  double load{ 0.0 };
+  double peak{ 0.0 };
+  double timeSincePeak{ 0.0 };
+};
+
+} // namespace unplug
@@ -0,0 +1,167 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include "unplug/Index.hpp"
+#include <bit>
+#include <cstdint>
+
+/**
+ * Fast approximations of logarithms, exponentials, decibel conversions and tanh, for single precision.
+ * They use the IEEE-754 representation of floats and low degree polynomials, have no branches and no calls to the
+ * standard library, so the array versions are auto-vectorized by the compiler (GCC needs -fno-trapping-math to
+ * vectorize the functions that clamp their input, clang and MSVC do not). The maximum errors given in the
+ * comments were measured against the double precision standard functions over the whole documented input range.
+ * Denormals, infinities and NaN are not handled: inputs are expected to be finite and normal, or zero where noted.
+ * */
+namespace unplug::FastMath {
+
+/**
+ * Base 2 logarithm of a positive normal float. Maximum relative error: 1.3e-7, maximum absolute error for inputs in
+ * [0.5, 2]: 1.6e-7.
+ * */
+inline float log2(float x) noexcept
+{
+  // x = 2^exponent * m, with m in [sqrt(0.5), sqrt(2)), and log2(m) = 2 / ln(2) * atanh((m - 1) / (m + 1))
+  auto const bits = std::bit_cast<std::int32_t>(x);
+  auto const exponent = (bits - 0x3f3504f3) >> 23;
+  auto const m = std::bit_cast<float>(bits - (exponent << 23));
+  auto const s = (m - 1.f) / (m + 1.f);
+  auto const s2 = s * s;
+  auto const atanhSeries = 2.88539008f + s2 * (0.961796694f + s2 * (0.577078016f + s2 * 0.412198583f));
+  return static_cast<float>(exponent) + s * atanhSeries;
+}
+
+/**
+ * Base 2 exponential. The input is clamped to [-126, 127.99], so the result is always a finite normal float.
+ * Maximum relative error: 1.1e-7.
+ * */
+inline float exp2(float x) noexcept
+{
+  x = x < -126.f ? -126.f : x;
+  x = x > 127.99f ? 127.99f : x;
+  auto integer = static_cast<std::int32_t>(x);
+  integer -= static_cast<float>(integer) > x ? 1 : 0;
+  auto const f = x - static_cast<float>(integer);
+  auto const p =
+    0.693147171f +
+    f * (0.240227215f + f * (0.0554959362f + f * (0.00965244053f + f * (0.00126893536f + f * 0.00020829187f))));
+  auto const fractionalPart = 1.f + f * p;
+  return fractionalPart * std::bit_cast<float>((integer + 127) << 23);
+}
+
+/**
+ * Natural logarithm of a positive normal float. Maximum relative error: 1.6e-7, maximum absolute error for inputs in
+ * [0.5, 2]: 1.2e-7.
+ * */
+inline float log(float x) noexcept
+{
+  return 0.693147181f * log2(x);
+}
+
+/**
+ * Natural exponential. The input is clamped to [-87.3, 88.7]. Maximum relative error: 5.5e-7 for inputs in [-10, 10],
+ * 4e-6 over the whole range, where it is dominated by the rounding of the scaled input.
+ * */
+inline float exp(float x) noexcept
+{
+  return exp2(1.44269504f * x);
+}
+
+/**
+ * Equivalent to unplug::linearToDB: 20 * log10(|linear| + epsilon), so 0 is mapped to about -138 dB.
+ * Maximum absolute error: 1.1e-6 dB for inputs in [0.5, 2], 1.6e-5 dB for inputs up to 1000, and 6.3e-5 dB over the
+ * whole range, where it is dominated by the rounding of the result.
+ * */
+inline float linearToDB(float linear) noexcept
+{
+  auto const magnitude = std::bit_cast<float>(std::bit_cast<std::int32_t>(linear) & 0x7fffffff);
+  return 6.02059991f * log2(magnitude + 1.1920929e-7f);
+}
+
+/**
+ * Equivalent to unplug::dBToLinear: 10^(dB / 20), for dB in [-758, 770]. Maximum relative error: 3.1e-6, dominated by
+ * the rounding of the scaled input, so it is smaller for smaller magnitudes of the input.
+ * */
+inline float dBToLinear(float dB) noexcept
+{
+  return exp2(0.166096404f * dB);
+}
+
+/**
+ * Hyperbolic tangent, computed as (e^2x - 1) / (e^2x + 1). Maximum absolute error: 1.4e-7. The relative error grows
+ * for |x| < 1e-3, where tanh(x) is better approximated by x itself.
+ * */
+inline float tanh(float x) noexcept
+{
+  x = x < -9.f ? -9.f : x;
+  x = x > 9.f ? 9.f : x;
+  auto const e = exp(2.f * x);
+  return (e - 1.f) / (e + 1.f);
+}
+
+/**
+ * Array versions of the functions above: output[i] = function(input[i]) for i in [0, size). Input and output may be
+ * the same buffer, but must not otherwise overlap.
+ * */
+inline void log2(float const* input, float* output, Index size) noexcept
+{
+  for (Index i = 0; i < size; ++i) {
+    output[i] = log2(input[i]);
+  }
+}
+
+inline void exp2(float const* input, float* output, Index size) noexcept
+{
+  for (Index i = 0; i < size; ++i) {
+    output[i] = exp2(input[i]);
+  }
+}
+
+inline void log(float const* input, float* output, Index size) noexcept
+{
+  for (Index i = 0; i < size; ++i) {
+    output[i] = log(input[i]);
+  }
+}
+
+inline void exp(float const* input, float* output, Index size) noexcept
+{
+  for (Index i = 0; i < size; ++i) {
+    output[i] = exp(input[i]);
+  }
+}
+
+inline void linearToDB(float const* input, float* output, Index size) noexcept
+{
+  for (Index i = 0; i < size; ++i) {
+    output[i] = linearToDB(input[i]);
+  }
+}
+
+inline void dBToLinear(float const* input, float* output, Index size) noexcept
+{
+  for (Index i = 0; i < size; ++i) {
+    output[i] = dBToLinear(input[i]);
+  }
+}
+
+inline void tanh(float const* input, float* output, Index size) noexcept
+{
+  for (Index i = 0; i < size; ++i) {
+    output[i] = tanh(input[i]);
+  }
+}
+
+} // namespace unplug::FastMath
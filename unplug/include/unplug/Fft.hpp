@@ -0,0 +1,77 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include "unplug/Index.hpp"
+#include <memory>
+#include <vector>
+
+namespace unplug {
+
+/**
+ * A fast Fourier transform of real signals, with the spectra in split format: the real and the imaginary parts of the
+ * size / 2 + 1 bins are stored in separate arrays, so that the complex products done on them by convolution are
+ * vectorized by the compiler. It uses a radix-2 complex transform of half the size. The buffers are allocated by the
+ * constructor, so an instance must not be used by more than one thread at a time. The twiddles and the bit reversal
+ * permutation are shared by all the transforms of the same size in the process, see SharedTableCache, so the
+ * constructor must not be called on the audio thread.
+ * */
+class Fft final
+{
+public:
+  /**
+   * @size the size of the transform, a power of 2 not smaller than 4
+   * */
+  explicit Fft(Index size);
+
+  Index getSize() const
+  {
+    return size;
+  }
+
+  Index getNumBins() const
+  {
+    return size / 2 + 1;
+  }
+
+  /**
+   * Computes the spectrum of a real signal.
+   * @input size samples
+   * @real the real part of the getNumBins() bins
+   * @imaginary the imaginary part of the getNumBins() bins
+   * */
+  void forward(float const* input, float* real, float* imaginary);
+
+  /**
+   * Computes the real signal of a spectrum, scaled so that inverse(forward(x)) is x. The imaginary parts of the first
+   * and the last bins are ignored.
+   * @real the real part of the getNumBins() bins
+   * @imaginary the imaginary part of the getNumBins() bins
+   * @output size samples
+   * */
+  void inverse(float const* real, float const* imaginary, float* output);
+
+private:
+  struct Tables;
+
+  void transform(bool isInverse);
+
+  Index size;
+  Index halfSize;
+  std::shared_ptr<Tables const> tables;
+  std::vector<float> bufferReal;
+  std::vector<float> bufferImaginary;
+};
+
+} // namespace unplug
@@ -20,4 +20,9 @@ using Index = uint32_t;
 using ParamIndex = Index;
 using MeterIndex = Index;
 
+/**
+ * Identifies the user interface control that is editing a parameter. With Dear ImGui it is the ImGuiID of the control.
+ * */
+using ControlId = uint32_t;
+
 } // namespace unplug
\ No newline at end of file
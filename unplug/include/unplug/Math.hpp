@@ -39,6 +39,16 @@ std::string linearToDBAsText(float linear);
 
 std::string linearToDBAsTextWithDecimalDigits(float linear, int numDecimalDigits);
 
+/**
+ * Writes a linear value as decibels in text form into a user provided buffer, without allocating.
+ * @linear the linear value to convert
+ * @buffer the buffer to write the text to, it will be null terminated
+ * @bufferSize the size of the buffer
+ * @numDecimalDigits the number of decimal digits to display
+ * @return the number of characters written, not counting the null terminator
+ * */
+int writeLinearToDBAsText(float linear, char* buffer, std::size_t bufferSize, int numDecimalDigits = 1);
+
 struct FractionalIndex final
 {
   float value;
@@ -40,6 +40,23 @@ public:
    */
   float get(MeterIndex index) const;
 
+  /**
+   * Sets the load of the processing of the plugin instance
+   * @load the smoothed load, as the ratio between the processing time and the duration of the audio blocks
+   * @peak the peak of the load
+   */
+  void setDspLoad(float load, float peak);
+
+  /**
+   * @return the smoothed load of the processing, as set by setDspLoad
+   */
+  float getDspLoad() const;
+
+  /**
+   * @return the peak of the load of the processing, as set by setDspLoad
+   */
+  float getDspLoadPeak() const;
+
   TMeterStorage();
 
   TMeterStorage(TMeterStorage const&) = delete;
@@ -48,6 +65,8 @@ public:
 
 private:
   std::array<std::atomic<float>, numValues> values;
+  std::atomic<float> dspLoad{ 0.f };
+  std::atomic<float> dspLoadPeak{ 0.f };
 };
 
 using MeterStorage = TMeterStorage<NumMeters::value>;
@@ -75,6 +94,25 @@ float TMeterStorage<numValues>::get(MeterIndex index) const
   return values[index].load(std::memory_order_acquire);
 }
 
+template<int numValues>
+void TMeterStorage<numValues>::setDspLoad(float load, float peak)
+{
+  dspLoad.store(load, std::memory_order_release);
+  dspLoadPeak.store(peak, std::memory_order_release);
+}
+
+template<int numValues>
+float TMeterStorage<numValues>::getDspLoad() const
+{
+  return dspLoad.load(std::memory_order_acquire);
+}
+
+template<int numValues>
+float TMeterStorage<numValues>::getDspLoadPeak() const
+{
+  return dspLoadPeak.load(std::memory_order_acquire);
+}
+
 template<int numValues>
 TMeterStorage<numValues>::TMeterStorage()
 {
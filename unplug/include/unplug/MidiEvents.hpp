@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include "unplug/Index.hpp"
+#include "unplug/MidiMapping.hpp"
+#include <cstdint>
+
+namespace unplug {
+
+/**
+ * A MIDI event, used to pass notes and controllers to the ProcessingEngine without depending on a plugin format.
+ * Controller events only come from sources that deliver them as events, such as a MidiEventSpan: the VST3 wrapper
+ * receives them as parameter changes, see Vst3MidiEventsReader.
+ * */
+struct MidiEvent final
+{
+  enum class Type
+  {
+    noteOn,
+    noteOff,
+    polyPressure,
+    controlChange,
+    channelPressure,
+    pitchBend
+  };
+
+  Type type = Type::noteOn;
+  /** the sample of the block at which the event happens */
+  Index sampleOffset = 0;
+  int channel = 0;
+  /** the pitch for note and poly pressure events, the controller number for control change events */
+  int number = 0;
+  /**
+   * the velocity, the pressure or the controller value, normalized in [0, 1]. For pitch bend events 0.5 is the center
+   * position.
+   * */
+  float value = 0.f;
+  /** an identifier of the note shared by its events, or -1 if the plugin format does not provide one */
+  int32_t noteId = -1;
+
+  /**
+   * @return the controller number used to look the event up in a MidiMapping: the controller number for control change
+   * events, MidiCC::AfterTouch for channel pressure events, MidiCC::PitchBend for pitch bend events, and -1 for notes.
+   * */
+  int getController() const
+  {
+    switch (type) {
+      case Type::controlChange:
+        return number;
+      case Type::channelPressure:
+        return MidiCC::AfterTouch;
+      case Type::pitchBend:
+        return MidiCC::PitchBend;
+      default:
+        return -1;
+    }
+  }
+};
+
+/**
+ * Presents a span of MidiEvent, sorted by sampleOffset, as the event list the ProcessingEngine consumes.
+ * The ProcessingEngine accepts any class with the same two const member functions, so that the events received by a
+ * plugin format can be read in place, see Vst3MidiEventsReader. getEvent returns false for the events that can not be
+ * read as a MidiEvent, which are skipped.
+ * */
+class MidiEventSpan final
+{
+public:
+  MidiEventSpan() = default;
+
+  MidiEventSpan(MidiEvent const* events, Index numEvents)
+    : events{ events }
+    , numEvents{ numEvents }
+  {}
+
+  Index getNumEvents() const
+  {
+    return numEvents;
+  }
+
+  bool getEvent(Index index, MidiEvent& event) const
+  {
+    event = events[index];
+    return true;
+  }
+
+private:
+  MidiEvent const* events = nullptr;
+  Index numEvents = 0;
+};
+
+} // namespace unplug
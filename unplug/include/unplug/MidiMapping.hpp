@@ -14,6 +14,8 @@
 #pragma once
 #include "unplug/Index.hpp"
 #include <array>
+#include <limits>
+#include <vector>
 
 namespace unplug {
 
@@ -92,20 +94,29 @@ enum MidiCC
 };
 }
 
+struct ParameterDescription;
+
 namespace detail {
 class MidiMappingSingleChannel final
 {
 public:
   static constexpr auto unmapped = ParamIndex{ std::numeric_limits<ParamIndex>::max() };
 
+  /** the midi controls, plus MidiCC::AfterTouch and MidiCC::PitchBend */
+  static constexpr int numControllers = 130;
+
   MidiMappingSingleChannel();
 
   void mapParameter(ParamIndex paramIndex, int controller);
 
+  void unmapParameter(ParamIndex paramIndex);
+
   ParamIndex getParameter(int controller) const;
 
+  bool operator==(MidiMappingSingleChannel const& other) const = default;
+
 private:
-  std::array<ParamIndex, 130> midiMapping;
+  std::array<ParamIndex, numControllers> midiMapping;
 };
 
 class MidiMapping final
@@ -113,14 +124,37 @@ class MidiMapping final
 public:
   static constexpr auto unmapped = MidiMappingSingleChannel::unmapped;
 
+  static constexpr int numChannels = 16;
+
+  /**
+   * A controller of a channel mapped to a parameter, see getAssignments
+   * */
+  struct Assignment final
+  {
+    int channel;
+    int controller;
+    ParamIndex paramIndex;
+  };
+
   void mapParameter(ParamIndex paramIndex, int controller, int channel);
 
   void mapParameter(ParamIndex paramIndex, int controller);
 
+  /** maps the parameter as set by ParameterDescription::MidiMapping, if it has a default midi mapping */
+  void mapDefaultMidiMapping(ParameterDescription const& description);
+
+  /** removes every controller mapped to the parameter, on all channels */
+  void unmapParameter(ParamIndex paramIndex);
+
   ParamIndex getParameter(int controller, int channel) const;
 
+  /** @return all the mapped controllers, ordered by channel and controller, used to save the mapping */
+  std::vector<Assignment> getAssignments() const;
+
+  bool operator==(MidiMapping const& other) const = default;
+
 private:
-  std::array<MidiMappingSingleChannel, 16> midiMappingByChannel;
+  std::array<MidiMappingSingleChannel, numChannels> midiMappingByChannel;
 };
 
 } // namespace detail
@@ -0,0 +1,102 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include "Parameters.hpp"
+#include "unplug/Index.hpp"
+#include <array>
+#include <cassert>
+
+namespace unplug {
+
+/**
+ * A point of a parameter queue: the normalized value the parameter has at a sample of the processing block.
+ * */
+struct ParameterPoint final
+{
+  Index sampleOffset = 0;
+  double normalizedValue = 0.0;
+};
+
+/**
+ * A parameter change, used to pass automation to the ProcessingEngine without depending on a plugin format.
+ * */
+struct ParameterEvent final
+{
+  ParamIndex paramIndex = 0;
+  Index sampleOffset = 0;
+  double normalizedValue = 0.0;
+};
+
+/**
+ * Presents a span of ParameterEvent as parameter queues, the form the ProcessingEngine consumes. The events of each
+ * parameter must be contiguous and sorted by sampleOffset, as when they are written one parameter at a time.
+ * The ProcessingEngine accepts any class with the same four const member functions, so that the changes received by a
+ * plugin format can be read in place, see Vst3ParameterChangesReader.
+ * */
+class ParameterEventSpan final
+{
+public:
+  ParameterEventSpan() = default;
+
+  ParameterEventSpan(ParameterEvent const* events, Index numEvents)
+    : events{ events }
+  {
+    for (Index i = 0; i < numEvents; ++i) {
+      bool const startsQueue = i == 0 || events[i].paramIndex != events[i - 1].paramIndex;
+      if (startsQueue) {
+        assert(numQueues < queues.size() && "each parameter must appear in a single contiguous run of events");
+        if (numQueues == queues.size()) {
+          break;
+        }
+        queues[numQueues++] = { i, 0 };
+      }
+      ++queues[numQueues - 1].numPoints;
+    }
+  }
+
+  Index getNumQueues() const
+  {
+    return numQueues;
+  }
+
+  ParamIndex getParamIndex(Index queue) const
+  {
+    return events[queues[queue].firstEvent].paramIndex;
+  }
+
+  Index getNumPoints(Index queue) const
+  {
+    return queues[queue].numPoints;
+  }
+
+  ParameterPoint getPoint(Index queue, Index point) const
+  {
+    auto const& event = events[queues[queue].firstEvent + point];
+    return { event.sampleOffset, event.normalizedValue };
+  }
+
+private:
+  struct Queue final
+  {
+    Index firstEvent;
+    Index numPoints;
+  };
+
+  ParameterEvent const* events = nullptr;
+  std::array<Queue, NumParameters::value> queues;
+  Index numQueues = 0;
+};
+
+} // namespace unplug
@@ -92,12 +92,51 @@ public:
    * */
   ParameterValueType valueFromNormalized(ParamIndex paramIndex, ParameterValueType valueNormalized);
 
-  TParameterStorage() = default;
+  TParameterStorage()
+  {
+    // no change has been logged yet, so no entry matches its number
+    for (auto& entry : changeLog) {
+      entry.store(~uint64_t{ 0 }, std::memory_order_relaxed);
+    }
+  }
 
   TParameterStorage(TParameterStorage const&) = delete;
 
   TParameterStorage& operator=(TParameterStorage const&) = delete;
 
+  /**
+   * The number of changes kept in the log read by getChangedParameter
+   * */
+  static constexpr uint32_t changeLogSize = 256;
+
+  /**
+   * Gets the number of times the parameters have been set. The objects that keep a snapshot of the parameters, such as
+   * LinearAutomation, compare it with the number they last saw and read the parameters set since then with
+   * getChangedParameter, instead of reading all of them.
+   * @return the number of changes, which wraps around
+   * */
+  uint32_t getNumChanges() const
+  {
+    return numChanges.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Gets the parameter set by a change
+   * @change the number of the change, lower than the value returned by getNumChanges
+   * @paramIndex on success, the index of the parameter that has been set
+   * @return false if the change is no longer in the log, or if it is still being logged: in that case any parameter may
+   * have changed
+   * */
+  bool getChangedParameter(uint32_t change, ParamIndex& paramIndex) const
+  {
+    auto const entry = changeLog[change % changeLogSize].load(std::memory_order_acquire);
+    if (static_cast<uint32_t>(entry >> 32u) != change) {
+      return false;
+    }
+    paramIndex = static_cast<ParamIndex>(entry & 0xffffffffu);
+    return true;
+  }
+
   bool isParameterAutomatable(ParamIndex paramIndex) const
   {
     return !notAutomatalbeParameters.contains(paramIndex);
@@ -119,6 +158,9 @@ private:
 
   std::array<StoredParameter, numParameters> parameters;
   std::unordered_set<ParamIndex> notAutomatalbeParameters;
+  std::atomic<uint32_t> numChanges{ 0 };
+  // each entry holds the number of a change in the high 32 bits and the index of the parameter in the low ones
+  std::array<std::atomic<uint64_t>, changeLogSize> changeLog;
 };
 
 using ParameterStorage = TParameterStorage<NumParameters::value>;
@@ -129,6 +171,10 @@ template<int numParameters>
 void TParameterStorage<numParameters>::set(ParamIndex paramIndex, ParameterValueType value)
 {
   parameters[paramIndex].value.store(value, std::memory_order_release);
+  // the value is stored before the change is counted, so a reader that sees the change also sees the value
+  auto const change = numChanges.fetch_add(1, std::memory_order_acq_rel);
+  changeLog[change % changeLogSize].store((static_cast<uint64_t>(change) << 32u) | paramIndex,
+                                          std::memory_order_release);
 }
 
 template<int numParameters>
@@ -181,7 +227,7 @@ void TParameterStorage<numParameters>::initializeDefaultValues(
     auto const& parameter = parameterDescriptions[i];
     auto const defaultValue =
       parameter.isNonlinear() ? parameter.nonlinearToLinear(parameter.defaultValue) : parameter.defaultValue;
-    parameters[i].value.store(defaultValue);
+    set(i, defaultValue);
   }
 }
 
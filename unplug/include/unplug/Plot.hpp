@@ -15,6 +15,7 @@
 #include "implot.h"
 #include "unplug/Color.hpp"
 #include "unplug/RingBuffer.hpp"
+#include "unplug/Trace.hpp"
 #include <functional>
 
 namespace unplug {
@@ -71,35 +72,35 @@ std::function<PlotChannelLegend(Index channel, Index numChannels)> makeMidSideOr
   float colorAlpha = 1.f);
 
 /**
- * Plots a ring buffer using a custom plotting function
+ * Plots a ring buffer using a custom plotting function. When tracing, the lag of the plot behind the dsp is recorded as
+ * a counter named after the plot, so the name must outlive the trace, see Trace.hpp.
  * */
-template<class ElementType, class Allocator, class Plotter>
+template<class ElementType, class Allocator, RingBufferLayout layout, class Plotter>
 bool TPlotRingBuffer(const char* name,
-                     RingBuffer<ElementType, Allocator>& ringBuffer,
+                     RingBuffer<ElementType, Allocator, layout>& ringBuffer,
                      std::function<PlotChannelLegend(Index channel, Index numChannels)> const& getChannelLegend,
                      Plotter plotter)
 {
+  // BeginPlot fails when the plot is not visible, so the ring buffer is only marked as read when it is shown
   if (ImPlot::BeginPlot(name)) {
+    [[maybe_unused]] auto const lag = ringBuffer.markAsRead();
+    UNPLUG_TRACE_COUNTER(name, lag);
     auto const numChannels = ringBuffer.getNumChannels();
-    auto const offset = numChannels * ringBuffer.getReadPosition();
-    auto const stride = ringBuffer.getNumChannels() * sizeof(ElementType);
-    auto const readBlockSize = numChannels * ringBuffer.getReadBlockSize();
-    auto const totalSize = static_cast<Index>(ringBuffer.getBuffer().size());
+    auto const readPosition = ringBuffer.getReadPosition();
+    auto const pointStride = ringBuffer.getPointStride();
+    auto const stride = pointStride * sizeof(ElementType);
+    auto const readBlockSize = ringBuffer.getReadBlockSize();
+    auto const pointsCount = std::min(readBlockSize, ringBuffer.getBufferCapacity() - readPosition);
     auto const xScale = ringBuffer.getSecondsPerPoint();
     for (Index channel = 0; channel < numChannels; ++channel) {
-      auto const start = offset + channel;
-      auto const end = start + readBlockSize;
-      auto contiguousEnd = std::min(end, totalSize);
-      auto contiguousSize = contiguousEnd - start;
+      auto const channelOffset = ringBuffer.getChannelOffset(channel);
       auto const channelLegend = getChannelLegend(channel, numChannels);
-      auto const pointsCount = contiguousSize / numChannels;
       if (pointsCount > 0)
-        plotter(channelLegend, ringBuffer, pointsCount, xScale, 0, start, stride, channel);
-      if (contiguousEnd != end) {
-        auto const size = (end - totalSize) / numChannels;
-        if (size > 0)
-          plotter(channelLegend, ringBuffer, size, xScale, pointsCount * xScale, channel, stride, channel);
-      }
+        plotter(
+          channelLegend, ringBuffer, pointsCount, xScale, 0, channelOffset + readPosition * pointStride, stride, channel);
+      auto const size = readBlockSize - pointsCount;
+      if (size > 0)
+        plotter(channelLegend, ringBuffer, size, xScale, pointsCount * xScale, channelOffset, stride, channel);
     }
     ImPlot::EndPlot();
     return true;
@@ -110,9 +111,9 @@ bool TPlotRingBuffer(const char* name,
 /**
  * Plots a simple ring buffer, suitable for ring buffers holding continuous numeric data
  * */
-template<class ElementType, class Allocator>
+template<class ElementType, class Allocator, RingBufferLayout layout>
 bool PlotRingBuffer(const char* name,
-                    RingBuffer<ElementType, Allocator>& ringBuffer,
+                    RingBuffer<ElementType, Allocator, layout>& ringBuffer,
                     std::function<PlotChannelLegend(Index channel, Index numChannels)> const& getChannelLegend =
                       makeStereoOrGenericPlotChannelLegend())
 {
@@ -121,7 +122,7 @@ bool PlotRingBuffer(const char* name,
     ringBuffer,
     getChannelLegend,
     [&](PlotChannelLegend const& channelLegend,
-        const RingBuffer<ElementType, Allocator>& buffer,
+        const RingBuffer<ElementType, Allocator, layout>& buffer,
         int count,
         double xScale,
         double x0,
@@ -138,9 +139,9 @@ bool PlotRingBuffer(const char* name,
 /**
  * Plots a waveform ring buffer.
  * */
-template<class ElementType, class Allocator>
+template<class ElementType, class Allocator, RingBufferLayout layout>
 bool PlotWaveformRingBuffer(const char* name,
-                            WaveformRingBuffer<ElementType, Allocator>& ringBuffer,
+                            WaveformRingBuffer<ElementType, Allocator, layout>& ringBuffer,
                             float alpha = 0.5f,
                             std::function<PlotChannelLegend(Index channel, Index numChannels)> const& getChannelLegend =
                               makeStereoOrGenericPlotChannelLegend())
@@ -150,7 +151,7 @@ bool PlotWaveformRingBuffer(const char* name,
     ringBuffer,
     getChannelLegend,
     [&](PlotChannelLegend const& channelLegend,
-        const WaveformRingBuffer<ElementType, Allocator>& buffer,
+        const WaveformRingBuffer<ElementType, Allocator, layout>& buffer,
         int count,
         double xScale,
         double x0,
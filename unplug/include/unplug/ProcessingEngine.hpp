@@ -0,0 +1,488 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include "Parameters.hpp"
+#include "unplug/AutomationEvent.hpp"
+#include "unplug/DenormalFlusher.hpp"
+#include "unplug/IO.hpp"
+#include "unplug/MidiEvents.hpp"
+#include "unplug/MidiMapping.hpp"
+#include "unplug/ParameterEvents.hpp"
+#include "unplug/ParameterStorage.hpp"
+#include "unplug/Trace.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+namespace unplug {
+
+/**
+ * The channels of an audio input or output, as passed to ProcessingEngine::setupIO.
+ * */
+template<class SampleType>
+struct AudioBus final
+{
+  SampleType** channels = nullptr;
+  Index numChannels = 0;
+};
+
+/**
+ * The part of the processing that does not depend on the plugin format: it sets up the IO, schedules the sample
+ * precise automation and keeps the parameter storage up to date. It reads the parameter changes through any class that
+ * exposes them as queues, like ParameterEventSpan, so it can be driven by a plugin format adapter (see
+ * UnplugProcessor), by an offline renderer or by a benchmark, without the SDK of a plugin format.
+ * The processing callbacks have the same signatures as the ones of the UnplugProcessor helpers.
+ * */
+class ProcessingEngine final
+{
+public:
+  /**
+   * Constructor
+   * @parameters the parameter storage to update with the received parameter changes
+   * @ioCache the cache of the audio buffers used to construct the IO passed to the processing callbacks
+   * */
+  ProcessingEngine(ParameterStorage& parameters, detail::CachedIO& ioCache)
+    : parameters{ parameters }
+    , ioCache{ ioCache }
+  {}
+
+  /**
+   * Sets up the IO from the audio buffers of the block to process. When there are no inputs and no outputs, the IO is
+   * flushing, see IO::isFlushing.
+   * */
+  template<class SampleType>
+  void setupIO(AudioBus<SampleType> const* inputs,
+               Index numInputs,
+               AudioBus<SampleType> const* outputs,
+               Index numOutputs);
+
+  /** processing without sample precise automation: the parameters are set to their last value in the block. */
+  template<class SampleType, class ParameterChanges, class StaticProcessing, class Upsampling, class Downsampling>
+  void staticProcessing(Index numSamples,
+                        ParameterChanges const& parameterChanges,
+                        StaticProcessing staticProcessing_,
+                        Upsampling upsampling,
+                        Downsampling downsampling);
+
+  /** processing with sample precise automation, see UnplugProcessor::processWithSamplePreciseAutomation. */
+  template<class SampleType,
+           class ParameterChanges,
+           class StaticProcessing,
+           class PrepareAutomation,
+           class AutomatedProcessing,
+           class SetParameterAutomation,
+           class Upsampling,
+           class Downsampling>
+  void processWithSamplePreciseAutomation(Index numSamples,
+                                          ParameterChanges const& parameterChanges,
+                                          StaticProcessing staticProcessing_,
+                                          PrepareAutomation prepareAutomation,
+                                          AutomatedProcessing automatedProcessing,
+                                          SetParameterAutomation setParameterAutomation,
+                                          Upsampling upsampling,
+                                          Downsampling downsampling,
+                                          float oversamplingRate = 1.f);
+
+  /**
+   * processing with sample precise automation and MIDI events, see UnplugProcessor::processWithEvents. The MIDI events
+   * and the automation are merged into a single timeline: the block is split once at each sample where an event happens
+   * or an automation segment ends, and onMidiEvent(MidiEvent const&) is called for the events of a sample before the
+   * segment that starts there is processed. The events must be sorted by sampleOffset.
+   * The control change, channel pressure and pitch bend events mapped to a parameter by midiMapping are not passed to
+   * onMidiEvent: they set the parameter, which holds the value until the next automation point. midiMapping may be
+   * null, then every event is passed to onMidiEvent.
+   * */
+  template<class SampleType,
+           class ParameterChanges,
+           class MidiEvents,
+           class StaticProcessing,
+           class PrepareAutomation,
+           class AutomatedProcessing,
+           class SetParameterAutomation,
+           class OnMidiEvent,
+           class Upsampling,
+           class Downsampling>
+  void processWithEvents(Index numSamples,
+                         ParameterChanges const& parameterChanges,
+                         MidiEvents const& midiEvents,
+                         detail::MidiMapping const* midiMapping,
+                         StaticProcessing staticProcessing_,
+                         PrepareAutomation prepareAutomation,
+                         AutomatedProcessing automatedProcessing,
+                         SetParameterAutomation setParameterAutomation,
+                         OnMidiEvent onMidiEvent,
+                         Upsampling upsampling,
+                         Downsampling downsampling,
+                         float oversamplingRate = 1.f);
+
+  /** sets every parameter that received changes to the value of its last point */
+  template<class ParameterChanges>
+  void updateParametersToLastPoint(ParameterChanges const& parameterChanges)
+  {
+    updateToLastPoint(parameterChanges, [](ParamIndex) { return true; });
+  }
+
+  /** sets every parameter that is not automatable and received changes to the value of its last point */
+  template<class ParameterChanges>
+  void updateNotAutomatableParameters(ParameterChanges const& parameterChanges)
+  {
+    if (parameters.getNumNotAutomatableParameters() == 0) {
+      return;
+    }
+    updateToLastPoint(parameterChanges,
+                      [this](ParamIndex paramIndex) { return !parameters.isParameterAutomatable(paramIndex); });
+  }
+
+  /**
+   * @return the counter of the denormals found in the inputs, and in whatever the dsp passes to its count methods. It
+   * only samples blocks when UNPLUG_COUNT_DENORMALS is enabled, which is the default in debug builds.
+   * */
+  DenormalCounter const& getDenormalCounter() const
+  {
+    return denormalCounter;
+  }
+
+  DenormalCounter& getDenormalCounter()
+  {
+    return denormalCounter;
+  }
+
+private:
+  struct NoMidiEvents final
+  {
+    Index getNumEvents() const
+    {
+      return 0;
+    }
+
+    bool getEvent(Index, MidiEvent&) const
+    {
+      return false;
+    }
+  };
+
+  /** @return the parameter the event is mapped to, or MidiMapping::unmapped */
+  static ParamIndex getMappedParameter(MidiEvent const& event, detail::MidiMapping const* midiMapping)
+  {
+    auto const controller = event.getController();
+    if (!midiMapping || controller < 0 || event.channel < 0 || event.channel >= 16) {
+      return detail::MidiMapping::unmapped;
+    }
+    return midiMapping->getParameter(controller, event.channel);
+  }
+
+  /**
+   * sets the parameters mapped to the MIDI controllers received in the block, unless a point of their automation at
+   * the same or a later sample overrides the value. To be called after updateParametersToLastPoint.
+   * */
+  template<class ParameterChanges, class MidiEvents>
+  void updateMidiControlledParameters(ParameterChanges const& parameterChanges,
+                                      MidiEvents const& midiEvents,
+                                      detail::MidiMapping const* midiMapping)
+  {
+    if (!midiMapping) {
+      return;
+    }
+    auto const numEvents = midiEvents.getNumEvents();
+    auto const numQueues = parameterChanges.getNumQueues();
+    for (Index i = 0; i < numEvents; ++i) {
+      MidiEvent event;
+      if (!midiEvents.getEvent(i, event)) {
+        continue;
+      }
+      auto const paramIndex = getMappedParameter(event, midiMapping);
+      if (paramIndex >= NumParameters::value) {
+        continue;
+      }
+      bool isOverridden = false;
+      for (Index queue = 0; queue < numQueues && !isOverridden; ++queue) {
+        auto const numPoints = parameterChanges.getNumPoints(queue);
+        isOverridden = numPoints > 0 && parameterChanges.getParamIndex(queue) == paramIndex &&
+                       parameterChanges.getPoint(queue, numPoints - 1).sampleOffset >= event.sampleOffset;
+      }
+      if (!isOverridden) {
+        parameters.setNormalized(paramIndex, event.value);
+      }
+    }
+  }
+
+  template<class ParameterChanges, class Filter>
+  void updateToLastPoint(ParameterChanges const& parameterChanges, Filter filter)
+  {
+    auto const numQueues = parameterChanges.getNumQueues();
+    for (Index queue = 0; queue < numQueues; ++queue) {
+      auto const paramIndex = parameterChanges.getParamIndex(queue);
+      auto const numPoints = parameterChanges.getNumPoints(queue);
+      if (numPoints > 0 && paramIndex < NumParameters::value && filter(paramIndex)) {
+        auto const lastPoint = parameterChanges.getPoint(queue, numPoints - 1);
+        parameters.setNormalized(paramIndex, lastPoint.normalizedValue);
+      }
+    }
+  }
+
+  template<class SampleType>
+  void countDenormals(IO<SampleType> const& io, Index numSamples)
+  {
+#if UNPLUG_COUNT_DENORMALS
+    if (denormalCounter.isBlockSampled()) {
+      for (Index in = 0; in < ioCache.ins.size(); ++in) {
+        auto const channels = io.getIn(in);
+        denormalCounter.count(channels.buffers, channels.numChannels, numSamples);
+      }
+    }
+#endif
+  }
+
+  ParameterStorage& parameters;
+  detail::CachedIO& ioCache;
+  DenormalCounter denormalCounter;
+  // the scheduling state of each parameter queue: whether it is automated, the index of the point that ends the current
+  // segment, and the sample at which it ends
+  std::array<bool, NumParameters::value> isScheduled;
+  std::array<Index, NumParameters::value> segmentEndPoint;
+  std::array<Index, NumParameters::value> segmentEndSample;
+};
+
+template<class SampleType>
+void ProcessingEngine::setupIO(AudioBus<SampleType> const* inputs,
+                               Index numInputs,
+                               AudioBus<SampleType> const* outputs,
+                               Index numOutputs)
+{
+  ioCache.isFlushing = numInputs == 0 && numOutputs == 0;
+  if (ioCache.isFlushing)
+    return;
+  assert(numInputs == ioCache.ins.size());
+  assert(numOutputs == ioCache.outs.size());
+  ioCache.ins.resize(numInputs);
+  ioCache.outs.resize(numOutputs);
+  for (Index in = 0; in < numInputs; ++in) {
+    ioCache.ins[in].setChannels(inputs[in].channels);
+    ioCache.ins[in].numChannels = inputs[in].numChannels;
+  }
+  for (Index out = 0; out < numOutputs; ++out) {
+    ioCache.outs[out].setChannels(outputs[out].channels);
+    ioCache.outs[out].numChannels = outputs[out].numChannels;
+  }
+}
+
+template<class SampleType, class ParameterChanges, class StaticProcessing, class Upsampling, class Downsampling>
+void ProcessingEngine::staticProcessing(Index numSamples,
+                                        ParameterChanges const& parameterChanges,
+                                        StaticProcessing staticProcessing_,
+                                        Upsampling upsampling,
+                                        Downsampling downsampling)
+{
+  UNPLUG_TRACE_SCOPE("ProcessingEngine::staticProcessing");
+  auto io = IO<SampleType>(ioCache);
+  updateParametersToLastPoint(parameterChanges);
+  bool const isNotFlushing = !io.isFlushing();
+  if (isNotFlushing) {
+    auto const denormalFlusher = DenormalFlusher{};
+    countDenormals(io, numSamples);
+    auto const numUpsampledSamples = upsampling(io, numSamples);
+    staticProcessing_(io, numUpsampledSamples);
+    downsampling(io, numUpsampledSamples, numSamples);
+  }
+}
+
+template<class SampleType,
+         class ParameterChanges,
+         class StaticProcessing,
+         class PrepareAutomation,
+         class AutomatedProcessing,
+         class SetParameterAutomation,
+         class Upsampling,
+         class Downsampling>
+void ProcessingEngine::processWithSamplePreciseAutomation(Index numSamples,
+                                                          ParameterChanges const& parameterChanges,
+                                                          StaticProcessing staticProcessing_,
+                                                          PrepareAutomation prepareAutomation,
+                                                          AutomatedProcessing automatedProcessing,
+                                                          SetParameterAutomation setParameterAutomation,
+                                                          Upsampling upsampling,
+                                                          Downsampling downsampling,
+                                                          float oversamplingRate)
+{
+  processWithEvents<SampleType>(numSamples,
+                                parameterChanges,
+                                NoMidiEvents{},
+                                nullptr,
+                                staticProcessing_,
+                                prepareAutomation,
+                                automatedProcessing,
+                                setParameterAutomation,
+                                [](MidiEvent const&) {},
+                                upsampling,
+                                downsampling,
+                                oversamplingRate);
+}
+
+template<class SampleType,
+         class ParameterChanges,
+         class MidiEvents,
+         class StaticProcessing,
+         class PrepareAutomation,
+         class AutomatedProcessing,
+         class SetParameterAutomation,
+         class OnMidiEvent,
+         class Upsampling,
+         class Downsampling>
+void ProcessingEngine::processWithEvents(Index numSamples,
+                                         ParameterChanges const& parameterChanges,
+                                         MidiEvents const& midiEvents,
+                                         detail::MidiMapping const* midiMapping,
+                                         StaticProcessing staticProcessing_,
+                                         PrepareAutomation prepareAutomation,
+                                         AutomatedProcessing automatedProcessing,
+                                         SetParameterAutomation setParameterAutomation,
+                                         OnMidiEvent onMidiEvent,
+                                         Upsampling upsampling,
+                                         Downsampling downsampling,
+                                         float oversamplingRate)
+{
+  UNPLUG_TRACE_SCOPE("ProcessingEngine::processWithEvents");
+  using AutomationEvent = unplug::AutomationEvent<SampleType>;
+  auto io = IO<SampleType>(ioCache);
+
+  // the events are read one at a time, skipping the ones the reader can not convert
+  auto const numEvents = midiEvents.getNumEvents();
+  Index eventIndex = 0;
+  MidiEvent nextEvent;
+  auto const readNextEvent = [&] {
+    while (eventIndex < numEvents) {
+      if (midiEvents.getEvent(eventIndex++, nextEvent)) {
+        return true;
+      }
+    }
+    return false;
+  };
+  bool hasNextEvent = readNextEvent();
+
+  bool const isNotFlushing = !io.isFlushing();
+  if (isNotFlushing) {
+    auto const denormalFlusher = DenormalFlusher{};
+    countDenormals(io, numSamples);
+    auto const numOversampledSamples = static_cast<Index>(static_cast<float>(numSamples) * oversamplingRate);
+    auto const numUpsampledSamples = upsampling(io, numSamples);
+    // this implementation of sample precise automation does not support linear phase oversampling, so
+    assert(numUpsampledSamples == numOversampledSamples);
+
+    auto const toOversampled = [&](Index sampleOffset) {
+      return std::min(static_cast<Index>(static_cast<float>(sampleOffset) * oversamplingRate), numOversampledSamples);
+    };
+
+    // only the automatable parameters that received points are scheduled, the others end their segment at the end of
+    // the block, so they never start one
+    auto const numQueues = std::min(parameterChanges.getNumQueues(), static_cast<Index>(NumParameters::value));
+    bool hasAutomation = false;
+    for (Index queue = 0; queue < numQueues; ++queue) {
+      auto const paramIndex = parameterChanges.getParamIndex(queue);
+      isScheduled[queue] = parameterChanges.getNumPoints(queue) > 0 && paramIndex < NumParameters::value &&
+                           parameters.isParameterAutomatable(paramIndex);
+      segmentEndPoint[queue] = 0;
+      segmentEndSample[queue] =
+        isScheduled[queue] ? toOversampled(parameterChanges.getPoint(queue, 0).sampleOffset) : numOversampledSamples;
+      hasAutomation = hasAutomation || isScheduled[queue];
+    }
+
+    if (!hasAutomation && !hasNextEvent) {
+      staticProcessing_(io, numOversampledSamples);
+    }
+    else {
+      // prepareAutomation may return a reference to an automation object that persists across blocks
+      decltype(auto) automation = prepareAutomation();
+
+      // ramp from the value at the end of the previous block to the first point
+      for (Index queue = 0; queue < numQueues; ++queue) {
+        auto const firstSample = segmentEndSample[queue];
+        if (isScheduled[queue] && firstSample > 0) {
+          auto const paramIndex = parameterChanges.getParamIndex(queue);
+          auto const value =
+            parameters.valueFromNormalized(paramIndex, parameterChanges.getPoint(queue, 0).normalizedValue);
+          setParameterAutomation(automation,
+                                 AutomationEvent(paramIndex, 0, parameters.get(paramIndex), firstSample, value));
+        }
+      }
+
+      // a mapped controller jumps its parameter to the value of the event, until the next automation point
+      auto const dispatchEvent = [&](Index currentSample) {
+        auto const paramIndex = getMappedParameter(nextEvent, midiMapping);
+        if (paramIndex >= NumParameters::value) {
+          onMidiEvent(nextEvent);
+        }
+        else if (parameters.isParameterAutomatable(paramIndex)) {
+          auto const value = parameters.valueFromNormalized(paramIndex, nextEvent.value);
+          setParameterAutomation(automation,
+                                 AutomationEvent(paramIndex, currentSample, value, numOversampledSamples, value));
+        }
+      };
+
+      Index currentSample = 0;
+      while (currentSample < numOversampledSamples) {
+        while (hasNextEvent && toOversampled(nextEvent.sampleOffset) <= currentSample) {
+          dispatchEvent(currentSample);
+          hasNextEvent = readNextEvent();
+        }
+        Index nextSample = hasNextEvent ? toOversampled(nextEvent.sampleOffset) : numOversampledSamples;
+        for (Index queue = 0; queue < numQueues; ++queue) {
+          if (segmentEndSample[queue] == currentSample) {
+            // start a new segment from the last point at the current sample (more than one point at the same sample is
+            // a jump) to the next point, or hold the value until the end of the block if there are no more points
+            auto const paramIndex = parameterChanges.getParamIndex(queue);
+            auto const numPoints = parameterChanges.getNumPoints(queue);
+            auto point = segmentEndPoint[queue];
+            while (point + 1 < numPoints &&
+                   toOversampled(parameterChanges.getPoint(queue, point + 1).sampleOffset) <= currentSample) {
+              ++point;
+            }
+            auto const value =
+              parameters.valueFromNormalized(paramIndex, parameterChanges.getPoint(queue, point).normalizedValue);
+            if (point + 1 < numPoints) {
+              auto const nextPoint = parameterChanges.getPoint(queue, point + 1);
+              auto const nextPointSample = toOversampled(nextPoint.sampleOffset);
+              auto const nextValue = parameters.valueFromNormalized(paramIndex, nextPoint.normalizedValue);
+              setParameterAutomation(automation,
+                                     AutomationEvent(paramIndex, currentSample, value, nextPointSample, nextValue));
+              segmentEndPoint[queue] = point + 1;
+              segmentEndSample[queue] = nextPointSample;
+            }
+            else {
+              setParameterAutomation(automation,
+                                     AutomationEvent(paramIndex, currentSample, value, numOversampledSamples, value));
+              segmentEndPoint[queue] = numPoints;
+              segmentEndSample[queue] = numOversampledSamples;
+            }
+          }
+          nextSample = std::min(nextSample, segmentEndSample[queue]);
+        }
+        automatedProcessing(automation, io, currentSample, nextSample);
+        currentSample = nextSample;
+      }
+    }
+    downsampling(io, numOversampledSamples, numSamples);
+  }
+  // the events left are the ones past the end of the block, or all of them when flushing, as there is no audio to split
+  while (hasNextEvent) {
+    if (getMappedParameter(nextEvent, midiMapping) >= NumParameters::value) {
+      onMidiEvent(nextEvent);
+    }
+    hasNextEvent = readNextEvent();
+  }
+  updateParametersToLastPoint(parameterChanges);
+  updateMidiControlledParameters(parameterChanges, midiEvents, midiMapping);
+}
+
+} // namespace unplug
@@ -0,0 +1,130 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+
+#include "unplug/Index.hpp"
+#include <algorithm>
+
+namespace unplug {
+
+/**
+ * QualityGovernor lowers the quality of the processing when its load is too high for real-time. It does not measure
+ * the processing time itself: it is fed the smoothed load computed by DspLoad, see UnplugProcessor::getDspLoad. When
+ * the load goes above a threshold, it asks the processing code to lower its quality by one step, and when the load
+ * stays below a lower threshold for a while, it allows the quality to go back up by one step. The quality is expressed
+ * as a number of steps below the one requested by the user, so that it can be applied to any setting that trades
+ * quality for processing time, such as the oversampling order.
+ * */
+class QualityGovernor final
+{
+public:
+  struct Settings final
+  {
+    /** the load above which the quality is lowered */
+    double stepDownLoad = 0.6;
+    /** the load below which the quality can be raised. Keep it well below half of stepDownLoad, as lowering the
+     * quality usually halves the processing time. */
+    double stepUpLoad = 0.2;
+    /** how long the load must stay below stepUpLoad before the quality is raised, in seconds */
+    double stepUpHoldTime = 2.0;
+    /** the minimum time between two changes of quality, in seconds. Keep it longer than the smoothing time of the
+     * DspLoad, so that the load reflects the new quality before the next change. */
+    double settlingTime = 0.5;
+  };
+
+  QualityGovernor() = default;
+
+  explicit QualityGovernor(Settings settings_)
+    : settings{ settings_ }
+  {}
+
+  /**
+   * Sets the sample rate of the processing. Call it before processing, not on the audio thread.
+   * @sampleRate_ the sample rate
+   * */
+  void setSampleRate(double sampleRate_)
+  {
+    sampleRate = sampleRate_;
+    reset();
+  }
+
+  /**
+   * Restores the full quality.
+   * */
+  void reset()
+  {
+    reduction = 0;
+    timeBelowStepUpLoad = 0.0;
+    timeSinceLastChange = 0.0;
+  }
+
+  /**
+   * Updates the quality reduction. Call it once per block, before getEffectiveQuality.
+   * @load the smoothed load of the processing, see DspLoad::getLoad
+   * @numSamples the number of samples of the block, at the sample rate set with setSampleRate
+   * @maxReduction the number of steps the quality can currently be lowered by, usually the requested quality minus the
+   * lowest one
+   * */
+  void update(double load, Index numSamples, int maxReduction)
+  {
+    reduction = std::min(reduction, std::max(maxReduction, 0));
+    if (numSamples == 0 || sampleRate <= 0.0) {
+      return;
+    }
+    auto const duration = static_cast<double>(numSamples) / sampleRate;
+    timeSinceLastChange += duration;
+    timeBelowStepUpLoad = load < settings.stepUpLoad ? timeBelowStepUpLoad + duration : 0.0;
+    if (timeSinceLastChange < settings.settlingTime) {
+      return;
+    }
+    if (load > settings.stepDownLoad && reduction < maxReduction) {
+      ++reduction;
+      timeSinceLastChange = 0.0;
+      timeBelowStepUpLoad = 0.0;
+    }
+    else if (timeBelowStepUpLoad >= settings.stepUpHoldTime && reduction > 0) {
+      --reduction;
+      timeSinceLastChange = 0.0;
+      timeBelowStepUpLoad = 0.0;
+    }
+  }
+
+  /**
+   * @requestedQuality the quality requested by the user
+   * @minQuality the lowest quality allowed
+   * @return the quality to use for the next block
+   * */
+  int getEffectiveQuality(int requestedQuality, int minQuality = 0) const
+  {
+    return std::max(std::min(requestedQuality, minQuality), requestedQuality - reduction);
+  }
+
+  /**
+   * @return how many steps the quality is currently lowered by
+   * */
+  int getReduction() const
+  {
+    return reduction;
+  }
+
+private:
+  Settings settings;
+  double sampleRate{ 44100.0 };
+  int reduction{ 0 };
+  double timeBelowStepUpLoad{ 0.0 };
+  double timeSinceLastChange{ 0.0 };
+};
+
+} // namespace unplug
@@ -0,0 +1,71 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace unplug {
+
+/**
+ * The time of the last read of some data that the dsp produces only for the user interface, such as a RingBuffer. The
+ * user interface beats it when it actually shows the data, and the dsp skips producing the data when there has been no
+ * beat for a while, for example because the plot is scrolled out of view, in a collapsed tab, or the window is hidden.
+ * */
+class ReaderHeartbeat final
+{
+public:
+  /**
+   * To be called by the reader, every time it reads.
+   * */
+  void beat()
+  {
+    lastBeat.store(now(), std::memory_order_relaxed);
+  }
+
+  /**
+   * @return true if the reader has beaten within the timeout. Can be called on the audio thread.
+   * */
+  bool isAlive(float timeoutInSeconds) const
+  {
+    auto const last = lastBeat.load(std::memory_order_relaxed);
+    auto const timeout = static_cast<int64_t>(static_cast<double>(timeoutInSeconds) * 1e9);
+    return last != neverBeaten && now() - last < timeout;
+  }
+
+  ReaderHeartbeat() = default;
+
+  ReaderHeartbeat(ReaderHeartbeat const& other)
+    : lastBeat{ other.lastBeat.load(std::memory_order_relaxed) }
+  {}
+
+  ReaderHeartbeat& operator=(ReaderHeartbeat const& other)
+  {
+    lastBeat.store(other.lastBeat.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    return *this;
+  }
+
+private:
+  static int64_t now()
+  {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+  }
+
+  static constexpr int64_t neverBeaten = INT64_MIN;
+  std::atomic<int64_t> lastBeat{ neverBeaten };
+};
+
+} // namespace unplug
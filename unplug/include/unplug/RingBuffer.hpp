@@ -15,8 +15,11 @@
 #include "unplug/ContextInfo.hpp"
 #include "unplug/Index.hpp"
 #include "unplug/Math.hpp"
+#include "unplug/ReaderHeartbeat.hpp"
 #include "unplug/Serialization.hpp"
 #include <atomic>
+#include <cassert>
+#include <cstdint>
 #include <vector>
 
 namespace unplug {
@@ -26,18 +29,42 @@ struct RingBufferSettings final
   ContextInfo context;
   float pointsPerSecond = 128;
   float durationInSeconds = 1.f;
+  // the dsp stops sending data to the ring buffer when the user interface has not read it for this long
+  float readerTimeoutInSeconds = 0.5f;
   bool operator==(RingBufferSettings const&) const noexcept = default;
 };
 
 /**
- * A ring buffer to send continuous data from the dsp to the user interface.
+ * How the channels of a RingBuffer are stored.
+ * - interleaved: the points of all the channels at the same time are contiguous
+ * - planar: each channel is a contiguous array, starting on a cache line, so the points of a channel are read with
+ * stride 1
  * */
-template<class ElementType, class Allocator = std::allocator<ElementType>>
+enum class RingBufferLayout
+{
+  interleaved,
+  planar
+};
+
+/**
+ * A ring buffer to send continuous data from the dsp to the user interface. Its memory is allocated when the context or
+ * the resolution are set, so an ArenaAllocator can be used to keep it pre-faulted and locked, see Arena.hpp.
+ * The user interface marks it as read every time it shows it, and sendToRingBuffer skips the work when it has not been
+ * read within the reader timeout of its settings.
+ * */
+template<class ElementType,
+         class Allocator = std::allocator<ElementType>,
+         RingBufferLayout layout = RingBufferLayout::interleaved>
 class RingBuffer final
 {
 public:
   using Buffer = std::vector<ElementType, Allocator>;
 
+  static constexpr RingBufferLayout getLayout()
+  {
+    return layout;
+  }
+
   Buffer& getBuffer()
   {
     return buffer;
@@ -45,7 +72,33 @@ public:
 
   ElementType& at(Index channel, Index pointIndex)
   {
-    return buffer[numChannels * pointIndex + channel];
+    return buffer[getChannelOffset(channel) + getPointStride() * pointIndex];
+  }
+
+  /**
+   * @return the index in the buffer of the first point of a channel
+   * */
+  Index getChannelOffset(Index channel) const
+  {
+    if constexpr (layout == RingBufferLayout::planar) {
+      return firstElement + channel * channelStride;
+    }
+    else {
+      return channel;
+    }
+  }
+
+  /**
+   * @return the distance in the buffer between two consecutive points of a channel
+   * */
+  Index getPointStride() const
+  {
+    if constexpr (layout == RingBufferLayout::planar) {
+      return 1;
+    }
+    else {
+      return numChannels;
+    }
   }
 
   Index wrapIndex(int index) const
@@ -143,8 +196,46 @@ public:
     return settings.context;
   }
 
-  explicit RingBuffer(RingBufferSettings settings = {})
-    : settings{ settings }
+  /**
+   * To be called by the user interface when it reads the ring buffer.
+   * @return the number of points written by the dsp since the previous read, that is how far the reader lags behind
+   * the writer. When it gets close to getBufferCapacity() - getReadBlockSize(), points are overwritten before they are
+   * shown.
+   * */
+  Index markAsRead()
+  {
+    readerHeartbeat.beat();
+    if (bufferCapacity == 0) {
+      return 0;
+    }
+    auto const currentWritePosition = getWritePosition();
+    auto const lag = wrapIndex(static_cast<int>(currentWritePosition) - static_cast<int>(lastReadWritePosition));
+    lastReadWritePosition = currentWritePosition;
+    return lag;
+  }
+
+  /**
+   * @return true if the user interface has read the ring buffer within the reader timeout
+   * */
+  bool isBeingRead() const
+  {
+    return readerHeartbeat.isAlive(settings.readerTimeoutInSeconds);
+  }
+
+  /**
+   * Discards the partially accumulated point, so that a ring buffer that has not been sent data for a while does not
+   * mix it with the stale one.
+   * */
+  void resetAccumulation()
+  {
+    std::fill(std::begin(accumulator), std::end(accumulator), ElementType(0.f));
+    accumulatedSamples = 0.f;
+  }
+
+  explicit RingBuffer(RingBufferSettings settings = {}, Allocator const& allocator = Allocator{})
+    : accumulator{ allocator }
+    , settings{ settings }
+    , buffer{ allocator }
   {
     secondsPerPoint = 1.f / settings.pointsPerSecond;
     resize();
@@ -189,6 +280,10 @@ private:
 
   void resize(Index newSize)
   {
+    if constexpr (layout == RingBufferLayout::planar) {
+      resizePlanar(newSize);
+      return;
+    }
     auto const currentWritePosition = getWritePosition();
     if (newSize <= currentWritePosition) {
       setWritePosition(0);
@@ -203,6 +298,47 @@ private:
     buffer.resize(newSize * numChannels);
   }
 
+  // keeps the same points as the interleaved layout, moving each channel to its new place
+  void resizePlanar(Index newSize)
+  {
+    auto const currentWritePosition = getWritePosition();
+    auto const isShifting = newSize <= currentWritePosition;
+    auto const firstPointToKeep = isShifting ? currentWritePosition - newSize : 0;
+    auto const numPointsToKeep = isShifting ? newSize : std::min(newSize, bufferCapacity);
+    if (isShifting) {
+      setWritePosition(0);
+    }
+    auto const newChannelStride = (newSize + elementsPerCacheLine - 1) / elementsPerCacheLine * elementsPerCacheLine;
+    auto newBuffer = Buffer(newChannelStride * numChannels + elementsPerCacheLine - 1, buffer.get_allocator());
+    auto const newFirstElement = getFirstAlignedElement(newBuffer);
+    for (Index channel = 0; channel < numChannels; ++channel) {
+      auto const source = firstElement + channel * channelStride + firstPointToKeep;
+      if (source + numPointsToKeep > static_cast<Index>(buffer.size())) {
+        break;
+      }
+      std::copy(std::begin(buffer) + source,
+                std::begin(buffer) + source + numPointsToKeep,
+                std::begin(newBuffer) + newFirstElement + channel * newChannelStride);
+    }
+    buffer = std::move(newBuffer);
+    firstElement = getFirstAlignedElement(buffer);
+    channelStride = newChannelStride;
+    bufferCapacity = newSize;
+  }
+
+  static Index getFirstAlignedElement(Buffer const& buffer)
+  {
+    if (elementsPerCacheLine == 1 || buffer.empty()) {
+      return 0;
+    }
+    auto const address = reinterpret_cast<uintptr_t>(buffer.data());
+    return static_cast<Index>(((cacheLineSize - address % cacheLineSize) % cacheLineSize) / sizeof(ElementType));
+  }
+
+  static constexpr Index cacheLineSize = 64;
+  static constexpr Index elementsPerCacheLine =
+    cacheLineSize % sizeof(ElementType) == 0 ? cacheLineSize / sizeof(ElementType) : 1;
+
   template<class T>
   struct MovableAtomic
   {
@@ -247,17 +383,26 @@ private:
 
   Index numChannels = 1;
   Index bufferCapacity = 0;
+  // only used by the planar layout
+  Index firstElement = 0;
+  Index channelStride = 0;
   MovableAtomic<int> writePosition{ 0 };
+  // only used by the reader
+  Index lastReadWritePosition = 0;
   Index readBlockSize = 0;
   float pointsPerSample = 1.f;
   float samplesPerPoint = 1;
   RingBufferSettings settings;
   float secondsPerPoint;
+  ReaderHeartbeat readerHeartbeat;
   Buffer buffer;
 };
 
-template<Serialization::Action action, class ElementType, class Allocator = std::allocator<ElementType>>
-bool serialization(RingBuffer<ElementType, Allocator>& ringBuffer, Serialization::Streamer<action>& streamer)
+template<Serialization::Action action,
+         class ElementType,
+         class Allocator = std::allocator<ElementType>,
+         RingBufferLayout layout = RingBufferLayout::interleaved>
+bool serialization(RingBuffer<ElementType, Allocator, layout>& ringBuffer, Serialization::Streamer<action>& streamer)
 {
   auto settings = ringBuffer.getSettings();
   if (!streamer(settings.pointsPerSecond))
@@ -274,6 +419,7 @@ bool serialization(RingBuffer<ElementType, Allocator>& ringBuffer, Serialization
 
 /**
  * Sends data to a ring buffer, with custom logic to average it
+ * @return false if nothing has been sent because the ring buffer is not being read
  * */
 template<class SampleType,
          class Preprocess,
@@ -281,8 +427,9 @@ template<class SampleType,
          class Accumulate,
          class Postprocess,
          class ElementType = float,
-         class Allocator = std::allocator<ElementType>>
-void sendToRingBuffer(RingBuffer<ElementType, Allocator>& ringBuffer,
+         class Allocator = std::allocator<ElementType>,
+         RingBufferLayout layout = RingBufferLayout::interleaved>
+bool sendToRingBuffer(RingBuffer<ElementType, Allocator, layout>& ringBuffer,
                       SampleType** buffers,
                       Index numChannels,
                       Index startSample,
@@ -293,6 +440,10 @@ void sendToRingBuffer(RingBuffer<ElementType, Allocator>& ringBuffer,
                       Postprocess postprocess,
                       float oversamplingRate = 1.f)
 {
+  if (!ringBuffer.isBeingRead()) {
+    ringBuffer.resetAccumulation();
+    return false;
+  }
   auto const currentWritePosition = ringBuffer.getWritePosition();
   auto const samplesPerPoint = ringBuffer.getSamplesPerPoint() * oversamplingRate;
   auto const pointsPerSample = ringBuffer.getPointsPerSample() / oversamplingRate;
@@ -302,11 +453,14 @@ void sendToRingBuffer(RingBuffer<ElementType, Allocator>& ringBuffer,
     auto const numSamplesNeededForNextPoint = samplesPerPoint - ringBuffer.accumulatedSamples;
     auto const lastSampleOfPoint = static_cast<float>(fistSampleOfPoint) + numSamplesNeededForNextPoint;
     auto const lastSampleToAccumulate = FractionalIndex(std::min(static_cast<float>(endSample), lastSampleOfPoint));
-    for (Index sample = fistSampleOfPoint; sample < lastSampleToAccumulate.integer; ++sample) {
-      for (Index channel = 0; channel < numChannels; ++channel) {
-        auto const sampleValue = preprocess(buffers[channel][sample], channel);
-        ringBuffer.accumulator[channel] = accumulate(ringBuffer.accumulator[channel], sampleValue);
+    // each channel is accumulated over contiguous samples, in a local
+    for (Index channel = 0; channel < numChannels; ++channel) {
+      auto accumulated = ringBuffer.accumulator[channel];
+      auto const channelBuffer = buffers[channel];
+      for (Index sample = fistSampleOfPoint; sample < lastSampleToAccumulate.integer; ++sample) {
+        accumulated = accumulate(accumulated, preprocess(channelBuffer[sample], channel));
       }
+      ringBuffer.accumulator[channel] = accumulated;
     }
     bool const accumulationIsCompleted = lastSampleOfPoint == lastSampleToAccumulate.value;
     if (accumulationIsCompleted) {
@@ -342,20 +496,25 @@ void sendToRingBuffer(RingBuffer<ElementType, Allocator>& ringBuffer,
     }
   }
   ringBuffer.setWritePosition(pointIndex);
+  return true;
 }
 
 /**
  * Sends data to a ring buffer, using simple averaging
+ * @return false if nothing has been sent because the ring buffer is not being read
  * */
-template<class SampleType, class ElementType = float, class Allocator = std::allocator<ElementType>>
-void sendToRingBuffer(RingBuffer<ElementType, Allocator>& ringBuffer,
+template<class SampleType,
+         class ElementType = float,
+         class Allocator = std::allocator<ElementType>,
+         RingBufferLayout layout = RingBufferLayout::interleaved>
+bool sendToRingBuffer(RingBuffer<ElementType, Allocator, layout>& ringBuffer,
                       SampleType** buffers,
                       Index numChannels,
                       Index startSample,
                       Index endSample,
                       float oversamplingRate = 1.f)
 {
-  sendToRingBuffer(
+  return sendToRingBuffer(
     ringBuffer,
     buffers,
     numChannels,
@@ -386,23 +545,27 @@ struct WaveformElement final
 /**
  * A ring buffer to send the waveform profile to the user interface.
  * */
-template<class SampleType, class Allocator = std::allocator<WaveformElement<SampleType>>>
-using WaveformRingBuffer = RingBuffer<WaveformElement<SampleType>, Allocator>;
+template<class SampleType,
+         class Allocator = std::allocator<WaveformElement<SampleType>>,
+         RingBufferLayout layout = RingBufferLayout::interleaved>
+using WaveformRingBuffer = RingBuffer<WaveformElement<SampleType>, Allocator, layout>;
 
 /**
  * Sends the waveform profile to a ring buffer.
+ * @return false if nothing has been sent because the ring buffer is not being read
  * */
 template<class SampleType,
          class WaveformSampleType = float,
-         class Allocator = std::allocator<WaveformElement<WaveformSampleType>>>
-void sendToWaveformRingBuffer(WaveformRingBuffer<WaveformSampleType, Allocator>& ringBuffer,
+         class Allocator = std::allocator<WaveformElement<WaveformSampleType>>,
+         RingBufferLayout layout = RingBufferLayout::interleaved>
+bool sendToWaveformRingBuffer(WaveformRingBuffer<WaveformSampleType, Allocator, layout>& ringBuffer,
                               SampleType** buffers,
                               Index numChannels,
                               Index startSample,
                               Index endSample,
                               float oversamplingRate = 1.f)
 {
-  sendToRingBuffer(
+  return sendToRingBuffer(
     ringBuffer,
     buffers,
     numChannels,
@@ -13,10 +13,13 @@
 
 #pragma once
 #include "unplug/Index.hpp"
+#include "unplug/MidiMapping.hpp"
 #ifdef UNPLUG_VST3
 #include "base/source/fstreamer.h"
 #endif
 
+#include <algorithm>
+#include <array>
 #include <map>
 #include <string>
 #include <unordered_map>
@@ -204,4 +207,220 @@ public:
   }
 };
 
+/**
+ * Chunked state format.
+ * The state begins with a header (a magic number, the version of the format and the version of the plugin), followed by
+ * tagged chunks, each one prefixed with its size in bytes, and terminated by an end chunk. Chunks with unknown tags are
+ * skipped, so that states saved by newer versions of the plugin can still be loaded. Within the parameters chunk the
+ * values are matched to the parameters by index, see writeParameterBlock.
+ * States saved before the chunked format was introduced begin directly with the version of the plugin, and are
+ * reported as legacy by readStateHeader.
+ * */
+
+constexpr uint32_t makeChunkTag(char a, char b, char c, char d)
+{
+  return (static_cast<uint32_t>(a) << 24u) | (static_cast<uint32_t>(b) << 16u) | (static_cast<uint32_t>(c) << 8u) |
+         static_cast<uint32_t>(d);
+}
+
+namespace ChunkTag {
+inline constexpr auto parameters = makeChunkTag('P', 'R', 'M', 'S');
+inline constexpr auto sharedData = makeChunkTag('S', 'H', 'R', 'D');
+inline constexpr auto user = makeChunkTag('U', 'S', 'E', 'R');
+inline constexpr auto midiMapping = makeChunkTag('M', 'I', 'D', 'I');
+inline constexpr auto end = makeChunkTag('E', 'N', 'D', ' ');
+} // namespace ChunkTag
+
+inline constexpr auto stateMagicNumber = static_cast<int32_t>(makeChunkTag('U', 'N', 'P', 'L'));
+inline constexpr int32_t stateFormatVersion = 1;
+
+enum class StateFormat
+{
+  legacy,
+  chunked
+};
+
+/**
+ * Writes the header of the chunked state format
+ * @stream the stream to write to
+ * @pluginVersion the version of the plugin
+ * @return true on success
+ * */
+inline bool writeStateHeader(Steinberg::IBStreamer& stream, std::array<int, 4> pluginVersion)
+{
+  if (!stream.writeInt32(stateMagicNumber))
+    return false;
+  if (!stream.writeInt32(stateFormatVersion))
+    return false;
+  return stream.writeInt32Array(pluginVersion.data(), static_cast<Steinberg::int32>(pluginVersion.size()));
+}
+
+/**
+ * Reads the header of a state, which may be either in the chunked format or in the legacy one
+ * @stream the stream to read from
+ * @pluginVersion on success, it holds the version of the plugin that saved the state
+ * @format on success, it holds the format of the state
+ * @return true on success
+ * */
+inline bool readStateHeader(Steinberg::IBStreamer& stream, std::array<int, 4>& pluginVersion, StateFormat& format)
+{
+  Steinberg::int32 first = 0;
+  if (!stream.readInt32(first))
+    return false;
+  if (first != stateMagicNumber) {
+    format = StateFormat::legacy;
+    pluginVersion[0] = first;
+    return stream.readInt32Array(pluginVersion.data() + 1, static_cast<Steinberg::int32>(pluginVersion.size() - 1));
+  }
+  format = StateFormat::chunked;
+  Steinberg::int32 formatVersion = 0;
+  if (!stream.readInt32(formatVersion))
+    return false;
+  if (formatVersion < 1)
+    return false;
+  return stream.readInt32Array(pluginVersion.data(), static_cast<Steinberg::int32>(pluginVersion.size()));
+}
+
+/**
+ * Writes a chunk: its tag, its size and the content written by writeContent, which must return true on success
+ * @stream the stream to write to
+ * @tag the tag of the chunk
+ * @writeContent a callable that writes the content of the chunk
+ * @return true on success
+ * */
+template<class WriteContent>
+bool writeChunk(Steinberg::IBStreamer& stream, uint32_t tag, WriteContent writeContent)
+{
+  if (!stream.writeInt32u(tag))
+    return false;
+  auto const sizePosition = stream.tell();
+  if (!stream.writeInt64(0))
+    return false;
+  auto const contentPosition = stream.tell();
+  if (!writeContent())
+    return false;
+  auto const endPosition = stream.tell();
+  if (stream.seek(sizePosition, Steinberg::kSeekSet) != sizePosition)
+    return false;
+  if (!stream.writeInt64(endPosition - contentPosition))
+    return false;
+  return stream.seek(endPosition, Steinberg::kSeekSet) == endPosition;
+}
+
+/**
+ * Writes the end chunk, which terminates a chunked state
+ * */
+inline bool writeEndChunk(Steinberg::IBStreamer& stream)
+{
+  return writeChunk(stream, ChunkTag::end, [] { return true; });
+}
+
+/**
+ * Reads all the chunks up to the end chunk, calling readContent(tag, size) for each of them. readContent should return
+ * false only if it fails to read a chunk it knows; unknown chunks should just be ignored returning true. Whatever
+ * readContent reads, the next chunk is read from the end of the current one.
+ * @stream the stream to read from
+ * @readContent a callable that reads the content of a chunk
+ * @return true on success
+ * */
+template<class ReadContent>
+bool readChunks(Steinberg::IBStreamer& stream, ReadContent readContent)
+{
+  while (true) {
+    Steinberg::uint32 tag = 0;
+    if (!stream.readInt32u(tag))
+      return false;
+    Steinberg::int64 size = 0;
+    if (!stream.readInt64(size) || size < 0)
+      return false;
+    if (tag == ChunkTag::end)
+      return true;
+    auto const contentPosition = stream.tell();
+    if (!readContent(static_cast<uint32_t>(tag), static_cast<int64_t>(size)))
+      return false;
+    auto const endPosition = contentPosition + size;
+    if (stream.seek(endPosition, Steinberg::kSeekSet) != endPosition)
+      return false;
+  }
+}
+
+/**
+ * Writes the normalized values of the parameters as a contiguous block: their number, then the values. The values are
+ * stored little endian, so on little endian machines they are written with a single call to the stream.
+ * The values are identified only by their index: parameters can be appended in newer versions of a plugin, but removing
+ * or reordering parameters shifts the values of all the following ones, and old states will load them into the wrong
+ * parameters.
+ * */
+inline bool writeParameterBlock(Steinberg::IBStreamer& stream, std::vector<double> const& values)
+{
+  if (!stream.writeInt32u(static_cast<Steinberg::uint32>(values.size())))
+    return false;
+#if BYTEORDER == kLittleEndian
+  auto const numBytes = static_cast<Steinberg::int32>(values.size() * sizeof(double));
+  return stream.writeRaw(values.data(), numBytes) == numBytes;
+#else
+  return stream.writeDoubleArray(values.data(), static_cast<Steinberg::int32>(values.size()));
+#endif
+}
+
+/**
+ * Reads a block of normalized parameter values written by writeParameterBlock. If the block holds more values than the
+ * size of the values vector, the exceeding ones are ignored; if it holds less, the vector is shrunk to their number.
+ * This only tolerates parameters added or removed at the end of the list, see writeParameterBlock.
+ * */
+inline bool readParameterBlock(Steinberg::IBStreamer& stream, std::vector<double>& values)
+{
+  Steinberg::uint32 numStoredValues = 0;
+  if (!stream.readInt32u(numStoredValues))
+    return false;
+  values.resize(std::min(values.size(), static_cast<std::size_t>(numStoredValues)));
+#if BYTEORDER == kLittleEndian
+  auto const numBytes = static_cast<Steinberg::int32>(values.size() * sizeof(double));
+  return stream.readRaw(values.data(), numBytes) == numBytes;
+#else
+  return stream.readDoubleArray(values.data(), static_cast<Steinberg::int32>(values.size()));
+#endif
+}
+
+/**
+ * Writes the assignments of a MidiMapping: their number, then the channel, the controller and the parameter of each.
+ * */
+inline bool writeMidiMappingBlock(Steinberg::IBStreamer& stream, detail::MidiMapping const& midiMapping)
+{
+  auto const assignments = midiMapping.getAssignments();
+  if (!stream.writeInt32u(static_cast<Steinberg::uint32>(assignments.size())))
+    return false;
+  for (auto const& assignment : assignments) {
+    if (!stream.writeInt32(assignment.channel))
+      return false;
+    if (!stream.writeInt32(assignment.controller))
+      return false;
+    if (!stream.writeInt32u(static_cast<Steinberg::uint32>(assignment.paramIndex)))
+      return false;
+  }
+  return true;
+}
+
+/**
+ * Reads the assignments written by writeMidiMappingBlock into an empty MidiMapping. The assignments to parameters that
+ * no longer exist are ignored.
+ * */
+inline bool readMidiMappingBlock(Steinberg::IBStreamer& stream, detail::MidiMapping& midiMapping, Index numParameters)
+{
+  Steinberg::uint32 numAssignments = 0;
+  if (!stream.readInt32u(numAssignments))
+    return false;
+  for (Steinberg::uint32 i = 0; i < numAssignments; ++i) {
+    Steinberg::int32 channel = 0;
+    Steinberg::int32 controller = 0;
+    Steinberg::uint32 paramIndex = 0;
+    if (!stream.readInt32(channel) || !stream.readInt32(controller) || !stream.readInt32u(paramIndex))
+      return false;
+    if (channel >= 0 && channel < detail::MidiMapping::numChannels && paramIndex < numParameters) {
+      midiMapping.mapParameter(static_cast<ParamIndex>(paramIndex), controller, channel);
+    }
+  }
+  return true;
+}
+
 } // namespace unplug::Serialization
\ No newline at end of file
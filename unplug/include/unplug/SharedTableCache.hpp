@@ -0,0 +1,128 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace unplug {
+
+/**
+ * A process-wide cache of immutable data, like filter coefficients or lookup tables, that can be shared by all the
+ * instances of a plugin that use the same configuration. Tables are built on first request and destroyed when the last
+ * instance using them releases its reference. It is thread-safe: concurrent requests for the same key build the table
+ * only once, while tables for different keys can be built concurrently.
+ * Usage:
+ *   struct FilterKey final
+ *   {
+ *     double sampleRate;
+ *     int order;
+ *     bool isLinearPhase;
+ *     auto operator<=>(FilterKey const&) const = default;
+ *   };
+ *   std::shared_ptr<FilterCoefficients const> coefficients =
+ *     SharedTableCache<FilterKey, FilterCoefficients>::get(key, [&] { return FilterCoefficients(key); });
+ * It must not be used on the audio thread: request the tables in setActive (see UnplugProcessor::onSetup) and keep
+ * the returned pointer for as long as they are needed.
+ * @Key the configuration that identifies a table. It must be copyable and ordered by operator<.
+ * @Table the type of the shared data
+ * */
+template<class Key, class Table>
+class SharedTableCache final
+{
+public:
+  using TablePtr = std::shared_ptr<Table const>;
+
+  /**
+   * Gets the table associated with the key, building it with the build function if no instance is currently using
+   * it.
+   * @key the configuration of the table
+   * @build a function with no arguments that returns the table by value
+   * */
+  template<class Build>
+  static TablePtr get(Key const& key, Build&& build)
+  {
+    auto& cache = getInstance();
+    auto entry = cache.getEntry(key);
+    auto const lock = std::lock_guard{ entry->mutex };
+    if (auto table = entry->table.lock()) {
+      return table;
+    }
+    auto table = std::make_shared<Table const>(std::invoke(std::forward<Build>(build)));
+    entry->table = table;
+    return table;
+  }
+
+  /**
+   * @return the number of keys whose table is currently alive.
+   * */
+  static int getNumTables()
+  {
+    auto& cache = getInstance();
+    auto const lock = std::lock_guard{ cache.mutex };
+    int numTables = 0;
+    for (auto const& [key, entry] : cache.entries) {
+      auto const entryLock = std::lock_guard{ entry->mutex };
+      numTables += entry->table.expired() ? 0 : 1;
+    }
+    return numTables;
+  }
+
+private:
+  struct Entry final
+  {
+    std::mutex mutex;
+    std::weak_ptr<Table const> table;
+  };
+
+  static SharedTableCache& getInstance()
+  {
+    static SharedTableCache instance;
+    return instance;
+  }
+
+  std::shared_ptr<Entry> getEntry(Key const& key)
+  {
+    auto const lock = std::lock_guard{ mutex };
+    removeUnusedEntries();
+    auto& entry = entries[key];
+    if (!entry) {
+      entry = std::make_shared<Entry>();
+    }
+    return entry;
+  }
+
+  // entries referenced only by the map and whose table has been released are no longer needed
+  void removeUnusedEntries()
+  {
+    for (auto it = entries.begin(); it != entries.end();) {
+      auto const isUnused = [&] {
+        if (it->second.use_count() != 1) {
+          return false;
+        }
+        auto const entryLock = std::lock_guard{ it->second->mutex };
+        return it->second->table.expired();
+      }();
+      it = isUnused ? entries.erase(it) : std::next(it);
+    }
+  }
+
+  std::mutex mutex;
+  std::map<Key, std::shared_ptr<Entry>> entries;
+};
+
+} // namespace unplug
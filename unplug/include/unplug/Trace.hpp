@@ -0,0 +1,99 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+
+/**
+ * Set UNPLUG_TRACE to 1 to compile the trace macros. When it is 0 (the default), they expand to nothing.
+ * */
+#ifndef UNPLUG_TRACE
+#define UNPLUG_TRACE 0
+#endif
+
+namespace unplug::trace {
+
+/**
+ * Starts tracing, if it is not already running, and increments the number of users of the trace. The events are
+ * written as Chrome trace JSON (readable by chrome://tracing and Perfetto) to the file specified by the environment
+ * variable UNPLUG_TRACE_FILE, or to a file named unplug-trace-<time>.json in the temporary directory. Not to be called
+ * on the audio thread.
+ * */
+void start();
+
+/**
+ * Decrements the number of users of the trace, and stops tracing when it gets to zero, flushing the remaining events
+ * to the file. Not to be called on the audio thread.
+ * */
+void stop();
+
+/**
+ * Records the beginning of a scope on the current thread. It is lock-free and does not allocate memory, so it can be
+ * used on the audio thread. If the buffer of the thread is full, the event is dropped, and the number of dropped events
+ * is written to the trace as the counter "dropped trace events".
+ * @name the name of the scope, which must be a string literal or otherwise outlive the trace
+ * */
+void begin(const char* name);
+
+/**
+ * Records the end of a scope on the current thread, see begin.
+ * */
+void end(const char* name);
+
+/**
+ * Records the value of a counter on the current thread, shown as a track of its own by the trace viewers. Like begin,
+ * it can be used on the audio thread.
+ * @name the name of the counter, which must be a string literal or otherwise outlive the trace
+ * @value the value of the counter
+ * */
+void counter(const char* name, double value);
+
+/**
+ * Records the beginning of a scope on construction and its end on destruction.
+ * */
+class Scope final
+{
+public:
+  explicit Scope(const char* name)
+    : name{ name }
+  {
+    begin(name);
+  }
+
+  ~Scope()
+  {
+    end(name);
+  }
+
+  Scope(Scope const&) = delete;
+  Scope& operator=(Scope const&) = delete;
+
+private:
+  const char* name;
+};
+
+} // namespace unplug::trace
+
+#if UNPLUG_TRACE
+#define UNPLUG_TRACE_CONCAT_IMPL(a, b) a##b
+#define UNPLUG_TRACE_CONCAT(a, b) UNPLUG_TRACE_CONCAT_IMPL(a, b)
+#define UNPLUG_TRACE_SCOPE(name) ::unplug::trace::Scope UNPLUG_TRACE_CONCAT(unplugTraceScope, __LINE__)(name)
+#define UNPLUG_TRACE_COUNTER(name, value) ::unplug::trace::counter(name, static_cast<double>(value))
+#define UNPLUG_TRACE_START() ::unplug::trace::start()
+#define UNPLUG_TRACE_STOP() ::unplug::trace::stop()
+#else
+#define UNPLUG_TRACE_SCOPE(name)
+#define UNPLUG_TRACE_COUNTER(name, value)
+#define UNPLUG_TRACE_START()
+#define UNPLUG_TRACE_STOP()
+#endif
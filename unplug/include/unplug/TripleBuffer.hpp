@@ -0,0 +1,134 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include "unplug/detail/RedrawConditions.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace unplug {
+
+/**
+ * A triple buffer to publish snapshots of any state, such as filter coefficients or analysis results, from the dsp to
+ * the user interface. The producer always has a copy to write to and never waits, the consumer always reads the last
+ * complete copy, and the two never touch the same copy. The three copies are allocated with the TripleBuffer itself,
+ * so assigning a copy on the audio thread does not allocate as long as copying T does not.
+ * There must be a single producer and a single consumer.
+ * */
+template<class T>
+class TripleBuffer final
+{
+public:
+  explicit TripleBuffer(T const& initialValue = T{})
+  {
+    for (auto& slot : slots) {
+      slot.value = initialValue;
+    }
+  }
+
+  TripleBuffer(TripleBuffer const&) = delete;
+  TripleBuffer& operator=(TripleBuffer const&) = delete;
+
+  /**
+   * @return the copy to write to, to be called by the producer. It holds an older snapshot, not the last published one.
+   * */
+  T& getWriteBuffer()
+  {
+    return slots[writeIndex].value;
+  }
+
+  /**
+   * Publishes the copy returned by getWriteBuffer, to be called by the producer. The next call to getWriteBuffer
+   * returns another copy.
+   * */
+  void publish()
+  {
+    auto const previous = middle.exchange(static_cast<uint8_t>(writeIndex | newDataFlag), std::memory_order_acq_rel);
+    writeIndex = previous & indexMask;
+  }
+
+  /**
+   * Assigns the value to the copy returned by getWriteBuffer, and publishes it.
+   * */
+  void publish(T const& value)
+  {
+    getWriteBuffer() = value;
+    publish();
+  }
+
+  /**
+   * Takes the last published copy, to be called by the consumer.
+   * @return true if a copy has been published since the last call, false if the read buffer is left as it is
+   * */
+  bool update()
+  {
+    if (!hasNewData()) {
+      return false;
+    }
+    auto const previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+    readIndex = previous & indexMask;
+    return true;
+  }
+
+  /**
+   * @return the copy taken by the last call to update, to be called by the consumer
+   * */
+  T const& getReadBuffer() const
+  {
+    return slots[readIndex].value;
+  }
+
+  /**
+   * @return true if a copy has been published and not taken yet by update. Can be called by any thread.
+   * */
+  bool hasNewData() const
+  {
+    return (middle.load(std::memory_order_acquire) & newDataFlag) != 0;
+  }
+
+private:
+  static constexpr uint8_t indexMask = 3;
+  static constexpr uint8_t newDataFlag = 4;
+
+  // each copy on its own cache line, so that the producer and the consumer do not share one
+  struct alignas(64) Slot final
+  {
+    T value;
+  };
+
+  std::array<Slot, 3> slots;
+  // the index of the copy between the producer and the consumer, and whether it has not been taken yet
+  std::atomic<uint8_t> middle{ 1 };
+  uint8_t writeIndex = 0;
+  uint8_t readIndex = 2;
+};
+
+/**
+ * To be called in UserInterface::paint, for the triple buffers that the user interface shows. In a frame that calls it,
+ * the redraw timer only redraws the next frame if one of the triple buffers has new data, if there has been some user
+ * input, or if the parameters have been changed, also by the host through automation, presets or states. Frames that
+ * do not call it are always redrawn, so it must not be used if the frame shows anything else that changes on its own,
+ * such as meters or ring buffers.
+ * */
+template<class T>
+void redrawOnNewData(TripleBuffer<T> const& tripleBuffer)
+{
+  detail::addRedrawCondition({ &tripleBuffer, [](void const* object) {
+                                return static_cast<TripleBuffer<T> const*>(object)->hasNewData();
+                              } });
+}
+
+} // namespace unplug
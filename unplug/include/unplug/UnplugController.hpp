@@ -16,13 +16,17 @@
 #include "GetParameterDescriptions.hpp"
 #include "Meters.hpp"
 #include "SharedData.hpp"
+#include "pluginterfaces/vst/ivstmidilearn.h"
 #include "public.sdk/source/vst/vsteditcontroller.h"
 #include "unplug/GetVersion.hpp"
 #include "unplug/MeterStorage.hpp"
 #include "unplug/MidiMapping.hpp"
+#include "unplug/detail/SharedMidiMapping.hpp"
 #include "unplug/detail/Vst3View.hpp"
+#include <atomic>
 #include <memory>
 #include <unordered_set>
+#include <vector>
 
 namespace unplug {
 using UpdateLatencyOnParamChange = std::function<void(unplug::ParamIndex paramId, double parameterValue)>;
@@ -34,6 +38,7 @@ namespace Steinberg::Vst {
 class UnplugController
   : public EditControllerEx1
   , public IMidiMapping
+  , public IMidiLearn
 {
 public:
   using FUnknown = FUnknown;
@@ -60,12 +65,49 @@ public:
                                                  CtrlNumber midiControllerNumber,
                                                  ParamID& tag) final;
 
+  tresult PLUGIN_API onLiveMIDIControllerInput(int32 busIndex, int16 channel, CtrlNumber midiCC) final;
+
   tresult PLUGIN_API setParamNormalized(ParamID tag, ParamValue value) final;
 
   tresult PLUGIN_API notify(IMessage* message) final;
 
   void onViewClosed();
 
+  /**
+   * Publishes midiMapping to the processor and tells the host that the assignments have changed. To be called after
+   * editing midiMapping.
+   * */
+  void onMidiMappingChanged();
+
+  /**
+   * Maps the next controller received from the host to the parameter, see IMidiLearn. The controllers that were mapped
+   * to the parameter are unmapped.
+   * @paramIndex the parameter to map
+   * @listensToAllChannels if true the controller is mapped on all channels, otherwise only on the one it is received
+   * */
+  void startMidiLearn(ParamID paramIndex, bool listensToAllChannels);
+
+  void stopMidiLearn()
+  {
+    midiLearnParameter = MidiMapping::unmapped;
+  }
+
+  /** @return the parameter waiting for a controller, or MidiMapping::unmapped if no MIDI learn is in progress */
+  unplug::ParamIndex getMidiLearnParameter() const
+  {
+    return midiLearnParameter;
+  }
+
+  /**
+   * @return the number of times the parameters have been changed, by the user interface or by the host: automation,
+   * presets and states. It wraps around, and can be compared with a previous value to know whether the parameters have
+   * changed since then.
+   * */
+  uint32_t getNumParameterChanges() const
+  {
+    return numParameterChanges.load(std::memory_order_acquire);
+  }
+
 //  bool setValueNormalizedFormUserInterface(ParamID tag, ParamValue value);
 
 protected:
@@ -74,18 +116,33 @@ protected:
 
 private:
   void applyPreset(int presetIndex);
-  void restart();
+  void restart(int32 flags = kLatencyChanged);
+  /** @return the flags of restartComponent needed by the loaded values, or 0 if no restart is needed */
+  int32 loadParameters(std::vector<double> const& values);
+  /** @return kMidiCCAssignmentChanged if the loaded mapping differs from the current one, 0 otherwise */
+  int32 loadMidiMapping(MidiMapping const& loadedMidiMapping);
+  void sendLatencyUpdate(ParamID tag, ParamValue plainValue);
 
 public:
   MidiMapping midiMapping;
+  std::shared_ptr<unplug::detail::SharedMidiMapping> sharedMidiMapping;
   std::array<int, 2> lastViewSize{ { -1, -1 } };
   std::shared_ptr<unplug::MeterStorage> meters;
   std::shared_ptr<unplug::SharedDataWrapped> sharedData;
   std::unordered_map<ParamID, unplug::ParamEditPolicy> notAutomatableParameters;
+  std::vector<ParamID> latencyParameters;
 
 private:
+  // the mapping set by the parameter descriptions, restored by the states that do not have one
+  MidiMapping defaultMidiMapping;
+  unplug::ParamIndex midiLearnParameter{ MidiMapping::unmapped };
+  bool isMidiLearnOnAllChannels{ true };
+  // the host may set the parameters from any thread
+  std::atomic<uint32_t> numParameterChanges{ 0 };
+
   DEFINE_INTERFACES
   DEF_INTERFACE(IMidiMapping)
+  DEF_INTERFACE(IMidiLearn)
   END_DEFINE_INTERFACES(EditControllerEx1)
   DELEGATE_REFCOUNT(EditControllerEx1)
 };
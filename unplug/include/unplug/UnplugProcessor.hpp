@@ -18,15 +18,25 @@
 #include "PluginState.hpp"
 #include "SharedData.hpp"
 #include "base/source/fstreamer.h"
+#include "unplug/DenormalFlusher.hpp"
+#include "unplug/DspLoad.hpp"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
 #include "public.sdk/source/vst/vstaudioeffect.h"
 #include "unplug/AutomationEvent.hpp"
 #include "unplug/GetParameterDescriptions.hpp"
 #include "unplug/IO.hpp"
 #include "unplug/MeterStorage.hpp"
+#include "unplug/MidiEvents.hpp"
+#include "unplug/MidiMapping.hpp"
 #include "unplug/ParameterStorage.hpp"
+#include "unplug/ProcessingEngine.hpp"
 #include "unplug/Serialization.hpp"
+#include "unplug/Trace.hpp"
 #include "unplug/detail/SetupIOFromVst3ProcessData.hpp"
+#include "unplug/detail/SharedMidiMapping.hpp"
+#include "unplug/detail/Vst3BlockAdapter.hpp"
+#include "unplug/detail/Vst3MidiEvents.hpp"
+#include "unplug/detail/Vst3ParameterChanges.hpp"
 #include <atomic>
 #include <memory>
 
@@ -42,6 +52,7 @@ protected:
   using IO = unplug::IO<SampleType>;
   using NumIO = unplug::NumIO;
   using ContextInfo = unplug::ContextInfo;
+  using MidiEvent = unplug::MidiEvent;
 
   /** helper function for processing without sample precise automation */
   template<class SampleType, class StaticProcessing, class Upsampling, class Downsampling>
@@ -100,6 +111,157 @@ protected:
       [](IO<SampleType> const&, Index numUpsampledSamples, Index requiredOutputSamples) {});
   }
 
+  /**
+   * helper function for processing with sample precise automation and the MIDI events received on the event input. The
+   * block is split at the events and at the automation points, and onMidiEvent(MidiEvent const&) is called for the
+   * events of a sample before the processing of the segment that starts there. The controllers mapped to a parameter
+   * set the parameter instead of being passed to onMidiEvent. The mapping starts from the default midi mapping of the
+   * parameter descriptions, see ParameterDescription::MidiMapping, and can be changed at runtime by MIDI learn, see
+   * ParameterAccess::startMidiLearn. When called from processInBlocks, each adapted block carries its own events: they
+   * are split with the sub-blocks, or delayed with the audio in BlockAdapter::Mode::fixedBlockSize, in which case the
+   * data (SysEx), note expression text, chord and scale events are dropped, see BlockAdapter.
+   * */
+  template<class SampleType,
+           class StaticProcessing,
+           class PrepareAutomation,
+           class AutomatedProcessing,
+           class SetParameterAutomation,
+           class OnMidiEvent,
+           class Upsampling,
+           class Downsampling>
+  void processWithEvents(ProcessData& data,
+                         StaticProcessing staticProcessing,
+                         PrepareAutomation prepareAutomation,
+                         AutomatedProcessing automatedProcessing,
+                         SetParameterAutomation setParameterAutomation,
+                         OnMidiEvent onMidiEvent,
+                         Upsampling upsampling,
+                         Downsampling downsampling,
+                         float oversamplingRate = 1.f);
+
+  /** helper function for processing with sample precise automation and MIDI events */
+  template<class SampleType,
+           class StaticProcessing,
+           class PrepareAutomation,
+           class AutomatedProcessing,
+           class SetParameterAutomation,
+           class OnMidiEvent>
+  void processWithEvents(ProcessData& data,
+                         StaticProcessing staticProcessing,
+                         PrepareAutomation prepareAutomation,
+                         AutomatedProcessing automatedProcessing,
+                         SetParameterAutomation setParameterAutomation,
+                         OnMidiEvent onMidiEvent)
+  {
+    processWithEvents<SampleType>(
+      data,
+      staticProcessing,
+      prepareAutomation,
+      automatedProcessing,
+      setParameterAutomation,
+      onMidiEvent,
+      [](IO<SampleType> const&, Index numSamples) { return numSamples; },
+      [](IO<SampleType> const&, Index numUpsampledSamples, Index requiredOutputSamples) {});
+  }
+
+  /**
+   * Sets how processInBlocks adapts the blocks received from the host, see BlockAdapter. Call this before the processor
+   * is activated, for example from onInitialization. In BlockAdapter::Mode::fixedBlockSize, blockSize samples are added
+   * to the latency reported to the host. The maxAudioBlockSize of the ContextInfo passed to onSetup takes the adapter
+   * into account.
+   * */
+  void setBlockAdapterMode(BlockAdapter::Mode mode, Index blockSize)
+  {
+    blockAdapter.setMode(mode, blockSize);
+  }
+
+  /**
+   * helper function to process the audio in blocks of a maximum or fixed size, see setBlockAdapterMode. processing is
+   * called with the ProcessData of each block, and should pass it to staticProcessing or
+   * processWithSamplePreciseAutomation.
+   * */
+  template<class SampleType, class Processing>
+  void processInBlocks(ProcessData& data, Processing processing)
+  {
+    blockAdapter.template process<SampleType>(data, pluginState.parameters, processing);
+  }
+
+  /**
+   * @return the counter of the denormals found in the inputs of the processing helpers. The dsp can also count the
+   * denormals in its own outputs and state with DenormalCounter::count, which only checks the blocks sampled by the
+   * processing helpers, so it can be called in every block. It only counts when UNPLUG_COUNT_DENORMALS is enabled,
+   * which is the default in debug builds.
+   * */
+  unplug::DenormalCounter const& getDenormalCounter() const
+  {
+    return processingEngine.getDenormalCounter();
+  }
+
+  unplug::DenormalCounter& getDenormalCounter()
+  {
+    return processingEngine.getDenormalCounter();
+  }
+
+  /**
+   * A scoped measurement of the time spent in a call to process, see measureDspLoad.
+   * */
+  class DspLoadMeasurement final
+  {
+  public:
+    DspLoadMeasurement(UnplugProcessor* processor, Index numSamples)
+      : processor{ processor }
+      , numSamples{ numSamples }
+    {
+      if (processor) {
+        start = unplug::DspLoad::Clock::now();
+      }
+    }
+
+    ~DspLoadMeasurement()
+    {
+      if (processor) {
+        processor->updateDspLoad(unplug::DspLoad::Clock::now() - start, numSamples);
+      }
+    }
+
+    DspLoadMeasurement(DspLoadMeasurement const&) = delete;
+    DspLoadMeasurement& operator=(DspLoadMeasurement const&) = delete;
+
+  private:
+    UnplugProcessor* processor;
+    Index numSamples;
+    unplug::DspLoad::Clock::time_point start;
+  };
+
+  /**
+   * Enables or disables the measurement of the load of the processing. It is disabled by default.
+   * */
+  void enableDspLoadMeasurement(bool isEnabled)
+  {
+    isDspLoadMeasured.store(isEnabled, std::memory_order_relaxed);
+  }
+
+  /**
+   * Measures the load of the processing, publishing it to the MeterStorage, see MeterStorage::getDspLoad. Create the
+   * returned object at the beginning of process:
+   * auto const dspLoadMeasurement = measureDspLoad(data);
+   * When the measurement is disabled, the clock is not read.
+   * */
+  [[nodiscard]] DspLoadMeasurement measureDspLoad(ProcessData const& data)
+  {
+    bool const isEnabled = isDspLoadMeasured.load(std::memory_order_relaxed);
+    return DspLoadMeasurement(isEnabled ? this : nullptr, static_cast<Index>(data.numSamples));
+  }
+
+  /**
+   * @return the load of the processing, updated at the end of each call to process while the measurement is enabled,
+   * see measureDspLoad. Pass its smoothed load to a QualityGovernor to adapt the quality of the processing.
+   * */
+  unplug::DspLoad const& getDspLoad() const
+  {
+    return dspLoad;
+  }
+
   /** updates the parameters to the last values received by the host  */
   void updateParametersToLastPoint(ProcessData& data);
   void updateNotAutomatableParameters(ProcessData& data);
@@ -171,8 +333,11 @@ protected:
   void setLatency(uint32_t value);
 
 private:
-  template<unplug::Serialization::Action>
-  bool serialization(IBStreamer& streamer);
+  bool saveState(IBStreamer& streamer);
+
+  bool loadState(IBStreamer& streamer);
+
+  bool loadLegacyState(IBStreamer& streamer);
 
   void sendSharedDataToController();
 
@@ -180,6 +345,14 @@ private:
 
   bool setup();
 
+  void setupBlockAdapter();
+
+  void updateDspLoad(unplug::DspLoad::Clock::duration elapsed, Index numSamples)
+  {
+    dspLoad.update(elapsed, numSamples);
+    pluginState.meters->setDspLoad(static_cast<float>(dspLoad.getLoad()), static_cast<float>(dspLoad.getPeak()));
+  }
+
 public:
   tresult PLUGIN_API initialize(FUnknown* context) final;
 
@@ -206,18 +379,24 @@ public:
 
   uint32 PLUGIN_API getLatencySamples() override
   {
-    return static_cast<uint32>(getLatency());
+    return static_cast<uint32>(getLatency() + blockAdapter.getLatency());
   }
 
 protected:
   std::shared_ptr<unplug::SharedDataWrapped> sharedDataWrapped;
   unplug::PluginState pluginState;
   unplug::detail::CachedIO ioCache;
-  std::array<int32, unplug::NumParameters::value> automationPointsHandled;
 
 private:
   ContextInfo contextInfo;
   uint32_t latency{ 0 };
+  BlockAdapter blockAdapter;
+  unplug::ProcessingEngine processingEngine{ pluginState.parameters, ioCache };
+  std::shared_ptr<unplug::detail::SharedMidiMapping> midiMapping;
+  // the mapping set by the parameter descriptions, restored by the states that do not have one
+  unplug::detail::MidiMapping defaultMidiMapping;
+  unplug::DspLoad dspLoad;
+  std::atomic<bool> isDspLoadMeasured{ false };
 };
 
 template<class SampleType, class StaticProcessing, class Upsampling, class Downsampling>
@@ -227,14 +406,11 @@ void UnplugProcessor::staticProcessing(ProcessData& data,
                                        Downsampling downsampling)
 {
   unplug::detail::setupIO<SampleType>(ioCache, data);
-  auto io = IO<SampleType>(ioCache);
-  updateParametersToLastPoint(data);
-  bool const isNotFlushing = !io.isFlushing();
-  if (isNotFlushing) {
-    auto const numUpsampledSamples = upsampling(io, data.numSamples);
-    staticProcessing_(io, numUpsampledSamples);
-    downsampling(io, numUpsampledSamples, data.numSamples);
-  }
+  processingEngine.staticProcessing<SampleType>(static_cast<Index>(data.numSamples),
+                                                Vst3ParameterChangesReader(data.inputParameterChanges),
+                                                staticProcessing_,
+                                                upsampling,
+                                                downsampling);
 }
 
 template<class SampleType,
@@ -253,137 +429,50 @@ void UnplugProcessor::processWithSamplePreciseAutomation(ProcessData& data,
                                                          Downsampling downsampling,
                                                          float oversamplingRate)
 {
-  using AutomationEvent = unplug::AutomationEvent<SampleType>;
   unplug::detail::setupIO<SampleType>(ioCache, data);
-  auto io = IO<SampleType>(ioCache);
-  bool const isNotFlushing = !io.isFlushing();
-  if (isNotFlushing) {
-    auto const numSamples = data.numSamples * oversamplingRate;
-    auto const numUpsampledSamples = upsampling(io, data.numSamples);
-    // this implementation of sample precise automation does not support linear phase oversampling, so
-    assert(numUpsampledSamples == numSamples);
-    if (data.inputParameterChanges) {
-      auto automation = prepareAutomation();
-      int32 const numParamsChanged = data.inputParameterChanges->getParameterCount();
-      if (numParamsChanged == 0) {
-        staticProcessing_(io, numSamples);
-      }
-      else {
-        // reset cache of handled points
-        std::fill(automationPointsHandled.begin(), automationPointsHandled.begin() + numParamsChanged, 0);
-        // handle first changes if not on zero
-        int32 numChangesToHandle = 0;
-        for (int32 index = 0; index < numParamsChanged; index++) {
-          if (auto* paramQueue = data.inputParameterChanges->getParameterData(index)) {
-            int32 const numPoints = paramQueue->getPointCount();
-            numChangesToHandle += numPoints;
-            if (numPoints > 0) {
-              ParamValue value;
-              int32 sampleOffset;
-              paramQueue->getPoint(0, sampleOffset, value);
-              if (sampleOffset > 0) {
-                sampleOffset *= oversamplingRate;
-                auto const parameterId = paramQueue->getParameterId();
-                auto const isAutomatable = pluginState.parameters.isParameterAutomatable(parameterId);
-                if (isAutomatable) {
-                  value = pluginState.parameters.valueFromNormalized(parameterId, value);
-                  auto const prevValue = pluginState.parameters.get(parameterId);
-                  setParameterAutomation(automation, AutomationEvent(parameterId, -1, prevValue, sampleOffset, value));
-                  automationPointsHandled[index] = 1;
-                }
-                --numChangesToHandle;
-              }
-            }
-          }
-        }
-        // handle other changes until the end
-        int32 currentSample = 0;
-        while (numChangesToHandle > 0) {
-          int32 nextSample = numSamples;
-          for (int32 index = 0; index < numParamsChanged; index++) {
-            if (auto* paramQueue = data.inputParameterChanges->getParameterData(index)) {
-              int32 const numPoints = paramQueue->getPointCount();
-              auto const parameterId = paramQueue->getParameterId();
-              auto const isAutomatable = pluginState.parameters.isParameterAutomatable(parameterId);
-              if (!isAutomatable) {
-                --numChangesToHandle;
-              }
-              else {
-                for (int32 point = automationPointsHandled[index]; point < numPoints; ++point) {
-                  ParamValue value;
-                  int32 sampleOffset;
-                  paramQueue->getPoint(point, sampleOffset, value);
-                  bool const onEnd = sampleOffset == data.numSamples;
-                  if (onEnd) {
-                    --numChangesToHandle;
-                    ++automationPointsHandled[index];
-                    break;
-                  }
-                  sampleOffset *= oversamplingRate;
-                  const bool startsAtCurrentSample = sampleOffset == currentSample;
-                  if (startsAtCurrentSample) {
-                    value = pluginState.parameters.valueFromNormalized(parameterId, value);
-                    ParamValue nextValue;
-                    int32 nextSampleOffset;
-                    // get the end
-                    auto const endPoint = point + 1;
-                    if (endPoint < numPoints) {
-                      paramQueue->getPoint(endPoint, nextSampleOffset, nextValue);
-                      nextSampleOffset *= oversamplingRate;
-                      nextValue = pluginState.parameters.valueFromNormalized(parameterId, nextValue);
-                    }
-                    else {
-                      nextSampleOffset = numSamples;
-                      nextValue = value;
-                    }
-                    bool const isJump = sampleOffset == nextSampleOffset;
-                    if (isJump) {
-                      ParamValue nextValueAfterJump;
-                      int32 nextSampleOffsetAfterJump;
-                      // get the end
-                      auto const endPointAfterJump = endPoint + 1;
-                      if (endPointAfterJump < numPoints) {
-                        paramQueue->getPoint(endPointAfterJump, nextSampleOffsetAfterJump, nextValueAfterJump);
-                        nextSampleOffsetAfterJump *= oversamplingRate;
-                        nextValueAfterJump =
-                          pluginState.parameters.valueFromNormalized(parameterId, nextValueAfterJump);
-                      }
-                      else {
-                        nextSampleOffsetAfterJump = numSamples;
-                        nextValueAfterJump = nextValue;
-                      }
-                      setParameterAutomation(
-                        automation,
-                        AutomationEvent(
-                          parameterId, sampleOffset, nextValue, nextSampleOffsetAfterJump, nextValueAfterJump));
-                      nextSample = std::min(nextSample, nextSampleOffsetAfterJump);
-                    }
-                    else {
-                      setParameterAutomation(
-                        automation, AutomationEvent(parameterId, sampleOffset, value, nextSampleOffset, nextValue));
-                      nextSample = std::min(nextSample, nextSampleOffset);
-                    }
-                    --numChangesToHandle;
-                    ++automationPointsHandled[index];
-                  }
-                  else {
-                    nextSample = std::min(nextSample, sampleOffset);
-                  }
-                }
-              }
-            }
-          }
-          automatedProcessing(automation, io, currentSample, nextSample);
-          currentSample = nextSample;
-        }
-      }
-    }
-    else {
-      staticProcessing_(io, numSamples);
-    }
-    downsampling(io, numSamples, data.numSamples);
-  }
-  updateParametersToLastPoint(data);
+  processingEngine.processWithSamplePreciseAutomation<SampleType>(static_cast<Index>(data.numSamples),
+                                                                  Vst3ParameterChangesReader(data.inputParameterChanges),
+                                                                  staticProcessing_,
+                                                                  prepareAutomation,
+                                                                  automatedProcessing,
+                                                                  setParameterAutomation,
+                                                                  upsampling,
+                                                                  downsampling,
+                                                                  oversamplingRate);
+}
+
+template<class SampleType,
+         class StaticProcessing,
+         class PrepareAutomation,
+         class AutomatedProcessing,
+         class SetParameterAutomation,
+         class OnMidiEvent,
+         class Upsampling,
+         class Downsampling>
+void UnplugProcessor::processWithEvents(ProcessData& data,
+                                        StaticProcessing staticProcessing_,
+                                        PrepareAutomation prepareAutomation,
+                                        AutomatedProcessing automatedProcessing,
+                                        SetParameterAutomation setParameterAutomation,
+                                        OnMidiEvent onMidiEvent,
+                                        Upsampling upsampling,
+                                        Downsampling downsampling,
+                                        float oversamplingRate)
+{
+  unplug::detail::setupIO<SampleType>(ioCache, data);
+  auto const midiMappingRead = midiMapping->read();
+  processingEngine.processWithEvents<SampleType>(static_cast<Index>(data.numSamples),
+                                                 Vst3ParameterChangesReader(data.inputParameterChanges),
+                                                 Vst3MidiEventsReader(data.inputEvents),
+                                                 &midiMappingRead.get(),
+                                                 staticProcessing_,
+                                                 prepareAutomation,
+                                                 automatedProcessing,
+                                                 setParameterAutomation,
+                                                 onMidiEvent,
+                                                 upsampling,
+                                                 downsampling,
+                                                 oversamplingRate);
 }
 
-} // namespace Steinberg::Vst
\ No newline at end of file
+} // namespace Steinberg::Vst
@@ -0,0 +1,319 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include "unplug/Index.hpp"
+#include "unplug/MidiEvents.hpp"
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+
+namespace unplug {
+
+/**
+ * Allocates the voices of a polyphonic instrument, keeping their state in structure-of-arrays layout: each property of
+ * the voices is a contiguous, aligned array, padded to a multiple of laneWidth voices. The per-voice DSP state of the
+ * plugin (oscillator phases, envelopes, filters) should be kept the same way, in arrays of VoicePool::capacity
+ * elements, so that processing laneWidth voices at a time with plain loops is vectorized by the compiler, see
+ * forEachActiveGroup. Use laneWidth 4 for SSE and NEON, 8 for AVX.
+ * Note on and note off do not allocate memory. When all the voices allowed by the polyphony are active, a note on steals
+ * the oldest released voice, or the oldest voice if none is released.
+ * handleMidiEvent can be called directly from the onMidiEvent callback of UnplugProcessor::processWithEvents, which
+ * splits the block at each event, so that the voices start and stop at the exact sample:
+ *   processWithEvents<float>(data, staticProcessing, prepareAutomation, automatedProcessing, setParameterAutomation,
+ *     [&](MidiEvent const& event) {
+ *       voices.handleMidiEvent(event, [&](auto allocation, MidiEvent const& noteOn) {
+ *         phases[allocation.voice] = 0.f;
+ *         envelopes[allocation.voice] = 0.f;
+ *       });
+ *     });
+ * A voice stays active after its note off, with a gate of 0, until the plugin frees it with freeVoice when its release
+ * has ended.
+ * @maxVoices the maximum number of voices
+ * @Float the floating point type of the gates, the velocities and the active mask
+ * @laneWidth_ the number of voices processed at a time
+ * */
+template<Index maxVoices, class Float = float, Index laneWidth_ = 8>
+class VoicePool final
+{
+public:
+  static constexpr Index laneWidth = laneWidth_;
+  static constexpr Index numGroups = (maxVoices + laneWidth - 1) / laneWidth;
+  /** the size of the voice arrays, a multiple of laneWidth */
+  static constexpr Index capacity = numGroups * laneWidth;
+  static constexpr Index noVoice = std::numeric_limits<Index>::max();
+
+  static_assert(maxVoices > 0 && laneWidth > 0);
+
+  /**
+   * The voice assigned to a note. If isStolen is true, the voice was playing another note, and the plugin should reset
+   * its state.
+   * */
+  struct Allocation final
+  {
+    Index voice = noVoice;
+    bool isStolen = false;
+  };
+
+  VoicePool()
+  {
+    reset();
+  }
+
+  /**
+   * Sets the number of voices that can be active at the same time, at most maxVoices. The voices beyond the new
+   * polyphony are not stopped, but they are no longer allocated.
+   * */
+  void setPolyphony(Index numVoices)
+  {
+    assert(numVoices > 0 && numVoices <= maxVoices);
+    polyphony = numVoices < 1 ? 1 : numVoices > maxVoices ? maxVoices : numVoices;
+  }
+
+  Index getPolyphony() const
+  {
+    return polyphony;
+  }
+
+  /**
+   * Assigns a voice to a note: the free voice with the lowest index, so that the active voices stay packed in the first
+   * groups, or a stolen one.
+   * */
+  Allocation noteOn(int channel, int pitch, Float velocity, int32_t noteId = -1)
+  {
+    auto allocation = Allocation{ findFreeVoice(), false };
+    if (allocation.voice == noVoice) {
+      allocation.voice = findVoiceToSteal();
+      allocation.isStolen = true;
+    }
+    else {
+      setActive(allocation.voice, true);
+    }
+    auto const voice = allocation.voice;
+    gates[voice] = Float(1);
+    velocities[voice] = velocity;
+    channels[voice] = channel;
+    pitches[voice] = pitch;
+    noteIds[voice] = noteId;
+    startOrder[voice] = ++numNotesStarted;
+    return allocation;
+  }
+
+  /**
+   * Releases the held voices playing the note, matched by note id if both the event and the voice have one, otherwise
+   * by channel and pitch.
+   * @return the number of released voices
+   * */
+  Index noteOff(int channel, int pitch, int32_t noteId = -1)
+  {
+    Index numReleased = 0;
+    for (Index voice = 0; voice < capacity; ++voice) {
+      bool const isHeld = gates[voice] != Float(0);
+      bool const isMatching = noteId >= 0 && noteIds[voice] >= 0
+                                ? noteIds[voice] == noteId
+                                : channels[voice] == channel && pitches[voice] == pitch;
+      if (isHeld && isMatching) {
+        gates[voice] = Float(0);
+        ++numReleased;
+      }
+    }
+    return numReleased;
+  }
+
+  /** Releases all the held voices. */
+  void releaseAll()
+  {
+    gates.fill(Float(0));
+  }
+
+  /** Frees a voice whose release has ended, making it available to new notes. */
+  void freeVoice(Index voice)
+  {
+    assert(voice < capacity);
+    if (activeMask[voice] != Float(0)) {
+      setActive(voice, false);
+    }
+    gates[voice] = Float(0);
+  }
+
+  /** Frees all the voices. */
+  void reset()
+  {
+    gates.fill(Float(0));
+    velocities.fill(Float(0));
+    activeMask.fill(Float(0));
+    channels.fill(0);
+    pitches.fill(-1);
+    noteIds.fill(-1);
+    startOrder.fill(0);
+    numActiveInGroup.fill(0);
+    numActiveVoices = 0;
+    numNotesStarted = 0;
+  }
+
+  /**
+   * Handles the note on, note off, all notes off and all sound off events, ignoring the others.
+   * @event the event
+   * @onNoteOn called as onNoteOn(Allocation, MidiEvent const&) after a voice has been assigned to a note on
+   * @return true if the event has been handled
+   * */
+  template<class OnNoteOn>
+  bool handleMidiEvent(MidiEvent const& event, OnNoteOn onNoteOn)
+  {
+    switch (event.type) {
+      case MidiEvent::Type::noteOn:
+        onNoteOn(noteOn(event.channel, event.number, static_cast<Float>(event.value), event.noteId), event);
+        return true;
+      case MidiEvent::Type::noteOff:
+        noteOff(event.channel, event.number, event.noteId);
+        return true;
+      case MidiEvent::Type::controlChange:
+        if (event.number == MidiCC::AllNotesOff) {
+          releaseAll();
+          return true;
+        }
+        if (event.number == MidiCC::AllSoundOff) {
+          reset();
+          return true;
+        }
+        return false;
+      default:
+        return false;
+    }
+  }
+
+  /**
+   * Calls process(Index firstVoice) for each group of laneWidth voices that has at least one active voice. The groups
+   * with no active voices are skipped. The fastest layout processes the whole block for a group, with the voices of the
+   * group in the innermost loop, which has a constant trip count and is vectorized, and the state in local arrays:
+   *   voices.forEachActiveGroup([&](Index firstVoice) {
+   *     float phase[laneWidth], increment[laneWidth], gain[laneWidth];
+   *     // load the state of the group
+   *     for (Index i = 0; i < numSamples; ++i) {
+   *       float voiceOutputs[laneWidth];
+   *       for (Index lane = 0; lane < laneWidth; ++lane) {
+   *         phase[lane] += increment[lane];
+   *         phase[lane] -= phase[lane] >= 1.f ? 1.f : 0.f;
+   *         voiceOutputs[lane] = gain[lane] * sine(phase[lane]);
+   *       }
+   *       for (Index lane = 0; lane < laneWidth; ++lane) {
+   *         output[i] += voiceOutputs[lane];
+   *       }
+   *     }
+   *     // store the state of the group
+   *   });
+   * The inactive voices of a group are processed too, so their state must stay finite; multiplying by the active mask
+   * silences them.
+   * */
+  template<class Process>
+  void forEachActiveGroup(Process process) const
+  {
+    for (Index group = 0; group < numGroups; ++group) {
+      if (numActiveInGroup[group] > 0) {
+        process(group * laneWidth);
+      }
+    }
+  }
+
+  Index getNumActiveVoices() const
+  {
+    return numActiveVoices;
+  }
+
+  bool isActive(Index voice) const
+  {
+    return activeMask[voice] != Float(0);
+  }
+
+  /** @return 1 for the voices whose note is held, 0 for the released and free ones, capacity elements */
+  Float const* getGates() const
+  {
+    return gates.data();
+  }
+
+  /** @return the velocity of the last note of each voice, capacity elements */
+  Float const* getVelocities() const
+  {
+    return velocities.data();
+  }
+
+  /** @return 1 for the active voices, 0 for the free ones, capacity elements */
+  Float const* getActiveMask() const
+  {
+    return activeMask.data();
+  }
+
+  /** @return the pitch of the last note of each voice, or -1 if the voice never played, capacity elements */
+  int const* getPitches() const
+  {
+    return pitches.data();
+  }
+
+  /** @return the channel of the last note of each voice, capacity elements */
+  int const* getChannels() const
+  {
+    return channels.data();
+  }
+
+private:
+  void setActive(Index voice, bool isActive)
+  {
+    activeMask[voice] = isActive ? Float(1) : Float(0);
+    auto& numActive = numActiveInGroup[voice / laneWidth];
+    numActive = isActive ? numActive + 1 : numActive - 1;
+    numActiveVoices = isActive ? numActiveVoices + 1 : numActiveVoices - 1;
+  }
+
+  Index findFreeVoice() const
+  {
+    for (Index voice = 0; voice < polyphony; ++voice) {
+      if (activeMask[voice] == Float(0)) {
+        return voice;
+      }
+    }
+    return noVoice;
+  }
+
+  Index findVoiceToSteal() const
+  {
+    // the oldest released voice, or the oldest voice if all of them are held
+    Index oldestVoice = 0;
+    Index oldestReleasedVoice = noVoice;
+    for (Index voice = 0; voice < polyphony; ++voice) {
+      if (startOrder[voice] < startOrder[oldestVoice]) {
+        oldestVoice = voice;
+      }
+      bool const isReleased = gates[voice] == Float(0);
+      if (isReleased && (oldestReleasedVoice == noVoice || startOrder[voice] < startOrder[oldestReleasedVoice])) {
+        oldestReleasedVoice = voice;
+      }
+    }
+    return oldestReleasedVoice != noVoice ? oldestReleasedVoice : oldestVoice;
+  }
+
+  alignas(64) std::array<Float, capacity> gates;
+  alignas(64) std::array<Float, capacity> velocities;
+  alignas(64) std::array<Float, capacity> activeMask;
+  std::array<int, capacity> channels;
+  std::array<int, capacity> pitches;
+  std::array<int32_t, capacity> noteIds;
+  std::array<uint64_t, capacity> startOrder;
+  std::array<Index, numGroups> numActiveInGroup;
+  Index numActiveVoices = 0;
+  Index polyphony = maxVoices;
+  uint64_t numNotesStarted = 0;
+};
+
+} // namespace unplug
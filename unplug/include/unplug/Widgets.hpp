@@ -43,6 +43,11 @@ bool Checkbox(ParamIndex paramIndex, ShowLabel showLabel = ShowLabel::yes);
  * */
 void TextCentered(std::string const& text, float height = 0.f);
 
+/**
+ * Displays some text centered in the rectangle between the current position and size
+ * */
+void TextCentered(const char* text, float height = 0.f);
+
 /**
  * Displays the name of a parameter
  * */
@@ -140,6 +145,13 @@ void LevelMeterRaw(float value,
                    LevelMeterSettings const& settings = {},
                    LevelMeterAlign alignment = LevelMeterAlign::toMinValue);
 
+/**
+ * Meter showing the load of the processing of the plugin instance, see UnplugProcessor::measureDspLoad, with the peak
+ * load as text.
+ * @maxLoad the load corresponding to a full meter
+ * */
+void DspLoadMeter(std::string const& name, ImVec2 size, float maxLoad = 1.f);
+
 /**
  * Difference level meter.
  * */
@@ -245,12 +257,13 @@ bool KnobWithLabels(ParamIndex paramIndex,
 
 struct ParameterData
 {
-  std::string name;
+  // cached by the ParameterAccess
+  std::string const& name;
   float valueNormalized;
   float value;
   float minValue;
   float maxValue;
-  std::string measureUnit;
+  std::string const& measureUnit;
   bool isBeingEdited;
 
   ParameterData(ParameterAccess& parameters, ParamIndex paramIndex);
@@ -261,15 +274,19 @@ struct ParameterData
  * */
 struct ControlOutput
 {
-  std::string controlName;
+  // the ImGuiID of the control, as returned by ImGui::GetID for its label
+  ControlId controlId = 0;
   float value = 0.f;
   bool isActive = false;
 };
 
 /**
  * Controls a parameter with a custom control, used internally by most control that allows to edit a parameter
+ * @control a callable that takes the ParameterData of the parameter, draws the control and returns its ControlOutput.
+ * It is called directly, without being wrapped in a std::function, so it does not allocate memory every frame.
  * */
-bool Control(ParamIndex paramIndex, std::function<ControlOutput(ParameterData const& parameter)> const& control);
+template<class ControlFunction>
+bool Control(ParamIndex paramIndex, ControlFunction const& control);
 
 /**
  * implementation details that can be useful to implement custom controls
@@ -279,9 +296,9 @@ struct EditingState
 {
   bool isParameterBeingEdited;
   bool isControlActive;
-  std::string controlName;
+  ControlId controlId;
 
-  EditingState(ParameterData const& parameterData, bool isControlActive, std::string controlName);
+  EditingState(ParameterData const& parameterData, bool isControlActive, ControlId controlId);
 };
 
 void applyRangedParameters(ParameterAccess& parameters,
@@ -338,4 +355,17 @@ void endRegisterArea(ParameterAccess& parameters, ParamIndex paramIndex, BeginRe
 
 } // namespace detail
 
+template<class ControlFunction>
+bool Control(ParamIndex paramIndex, ControlFunction const& control)
+{
+  auto& parameters = getParameters();
+  auto const parameter = ParameterData{ parameters, paramIndex };
+  auto const areaInfo = detail::beginRegisterArea();
+  ControlOutput const output = control(parameter);
+  detail::endRegisterArea(parameters, paramIndex, areaInfo);
+  auto const editingState = detail::EditingState{ parameter, output.isActive, output.controlId };
+  detail::applyRangedParameters(parameters, paramIndex, editingState, output.value);
+  return output.isActive;
+}
+
 } // namespace unplug
@@ -12,25 +12,33 @@
 //------------------------------------------------------------------------
 
 #pragma once
+#include "Parameters.hpp"
 #include "unplug/Index.hpp"
-#include <string>
-#include <unordered_map>
+#include <array>
 
 namespace unplug::detail {
 
-class ParameterEditRegister
+/**
+ * Keeps track of which control is editing which parameter. It is a flat array indexed by the parameter index, so that
+ * all its operations are O(1) and never allocate, as they are called every frame while a control is being dragged.
+ * */
+class ParameterEditRegister final
 {
 public:
-  void registerEdit(ParamIndex paramIndex, std::string control);
+  static constexpr auto noControl = ControlId{ 0 };
 
-  void unregisterEdit(ParamIndex paramIndex);
+  ParameterEditRegister();
+
+  bool registerEdit(ParamIndex paramIndex, ControlId control);
+
+  bool unregisterEdit(ParamIndex paramIndex);
 
   bool isParameterBeingEdited(ParamIndex paramIndex) const;
 
-  std::string getControllerEditingParameter(ParamIndex paramIndex) const;
+  ControlId getControllerEditingParameter(ParamIndex paramIndex) const;
 
 private:
-  std::unordered_map<Index, std::string> paramsBeingEditedByControls;
+  std::array<ControlId, NumParameters::value> paramsBeingEditedByControls;
 };
 
-} // namespace unplug::detail
\ No newline at end of file
+} // namespace unplug::detail
@@ -19,6 +19,7 @@
 #include "unplug/MeterStorage.hpp"
 #include "unplug/ParameterAccess.hpp"
 #include "unplug/detail/ModifierKeys.hpp"
+#include "unplug/detail/RedrawConditions.hpp"
 #include <array>
 #include <chrono>
 #include <memory>
@@ -103,6 +104,10 @@ private:
 
   void resetKeys();
 
+  void onUserInput();
+
+  bool isRedrawNeeded();
+
 private:
   ParameterAccess& parameters;
   std::shared_ptr<MeterStorage>& meters;
@@ -113,6 +118,12 @@ private:
   time_point prevFrameTime;
   ImGuiMouseCursor lastCursor = -1;
   bool isMouseCursorIn = false;
+  RedrawConditions redrawConditions;
+  // Dear ImGui needs a frame more than the one of the input to settle hovering and activation
+  static constexpr int numFramesToRedrawAfterInput = 2;
+  int numFramesToRedraw = 0;
+  // see ParameterAccess::getNumChanges
+  uint32_t lastNumParameterChanges = 0;
   static constexpr uintptr_t redrawTimerId = 1;
 };
 
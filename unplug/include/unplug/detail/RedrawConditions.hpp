@@ -0,0 +1,69 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include <vector>
+
+namespace unplug::detail {
+
+/**
+ * Something that the user interface shows, with a function that tells whether it has changed since it was shown.
+ * */
+struct RedrawCondition final
+{
+  void const* object;
+  bool (*hasChanged)(void const* object);
+};
+
+/**
+ * The conditions added during a frame, used by the EventHandler to decide whether the redraw timer has to redraw the
+ * next one. When there are none, it always redraws. It also redraws after user input and after any parameter change.
+ * */
+class RedrawConditions final
+{
+public:
+  void add(RedrawCondition condition)
+  {
+    conditions.push_back(condition);
+  }
+
+  void clear()
+  {
+    conditions.clear();
+  }
+
+  bool isEmpty() const
+  {
+    return conditions.empty();
+  }
+
+  bool isAnyMet() const
+  {
+    for (auto const& condition : conditions) {
+      if (condition.hasChanged(condition.object)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  std::vector<RedrawCondition> conditions;
+};
+
+void setRedrawConditions(RedrawConditions& redrawConditions);
+
+void addRedrawCondition(RedrawCondition condition);
+
+} // namespace unplug::detail
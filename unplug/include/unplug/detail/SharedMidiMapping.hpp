@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include "unplug/MidiMapping.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace unplug::detail {
+
+/**
+ * Publishes a MidiMapping to the audio thread, so that it can be changed at runtime, for example by MIDI learn, while
+ * the audio thread keeps looking the controllers up without locks. Each publication is a new immutable table, swapped
+ * in with an atomic pointer. The audio thread marks the table it is reading, and the tables that have been replaced are
+ * deleted by the next publication that finds them unmarked, or by the destructor.
+ * There must be a single reader, the audio thread. publish and getLatest can be called from any other thread.
+ * */
+class SharedMidiMapping final
+{
+public:
+  /**
+   * A scoped read of the current table. The table stays alive until the scope is destroyed.
+   * */
+  class ReadScope final
+  {
+  public:
+    ~ReadScope()
+    {
+      owner.reading.store(nullptr, std::memory_order_release);
+    }
+
+    ReadScope(ReadScope const&) = delete;
+    ReadScope& operator=(ReadScope const&) = delete;
+
+    MidiMapping const& get() const
+    {
+      return *table;
+    }
+
+  private:
+    friend class SharedMidiMapping;
+
+    ReadScope(SharedMidiMapping& owner, MidiMapping const* table)
+      : owner{ owner }
+      , table{ table }
+    {}
+
+    SharedMidiMapping& owner;
+    MidiMapping const* table;
+  };
+
+  explicit SharedMidiMapping(MidiMapping const& mapping = {});
+
+  /**
+   * Publishes a copy of the mapping as the current table. Allocates memory, so it is not to be called on the audio thread.
+   * */
+  void publish(MidiMapping const& mapping);
+
+  /**
+   * @return a copy of the last published mapping. Not to be called on the audio thread.
+   * */
+  MidiMapping getLatest() const;
+
+  /**
+   * Reads the current table, to be called on the audio thread. The read does not lock nor allocate: it only retries if
+   * a new table is published while it is starting.
+   * */
+  [[nodiscard]] ReadScope read()
+  {
+    auto table = current.load(std::memory_order_acquire);
+    while (true) {
+      // the table is marked before checking that it is still the current one, so that a publication that replaces it
+      // afterwards can not miss the mark
+      reading.store(table, std::memory_order_seq_cst);
+      auto const latest = current.load(std::memory_order_seq_cst);
+      if (latest == table) {
+        return ReadScope(*this, table);
+      }
+      table = latest;
+    }
+  }
+
+private:
+  std::atomic<MidiMapping const*> current{ nullptr };
+  std::atomic<MidiMapping const*> reading{ nullptr };
+  mutable std::mutex mutex;
+  // all the tables that may still be read, the current one included
+  std::vector<std::unique_ptr<MidiMapping const>> tables;
+};
+
+} // namespace unplug::detail
@@ -0,0 +1,70 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include "unplug/Fft.hpp"
+#include "unplug/Index.hpp"
+#include <vector>
+
+namespace unplug::detail {
+
+/**
+ * Uniformly partitioned convolution, with partitions of blockSize samples transformed with an Fft of twice the size.
+ * It has no latency: a block that is only partially filled is convolved at every call, and the products of the older
+ * blocks are accumulated once per block. Everything is allocated by the constructor.
+ * */
+class UniformConvolver final
+{
+public:
+  /**
+   * @blockSize the size of the partitions, a power of 2
+   * @impulseResponse the impulse response to convolve with
+   * @size the length of the impulse response
+   * */
+  UniformConvolver(Index blockSize, float const* impulseResponse, Index size);
+
+  Index getBlockSize() const
+  {
+    return blockSize;
+  }
+
+  /**
+   * Writes the convolution of the input to the output. The input and the output can be the same buffer.
+   * */
+  void process(float const* input, float* output, Index numSamples);
+
+  void reset();
+
+private:
+  Index blockSize;
+  Index numBins;
+  Index numPartitions;
+  Fft fft;
+  // the spectra of the partitions of the impulse response, and the ring of the spectra of the last input blocks
+  std::vector<float> partitionsReal;
+  std::vector<float> partitionsImaginary;
+  std::vector<float> segmentsReal;
+  std::vector<float> segmentsImaginary;
+  std::vector<float> accumulatedReal;
+  std::vector<float> accumulatedImaginary;
+  std::vector<float> convolvedReal;
+  std::vector<float> convolvedImaginary;
+  std::vector<float> inputBuffer;
+  std::vector<float> outputBuffer;
+  std::vector<float> overlap;
+  Index inputPosition = 0;
+  Index currentSegment = 0;
+};
+
+} // namespace unplug::detail
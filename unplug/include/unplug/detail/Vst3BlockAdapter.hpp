@@ -0,0 +1,354 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+
+#include "pluginterfaces/vst/ivstaudioprocessor.h"
+#include "unplug/ContextInfo.hpp"
+#include "unplug/Index.hpp"
+#include "unplug/ParameterStorage.hpp"
+#include "unplug/detail/SetupIOFromVst3ProcessData.hpp"
+#include "unplug/detail/Vst3EventList.hpp"
+#include "unplug/detail/Vst3ParameterChanges.hpp"
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+namespace Steinberg::Vst {
+
+/**
+ * BlockAdapter changes the size of the blocks passed to the processing code: it can split the blocks received from the
+ * host into sub-blocks no longer than a maximum size, or re-block the audio into blocks of a fixed size, which adds as
+ * many samples of latency. The parameter changes are split accordingly, adding interpolated points at the boundaries of
+ * the blocks so that sample precise automation keeps working. The input events, which must be sorted by sampleOffset,
+ * are split in the same way, and the project time of the ProcessContext is moved to the start of each block. In
+ * Mode::fixedBlockSize the events are delayed together with the audio, except the ones that point to memory owned by the
+ * host, which is only valid during the call to process: data (SysEx), note expression text, chord and scale events are
+ * dropped. The output events are passed to the processing code as they are. Memory is only allocated by setMode and
+ * setup.
+ * */
+class BlockAdapter final
+{
+public:
+  enum class Mode
+  {
+    /** the blocks are passed as they are received from the host */
+    none,
+    /** the blocks are split into sub-blocks no longer than the block size */
+    maxBlockSize,
+    /** the audio is re-blocked into blocks of exactly the block size, adding as many samples of latency */
+    fixedBlockSize
+  };
+
+  /**
+   * Sets how the blocks are adapted. Not to be called on the audio thread. Takes effect on the next call to setup.
+   * @mode_ the mode
+   * @blockSize_ the maximum or fixed size of the blocks, ignored if mode_ is Mode::none
+   * @maxNumPoints_ the maximum number of parameter change points that can be held by the adapter at once
+   * @maxNumEvents_ the maximum number of input events that can be held by the adapter at once
+   * */
+  void setMode(Mode mode_, unplug::Index blockSize_, int32 maxNumPoints_ = 4096, int32 maxNumEvents_ = 1024);
+
+  Mode getMode() const
+  {
+    return mode;
+  }
+
+  unplug::Index getBlockSize() const
+  {
+    return blockSize;
+  }
+
+  /**
+   * @hostMaxBlockSize the maximum block size declared by the host
+   * @return the maximum size of the blocks passed to the processing code
+   * */
+  unplug::Index getMaxBlockSize(unplug::Index hostMaxBlockSize) const;
+
+  /**
+   * @return the latency added by the adapter, in samples
+   * */
+  unplug::Index getLatency() const
+  {
+    return mode == Mode::fixedBlockSize ? blockSize : 0;
+  }
+
+  /**
+   * Allocates the memory for the current mode and resets the adapter. Not to be called on the audio thread.
+   * @numInputChannels the number of channels of each input bus
+   * @numOutputChannels the number of channels of each output bus
+   * @precision the floating point precision of the audio
+   * */
+  void setup(std::vector<int32> const& numInputChannels,
+             std::vector<int32> const& numOutputChannels,
+             unplug::FloatingPointPrecision precision);
+
+  /**
+   * Clears the audio, the parameter changes and the events held by the adapter.
+   * */
+  void reset();
+
+  /**
+   * Calls processing(ProcessData&) for each adapted block.
+   * @data the data received from the host
+   * @parameters the parameter storage, used to interpolate the parameter changes at the boundaries of the blocks
+   * @processing a callable that processes a block, usually calling UnplugProcessor::staticProcessing or
+   * UnplugProcessor::processWithSamplePreciseAutomation
+   * */
+  template<class SampleType, class Processing>
+  void process(ProcessData& data, unplug::ParameterStorage const& parameters, Processing processing);
+
+private:
+  struct BusLayout final
+  {
+    int32 numChannels;
+    int32 firstChannel;
+  };
+
+  struct PendingPoint final
+  {
+    ParamID id;
+    int64 position;
+    ParamValue value;
+    // the order in which the points were received, to keep points at the same position in order when sorting
+    int64 order;
+  };
+
+  struct PendingEvent final
+  {
+    Event event;
+    int64 position;
+  };
+
+  bool isSetUpFor(ProcessData const& data) const;
+
+  /** @return the context of the host moved forward by offset samples, or nullptr if the host provided no context */
+  ProcessContext* offsetProcessContext(ProcessContext* source, int64 offset);
+
+  void prepareSubBlockEvents(IEventList& source, int32 start, int32 end, bool isLastSubBlock, int32& nextEvent);
+
+  void enqueueEvents(IEventList& source, int64 blockPosition);
+
+  void prepareFixedBlockEvents(int64 blockStart);
+
+  void prepareSubBlockChanges(IParameterChanges& source,
+                              int32 start,
+                              int32 end,
+                              bool includeEnd,
+                              unplug::ParameterStorage const& parameters);
+
+  void enqueueChanges(IParameterChanges& source, int64 blockPosition);
+
+  void prepareFixedBlockChanges(int64 blockStart, unplug::ParameterStorage const& parameters);
+
+  void setFifoBuffers();
+
+  template<class SampleType, class Processing>
+  void processInSubBlocks(ProcessData& data, unplug::ParameterStorage const& parameters, Processing& processing);
+
+  template<class SampleType, class Processing>
+  void processInFixedBlocks(ProcessData& data, unplug::ParameterStorage const& parameters, Processing& processing);
+
+  template<class SampleType>
+  std::vector<SampleType*>& getChannelPointers()
+  {
+    if constexpr (std::is_same_v<SampleType, double>) {
+      return channels64;
+    }
+    else {
+      return channels32;
+    }
+  }
+
+  template<class SampleType>
+  std::vector<SampleType>& getFifo()
+  {
+    if constexpr (std::is_same_v<SampleType, double>) {
+      return fifo64;
+    }
+    else {
+      return fifo32;
+    }
+  }
+
+  template<class SampleType>
+  static void setBuffer(AudioBusBuffers& buffers, SampleType** channels)
+  {
+    if constexpr (std::is_same_v<SampleType, double>) {
+      buffers.channelBuffers64 = channels;
+    }
+    else {
+      buffers.channelBuffers32 = channels;
+    }
+  }
+
+  Mode mode{ Mode::none };
+  unplug::Index blockSize{ 0 };
+  int32 maxNumPoints{ 4096 };
+  int32 maxNumEvents{ 1024 };
+  unplug::FloatingPointPrecision precision{ unplug::FloatingPointPrecision::float32 };
+  std::vector<BusLayout> inputLayout;
+  std::vector<BusLayout> outputLayout;
+  std::vector<AudioBusBuffers> inputs;
+  std::vector<AudioBusBuffers> outputs;
+  std::vector<float*> channels32;
+  std::vector<double*> channels64;
+  std::vector<float> fifo32;
+  std::vector<double> fifo64;
+  unplug::Index fifoPosition{ 0 };
+  int64 streamPosition{ 0 };
+  // sorted by parameter and position, so that the points of each parameter are contiguous
+  std::vector<PendingPoint> pendingPoints;
+  int32 numPendingPoints{ 0 };
+  int64 numReceivedPoints{ 0 };
+  PreallocatedParameterChanges changes;
+  std::vector<PendingEvent> pendingEvents;
+  int32 numPendingEvents{ 0 };
+  PreallocatedEventList events;
+  ProcessContext context{};
+};
+
+template<class SampleType, class Processing>
+void BlockAdapter::process(ProcessData& data, unplug::ParameterStorage const& parameters, Processing processing)
+{
+  bool const isFlushing = data.numInputs == 0 && data.numOutputs == 0;
+  if (mode == Mode::none || isFlushing || !isSetUpFor(data)) {
+    processing(data);
+    return;
+  }
+  if (mode == Mode::maxBlockSize) {
+    processInSubBlocks<SampleType>(data, parameters, processing);
+  }
+  else {
+    processInFixedBlocks<SampleType>(data, parameters, processing);
+  }
+}
+
+template<class SampleType, class Processing>
+void BlockAdapter::processInSubBlocks(ProcessData& data,
+                                      unplug::ParameterStorage const& parameters,
+                                      Processing& processing)
+{
+  auto const numSamples = data.numSamples;
+  auto const maxSubBlockSize = static_cast<int32>(blockSize);
+  if (numSamples <= maxSubBlockSize) {
+    processing(data);
+    return;
+  }
+  auto& channels = getChannelPointers<SampleType>();
+  int32 nextEvent = 0;
+  auto const setupBuses = [&](AudioBusBuffers* hostBuses, int32 numBuses, auto& buses, auto& layout, int32 start) {
+    for (int32 bus = 0; bus < numBuses; ++bus) {
+      auto hostChannels = unplug::detail::getBuffer<SampleType>(hostBuses[bus]);
+      auto const numChannels = hostBuses[bus].numChannels;
+      auto busChannels = channels.data() + layout[bus].firstChannel;
+      for (int32 channel = 0; channel < numChannels; ++channel) {
+        busChannels[channel] = hostChannels && hostChannels[channel] ? hostChannels[channel] + start : nullptr;
+      }
+      buses[bus].numChannels = numChannels;
+      buses[bus].silenceFlags = 0;
+      setBuffer<SampleType>(buses[bus], hostChannels ? busChannels : nullptr);
+    }
+  };
+  for (int32 start = 0; start < numSamples; start += maxSubBlockSize) {
+    auto const end = std::min(start + maxSubBlockSize, numSamples);
+    auto subBlock = data;
+    subBlock.numSamples = end - start;
+    setupBuses(data.inputs, data.numInputs, inputs, inputLayout, start);
+    setupBuses(data.outputs, data.numOutputs, outputs, outputLayout, start);
+    subBlock.inputs = inputs.data();
+    subBlock.outputs = outputs.data();
+    subBlock.processContext = offsetProcessContext(data.processContext, start);
+    if (data.inputEvents) {
+      prepareSubBlockEvents(*data.inputEvents, start, end, end == numSamples, nextEvent);
+      subBlock.inputEvents = &events;
+    }
+    if (data.inputParameterChanges) {
+      prepareSubBlockChanges(*data.inputParameterChanges, start, end, end == numSamples, parameters);
+      subBlock.inputParameterChanges = &changes;
+    }
+    processing(subBlock);
+  }
+}
+
+template<class SampleType, class Processing>
+void BlockAdapter::processInFixedBlocks(ProcessData& data,
+                                        unplug::ParameterStorage const& parameters,
+                                        Processing& processing)
+{
+  if (data.inputParameterChanges) {
+    enqueueChanges(*data.inputParameterChanges, streamPosition);
+  }
+  if (data.inputEvents) {
+    enqueueEvents(*data.inputEvents, streamPosition);
+  }
+  auto& fifo = getFifo<SampleType>();
+  auto const fixedBlockSize = static_cast<int32>(blockSize);
+  int32 numSamplesDone = 0;
+  while (numSamplesDone < data.numSamples) {
+    auto const numSamplesToCopy =
+      std::min(fixedBlockSize - static_cast<int32>(fifoPosition), data.numSamples - numSamplesDone);
+    for (int32 bus = 0; bus < data.numInputs; ++bus) {
+      auto hostChannels = unplug::detail::getBuffer<SampleType>(data.inputs[bus]);
+      for (int32 channel = 0; channel < data.inputs[bus].numChannels; ++channel) {
+        auto fifoChannel = fifo.data() + (inputLayout[bus].firstChannel + channel) * blockSize + fifoPosition;
+        if (hostChannels && hostChannels[channel]) {
+          auto hostChannel = hostChannels[channel] + numSamplesDone;
+          std::copy(hostChannel, hostChannel + numSamplesToCopy, fifoChannel);
+        }
+        else {
+          std::fill(fifoChannel, fifoChannel + numSamplesToCopy, SampleType(0));
+        }
+      }
+    }
+    for (int32 bus = 0; bus < data.numOutputs; ++bus) {
+      auto hostChannels = unplug::detail::getBuffer<SampleType>(data.outputs[bus]);
+      if (!hostChannels) {
+        continue;
+      }
+      for (int32 channel = 0; channel < data.outputs[bus].numChannels; ++channel) {
+        auto fifoChannel = fifo.data() + (outputLayout[bus].firstChannel + channel) * blockSize + fifoPosition;
+        if (hostChannels[channel]) {
+          std::copy(fifoChannel, fifoChannel + numSamplesToCopy, hostChannels[channel] + numSamplesDone);
+        }
+      }
+    }
+    fifoPosition += numSamplesToCopy;
+    numSamplesDone += numSamplesToCopy;
+    if (fifoPosition == blockSize) {
+      auto fixedBlock = data;
+      fixedBlock.numSamples = fixedBlockSize;
+      for (int32 bus = 0; bus < data.numInputs; ++bus) {
+        inputs[bus].numChannels = data.inputs[bus].numChannels;
+      }
+      for (int32 bus = 0; bus < data.numOutputs; ++bus) {
+        outputs[bus].numChannels = data.outputs[bus].numChannels;
+      }
+      fixedBlock.inputs = inputs.data();
+      fixedBlock.outputs = outputs.data();
+      auto const blockStart = streamPosition + numSamplesDone - fixedBlockSize;
+      // the block starts before the current host block, numSamplesDone - fixedBlockSize is zero or negative
+      fixedBlock.processContext = offsetProcessContext(data.processContext, numSamplesDone - fixedBlockSize);
+      prepareFixedBlockEvents(blockStart);
+      fixedBlock.inputEvents = &events;
+      prepareFixedBlockChanges(blockStart, parameters);
+      fixedBlock.inputParameterChanges = &changes;
+      processing(fixedBlock);
+      fifoPosition = 0;
+    }
+  }
+  streamPosition += data.numSamples;
+}
+
+} // namespace Steinberg::Vst
@@ -0,0 +1,73 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+
+#include "pluginterfaces/vst/ivstevents.h"
+#include <vector>
+
+namespace Steinberg::Vst {
+
+/**
+ * An implementation of IEventList that does not allocate memory after setCapacity, used to pass the events to the
+ * processing callbacks when the blocks received from the host are split or re-blocked.
+ * */
+class PreallocatedEventList final : public IEventList
+{
+public:
+  /**
+   * Allocates the memory for the events. Not to be called on the audio thread.
+   * @maxNumEvents the maximum number of events that the list can hold
+   * */
+  void setCapacity(int32 maxNumEvents);
+
+  /**
+   * Removes all the events.
+   * */
+  void clear()
+  {
+    numEvents = 0;
+  }
+
+  int32 PLUGIN_API getEventCount() override
+  {
+    return numEvents;
+  }
+
+  tresult PLUGIN_API getEvent(int32 index, Event& e) override;
+
+  /**
+   * Adds an event at the end of the list.
+   * @return kResultTrue on success, kResultFalse if there is no room left for it
+   * */
+  tresult PLUGIN_API addEvent(Event& e) override;
+
+  tresult PLUGIN_API queryInterface(const TUID iid, void** obj) override;
+
+  uint32 PLUGIN_API addRef() override
+  {
+    return 1;
+  }
+
+  uint32 PLUGIN_API release() override
+  {
+    return 1;
+  }
+
+private:
+  std::vector<Event> events;
+  int32 numEvents{ 0 };
+};
+
+} // namespace Steinberg::Vst
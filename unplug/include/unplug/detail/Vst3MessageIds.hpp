@@ -21,6 +21,7 @@ inline constexpr auto programIndexId = "unplug program index";
 inline constexpr auto meterSharingId = "unplug meters message";
 inline constexpr auto meterStorageId = "unplug meters storage";
 inline constexpr auto sharedDataStorageId = "unplug shared data storage";
+inline constexpr auto midiMappingStorageId = "unplug midi mapping storage";
 
 inline constexpr auto userInterfaceChangedId = "unplug user interface message";
 inline constexpr auto userInterfaceStateId = "unplug user interface state";
@@ -0,0 +1,86 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+
+#include "pluginterfaces/vst/ivstevents.h"
+#include "unplug/MidiEvents.hpp"
+#include <algorithm>
+
+namespace Steinberg::Vst {
+
+/**
+ * Reads the IEventList received from the host in place, as the MIDI events consumed by the ProcessingEngine. Only the
+ * events of the first event bus are read. Note on, note off and poly pressure events are read as they are, the other
+ * events are skipped. A missing IEventList reads as no events.
+ * VST3 hosts do not send controllers, channel pressure and pitch bend as events: they turn them into parameter changes
+ * through the IMidiMapping of the controller, see UnplugController::getMidiControllerAssignment, so this reader never
+ * produces control change, channel pressure or pitch bend events.
+ * */
+class Vst3MidiEventsReader final
+{
+public:
+  explicit Vst3MidiEventsReader(IEventList* events)
+    : events{ events }
+    , numEvents{ events ? static_cast<unplug::Index>(std::max(events->getEventCount(), int32(0))) : 0 }
+  {}
+
+  unplug::Index getNumEvents() const
+  {
+    return numEvents;
+  }
+
+  bool getEvent(unplug::Index index, unplug::MidiEvent& midiEvent) const
+  {
+    using Type = unplug::MidiEvent::Type;
+    Event event{};
+    if (events->getEvent(static_cast<int32>(index), event) != kResultOk || event.busIndex != 0) {
+      return false;
+    }
+    midiEvent.sampleOffset = static_cast<unplug::Index>(std::max(event.sampleOffset, int32(0)));
+    midiEvent.noteId = -1;
+    switch (event.type) {
+      case Event::kNoteOnEvent:
+        // a note on with zero velocity is a note off
+        midiEvent.type = event.noteOn.velocity > 0.f ? Type::noteOn : Type::noteOff;
+        midiEvent.channel = event.noteOn.channel;
+        midiEvent.number = event.noteOn.pitch;
+        midiEvent.value = event.noteOn.velocity;
+        midiEvent.noteId = event.noteOn.noteId;
+        return true;
+      case Event::kNoteOffEvent:
+        midiEvent.type = Type::noteOff;
+        midiEvent.channel = event.noteOff.channel;
+        midiEvent.number = event.noteOff.pitch;
+        midiEvent.value = event.noteOff.velocity;
+        midiEvent.noteId = event.noteOff.noteId;
+        return true;
+      case Event::kPolyPressureEvent:
+        midiEvent.type = Type::polyPressure;
+        midiEvent.channel = event.polyPressure.channel;
+        midiEvent.number = event.polyPressure.pitch;
+        midiEvent.value = event.polyPressure.pressure;
+        midiEvent.noteId = event.polyPressure.noteId;
+        return true;
+      default:
+        return false;
+    }
+  }
+
+private:
+  IEventList* events;
+  unplug::Index numEvents;
+};
+
+} // namespace Steinberg::Vst
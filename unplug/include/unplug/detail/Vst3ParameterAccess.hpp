@@ -17,6 +17,9 @@
 #include "unplug/StringConversion.hpp"
 #include "unplug/detail/EditRegister.hpp"
 #include "unplug/detail/ParameterFromUserInterfaceCoordinates.hpp"
+#include <array>
+#include <cstdint>
+#include <vector>
 
 namespace Steinberg::Vst {
 class UnplugController;
@@ -114,14 +117,29 @@ public:
    * */
   bool setValueNormalized(ParamIndex index, double value);
 
+  /**
+   * Starts a batch of edits. Until the matching call to endBatchEdit, the values set with setValue and
+   * setValueNormalized are only stored. As outside of a batch, a parameter can only be set between beginEdit and
+   * endEdit. Edits to the same parameter are coalesced, and the host is notified once per parameter when the batch ends,
+   * or when endEdit is called if it comes first. Useful for macro controls and preset morphing. Batches can be nested.
+   * The EventHandler wraps each frame in a batch.
+   * */
+  void beginBatchEdit();
+
+  /**
+   * Ends a batch of edits, notifying the host of the last value set to each parameter during the batch that is still
+   * pending.
+   * */
+  void endBatchEdit();
+
   /**
    * Marks the specified  as being edited by a specific control and tells the host about it (for the undo). It should be
    * called when the editing starts. The unplug widgets do this internally.
    * @index the index of the parameter
-   * @control the name of the control that it is editing the parameter
+   * @control the id of the control that it is editing the parameter (with Dear ImGui, its ImGuiID)
    * @return true if the parameter index is valid and is not being edited, false otherwise
    * */
-  bool beginEdit(ParamIndex index, std::string control);
+  bool beginEdit(ParamIndex index, ControlId control);
 
   /**
    * Marks the specified parameter as not being edited and tells the host about it (for the undo).
@@ -139,11 +157,11 @@ public:
   bool isBeingEdited(ParamIndex index) const;
 
   /**
-   * Gets the name of the control that it is editing the specified parameter
+   * Gets the id of the control that it is editing the specified parameter
    * @index the index of the parameter
-   * @return the name of the control that is editing the parameter
+   * @return the id of the control that is editing the parameter, or 0 if the parameter is not being edited
    * */
-  std::string getEditingControl(ParamIndex index) const;
+  ControlId getEditingControl(ParamIndex index) const;
 
   /**
    * Converts a normalized value to a plain value in text form for the specified parameter.
@@ -154,25 +172,35 @@ public:
   std::string convertToText(ParamIndex index, double valueNormalized);
 
   /**
-   * Gets the plain value in text form for the specified parameter.
+   * Gets the plain value in text form for the specified parameter. The text is cached and only converted again when the
+   * normalized value of the parameter changes, so it is cheap to call every frame.
    * @index the index of the parameter
-   * @return a string holding the plain value of the parameter in text
+   * @return a string holding the plain value of the parameter in text, valid until the next call to this method
    * */
-  std::string getValueAsText(ParamIndex index);
+  std::string const& getValueAsText(ParamIndex index);
 
   /**
-   * Gets the name of the specified parameter.
+   * Gets the name and the plain value in text form for the specified parameter, as "name: value". The text is cached
+   * like the one of getValueAsText.
+   * @index the index of the parameter
+   * @return a string holding the name and the value of the parameter, valid until the next call to this method
+   * */
+  std::string const& getNameAndValueAsText(ParamIndex index);
+
+  /**
+   * Gets the name of the specified parameter. The name is converted to UTF-8 once and cached, so it is cheap to call
+   * every frame.
    * @index the index of the parameter
    * @return the name of the parameter
    * */
-  std::string getName(ParamIndex index);
+  std::string const& getName(ParamIndex index);
 
   /**
-   * Gets the measure unit of the specified parameter.
+   * Gets the measure unit of the specified parameter, cached like the name.
    * @index the index of the parameter
    * @return the measure unit of the parameter
    * */
-  std::string getMeasureUnit(ParamIndex index);
+  std::string const& getMeasureUnit(ParamIndex index);
 
   /**
    * Gets the number of steps of the specified parameter.
@@ -224,6 +252,32 @@ public:
    * */
   void setMidiMapping(ParamIndex index, int midiControl);
 
+  /**
+   * Removes all the midi controls mapped to a parameter.
+   * @index the index of the parameter
+   * */
+  void removeMidiMapping(ParamIndex index);
+
+  /**
+   * Starts MIDI learn: the next midi control moved by the user is mapped to the parameter, replacing the controls
+   * previously mapped to it. The mapping is published to the processor without locks and saved with the state.
+   * @index the index of the parameter
+   * @listensToAllChannels if true the control is mapped on all channels, otherwise only on the channel it is received
+   * */
+  void startMidiLearn(ParamIndex index, bool listensToAllChannels = true);
+
+  /**
+   * Stops MIDI learn without mapping any control.
+   * */
+  void stopMidiLearn();
+
+  /**
+   * Tells if MIDI learn is waiting for a control to map to the specified parameter.
+   * @index the index of the parameter
+   * @return true if MIDI learn is in progress for the parameter, false otherwise
+   * */
+  bool isMidiLearning(ParamIndex index) const;
+
   /**
    * Relates a parameter to a rectangular section of the user interface.
    * Used internally by the widgets.
@@ -252,6 +306,12 @@ public:
    * */
   void setDirty();
 
+  /**
+   * @return the number of times the parameters have been changed, by the user interface or by the host, see
+   * UnplugController::getNumParameterChanges
+   * */
+  uint32_t getNumChanges() const;
+
   ParameterAccess(UnplugController& controller, MidiMapping& midiMapping);
 
   ~ParameterAccess();
@@ -277,8 +337,38 @@ private:
   bool isProgramChange(ParamIndex index, bool& result);
 
 private:
+  struct CachedValueText final
+  {
+    double valueNormalized = -1.0;
+    std::string text;
+    double nameAndValueNormalized = -1.0;
+    std::string nameAndText;
+    // the name and the measure unit of a parameter never change
+    bool isNameCached = false;
+    std::string name;
+    bool isMeasureUnitCached = false;
+    std::string measureUnit;
+  };
+
+  struct BatchedEdit final
+  {
+    double valueNormalized = 0.0;
+    bool isPending = false;
+    bool isListed = false;
+  };
+
+  bool applyValueNormalized(ParamIndex index, double value);
+  bool flushBatchedEdit(ParamIndex index);
+
   UnplugController& controller;
   MidiMapping& midiMapping;
+  std::array<CachedValueText, NumParameters::value> valueTextCache;
+  std::string uncachedValueText;
+  std::string uncachedName;
+  std::string uncachedMeasureUnit;
+  std::array<BatchedEdit, NumParameters::value> batchedEdits;
+  std::vector<ParamIndex> batchedEditsOrder;
+  int batchDepth = 0;
   unplug::detail::ParameterEditRegister editRegister;
   unplug::detail::ParameterFromUserInterfaceCoordinates parameterFinder;
   inline static thread_local ParameterAccess* current = nullptr;
@@ -0,0 +1,179 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+
+#include "pluginterfaces/vst/ivstparameterchanges.h"
+#include "unplug/ParameterEvents.hpp"
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace Steinberg::Vst {
+
+/**
+ * An implementation of IParameterChanges that does not allocate memory after setCapacity, used to pass parameter
+ * changes to the processing callbacks when the blocks received from the host are split or re-blocked.
+ * The queues must be filled one at a time: points can only be added to the last queue that has been added.
+ * */
+class PreallocatedParameterChanges final : public IParameterChanges
+{
+public:
+  class Queue final : public IParamValueQueue
+  {
+  public:
+    ParamID PLUGIN_API getParameterId() override
+    {
+      return id;
+    }
+
+    int32 PLUGIN_API getPointCount() override
+    {
+      return numPoints;
+    }
+
+    tresult PLUGIN_API getPoint(int32 index, int32& sampleOffset, ParamValue& value) override;
+
+    /**
+     * Adds a point at the end of the queue. If there is no room left for it, the last point of the queue is replaced,
+     * so that the value at the end of the block is preserved, and kResultFalse is returned.
+     * */
+    tresult PLUGIN_API addPoint(int32 sampleOffset, ParamValue value, int32& index) override;
+
+    tresult PLUGIN_API queryInterface(const TUID iid, void** obj) override;
+
+    uint32 PLUGIN_API addRef() override
+    {
+      return 1;
+    }
+
+    uint32 PLUGIN_API release() override
+    {
+      return 1;
+    }
+
+  private:
+    friend class PreallocatedParameterChanges;
+    PreallocatedParameterChanges* owner{ nullptr };
+    ParamID id{ 0 };
+    int32 firstPoint{ 0 };
+    int32 numPoints{ 0 };
+  };
+
+  /**
+   * Allocates the memory for the queues and their points. Not to be called on the audio thread.
+   * @maxNumQueues the maximum number of parameters that can be changed in a block
+   * @maxNumPoints the maximum number of points, shared by all the queues
+   * */
+  void setCapacity(int32 maxNumQueues, int32 maxNumPoints);
+
+  /**
+   * Removes all the queues and their points.
+   * */
+  void clear();
+
+  /**
+   * Adds a queue for a parameter.
+   * @id the id of the parameter
+   * @return the new queue, or nullptr if there is no room left for it
+   * */
+  Queue* addQueue(ParamID id);
+
+  /**
+   * Removes the last queue if it has no points.
+   * */
+  void removeLastQueueIfEmpty();
+
+  int32 PLUGIN_API getParameterCount() override
+  {
+    return numQueues;
+  }
+
+  IParamValueQueue* PLUGIN_API getParameterData(int32 index) override;
+
+  IParamValueQueue* PLUGIN_API addParameterData(const ParamID& id, int32& index) override;
+
+  tresult PLUGIN_API queryInterface(const TUID iid, void** obj) override;
+
+  uint32 PLUGIN_API addRef() override
+  {
+    return 1;
+  }
+
+  uint32 PLUGIN_API release() override
+  {
+    return 1;
+  }
+
+private:
+  struct Point final
+  {
+    int32 sampleOffset;
+    ParamValue value;
+  };
+
+  std::vector<Queue> queues;
+  std::vector<Point> points;
+  int32 numQueues{ 0 };
+  int32 numPoints{ 0 };
+};
+
+/**
+ * Reads the IParameterChanges received from the host in place, as the parameter queues consumed by the
+ * ProcessingEngine. A missing IParameterChanges reads as no changes.
+ * */
+class Vst3ParameterChangesReader final
+{
+public:
+  explicit Vst3ParameterChangesReader(IParameterChanges* changes)
+    : changes{ changes }
+    , numQueues{ changes ? static_cast<unplug::Index>(std::max(changes->getParameterCount(), int32(0))) : 0 }
+  {}
+
+  unplug::Index getNumQueues() const
+  {
+    return numQueues;
+  }
+
+  /**
+   * @return the index of the parameter of the queue, or the maximum Index if the host gave no queue at that position,
+   * so that the queue is ignored
+   * */
+  unplug::ParamIndex getParamIndex(unplug::Index queue) const
+  {
+    auto const paramQueue = changes->getParameterData(static_cast<int32>(queue));
+    return paramQueue ? static_cast<unplug::ParamIndex>(paramQueue->getParameterId())
+                      : std::numeric_limits<unplug::ParamIndex>::max();
+  }
+
+  unplug::Index getNumPoints(unplug::Index queue) const
+  {
+    auto const paramQueue = changes->getParameterData(static_cast<int32>(queue));
+    return paramQueue ? static_cast<unplug::Index>(std::max(paramQueue->getPointCount(), int32(0))) : 0;
+  }
+
+  unplug::ParameterPoint getPoint(unplug::Index queue, unplug::Index point) const
+  {
+    int32 sampleOffset = 0;
+    ParamValue value = 0.0;
+    changes->getParameterData(static_cast<int32>(queue))->getPoint(static_cast<int32>(point), sampleOffset, value);
+    return { static_cast<unplug::Index>(std::max(sampleOffset, int32(0))), value };
+  }
+
+private:
+  IParameterChanges* changes;
+  unplug::Index numQueues;
+};
+
+} // namespace Steinberg::Vst
@@ -0,0 +1,75 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include "unplug/renderer/OfflineRenderer.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace unplug::renderer {
+
+struct BatchJob final
+{
+  std::string inputPath;
+  std::string outputPath;
+};
+
+struct BatchOptions final
+{
+  /** the number of worker threads, each with its own instance of the plugin. 0 means one for each hardware thread */
+  Index numWorkers = 0;
+  /** whether to pin each worker thread to a processor. It is supported on Linux and Windows */
+  bool pinWorkers = true;
+};
+
+struct BatchResult final
+{
+  std::size_t jobIndex = 0;
+  Index worker = 0;
+  bool isOk = false;
+  /** set on failure */
+  std::string error;
+  RenderStats stats;
+};
+
+struct BatchStats final
+{
+  Index numWorkers = 0;
+  std::size_t numRendered = 0;
+  std::size_t numFailed = 0;
+  /** the duration of the audio rendered successfully */
+  double audioSeconds = 0.0;
+  double totalSeconds = 0.0;
+
+  /** @return how many seconds of audio are rendered in a second by all the workers together */
+  double getThroughput() const
+  {
+    return totalSeconds > 0.0 ? audioSeconds / totalSeconds : 0.0;
+  }
+};
+
+/**
+ * Renders many files in parallel. Each worker thread has its own OfflineRenderer, so its own instance of the plugin
+ * with its own PluginState, and gets the files from a WorkStealingQueue. Each OfflineRenderer reads and writes the
+ * files on its own io thread while the plugin processes, so a worker is rarely waiting for the disk.
+ * @param onRendered called after each job from the thread of the worker that rendered it. The calls are serialized.
+ * */
+BatchStats renderBatch(std::vector<BatchJob> const& jobs,
+                       ParameterSettings const& settings,
+                       RenderOptions const& renderOptions,
+                       BatchOptions const& batchOptions,
+                       std::function<void(BatchJob const& job, BatchResult const& result)> const& onRendered);
+
+} // namespace unplug::renderer
@@ -0,0 +1,60 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace unplug::renderer {
+
+/**
+ * A value parsed from a JSON document. Only the member corresponding to the type is meaningful. The members of an
+ * object are kept in the order in which they appear in the document.
+ * */
+struct JsonValue final
+{
+  enum class Type
+  {
+    null,
+    boolean,
+    number,
+    string,
+    array,
+    object
+  };
+
+  Type type = Type::null;
+  bool boolean = false;
+  double number = 0.0;
+  std::string string;
+  std::vector<JsonValue> array;
+  std::vector<std::pair<std::string, JsonValue>> object;
+
+  /**
+   * @return the member of an object with the specified key, or nullptr if the value is not an object or it has no
+   * such member
+   * */
+  JsonValue const* find(std::string_view key) const;
+};
+
+/**
+ * Parses a JSON document.
+ * @param error on failure, it is set to a description of the error and of its position
+ * @return false on failure
+ * */
+bool parseJson(std::string_view text, JsonValue& value, std::string& error);
+
+} // namespace unplug::renderer
@@ -0,0 +1,161 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include "pluginterfaces/base/ipluginbase.h"
+#include "pluginterfaces/vst/ivstaudioprocessor.h"
+#include "pluginterfaces/vst/ivstcomponent.h"
+#include "pluginterfaces/vst/ivsteditcontroller.h"
+#include "pluginterfaces/vst/ivstmessage.h"
+#include "public.sdk/source/common/memorystream.h"
+#include "public.sdk/source/vst/hosting/hostclasses.h"
+#include "unplug/renderer/ParameterSettings.hpp"
+#include "unplug/renderer/TaskThread.hpp"
+#include "unplug/renderer/WavFile.hpp"
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace unplug::renderer {
+
+struct RenderOptions final
+{
+  /**
+   * The maximum number of samples processed by each call to process. Larger blocks amortize the cost of the calls and
+   * of the file IO.
+   * */
+  Index blockSize = 4096;
+  /** Whether to process in double precision. It is ignored if the plugin does not support it. */
+  bool doublePrecision = true;
+  /** The format of the output file. If not set, the format of the input file is used. */
+  std::optional<SampleFormat> outputFormat;
+};
+
+struct RenderStats final
+{
+  uint64_t numFrames = 0;
+  double sampleRate = 0.0;
+  Index latency = 0;
+  bool isDoublePrecision = false;
+  /** the time spent in the calls to process */
+  double processingSeconds = 0.0;
+  /** the time spent rendering the file, including the file IO and the setup of the plugin */
+  double totalSeconds = 0.0;
+
+  double getAudioSeconds() const
+  {
+    return sampleRate > 0.0 ? static_cast<double>(numFrames) / sampleRate : 0.0;
+  }
+
+  /** @return how many seconds of audio are rendered in a second */
+  double getRealTimeFactor() const
+  {
+    return totalSeconds > 0.0 ? getAudioSeconds() / totalSeconds : 0.0;
+  }
+};
+
+/**
+ * Renders audio files through the plugin linked to the executable, without a DAW. It acts as a minimal VST3 host: it
+ * creates the processor and the controller of the plugin through its factory, connects them, and calls process in
+ * kOffline mode, so the plugin runs the same code it runs in a DAW, including the processing helpers of
+ * UnplugProcessor and the sample precise automation.
+ * The latency reported by the plugin is compensated: the output file is aligned to the input file and has the same
+ * length. The files are read and written by a dedicated thread, while the plugin processes.
+ * */
+class OfflineRenderer final
+{
+public:
+  OfflineRenderer() = default;
+
+  ~OfflineRenderer();
+
+  OfflineRenderer(OfflineRenderer const&) = delete;
+  OfflineRenderer& operator=(OfflineRenderer const&) = delete;
+
+  /**
+   * Creates the plugin instance.
+   * @param error on failure, it is set to a description of the error
+   * @return false on failure
+   * */
+  bool initialize(std::string& error);
+
+  /**
+   * Renders a file. The plugin is reset to its initial state before rendering, so the result does not depend on the
+   * files rendered before.
+   * @param error on failure, it is set to a description of the error
+   * @return false on failure
+   * */
+  bool render(std::string const& inputPath,
+              std::string const& outputPath,
+              ParameterSettings const& settings,
+              RenderOptions const& options,
+              RenderStats& stats,
+              std::string& error);
+
+  /**
+   * Looks for a parameter by name or by index.
+   * @return false if there is no such parameter
+   * */
+  bool findParameter(std::string const& nameOrIndex, Steinberg::Vst::ParamID& id) const;
+
+private:
+  struct Lane final
+  {
+    Steinberg::Vst::ParamID id;
+    /** sample positions and normalized values */
+    std::vector<std::pair<double, double>> points;
+
+    double getValue(double samplePosition) const;
+  };
+
+  struct Buses final
+  {
+    std::vector<Steinberg::Vst::SpeakerArrangement> inputs;
+    std::vector<Steinberg::Vst::SpeakerArrangement> outputs;
+  };
+
+  bool resolveParameterSettings(ParameterSettings const& settings,
+                                double sampleRate,
+                                std::vector<std::pair<Steinberg::Vst::ParamID, double>>& values,
+                                std::vector<Lane>& lanes,
+                                std::string& error) const;
+
+  bool setupBuses(Index numFileChannels, Buses& buses);
+
+  template<class SampleType>
+  bool renderFile(WavReader& reader,
+                  WavWriter& writer,
+                  Buses const& buses,
+                  std::vector<std::pair<Steinberg::Vst::ParamID, double>> const& values,
+                  std::vector<Lane> const& lanes,
+                  Index blockSize,
+                  RenderStats& stats,
+                  std::string& error);
+
+  void restoreInitialState();
+
+  void terminate();
+
+  Steinberg::IPtr<Steinberg::Vst::HostApplication> hostApplication;
+  Steinberg::IPtr<Steinberg::Vst::IComponent> component;
+  Steinberg::IPtr<Steinberg::Vst::IAudioProcessor> processor;
+  Steinberg::IPtr<Steinberg::Vst::IEditController> controller;
+  Steinberg::IPtr<Steinberg::Vst::IConnectionPoint> componentConnection;
+  Steinberg::IPtr<Steinberg::Vst::IConnectionPoint> controllerConnection;
+  Steinberg::IPtr<Steinberg::MemoryStream> initialState;
+  std::vector<Steinberg::Vst::ParameterInfo> parameters;
+  TaskThread ioThread;
+};
+
+} // namespace unplug::renderer
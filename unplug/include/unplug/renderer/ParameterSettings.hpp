@@ -0,0 +1,84 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace unplug::renderer {
+
+/**
+ * A parameter value, in the plain (not normalized) range of the parameter. The parameter is identified by its name or
+ * by its index.
+ * */
+struct ParameterValue final
+{
+  std::string parameter;
+  double value = 0.0;
+};
+
+struct AutomationPoint final
+{
+  /** in seconds from the beginning of the file */
+  double time = 0.0;
+  /** in the plain range of the parameter */
+  double value = 0.0;
+};
+
+/**
+ * The automation of a parameter. The value is interpolated linearly between the points, and it is held before the
+ * first one and after the last one. The points are sorted by time.
+ * */
+struct AutomationLane final
+{
+  std::string parameter;
+  std::vector<AutomationPoint> points;
+};
+
+/**
+ * The parameter values used to render a file: an optional preset, which is applied first, the values of some
+ * parameters, which override the ones of the preset, and the automation lanes, which override both.
+ * */
+struct ParameterSettings final
+{
+  /** the name or the index of a preset returned by getPresets, empty for none */
+  std::string preset;
+  std::vector<ParameterValue> values;
+  std::vector<AutomationLane> lanes;
+};
+
+/**
+ * Loads the parameter settings from a JSON file like the following:
+ * {
+ *   "preset": "Default",
+ *   "parameters": { "Gain": -6.0, "3": 1 },
+ *   "automation": { "Gain": [[0.0, -6.0], [2.5, 0.0]] }
+ * }
+ * All the members are optional. The parameters are identified by their names or by their indices, the automation
+ * points are pairs of time in seconds and value.
+ * @param error on failure, it is set to a description of the error
+ * @return false on failure
+ * */
+bool loadParameterSettings(std::string const& path, ParameterSettings& settings, std::string& error);
+
+/**
+ * Interpolates linearly between points sorted by position, holding the first value before them and the last one after
+ * them, as the automation lanes do.
+ * @param points pairs of position and value, not empty
+ * @return the value at the specified position
+ * */
+double interpolateLinearly(std::vector<std::pair<double, double>> const& points, double position);
+
+} // namespace unplug::renderer
@@ -0,0 +1,90 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace unplug::renderer {
+
+/**
+ * A thread that runs tasks one at a time, in the order in which they are posted. The OfflineRenderer uses it to read
+ * and write the files while the plugin processes.
+ * */
+class TaskThread final
+{
+public:
+  TaskThread()
+    : thread{ [this] { run(); } }
+  {}
+
+  ~TaskThread()
+  {
+    {
+      auto lock = std::lock_guard(mutex);
+      isStopping = true;
+    }
+    condition.notify_one();
+    thread.join();
+  }
+
+  TaskThread(TaskThread const&) = delete;
+  TaskThread& operator=(TaskThread const&) = delete;
+
+  /**
+   * Posts a task.
+   * @return a future that is ready when the task has been run
+   * */
+  std::future<void> post(std::function<void()> task)
+  {
+    auto packagedTask = std::packaged_task<void()>(std::move(task));
+    auto future = packagedTask.get_future();
+    {
+      auto lock = std::lock_guard(mutex);
+      tasks.push_back(std::move(packagedTask));
+    }
+    condition.notify_one();
+    return future;
+  }
+
+private:
+  void run()
+  {
+    while (true) {
+      auto task = std::packaged_task<void()>{};
+      {
+        auto lock = std::unique_lock(mutex);
+        condition.wait(lock, [this] { return isStopping || !tasks.empty(); });
+        if (tasks.empty()) {
+          return;
+        }
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<std::packaged_task<void()>> tasks;
+  bool isStopping = false;
+  std::thread thread;
+};
+
+} // namespace unplug::renderer
@@ -0,0 +1,132 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include "unplug/Index.hpp"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace unplug::renderer {
+
+enum class SampleFormat
+{
+  pcm16,
+  pcm24,
+  pcm32,
+  float32,
+  float64
+};
+
+/**
+ * @return the size in bytes of a sample in the specified format
+ * */
+Index getSampleSize(SampleFormat format);
+
+/**
+ * Parses a sample format from its name, which is the name of the enumerator: pcm16, pcm24, pcm32, float32 or float64.
+ * @return false if the name is not recognized
+ * */
+bool getSampleFormatFromName(std::string const& name, SampleFormat& format);
+
+struct WavInfo final
+{
+  Index numChannels = 0;
+  double sampleRate = 0.0;
+  uint64_t numFrames = 0;
+  SampleFormat format = SampleFormat::pcm16;
+};
+
+/**
+ * Reads a WAV file in blocks, without loading it in memory. It supports 16, 24 and 32 bits integer samples and 32 and
+ * 64 bits floating point samples, also in the WAVE_FORMAT_EXTENSIBLE format.
+ * */
+class WavReader final
+{
+public:
+  /**
+   * Opens a file and reads its header.
+   * @return false if the file could not be opened or if its format is not supported
+   * */
+  bool open(std::string const& path);
+
+  WavInfo const& getInfo() const
+  {
+    return info;
+  }
+
+  /**
+   * Reads the next frames of the file, converting them to floating point and separating the channels.
+   * @param channels the buffers to read into, one for each channel of the file, each with room for numFrames samples
+   * @return the number of frames read, which is less than numFrames at the end of the file or on errors
+   * */
+  template<class SampleType>
+  Index read(SampleType* const* channels, Index numFrames);
+
+private:
+  std::ifstream file;
+  WavInfo info;
+  uint64_t numFramesLeft = 0;
+  std::vector<char> rawData;
+};
+
+/**
+ * Writes a WAV file in blocks. The sizes in the header are written by close, or on destruction.
+ * */
+class WavWriter final
+{
+public:
+  WavWriter() = default;
+
+  ~WavWriter();
+
+  WavWriter(WavWriter const&) = delete;
+  WavWriter& operator=(WavWriter const&) = delete;
+
+  /**
+   * Creates a file and writes its header. The numFrames member of info is ignored.
+   * @return false if the file could not be created
+   * */
+  bool open(std::string const& path, WavInfo const& info);
+
+  /**
+   * Writes frames to the file, converting them to the sample format of the file. Integer samples are clipped.
+   * @param channels the buffers to write, one for each channel of the file
+   * @return false on errors, or if the size of the data exceeds the 4GB limit of the WAV format
+   * */
+  template<class SampleType>
+  bool write(SampleType const* const* channels, Index numFrames);
+
+  /**
+   * Writes the sizes in the header and closes the file.
+   * @return false on errors
+   * */
+  bool close();
+
+  uint64_t getNumFramesWritten() const
+  {
+    return numFramesWritten;
+  }
+
+private:
+  std::ofstream file;
+  WavInfo info;
+  uint64_t numFramesWritten = 0;
+  std::streamoff riffSizePosition = 0;
+  std::streamoff dataSizePosition = 0;
+  std::vector<char> rawData;
+};
+
+} // namespace unplug::renderer
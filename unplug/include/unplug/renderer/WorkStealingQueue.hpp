@@ -0,0 +1,82 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#pragma once
+#include "unplug/Index.hpp"
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace unplug::renderer {
+
+/**
+ * Distributes jobs to a set of workers. Each worker has its own queue, initially filled with a contiguous range of the
+ * jobs; when it is empty, the worker steals jobs from the back of the queues of the other workers, so that the load is
+ * balanced even if the jobs have very different durations. The jobs are identified by their index.
+ * */
+class WorkStealingQueue final
+{
+public:
+  WorkStealingQueue(Index numWorkers, std::size_t numJobs)
+    : queues(numWorkers)
+  {
+    for (Index worker = 0; worker < numWorkers; ++worker) {
+      auto const begin = numJobs * worker / numWorkers;
+      auto const end = numJobs * (worker + 1) / numWorkers;
+      for (auto job = begin; job < end; ++job) {
+        queues[worker].jobs.push_back(job);
+      }
+    }
+  }
+
+  /**
+   * Gets the next job for a worker.
+   * @return false if there are no jobs left
+   * */
+  bool pop(Index worker, std::size_t& job)
+  {
+    {
+      auto& queue = queues[worker];
+      auto lock = std::lock_guard(queue.mutex);
+      if (!queue.jobs.empty()) {
+        job = queue.jobs.front();
+        queue.jobs.pop_front();
+        return true;
+      }
+    }
+    auto const numWorkers = static_cast<Index>(queues.size());
+    for (Index i = 1; i < numWorkers; ++i) {
+      auto& victim = queues[(worker + i) % numWorkers];
+      auto lock = std::lock_guard(victim.mutex);
+      if (!victim.jobs.empty()) {
+        job = victim.jobs.back();
+        victim.jobs.pop_back();
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  struct alignas(64) Queue final
+  {
+    std::mutex mutex;
+    std::deque<std::size_t> jobs;
+  };
+
+  std::vector<Queue> queues;
+};
+
+} // namespace unplug::renderer
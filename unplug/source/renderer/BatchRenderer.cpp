@@ -0,0 +1,111 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/renderer/BatchRenderer.hpp"
+#include "unplug/renderer/WorkStealingQueue.hpp"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace unplug::renderer {
+
+namespace {
+
+bool pinCurrentThread(Index processor)
+{
+#if defined(_WIN32)
+  return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{ 1 } << (processor % 64)) != 0;
+#elif defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(processor % CPU_SETSIZE, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+} // namespace
+
+BatchStats renderBatch(std::vector<BatchJob> const& jobs,
+                       ParameterSettings const& settings,
+                       RenderOptions const& renderOptions,
+                       BatchOptions const& batchOptions,
+                       std::function<void(BatchJob const& job, BatchResult const& result)> const& onRendered)
+{
+  using Clock = std::chrono::steady_clock;
+  auto const startTime = Clock::now();
+  auto stats = BatchStats{};
+  auto const numProcessors = std::max(1u, std::thread::hardware_concurrency());
+  auto const numWorkers = batchOptions.numWorkers > 0 ? batchOptions.numWorkers : numProcessors;
+  stats.numWorkers = static_cast<Index>(std::min<std::size_t>(numWorkers, std::max<std::size_t>(jobs.size(), 1)));
+
+  auto queue = WorkStealingQueue(stats.numWorkers, jobs.size());
+  auto mutex = std::mutex{};
+  auto const work = [&](Index worker) {
+    // the renderer is created before pinning the thread, because on Linux new threads inherit the affinity of the
+    // thread that creates them, and its io thread should not compete with the processing for the same processor
+    auto renderer = OfflineRenderer{};
+    auto error = std::string{};
+    bool const isInitialized = renderer.initialize(error);
+    if (batchOptions.pinWorkers) {
+      pinCurrentThread(worker % numProcessors);
+    }
+    std::size_t jobIndex = 0;
+    while (queue.pop(worker, jobIndex)) {
+      auto const& job = jobs[jobIndex];
+      auto result = BatchResult{};
+      result.jobIndex = jobIndex;
+      result.worker = worker;
+      result.isOk = isInitialized &&
+                    renderer.render(job.inputPath, job.outputPath, settings, renderOptions, result.stats, error);
+      if (!result.isOk) {
+        result.error = error;
+      }
+      auto lock = std::lock_guard(mutex);
+      if (result.isOk) {
+        ++stats.numRendered;
+        stats.audioSeconds += result.stats.getAudioSeconds();
+      }
+      else {
+        ++stats.numFailed;
+      }
+      if (onRendered) {
+        onRendered(job, result);
+      }
+    }
+  };
+
+  auto workers = std::vector<std::thread>{};
+  workers.reserve(stats.numWorkers);
+  for (Index worker = 0; worker < stats.numWorkers; ++worker) {
+    workers.emplace_back(work, worker);
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  stats.totalSeconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+  return stats;
+}
+
+} // namespace unplug::renderer
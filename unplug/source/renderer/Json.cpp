@@ -0,0 +1,325 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/renderer/Json.hpp"
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+
+namespace unplug::renderer {
+
+namespace {
+
+class JsonParser final
+{
+public:
+  explicit JsonParser(std::string_view text)
+    : text{ text }
+  {}
+
+  bool parseDocument(JsonValue& value)
+  {
+    if (!parseValue(value, 0)) {
+      return false;
+    }
+    skipWhitespace();
+    return position == text.size() || fail("unexpected characters after the end of the document");
+  }
+
+  std::string const& getError() const
+  {
+    return error;
+  }
+
+private:
+  static constexpr int maxDepth = 256;
+
+  bool fail(char const* description)
+  {
+    error = std::string(description) + " at offset " + std::to_string(position);
+    return false;
+  }
+
+  void skipWhitespace()
+  {
+    while (position < text.size() &&
+           (text[position] == ' ' || text[position] == '\t' || text[position] == '\n' || text[position] == '\r')) {
+      ++position;
+    }
+  }
+
+  bool consume(char character)
+  {
+    skipWhitespace();
+    if (position < text.size() && text[position] == character) {
+      ++position;
+      return true;
+    }
+    return false;
+  }
+
+  bool consumeLiteral(std::string_view literal)
+  {
+    if (text.substr(position, literal.size()) == literal) {
+      position += literal.size();
+      return true;
+    }
+    return false;
+  }
+
+  bool parseValue(JsonValue& value, int depth)
+  {
+    if (depth > maxDepth) {
+      return fail("too many nested values");
+    }
+    skipWhitespace();
+    if (position == text.size()) {
+      return fail("unexpected end of the document");
+    }
+    switch (text[position]) {
+      case '{':
+        return parseObject(value, depth);
+      case '[':
+        return parseArray(value, depth);
+      case '"':
+        value.type = JsonValue::Type::string;
+        return parseString(value.string);
+      case 't':
+      case 'f':
+        value.type = JsonValue::Type::boolean;
+        value.boolean = text[position] == 't';
+        return consumeLiteral(value.boolean ? "true" : "false") || fail("invalid literal");
+      case 'n':
+        value.type = JsonValue::Type::null;
+        return consumeLiteral("null") || fail("invalid literal");
+      default:
+        value.type = JsonValue::Type::number;
+        return parseNumber(value.number);
+    }
+  }
+
+  bool parseObject(JsonValue& value, int depth)
+  {
+    value.type = JsonValue::Type::object;
+    ++position;
+    if (consume('}')) {
+      return true;
+    }
+    do {
+      skipWhitespace();
+      auto member = std::pair<std::string, JsonValue>{};
+      if (position == text.size() || text[position] != '"') {
+        return fail("expected a string as object key");
+      }
+      if (!parseString(member.first)) {
+        return false;
+      }
+      if (!consume(':')) {
+        return fail("expected ':'");
+      }
+      if (!parseValue(member.second, depth + 1)) {
+        return false;
+      }
+      value.object.push_back(std::move(member));
+    } while (consume(','));
+    return consume('}') || fail("expected ',' or '}'");
+  }
+
+  bool parseArray(JsonValue& value, int depth)
+  {
+    value.type = JsonValue::Type::array;
+    ++position;
+    if (consume(']')) {
+      return true;
+    }
+    do {
+      auto& element = value.array.emplace_back();
+      if (!parseValue(element, depth + 1)) {
+        return false;
+      }
+    } while (consume(','));
+    return consume(']') || fail("expected ',' or ']'");
+  }
+
+  bool parseHexDigits(uint32_t& codePoint)
+  {
+    if (position + 4 > text.size()) {
+      return fail("truncated unicode escape");
+    }
+    codePoint = 0;
+    for (int i = 0; i < 4; ++i) {
+      char const digit = text[position++];
+      codePoint <<= 4;
+      if (digit >= '0' && digit <= '9') {
+        codePoint |= digit - '0';
+      }
+      else if (digit >= 'a' && digit <= 'f') {
+        codePoint |= digit - 'a' + 10;
+      }
+      else if (digit >= 'A' && digit <= 'F') {
+        codePoint |= digit - 'A' + 10;
+      }
+      else {
+        return fail("invalid unicode escape");
+      }
+    }
+    return true;
+  }
+
+  static void appendUtf8(std::string& string, uint32_t codePoint)
+  {
+    if (codePoint < 0x80) {
+      string += static_cast<char>(codePoint);
+    }
+    else if (codePoint < 0x800) {
+      string += static_cast<char>(0xC0 | (codePoint >> 6));
+      string += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+    else if (codePoint < 0x10000) {
+      string += static_cast<char>(0xE0 | (codePoint >> 12));
+      string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+      string += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+    else {
+      string += static_cast<char>(0xF0 | (codePoint >> 18));
+      string += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+      string += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+      string += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+  }
+
+  bool parseEscape(std::string& string)
+  {
+    if (position == text.size()) {
+      return fail("unterminated string");
+    }
+    switch (text[position++]) {
+      case '"':
+        string += '"';
+        return true;
+      case '\\':
+        string += '\\';
+        return true;
+      case '/':
+        string += '/';
+        return true;
+      case 'b':
+        string += '\b';
+        return true;
+      case 'f':
+        string += '\f';
+        return true;
+      case 'n':
+        string += '\n';
+        return true;
+      case 'r':
+        string += '\r';
+        return true;
+      case 't':
+        string += '\t';
+        return true;
+      case 'u': {
+        uint32_t codePoint;
+        if (!parseHexDigits(codePoint)) {
+          return false;
+        }
+        bool const isHighSurrogate = codePoint >= 0xD800 && codePoint < 0xDC00;
+        if (isHighSurrogate && consumeLiteral("\\u")) {
+          uint32_t lowSurrogate;
+          if (!parseHexDigits(lowSurrogate)) {
+            return false;
+          }
+          if (lowSurrogate < 0xDC00 || lowSurrogate >= 0xE000) {
+            return fail("invalid surrogate pair");
+          }
+          codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+        }
+        appendUtf8(string, codePoint);
+        return true;
+      }
+      default:
+        return fail("invalid escape sequence");
+    }
+  }
+
+  bool parseString(std::string& string)
+  {
+    ++position;
+    while (position < text.size()) {
+      char const character = text[position++];
+      if (character == '"') {
+        return true;
+      }
+      if (character == '\\') {
+        if (!parseEscape(string)) {
+          return false;
+        }
+      }
+      else {
+        string += character;
+      }
+    }
+    return fail("unterminated string");
+  }
+
+  bool parseNumber(double& number)
+  {
+    auto const begin = position;
+    while (position < text.size() && (std::isdigit(static_cast<unsigned char>(text[position])) ||
+                                      text[position] == '-' || text[position] == '+' || text[position] == '.' ||
+                                      text[position] == 'e' || text[position] == 'E')) {
+      ++position;
+    }
+    auto const numberText = std::string(text.substr(begin, position - begin));
+    char* end = nullptr;
+    number = std::strtod(numberText.c_str(), &end);
+    if (numberText.empty() || end != numberText.c_str() + numberText.size()) {
+      position = begin;
+      return fail("invalid value");
+    }
+    return true;
+  }
+
+  std::string_view text;
+  std::size_t position = 0;
+  std::string error;
+};
+
+} // namespace
+
+JsonValue const* JsonValue::find(std::string_view key) const
+{
+  if (type != Type::object) {
+    return nullptr;
+  }
+  for (auto const& member : object) {
+    if (member.first == key) {
+      return &member.second;
+    }
+  }
+  return nullptr;
+}
+
+bool parseJson(std::string_view text, JsonValue& value, std::string& error)
+{
+  auto parser = JsonParser(text);
+  value = JsonValue{};
+  if (!parser.parseDocument(value)) {
+    error = parser.getError();
+    return false;
+  }
+  return true;
+}
+
+} // namespace unplug::renderer
@@ -0,0 +1,300 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/renderer/BatchRenderer.hpp"
+#include "unplug/renderer/OfflineRenderer.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using namespace unplug::renderer;
+
+void printUsage(char const* executable)
+{
+  std::fprintf(stderr,
+               "usage: %s [options] <input.wav> <output.wav>\n"
+               "       %s [options] --output-dir <directory> <input.wav>...\n"
+               "Renders WAV files through the plugin. With --output-dir, the files are rendered in parallel and each\n"
+               "output file has the name of its input file: input files with the same name, or output files that\n"
+               "would overwrite an input file, are an error.\n"
+               "options:\n"
+               "  --preset <name|index>     applies a preset of the plugin\n"
+               "  --automation <file.json>  applies the parameter values and the automation in a JSON file:\n"
+               "                            {\"preset\": \"Default\", \"parameters\": {\"Gain\": -6},\n"
+               "                             \"automation\": {\"Gain\": [[0.0, -6], [2.5, 0]]}}\n"
+               "                            values are in the range of the parameters, times in seconds\n"
+               "  --block-size <samples>    the maximum number of samples processed at once, 4096 by default\n"
+               "  --precision <float|double>  the floating point precision of the processing, double by default\n"
+               "  --format <pcm16|pcm24|pcm32|float32|float64>  the sample format of the output, the one of the\n"
+               "                            input by default\n"
+               "batch options:\n"
+               "  --output-dir <directory>  the directory of the output files, it is created if missing\n"
+               "  --input-list <file>       reads the input files from a text file, one for each line\n"
+               "  --jobs <number>           the number of worker threads, one for each hardware thread by default\n"
+               "  --no-pinning              does not pin the worker threads to the processors\n",
+               executable,
+               executable);
+}
+
+double getProcessingRealTimeFactor(RenderStats const& stats)
+{
+  return stats.processingSeconds > 0.0 ? stats.getAudioSeconds() / stats.processingSeconds : 0.0;
+}
+
+bool readInputList(std::string const& path, std::vector<std::string>& inputs)
+{
+  auto file = std::ifstream(path);
+  if (!file) {
+    return false;
+  }
+  auto line = std::string{};
+  while (std::getline(file, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (!line.empty()) {
+      inputs.push_back(line);
+    }
+  }
+  return true;
+}
+
+/**
+ * @return the path in a form that compares equal for the same file, also if it does not exist yet
+ * */
+std::filesystem::path getComparablePath(std::string const& path)
+{
+  auto errorCode = std::error_code{};
+  auto comparablePath = std::filesystem::weakly_canonical(std::filesystem::absolute(path, errorCode), errorCode);
+  return errorCode ? std::filesystem::path(path).lexically_normal() : comparablePath;
+}
+
+/**
+ * Checks that no output file would overwrite an input file or the output of another job, which would corrupt the
+ * files being read or written by the other workers.
+ * */
+bool checkOutputPaths(std::vector<BatchJob> const& jobs)
+{
+  auto inputs = std::map<std::filesystem::path, std::string const*>{};
+  for (auto const& job : jobs) {
+    inputs.emplace(getComparablePath(job.inputPath), &job.inputPath);
+  }
+  auto outputs = std::map<std::filesystem::path, std::string const*>{};
+  bool isOk = true;
+  for (auto const& job : jobs) {
+    auto const outputPath = getComparablePath(job.outputPath);
+    if (auto const input = inputs.find(outputPath); input != inputs.end()) {
+      std::fprintf(stderr,
+                   "the output of %s would overwrite the input file %s\n",
+                   job.inputPath.c_str(),
+                   input->second->c_str());
+      isOk = false;
+    }
+    else if (auto const [output, isNew] = outputs.emplace(outputPath, &job.inputPath); !isNew) {
+      std::fprintf(stderr,
+                   "%s and %s would be rendered to the same file %s\n",
+                   output->second->c_str(),
+                   job.inputPath.c_str(),
+                   job.outputPath.c_str());
+      isOk = false;
+    }
+  }
+  return isOk;
+}
+
+int renderFile(std::string const& inputPath,
+               std::string const& outputPath,
+               ParameterSettings const& settings,
+               RenderOptions const& options)
+{
+  if (getComparablePath(inputPath) == getComparablePath(outputPath)) {
+    std::fprintf(stderr, "the output file %s would overwrite the input file\n", outputPath.c_str());
+    return EXIT_FAILURE;
+  }
+  auto error = std::string{};
+  auto renderer = OfflineRenderer{};
+  if (!renderer.initialize(error)) {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return EXIT_FAILURE;
+  }
+  auto stats = RenderStats{};
+  if (!renderer.render(inputPath, outputPath, settings, options, stats, error)) {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return EXIT_FAILURE;
+  }
+  std::printf("%s -> %s: %.2f s of audio rendered in %.3f s, real-time factor %.1f (%.1f processing only), %s "
+              "precision, latency %u samples\n",
+              inputPath.c_str(),
+              outputPath.c_str(),
+              stats.getAudioSeconds(),
+              stats.totalSeconds,
+              stats.getRealTimeFactor(),
+              getProcessingRealTimeFactor(stats),
+              stats.isDoublePrecision ? "double" : "float",
+              static_cast<unsigned>(stats.latency));
+  return EXIT_SUCCESS;
+}
+
+int renderFiles(std::vector<std::string> const& inputPaths,
+                std::string const& outputDirectory,
+                ParameterSettings const& settings,
+                RenderOptions const& renderOptions,
+                BatchOptions const& batchOptions)
+{
+  auto jobs = std::vector<BatchJob>{};
+  jobs.reserve(inputPaths.size());
+  for (auto const& inputPath : inputPaths) {
+    auto const outputPath = std::filesystem::path(outputDirectory) / std::filesystem::path(inputPath).filename();
+    jobs.push_back({ inputPath, outputPath.string() });
+  }
+  if (!checkOutputPaths(jobs)) {
+    return EXIT_FAILURE;
+  }
+  auto errorCode = std::error_code{};
+  std::filesystem::create_directories(outputDirectory, errorCode);
+  if (errorCode) {
+    std::fprintf(stderr, "could not create %s: %s\n", outputDirectory.c_str(), errorCode.message().c_str());
+    return EXIT_FAILURE;
+  }
+  auto const stats = renderBatch(jobs, settings, renderOptions, batchOptions, [](auto const& job, auto const& result) {
+    if (result.isOk) {
+      std::printf("[worker %u] %s: %.2f s of audio rendered in %.3f s, real-time factor %.1f (%.1f processing only)\n",
+                  static_cast<unsigned>(result.worker),
+                  job.inputPath.c_str(),
+                  result.stats.getAudioSeconds(),
+                  result.stats.totalSeconds,
+                  result.stats.getRealTimeFactor(),
+                  getProcessingRealTimeFactor(result.stats));
+    }
+    else {
+      std::fprintf(stderr,
+                   "[worker %u] %s: %s\n",
+                   static_cast<unsigned>(result.worker),
+                   job.inputPath.c_str(),
+                   result.error.c_str());
+    }
+  });
+  std::printf("%zu files rendered, %zu failed: %.2f s of audio in %.3f s with %u workers, throughput %.1f times "
+              "real-time\n",
+              stats.numRendered,
+              stats.numFailed,
+              stats.audioSeconds,
+              stats.totalSeconds,
+              static_cast<unsigned>(stats.numWorkers),
+              stats.getThroughput());
+  return stats.numFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  auto renderOptions = RenderOptions{};
+  auto batchOptions = BatchOptions{};
+  auto settings = ParameterSettings{};
+  auto presetOption = std::string{};
+  auto automationPath = std::string{};
+  auto outputDirectory = std::string{};
+  auto paths = std::vector<std::string>{};
+  for (int i = 1; i < argc; ++i) {
+    auto const argument = std::string_view(argv[i]);
+    bool const hasValue = i + 1 < argc;
+    if (argument == "--help" || argument == "-h") {
+      printUsage(argv[0]);
+      return EXIT_SUCCESS;
+    }
+    else if (argument == "--preset" && hasValue) {
+      presetOption = argv[++i];
+    }
+    else if (argument == "--automation" && hasValue) {
+      automationPath = argv[++i];
+    }
+    else if (argument == "--block-size" && hasValue) {
+      auto const blockSize = std::strtol(argv[++i], nullptr, 10);
+      if (blockSize <= 0) {
+        std::fprintf(stderr, "invalid block size: %s\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+      renderOptions.blockSize = static_cast<unplug::Index>(blockSize);
+    }
+    else if (argument == "--precision" && hasValue) {
+      auto const precision = std::string_view(argv[++i]);
+      if (precision != "float" && precision != "double") {
+        std::fprintf(stderr, "invalid precision: %s\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+      renderOptions.doublePrecision = precision == "double";
+    }
+    else if (argument == "--format" && hasValue) {
+      auto format = SampleFormat{};
+      if (!getSampleFormatFromName(argv[++i], format)) {
+        std::fprintf(stderr, "invalid format: %s\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+      renderOptions.outputFormat = format;
+    }
+    else if (argument == "--output-dir" && hasValue) {
+      outputDirectory = argv[++i];
+    }
+    else if (argument == "--input-list" && hasValue) {
+      if (!readInputList(argv[++i], paths)) {
+        std::fprintf(stderr, "could not read %s\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+    }
+    else if (argument == "--jobs" && hasValue) {
+      auto const numWorkers = std::strtol(argv[++i], nullptr, 10);
+      if (numWorkers <= 0) {
+        std::fprintf(stderr, "invalid number of jobs: %s\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+      batchOptions.numWorkers = static_cast<unplug::Index>(numWorkers);
+    }
+    else if (argument == "--no-pinning") {
+      batchOptions.pinWorkers = false;
+    }
+    else if (argument.starts_with("--")) {
+      std::fprintf(stderr, "unknown option or missing value: %s\n", argv[i]);
+      printUsage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    else {
+      paths.emplace_back(argument);
+    }
+  }
+  bool const isBatch = !outputDirectory.empty();
+  if (isBatch ? paths.empty() : paths.size() != 2) {
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  auto error = std::string{};
+  if (!automationPath.empty() && !loadParameterSettings(automationPath, settings, error)) {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return EXIT_FAILURE;
+  }
+  if (!presetOption.empty()) {
+    settings.preset = presetOption;
+  }
+
+  return isBatch ? renderFiles(paths, outputDirectory, settings, renderOptions, batchOptions)
+                 : renderFile(paths[0], paths[1], settings, renderOptions);
+}
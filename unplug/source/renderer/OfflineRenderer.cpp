@@ -0,0 +1,625 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/renderer/OfflineRenderer.hpp"
+#include "pluginterfaces/vst/ivstprocesscontext.h"
+#include "pluginterfaces/vst/vstspeaker.h"
+#include "public.sdk/source/vst/hosting/parameterchanges.h"
+#include "unplug/Presets.hpp"
+#include "unplug/StringConversion.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+namespace unplug::renderer {
+
+using namespace Steinberg;
+using namespace Steinberg::Vst;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double getSeconds(Clock::duration duration)
+{
+  return std::chrono::duration<double>(duration).count();
+}
+
+IPluginFactory* getPluginFactory()
+{
+  // the factory of the plugin linked to the executable, defined in its Entry.cpp
+  static auto const factory = owned(GetPluginFactory());
+  return factory;
+}
+
+SpeakerArrangement getArrangement(Index numChannels)
+{
+  switch (numChannels) {
+    case 1:
+      return SpeakerArr::kMono;
+    case 2:
+      return SpeakerArr::kStereo;
+    default:
+      return numChannels >= 64 ? ~SpeakerArrangement{ 0 } : (SpeakerArrangement{ 1 } << numChannels) - 1;
+  }
+}
+
+bool parseIndex(std::string const& text, uint64_t& index)
+{
+  if (text.empty() || !std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+    return false;
+  }
+  index = std::strtoull(text.c_str(), nullptr, 10);
+  return true;
+}
+
+/**
+ * The buffers of the audio buses passed to process.
+ * */
+template<class SampleType>
+class BusBuffers final
+{
+public:
+  BusBuffers(std::vector<SpeakerArrangement> const& arrangements, Index blockSize)
+    : buffers(arrangements.size())
+    , channels(arrangements.size())
+    , audioBuses(arrangements.size())
+  {
+    for (std::size_t bus = 0; bus < arrangements.size(); ++bus) {
+      auto const numChannels = SpeakerArr::getChannelCount(arrangements[bus]);
+      buffers[bus].assign(numChannels, std::vector<SampleType>(blockSize, static_cast<SampleType>(0)));
+      for (auto& buffer : buffers[bus]) {
+        channels[bus].push_back(buffer.data());
+      }
+      audioBuses[bus].numChannels = numChannels;
+      if constexpr (std::is_same_v<SampleType, double>) {
+        audioBuses[bus].channelBuffers64 = channels[bus].data();
+      }
+      else {
+        audioBuses[bus].channelBuffers32 = channels[bus].data();
+      }
+    }
+  }
+
+  int32 getNumBuses() const
+  {
+    return static_cast<int32>(audioBuses.size());
+  }
+
+  AudioBusBuffers* getAudioBuses()
+  {
+    return audioBuses.empty() ? nullptr : audioBuses.data();
+  }
+
+  std::vector<SampleType*> const& getChannels(std::size_t bus) const
+  {
+    return channels[bus];
+  }
+
+private:
+  std::vector<std::vector<std::vector<SampleType>>> buffers;
+  std::vector<std::vector<SampleType*>> channels;
+  std::vector<AudioBusBuffers> audioBuses;
+};
+
+} // namespace
+
+OfflineRenderer::~OfflineRenderer()
+{
+  terminate();
+}
+
+bool OfflineRenderer::initialize(std::string& error)
+{
+  auto const factory = getPluginFactory();
+  if (!factory) {
+    error = "the plugin factory is missing";
+    return false;
+  }
+  auto classInfo = PClassInfo{};
+  bool hasProcessorClass = false;
+  for (int32 i = 0; i < factory->countClasses() && !hasProcessorClass; ++i) {
+    hasProcessorClass = factory->getClassInfo(i, &classInfo) == kResultOk &&
+                        std::strcmp(classInfo.category, kVstAudioEffectClass) == 0;
+  }
+  if (!hasProcessorClass) {
+    error = "the plugin factory has no audio effect class";
+    return false;
+  }
+  hostApplication = owned(new HostApplication());
+  auto const context = static_cast<IHostApplication*>(hostApplication);
+
+  IComponent* newComponent = nullptr;
+  if (factory->createInstance(classInfo.cid, IComponent::iid, reinterpret_cast<void**>(&newComponent)) != kResultOk ||
+      !newComponent) {
+    error = "could not create the plugin processor";
+    return false;
+  }
+  auto createdComponent = owned(newComponent);
+  if (createdComponent->initialize(context) != kResultOk) {
+    error = "could not initialize the plugin processor";
+    return false;
+  }
+  component = createdComponent;
+  processor = FUnknownPtr<IAudioProcessor>(component);
+  if (!processor) {
+    error = "the plugin processor is not an audio processor";
+    return false;
+  }
+
+  TUID controllerClassId;
+  IEditController* newController = nullptr;
+  if (component->getControllerClassId(controllerClassId) != kResultOk ||
+      factory->createInstance(controllerClassId, IEditController::iid, reinterpret_cast<void**>(&newController)) !=
+        kResultOk ||
+      !newController) {
+    error = "could not create the plugin controller";
+    return false;
+  }
+  auto createdController = owned(newController);
+  if (createdController->initialize(context) != kResultOk) {
+    error = "could not initialize the plugin controller";
+    return false;
+  }
+  controller = createdController;
+
+  componentConnection = FUnknownPtr<IConnectionPoint>(component);
+  controllerConnection = FUnknownPtr<IConnectionPoint>(controller);
+  if (componentConnection && controllerConnection) {
+    componentConnection->connect(controllerConnection);
+    controllerConnection->connect(componentConnection);
+  }
+
+  initialState = owned(new MemoryStream());
+  if (component->getState(initialState) != kResultOk) {
+    error = "could not get the state of the plugin";
+    return false;
+  }
+
+  auto const numParameters = controller->getParameterCount();
+  parameters.reserve(numParameters);
+  for (int32 i = 0; i < numParameters; ++i) {
+    auto info = ParameterInfo{};
+    if (controller->getParameterInfo(i, info) == kResultOk) {
+      parameters.push_back(info);
+    }
+  }
+  return true;
+}
+
+void OfflineRenderer::terminate()
+{
+  if (componentConnection && controllerConnection) {
+    componentConnection->disconnect(controllerConnection);
+    controllerConnection->disconnect(componentConnection);
+  }
+  componentConnection = nullptr;
+  controllerConnection = nullptr;
+  if (controller) {
+    controller->terminate();
+    controller = nullptr;
+  }
+  processor = nullptr;
+  if (component) {
+    component->terminate();
+    component = nullptr;
+  }
+}
+
+bool OfflineRenderer::findParameter(std::string const& nameOrIndex, ParamID& id) const
+{
+  for (auto const& info : parameters) {
+    if (ToUtf8{}(info.title) == nameOrIndex) {
+      id = info.id;
+      return true;
+    }
+  }
+  uint64_t index = 0;
+  if (parseIndex(nameOrIndex, index)) {
+    for (auto const& info : parameters) {
+      if (info.id == index) {
+        id = info.id;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+double OfflineRenderer::Lane::getValue(double samplePosition) const
+{
+  return interpolateLinearly(points, samplePosition);
+}
+
+bool OfflineRenderer::resolveParameterSettings(ParameterSettings const& settings,
+                                               double sampleRate,
+                                               std::vector<std::pair<ParamID, double>>& values,
+                                               std::vector<Lane>& lanes,
+                                               std::string& error) const
+{
+  values.clear();
+  lanes.clear();
+  auto const toNormalized = [&](ParamID id, double plainValue) {
+    return std::clamp(controller->plainParamToNormalized(id, plainValue), 0.0, 1.0);
+  };
+  auto const setValue = [&](ParamID id, double plainValue) {
+    auto const normalizedValue = toNormalized(id, plainValue);
+    auto const value = std::find_if(values.begin(), values.end(), [&](auto const& v) { return v.first == id; });
+    if (value != values.end()) {
+      value->second = normalizedValue;
+    }
+    else {
+      values.emplace_back(id, normalizedValue);
+    }
+  };
+  if (!settings.preset.empty()) {
+    auto const& presets = detail::Presets::get();
+    auto preset = std::find_if(
+      presets.begin(), presets.end(), [&](Preset const& candidate) { return candidate.name == settings.preset; });
+    uint64_t presetIndex = 0;
+    if (preset == presets.end() && parseIndex(settings.preset, presetIndex) && presetIndex < presets.size()) {
+      preset = presets.begin() + static_cast<std::ptrdiff_t>(presetIndex);
+    }
+    if (preset == presets.end()) {
+      error = "unknown preset \"" + settings.preset + "\"";
+      return false;
+    }
+    for (auto [id, value] : preset->parameterValues) {
+      setValue(static_cast<ParamID>(id), value);
+    }
+  }
+  for (auto const& value : settings.values) {
+    ParamID id;
+    if (!findParameter(value.parameter, id)) {
+      error = "unknown parameter \"" + value.parameter + "\"";
+      return false;
+    }
+    setValue(id, value.value);
+  }
+  for (auto const& automation : settings.lanes) {
+    auto lane = Lane{};
+    if (!findParameter(automation.parameter, lane.id)) {
+      error = "unknown parameter \"" + automation.parameter + "\"";
+      return false;
+    }
+    for (auto const& point : automation.points) {
+      lane.points.emplace_back(point.time * sampleRate, toNormalized(lane.id, point.value));
+    }
+    std::erase_if(values, [&](auto const& value) { return value.first == lane.id; });
+    lanes.push_back(std::move(lane));
+  }
+  return true;
+}
+
+bool OfflineRenderer::setupBuses(Index numFileChannels, Buses& buses)
+{
+  auto const numInputBuses = component->getBusCount(kAudio, kInput);
+  auto const numOutputBuses = component->getBusCount(kAudio, kOutput);
+  if (numOutputBuses < 1) {
+    return false;
+  }
+  auto const getArrangements = [&] {
+    buses.inputs.assign(numInputBuses, SpeakerArr::kEmpty);
+    buses.outputs.assign(numOutputBuses, SpeakerArr::kEmpty);
+    for (int32 bus = 0; bus < numInputBuses; ++bus) {
+      processor->getBusArrangement(kInput, bus, buses.inputs[bus]);
+    }
+    for (int32 bus = 0; bus < numOutputBuses; ++bus) {
+      processor->getBusArrangement(kOutput, bus, buses.outputs[bus]);
+    }
+  };
+  getArrangements();
+  auto const fileArrangement = getArrangement(numFileChannels);
+  if (numInputBuses > 0) {
+    buses.inputs[0] = fileArrangement;
+  }
+  buses.outputs[0] = fileArrangement;
+  bool const isFileArrangementAccepted =
+    processor->setBusArrangements(buses.inputs.data(), numInputBuses, buses.outputs.data(), numOutputBuses) ==
+    kResultTrue;
+  if (!isFileArrangementAccepted) {
+    // the plugin keeps its own arrangement, and the channels of the file are mapped to it, see renderFile
+    getArrangements();
+  }
+  for (int32 bus = 0; bus < numInputBuses; ++bus) {
+    component->activateBus(kAudio, kInput, bus, true);
+  }
+  for (int32 bus = 0; bus < numOutputBuses; ++bus) {
+    component->activateBus(kAudio, kOutput, bus, true);
+  }
+  return true;
+}
+
+void OfflineRenderer::restoreInitialState()
+{
+  initialState->seek(0, IBStream::kIBSeekSet, nullptr);
+  component->setState(initialState);
+  initialState->seek(0, IBStream::kIBSeekSet, nullptr);
+  controller->setComponentState(initialState);
+}
+
+bool OfflineRenderer::render(std::string const& inputPath,
+                             std::string const& outputPath,
+                             ParameterSettings const& settings,
+                             RenderOptions const& options,
+                             RenderStats& stats,
+                             std::string& error)
+{
+  assert(component && options.blockSize > 0);
+  auto const startTime = Clock::now();
+  stats = RenderStats{};
+
+  auto reader = WavReader{};
+  if (!reader.open(inputPath)) {
+    error = "could not read " + inputPath + ": the file is missing or its format is not supported";
+    return false;
+  }
+  auto const& inputInfo = reader.getInfo();
+
+  restoreInitialState();
+  auto buses = Buses{};
+  if (!setupBuses(inputInfo.numChannels, buses)) {
+    error = "the plugin has no audio outputs";
+    return false;
+  }
+  auto values = std::vector<std::pair<ParamID, double>>{};
+  auto lanes = std::vector<Lane>{};
+  if (!resolveParameterSettings(settings, inputInfo.sampleRate, values, lanes, error)) {
+    return false;
+  }
+
+  bool const isDoublePrecision = options.doublePrecision && processor->canProcessSampleSize(kSample64) == kResultTrue;
+  auto setup = ProcessSetup{
+    kOffline, isDoublePrecision ? kSample64 : kSample32, static_cast<int32>(options.blockSize), inputInfo.sampleRate
+  };
+  if (processor->setupProcessing(setup) != kResultOk) {
+    error = "the plugin refused the processing setup";
+    return false;
+  }
+
+  auto outputInfo = inputInfo;
+  outputInfo.numChannels = static_cast<Index>(SpeakerArr::getChannelCount(buses.outputs[0]));
+  outputInfo.format = options.outputFormat.value_or(inputInfo.format);
+  auto writer = WavWriter{};
+  if (!writer.open(outputPath, outputInfo)) {
+    error = "could not create " + outputPath;
+    return false;
+  }
+
+  // the controller gets the values before the activation, so that the latency reported by the processor takes into
+  // account the parameters that change it. The processor gets them with the first block, see renderFile.
+  for (auto [id, value] : values) {
+    controller->setParamNormalized(id, value);
+  }
+  for (auto const& lane : lanes) {
+    controller->setParamNormalized(lane.id, lane.getValue(0.0));
+  }
+
+  component->setActive(true);
+  processor->setProcessing(true);
+  stats.numFrames = inputInfo.numFrames;
+  stats.sampleRate = inputInfo.sampleRate;
+  stats.latency = processor->getLatencySamples();
+  stats.isDoublePrecision = isDoublePrecision;
+  bool const isRendered =
+    isDoublePrecision
+      ? renderFile<double>(reader, writer, buses, values, lanes, options.blockSize, stats, error)
+      : renderFile<float>(reader, writer, buses, values, lanes, options.blockSize, stats, error);
+  processor->setProcessing(false);
+  component->setActive(false);
+
+  bool const isWritten = writer.close();
+  if (isRendered && !isWritten) {
+    error = "could not write " + outputPath;
+  }
+  stats.totalSeconds = getSeconds(Clock::now() - startTime);
+  return isRendered && isWritten;
+}
+
+template<class SampleType>
+bool OfflineRenderer::renderFile(WavReader& reader,
+                                 WavWriter& writer,
+                                 Buses const& buses,
+                                 std::vector<std::pair<ParamID, double>> const& values,
+                                 std::vector<Lane> const& lanes,
+                                 Index blockSize,
+                                 RenderStats& stats,
+                                 std::string& error)
+{
+  // two sets of buffers are used alternately: while the plugin processes a block, the io thread reads the next one and
+  // writes the previous one
+  auto inputs = std::array<BusBuffers<SampleType>, 2>{ BusBuffers<SampleType>(buses.inputs, blockSize),
+                                                      BusBuffers<SampleType>(buses.inputs, blockSize) };
+  auto outputs = std::array<BusBuffers<SampleType>, 2>{ BusBuffers<SampleType>(buses.outputs, blockSize),
+                                                       BusBuffers<SampleType>(buses.outputs, blockSize) };
+
+  // if the plugin did not accept the channels of the file, the file is read here and its channels are copied
+  // cyclically to the ones of the plugin
+  auto const numFileChannels = reader.getInfo().numChannels;
+  bool const isReadDirectly = inputs[0].getNumBuses() == 0 || inputs[0].getChannels(0).size() == numFileChannels;
+  auto fileBuffers = std::vector<std::vector<SampleType>>(isReadDirectly ? 0 : numFileChannels);
+  auto fileChannels = std::vector<SampleType*>();
+  for (auto& buffer : fileBuffers) {
+    buffer.resize(blockSize);
+    fileChannels.push_back(buffer.data());
+  }
+  auto outputChannels = std::vector<SampleType const*>(outputs[0].getChannels(0).size());
+
+  auto const readBlock = [&](BusBuffers<SampleType> const& input, Index numFrames) {
+    if (input.getNumBuses() == 0) {
+      return;
+    }
+    auto const& mainInput = input.getChannels(0);
+    Index numFramesRead = 0;
+    if (isReadDirectly) {
+      numFramesRead = reader.read(mainInput.data(), numFrames);
+    }
+    else {
+      numFramesRead = reader.read(fileChannels.data(), numFrames);
+      for (std::size_t channel = 0; channel < mainInput.size() && numFileChannels > 0; ++channel) {
+        auto const source = fileChannels[channel % numFileChannels];
+        std::copy(source, source + numFramesRead, mainInput[channel]);
+      }
+    }
+    for (auto channel : mainInput) {
+      std::fill(channel + numFramesRead, channel + numFrames, static_cast<SampleType>(0));
+    }
+  };
+
+  bool isWritten = true;
+  auto const writeBlock = [&](BusBuffers<SampleType> const& output, Index numFramesSkipped, Index numFrames) {
+    if (!isWritten || numFramesSkipped == numFrames) {
+      return;
+    }
+    auto const& mainOutput = output.getChannels(0);
+    for (std::size_t channel = 0; channel < mainOutput.size(); ++channel) {
+      outputChannels[channel] = mainOutput[channel] + numFramesSkipped;
+    }
+    isWritten = writer.write(outputChannels.data(), numFrames - numFramesSkipped);
+  };
+
+  auto inputChanges = ParameterChanges(static_cast<int32>(parameters.size()));
+  auto outputChanges = ParameterChanges(static_cast<int32>(parameters.size()));
+  auto const addPoint = [&](ParamID id, int32 sampleOffset, double value) {
+    int32 queueIndex = 0;
+    if (auto queue = inputChanges.addParameterData(id, queueIndex)) {
+      int32 pointIndex = 0;
+      queue->addPoint(sampleOffset, value, pointIndex);
+    }
+  };
+  // the points of a lane are sent only for the blocks in which its value changes
+  auto lastSentValues = std::vector<double>(lanes.size(), -1.0);
+
+  auto context = ProcessContext{};
+  context.state = ProcessContext::kPlaying | ProcessContext::kContTimeValid;
+  context.sampleRate = stats.sampleRate;
+
+  auto data = ProcessData{};
+  data.processMode = kOffline;
+  data.symbolicSampleSize = std::is_same_v<SampleType, double> ? kSample64 : kSample32;
+  data.numInputs = inputs[0].getNumBuses();
+  data.numOutputs = outputs[0].getNumBuses();
+  data.inputParameterChanges = &inputChanges;
+  data.outputParameterChanges = &outputChanges;
+  data.processContext = &context;
+
+  // the output is delayed by the latency, so the first samples are discarded and the end of the input is followed by
+  // enough silence to flush the last ones
+  auto const numFramesToRender = stats.numFrames + stats.latency;
+  auto const getNumFrames = [&](uint64_t position) {
+    return static_cast<Index>(std::min<uint64_t>(blockSize, numFramesToRender - position));
+  };
+  uint64_t numFramesToSkip = stats.latency;
+
+  auto pendingRead = std::future<void>{};
+  auto pendingWrite = std::future<void>{};
+  if (numFramesToRender > 0) {
+    pendingRead = ioThread.post([&] { readBlock(inputs[0], getNumFrames(0)); });
+  }
+  bool isProcessed = true;
+  std::size_t slot = 0;
+  for (uint64_t position = 0; position < numFramesToRender; slot ^= 1) {
+    auto const numFrames = getNumFrames(position);
+    auto const nextPosition = position + numFrames;
+
+    // the io thread runs the tasks in order, so when this block has been read, the block that used the same output
+    // buffers two iterations ago has been written
+    pendingRead.get();
+    if (nextPosition < numFramesToRender) {
+      pendingRead = ioThread.post(
+        [&, nextSlot = slot ^ 1, nextPosition] { readBlock(inputs[nextSlot], getNumFrames(nextPosition)); });
+    }
+
+    inputChanges.clearQueue();
+    outputChanges.clearQueue();
+    if (position == 0) {
+      for (auto [id, value] : values) {
+        addPoint(id, 0, value);
+      }
+    }
+    auto const lastPosition = static_cast<double>(position + numFrames - 1);
+    for (std::size_t laneIndex = 0; laneIndex < lanes.size(); ++laneIndex) {
+      auto const& lane = lanes[laneIndex];
+      auto const firstValue = lane.getValue(static_cast<double>(position));
+      auto const lastValue = lane.getValue(lastPosition);
+      auto const innerBegin = std::upper_bound(lane.points.begin(),
+                                               lane.points.end(),
+                                               static_cast<double>(position),
+                                               [](double samplePosition, auto const& point) {
+                                                 return samplePosition < point.first;
+                                               });
+      auto const innerEnd = std::lower_bound(
+        innerBegin, lane.points.end(), lastPosition, [](auto const& point, double samplePosition) {
+          return point.first < samplePosition;
+        });
+      bool const isConstant =
+        innerBegin == innerEnd && firstValue == lastValue && firstValue == lastSentValues[laneIndex];
+      if (isConstant) {
+        continue;
+      }
+      addPoint(lane.id, 0, firstValue);
+      for (auto point = innerBegin; point != innerEnd; ++point) {
+        auto const sampleOffset = static_cast<int32>(std::lround(point->first - static_cast<double>(position)));
+        if (sampleOffset > 0 && sampleOffset < static_cast<int32>(numFrames) - 1) {
+          addPoint(lane.id, sampleOffset, point->second);
+        }
+      }
+      addPoint(lane.id, static_cast<int32>(numFrames) - 1, lastValue);
+      lastSentValues[laneIndex] = lastValue;
+    }
+
+    context.projectTimeSamples = static_cast<TSamples>(position);
+    context.continousTimeSamples = static_cast<TSamples>(position);
+    data.numSamples = static_cast<int32>(numFrames);
+    data.inputs = inputs[slot].getAudioBuses();
+    data.outputs = outputs[slot].getAudioBuses();
+    auto const processingStartTime = Clock::now();
+    auto const result = processor->process(data);
+    stats.processingSeconds += getSeconds(Clock::now() - processingStartTime);
+    if (result != kResultOk) {
+      error = "the plugin failed to process";
+      isProcessed = false;
+      break;
+    }
+
+    if (pendingWrite.valid()) {
+      pendingWrite.get();
+    }
+    if (!isWritten) {
+      break;
+    }
+    auto const numFramesSkipped = static_cast<Index>(std::min<uint64_t>(numFramesToSkip, numFrames));
+    numFramesToSkip -= numFramesSkipped;
+    pendingWrite =
+      ioThread.post([&, slot, numFramesSkipped, numFrames] { writeBlock(outputs[slot], numFramesSkipped, numFrames); });
+    position = nextPosition;
+  }
+  // the pending tasks use the local variables
+  for (auto pending : { &pendingRead, &pendingWrite }) {
+    if (pending->valid()) {
+      pending->get();
+    }
+  }
+  if (isProcessed && !isWritten) {
+    error = "could not write the output file";
+  }
+  return isProcessed && isWritten;
+}
+
+} // namespace unplug::renderer
@@ -0,0 +1,133 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/renderer/ParameterSettings.hpp"
+#include "unplug/renderer/Json.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace unplug::renderer {
+
+namespace {
+
+bool parsePreset(JsonValue const& json, ParameterSettings& settings, std::string& error)
+{
+  if (json.type == JsonValue::Type::string) {
+    settings.preset = json.string;
+    return true;
+  }
+  if (json.type == JsonValue::Type::number && json.number >= 0.0 && json.number == std::floor(json.number)) {
+    settings.preset = std::to_string(static_cast<long long>(json.number));
+    return true;
+  }
+  error = "\"preset\" must be a name or an index";
+  return false;
+}
+
+bool parseValues(JsonValue const& json, ParameterSettings& settings, std::string& error)
+{
+  if (json.type != JsonValue::Type::object) {
+    error = "\"parameters\" must be an object";
+    return false;
+  }
+  for (auto const& [parameter, value] : json.object) {
+    if (value.type != JsonValue::Type::number) {
+      error = "the value of the parameter \"" + parameter + "\" must be a number";
+      return false;
+    }
+    settings.values.push_back({ parameter, value.number });
+  }
+  return true;
+}
+
+bool parseLanes(JsonValue const& json, ParameterSettings& settings, std::string& error)
+{
+  if (json.type != JsonValue::Type::object) {
+    error = "\"automation\" must be an object";
+    return false;
+  }
+  for (auto const& [parameter, points] : json.object) {
+    auto const isPoint = [](JsonValue const& point) {
+      return point.type == JsonValue::Type::array && point.array.size() == 2 &&
+             point.array[0].type == JsonValue::Type::number && point.array[1].type == JsonValue::Type::number;
+    };
+    if (points.type != JsonValue::Type::array || points.array.empty() ||
+        !std::all_of(points.array.begin(), points.array.end(), isPoint)) {
+      error = "the automation of the parameter \"" + parameter + "\" must be a non empty array of [time, value] pairs";
+      return false;
+    }
+    auto& lane = settings.lanes.emplace_back();
+    lane.parameter = parameter;
+    lane.points.reserve(points.array.size());
+    for (auto const& point : points.array) {
+      lane.points.push_back({ point.array[0].number, point.array[1].number });
+    }
+    std::stable_sort(lane.points.begin(), lane.points.end(), [](auto const& a, auto const& b) {
+      return a.time < b.time;
+    });
+  }
+  return true;
+}
+
+} // namespace
+
+bool loadParameterSettings(std::string const& path, ParameterSettings& settings, std::string& error)
+{
+  auto file = std::ifstream(path, std::ios::binary);
+  if (!file) {
+    error = "could not open " + path;
+    return false;
+  }
+  auto text = std::stringstream();
+  text << file.rdbuf();
+  auto json = JsonValue{};
+  if (!parseJson(text.str(), json, error)) {
+    error = path + ": " + error;
+    return false;
+  }
+  if (json.type != JsonValue::Type::object) {
+    error = path + ": the document must be an object";
+    return false;
+  }
+  settings = ParameterSettings{};
+  auto const preset = json.find("preset");
+  auto const values = json.find("parameters");
+  auto const lanes = json.find("automation");
+  bool const isOk = (!preset || parsePreset(*preset, settings, error)) &&
+                    (!values || parseValues(*values, settings, error)) && (!lanes || parseLanes(*lanes, settings, error));
+  if (!isOk) {
+    error = path + ": " + error;
+  }
+  return isOk;
+}
+
+double interpolateLinearly(std::vector<std::pair<double, double>> const& points, double position)
+{
+  auto const next = std::upper_bound(points.begin(), points.end(), position, [](double position_, auto const& point) {
+    return position_ < point.first;
+  });
+  if (next == points.begin()) {
+    return points.front().second;
+  }
+  if (next == points.end()) {
+    return points.back().second;
+  }
+  auto const previous = next - 1;
+  auto const interpolation = (position - previous->first) / (next->first - previous->first);
+  return previous->second + interpolation * (next->second - previous->second);
+}
+
+} // namespace unplug::renderer
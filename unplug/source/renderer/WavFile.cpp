@@ -0,0 +1,385 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/renderer/WavFile.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace unplug::renderer {
+
+namespace {
+
+constexpr uint16_t formatTagPcm = 1;
+constexpr uint16_t formatTagFloat = 3;
+constexpr uint16_t formatTagExtensible = 0xFFFE;
+
+// the last 14 bytes of the KSDATAFORMAT_SUBTYPE_PCM and KSDATAFORMAT_SUBTYPE_IEEE_FLOAT guids, the first two bytes
+// are the format tag
+constexpr std::array<unsigned char, 14> subFormatGuidTail = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80,
+                                                             0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+
+uint32_t readLittleEndian(char const* bytes, int numBytes)
+{
+  uint32_t value = 0;
+  for (int i = 0; i < numBytes; ++i) {
+    value |= static_cast<uint32_t>(static_cast<unsigned char>(bytes[i])) << (8 * i);
+  }
+  return value;
+}
+
+void writeLittleEndian(char* bytes, uint32_t value, int numBytes)
+{
+  for (int i = 0; i < numBytes; ++i) {
+    bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+bool readBytes(std::ifstream& file, char* bytes, std::size_t numBytes)
+{
+  file.read(bytes, static_cast<std::streamsize>(numBytes));
+  return file.gcount() == static_cast<std::streamsize>(numBytes);
+}
+
+void writeUInt(std::ofstream& file, uint32_t value, int numBytes)
+{
+  char bytes[4];
+  writeLittleEndian(bytes, value, numBytes);
+  file.write(bytes, numBytes);
+}
+
+bool getSampleFormat(uint16_t formatTag, uint16_t bitsPerSample, SampleFormat& format)
+{
+  if (formatTag == formatTagPcm) {
+    switch (bitsPerSample) {
+      case 16:
+        format = SampleFormat::pcm16;
+        return true;
+      case 24:
+        format = SampleFormat::pcm24;
+        return true;
+      case 32:
+        format = SampleFormat::pcm32;
+        return true;
+      default:
+        return false;
+    }
+  }
+  if (formatTag == formatTagFloat) {
+    switch (bitsPerSample) {
+      case 32:
+        format = SampleFormat::float32;
+        return true;
+      case 64:
+        format = SampleFormat::float64;
+        return true;
+      default:
+        return false;
+    }
+  }
+  return false;
+}
+
+template<class SampleType>
+void decode(char const* raw, SampleFormat format, Index numChannels, Index numFrames, SampleType* const* channels)
+{
+  auto const sampleSize = getSampleSize(format);
+  auto const decodeWith = [&](auto decodeSample) {
+    for (Index frame = 0; frame < numFrames; ++frame) {
+      for (Index channel = 0; channel < numChannels; ++channel) {
+        channels[channel][frame] = static_cast<SampleType>(decodeSample(raw));
+        raw += sampleSize;
+      }
+    }
+  };
+  switch (format) {
+    case SampleFormat::pcm16:
+      decodeWith([](char const* bytes) {
+        return static_cast<int16_t>(readLittleEndian(bytes, 2)) * (1.0 / 32768.0);
+      });
+      break;
+    case SampleFormat::pcm24:
+      decodeWith([](char const* bytes) {
+        // the sample is shifted to the most significant bytes so that the sign is extended by the conversion
+        return static_cast<int32_t>(readLittleEndian(bytes, 3) << 8) * (1.0 / 2147483648.0);
+      });
+      break;
+    case SampleFormat::pcm32:
+      decodeWith([](char const* bytes) {
+        return static_cast<int32_t>(readLittleEndian(bytes, 4)) * (1.0 / 2147483648.0);
+      });
+      break;
+    case SampleFormat::float32:
+      decodeWith([](char const* bytes) {
+        float sample;
+        std::memcpy(&sample, bytes, sizeof(sample));
+        return sample;
+      });
+      break;
+    case SampleFormat::float64:
+      decodeWith([](char const* bytes) {
+        double sample;
+        std::memcpy(&sample, bytes, sizeof(sample));
+        return sample;
+      });
+      break;
+  }
+}
+
+template<class SampleType>
+void encode(SampleType const* const* channels, SampleFormat format, Index numChannels, Index numFrames, char* raw)
+{
+  auto const sampleSize = getSampleSize(format);
+  auto const encodeWith = [&](auto encodeSample) {
+    for (Index frame = 0; frame < numFrames; ++frame) {
+      for (Index channel = 0; channel < numChannels; ++channel) {
+        encodeSample(static_cast<double>(channels[channel][frame]), raw);
+        raw += sampleSize;
+      }
+    }
+  };
+  auto const encodeInteger = [&](double scale, int numBytes) {
+    encodeWith([=](double sample, char* bytes) {
+      auto const scaled = std::round(sample * scale);
+      auto const clipped = std::clamp(scaled, -scale, scale - 1.0);
+      writeLittleEndian(bytes, static_cast<uint32_t>(static_cast<int32_t>(clipped)), numBytes);
+    });
+  };
+  switch (format) {
+    case SampleFormat::pcm16:
+      encodeInteger(32768.0, 2);
+      break;
+    case SampleFormat::pcm24:
+      encodeInteger(8388608.0, 3);
+      break;
+    case SampleFormat::pcm32:
+      encodeInteger(2147483648.0, 4);
+      break;
+    case SampleFormat::float32:
+      encodeWith([](double sample, char* bytes) {
+        auto const value = static_cast<float>(sample);
+        std::memcpy(bytes, &value, sizeof(value));
+      });
+      break;
+    case SampleFormat::float64:
+      encodeWith([](double sample, char* bytes) { std::memcpy(bytes, &sample, sizeof(sample)); });
+      break;
+  }
+}
+
+} // namespace
+
+Index getSampleSize(SampleFormat format)
+{
+  switch (format) {
+    case SampleFormat::pcm16:
+      return 2;
+    case SampleFormat::pcm24:
+      return 3;
+    case SampleFormat::pcm32:
+    case SampleFormat::float32:
+      return 4;
+    case SampleFormat::float64:
+      return 8;
+  }
+  assert(false);
+  return 0;
+}
+
+bool getSampleFormatFromName(std::string const& name, SampleFormat& format)
+{
+  constexpr std::array<std::pair<char const*, SampleFormat>, 5> formats = {
+    { { "pcm16", SampleFormat::pcm16 },
+      { "pcm24", SampleFormat::pcm24 },
+      { "pcm32", SampleFormat::pcm32 },
+      { "float32", SampleFormat::float32 },
+      { "float64", SampleFormat::float64 } }
+  };
+  for (auto [formatName, value] : formats) {
+    if (name == formatName) {
+      format = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool WavReader::open(std::string const& path)
+{
+  file.open(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  char header[12];
+  if (!readBytes(file, header, sizeof(header)) || std::memcmp(header, "RIFF", 4) != 0 ||
+      std::memcmp(header + 8, "WAVE", 4) != 0) {
+    return false;
+  }
+  bool hasFormat = false;
+  uint16_t blockAlign = 0;
+  std::streamoff dataPosition = -1;
+  uint32_t dataSize = 0;
+  char chunkHeader[8];
+  while (readBytes(file, chunkHeader, sizeof(chunkHeader))) {
+    auto const chunkSize = readLittleEndian(chunkHeader + 4, 4);
+    auto const nextChunkPosition =
+      static_cast<std::streamoff>(file.tellg()) + static_cast<std::streamoff>(chunkSize + (chunkSize & 1));
+    if (std::memcmp(chunkHeader, "fmt ", 4) == 0) {
+      char format[40]{};
+      auto const formatSize = std::min<uint32_t>(chunkSize, sizeof(format));
+      if (formatSize < 16 || !readBytes(file, format, formatSize)) {
+        return false;
+      }
+      auto formatTag = static_cast<uint16_t>(readLittleEndian(format, 2));
+      info.numChannels = readLittleEndian(format + 2, 2);
+      info.sampleRate = static_cast<double>(readLittleEndian(format + 4, 4));
+      blockAlign = static_cast<uint16_t>(readLittleEndian(format + 12, 2));
+      auto const bitsPerSample = static_cast<uint16_t>(readLittleEndian(format + 14, 2));
+      if (formatTag == formatTagExtensible) {
+        if (formatSize < 40 || std::memcmp(format + 26, subFormatGuidTail.data(), subFormatGuidTail.size()) != 0) {
+          return false;
+        }
+        formatTag = static_cast<uint16_t>(readLittleEndian(format + 24, 2));
+      }
+      if (!getSampleFormat(formatTag, bitsPerSample, info.format)) {
+        return false;
+      }
+      hasFormat = true;
+    }
+    else if (std::memcmp(chunkHeader, "data", 4) == 0) {
+      dataPosition = file.tellg();
+      dataSize = chunkSize;
+      if (hasFormat) {
+        break;
+      }
+    }
+    file.seekg(nextChunkPosition);
+  }
+  if (!hasFormat || dataPosition < 0 || info.numChannels == 0 ||
+      blockAlign != info.numChannels * getSampleSize(info.format)) {
+    return false;
+  }
+  file.clear();
+  file.seekg(dataPosition);
+  info.numFrames = dataSize / blockAlign;
+  numFramesLeft = info.numFrames;
+  return static_cast<bool>(file);
+}
+
+template<class SampleType>
+Index WavReader::read(SampleType* const* channels, Index numFrames)
+{
+  auto const numFramesToRead = static_cast<Index>(std::min<uint64_t>(numFrames, numFramesLeft));
+  auto const frameSize = info.numChannels * getSampleSize(info.format);
+  rawData.resize(static_cast<std::size_t>(numFramesToRead) * frameSize);
+  file.read(rawData.data(), static_cast<std::streamsize>(rawData.size()));
+  auto const numFramesRead = static_cast<Index>(file.gcount() / frameSize);
+  decode(rawData.data(), info.format, info.numChannels, numFramesRead, channels);
+  numFramesLeft = numFramesRead == numFramesToRead ? numFramesLeft - numFramesRead : 0;
+  return numFramesRead;
+}
+
+template Index WavReader::read(float* const* channels, Index numFrames);
+template Index WavReader::read(double* const* channels, Index numFrames);
+
+WavWriter::~WavWriter()
+{
+  close();
+}
+
+bool WavWriter::open(std::string const& path, WavInfo const& info_)
+{
+  assert(!file.is_open());
+  info = info_;
+  numFramesWritten = 0;
+  file.open(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    return false;
+  }
+  bool const isFloat = info.format == SampleFormat::float32 || info.format == SampleFormat::float64;
+  auto const formatTag = isFloat ? formatTagFloat : formatTagPcm;
+  // the extensible format is required for more than two channels
+  bool const isExtensible = info.numChannels > 2;
+  auto const sampleSize = getSampleSize(info.format);
+  auto const blockAlign = info.numChannels * sampleSize;
+  auto const sampleRate = static_cast<uint32_t>(std::lround(info.sampleRate));
+  file.write("RIFF", 4);
+  riffSizePosition = file.tellp();
+  writeUInt(file, 0, 4);
+  file.write("WAVEfmt ", 8);
+  writeUInt(file, isExtensible ? 40 : (isFloat ? 18 : 16), 4);
+  writeUInt(file, isExtensible ? formatTagExtensible : formatTag, 2);
+  writeUInt(file, info.numChannels, 2);
+  writeUInt(file, sampleRate, 4);
+  writeUInt(file, sampleRate * blockAlign, 4);
+  writeUInt(file, blockAlign, 2);
+  writeUInt(file, sampleSize * 8, 2);
+  if (isExtensible) {
+    writeUInt(file, 22, 2);
+    writeUInt(file, sampleSize * 8, 2);
+    writeUInt(file, 0, 4); // channel mask: no speaker assignment
+    writeUInt(file, formatTag, 2);
+    file.write(reinterpret_cast<char const*>(subFormatGuidTail.data()), subFormatGuidTail.size());
+  }
+  else if (isFloat) {
+    writeUInt(file, 0, 2);
+  }
+  file.write("data", 4);
+  dataSizePosition = file.tellp();
+  writeUInt(file, 0, 4);
+  return static_cast<bool>(file);
+}
+
+template<class SampleType>
+bool WavWriter::write(SampleType const* const* channels, Index numFrames)
+{
+  assert(file.is_open());
+  auto const frameSize = info.numChannels * getSampleSize(info.format);
+  auto const maxDataSize = static_cast<uint64_t>(std::numeric_limits<uint32_t>::max()) - dataSizePosition - 4;
+  if ((numFramesWritten + numFrames) * frameSize > maxDataSize) {
+    return false;
+  }
+  rawData.resize(static_cast<std::size_t>(numFrames) * frameSize);
+  encode(channels, info.format, info.numChannels, numFrames, rawData.data());
+  file.write(rawData.data(), static_cast<std::streamsize>(rawData.size()));
+  numFramesWritten += numFrames;
+  return static_cast<bool>(file);
+}
+
+template bool WavWriter::write(float const* const* channels, Index numFrames);
+template bool WavWriter::write(double const* const* channels, Index numFrames);
+
+bool WavWriter::close()
+{
+  if (!file.is_open()) {
+    return true;
+  }
+  auto const dataSize = numFramesWritten * info.numChannels * getSampleSize(info.format);
+  if (dataSize & 1) {
+    file.put(0);
+  }
+  auto const fileSize = static_cast<uint64_t>(file.tellp());
+  file.seekp(riffSizePosition);
+  writeUInt(file, static_cast<uint32_t>(fileSize - 8), 4);
+  file.seekp(dataSizePosition);
+  writeUInt(file, static_cast<uint32_t>(dataSize), 4);
+  bool const isOk = static_cast<bool>(file);
+  file.close();
+  return isOk;
+}
+
+} // namespace unplug::renderer
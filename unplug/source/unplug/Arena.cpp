@@ -0,0 +1,216 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/Arena.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace unplug {
+
+namespace {
+
+std::size_t getPageSize()
+{
+#if defined(_WIN32)
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  return static_cast<std::size_t>(systemInfo.dwPageSize);
+#else
+  return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+std::byte* mapMemory(std::size_t size)
+{
+#if defined(_WIN32)
+  return static_cast<std::byte*>(VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#else
+  auto const memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return memory == MAP_FAILED ? nullptr : static_cast<std::byte*>(memory);
+#endif
+}
+
+void unmapMemory(std::byte* memory, std::size_t size)
+{
+#if defined(_WIN32)
+  VirtualFree(memory, 0, MEM_RELEASE);
+#else
+  munmap(memory, size);
+#endif
+}
+
+bool lockMemoryPages(std::byte* memory, std::size_t size)
+{
+#if defined(_WIN32)
+  return VirtualLock(memory, size) != 0;
+#else
+  return mlock(memory, size) == 0;
+#endif
+}
+
+void unlockMemoryPages(std::byte* memory, std::size_t size)
+{
+#if defined(_WIN32)
+  VirtualUnlock(memory, size);
+#else
+  munlock(memory, size);
+#endif
+}
+
+std::byte* alignPointer(std::byte* pointer, std::size_t alignment)
+{
+  auto const address = reinterpret_cast<std::uintptr_t>(pointer);
+  auto const aligned = (address + alignment - 1) / alignment * alignment;
+  return pointer + (aligned - address);
+}
+
+} // namespace
+
+Arena::Arena(std::size_t chunkSize, bool lockMemory)
+  : chunkSize{ chunkSize }
+  , lockMemory{ lockMemory }
+{}
+
+Arena::~Arena()
+{
+  assert(footprint.usedBytes == 0 && footprint.heapFallbackBytes == 0 &&
+         "The containers using an arena must be destroyed before it.");
+  for (auto& chunk : chunks) {
+    if (chunk.isLocked) {
+      unlockMemoryPages(chunk.memory, chunk.size);
+    }
+    unmapMemory(chunk.memory, chunk.size);
+  }
+}
+
+void Arena::reserve(std::size_t bytes)
+{
+  auto const lock = std::lock_guard{ mutex };
+  for (auto const& [begin, size] : freeRanges) {
+    if (size >= bytes) {
+      return;
+    }
+  }
+  addChunk(bytes);
+}
+
+void* Arena::allocate(std::size_t bytes, std::size_t alignment)
+{
+  bytes = std::max(bytes, std::size_t{ 1 });
+  auto const lock = std::lock_guard{ mutex };
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    for (auto range = freeRanges.begin(); range != freeRanges.end(); ++range) {
+      auto const [begin, size] = *range;
+      auto const aligned = alignPointer(begin, alignment);
+      auto const padding = static_cast<std::size_t>(aligned - begin);
+      if (padding + bytes > size) {
+        continue;
+      }
+      freeRanges.erase(range);
+      if (padding > 0) {
+        freeRanges.emplace(begin, padding);
+      }
+      if (padding + bytes < size) {
+        freeRanges.emplace(aligned + bytes, size - padding - bytes);
+      }
+      footprint.usedBytes += bytes;
+      footprint.peakUsedBytes = std::max(footprint.peakUsedBytes, footprint.usedBytes);
+      return aligned;
+    }
+    if (!addChunk(bytes + alignment)) {
+      break;
+    }
+  }
+  footprint.heapFallbackBytes += bytes;
+  return ::operator new(bytes, std::align_val_t{ alignment });
+}
+
+void Arena::deallocate(void* pointer, std::size_t bytes, std::size_t alignment)
+{
+  if (!pointer) {
+    return;
+  }
+  bytes = std::max(bytes, std::size_t{ 1 });
+  auto const lock = std::lock_guard{ mutex };
+  if (!owns(pointer)) {
+    footprint.heapFallbackBytes -= bytes;
+    ::operator delete(pointer, std::align_val_t{ alignment });
+    return;
+  }
+  footprint.usedBytes -= bytes;
+  addFreeRange(static_cast<std::byte*>(pointer), bytes);
+}
+
+ArenaFootprint Arena::getFootprint() const
+{
+  auto const lock = std::lock_guard{ mutex };
+  return footprint;
+}
+
+bool Arena::addChunk(std::size_t minSize)
+{
+  auto const pageSize = getPageSize();
+  auto const size = (std::max(chunkSize, minSize) + pageSize - 1) / pageSize * pageSize;
+  auto const memory = mapMemory(size);
+  if (!memory) {
+    return false;
+  }
+  // write to each page, so that the operating system maps it now rather than on its first use on the audio thread
+  for (std::size_t offset = 0; offset < size; offset += pageSize) {
+    static_cast<std::byte volatile*>(memory)[offset] = std::byte{ 0 };
+  }
+  bool const isLocked = lockMemory && lockMemoryPages(memory, size);
+  chunks.push_back({ memory, size, isLocked });
+  footprint.reservedBytes += size;
+  footprint.lockedBytes += isLocked ? size : 0;
+  footprint.numChunks = static_cast<Index>(chunks.size());
+  addFreeRange(memory, size);
+  return true;
+}
+
+void Arena::addFreeRange(std::byte* begin, std::size_t size)
+{
+  auto next = freeRanges.lower_bound(begin);
+  if (next != freeRanges.end() && begin + size == next->first) {
+    size += next->second;
+    next = freeRanges.erase(next);
+  }
+  if (next != freeRanges.begin()) {
+    auto const previous = std::prev(next);
+    if (previous->first + previous->second == begin) {
+      previous->second += size;
+      return;
+    }
+  }
+  freeRanges.emplace_hint(next, begin, size);
+}
+
+bool Arena::owns(void* pointer) const
+{
+  auto const bytePointer = static_cast<std::byte*>(pointer);
+  return std::any_of(chunks.begin(), chunks.end(), [&](Chunk const& chunk) {
+    return bytePointer >= chunk.memory && bytePointer < chunk.memory + chunk.size;
+  });
+}
+
+} // namespace unplug
@@ -0,0 +1,262 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/Convolution.hpp"
+#include "unplug/detail/UniformConvolver.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <limits>
+#include <memory>
+
+namespace unplug {
+
+namespace {
+
+constexpr auto workerPollPeriod = std::chrono::milliseconds(1);
+
+bool isPowerOfTwo(Index value)
+{
+  return value > 0 && (value & (value - 1)) == 0;
+}
+
+} // namespace
+
+struct Convolution::Engine final
+{
+  struct Channel final
+  {
+    /**
+     * A tail block in the queue of a channel: its input is written by the audio thread before it is posted, its
+     * output by the worker before it is marked as done.
+     * */
+    struct Slot final
+    {
+      std::vector<float> input;
+      std::vector<float> output;
+      int64_t deadline = 0;
+    };
+
+    // the worker can fall this many blocks behind before input blocks are not posted
+    static constexpr int64_t numSlots = 4;
+
+    Channel(std::vector<float> const& impulseResponse, Index headBlockSize, Index tailBlockSize)
+      : head(headBlockSize,
+             impulseResponse.data(),
+             std::min(static_cast<Index>(impulseResponse.size()), 2 * tailBlockSize))
+    {
+      auto const headSize = 2 * tailBlockSize;
+      if (static_cast<Index>(impulseResponse.size()) > headSize) {
+        tail = std::make_unique<detail::UniformConvolver>(
+          tailBlockSize, impulseResponse.data() + headSize, impulseResponse.size() - headSize);
+        tailInput.resize(tailBlockSize, 0.f);
+        for (auto& slot : slots) {
+          slot.input.resize(tailBlockSize, 0.f);
+          slot.output.resize(tailBlockSize, 0.f);
+        }
+      }
+    }
+
+    detail::UniformConvolver head;
+    std::unique_ptr<detail::UniformConvolver> tail;
+    std::array<Slot, numSlots> slots;
+    // the tail blocks are convolved in the order they are posted, so the done ones are the first numDoneBlocks
+    std::atomic<int64_t> numPostedBlocks{ 0 };
+    std::atomic<int64_t> numDoneBlocks{ 0 };
+    // only used by the audio thread
+    std::vector<float> tailInput;
+    float const* tailOutput = nullptr;
+    bool isLastBlockPosted = false;
+  };
+
+  Index tailBlockSize;
+  std::vector<std::unique_ptr<Channel>> channels;
+  // the tail output of the channels whose block was not ready in time
+  std::vector<float> silence;
+  Index tailPosition = 0;
+  int64_t position = 0;
+  Engine* nextRetired = nullptr;
+};
+
+Convolution::Convolution()
+  : worker{ [this] { runWorker(); } }
+{}
+
+Convolution::~Convolution()
+{
+  isStopping.store(true, std::memory_order_release);
+  worker.join();
+  deleteRetiredEngines();
+  delete pending.load();
+  delete active;
+}
+
+bool Convolution::setImpulseResponse(std::vector<std::vector<float>> const& impulseResponse,
+                                     Index numChannels,
+                                     Index headBlockSize,
+                                     Index tailBlockSize)
+{
+  if (impulseResponse.empty() || numChannels < 1 || !isPowerOfTwo(headBlockSize) ||
+      !isPowerOfTwo(tailBlockSize) || headBlockSize > tailBlockSize) {
+    return false;
+  }
+  auto engine = std::make_unique<Engine>();
+  engine->tailBlockSize = tailBlockSize;
+  engine->silence.resize(tailBlockSize, 0.f);
+  for (Index channel = 0; channel < numChannels; ++channel) {
+    engine->channels.push_back(std::make_unique<Engine::Channel>(
+      impulseResponse[channel % impulseResponse.size()], headBlockSize, tailBlockSize));
+    engine->channels.back()->tailOutput = engine->silence.data();
+  }
+  // an engine that the audio thread has not picked up yet is just replaced
+  delete pending.exchange(engine.release(), std::memory_order_acq_rel);
+  return true;
+}
+
+void Convolution::process(float const* const* input, float* const* output, Index numChannels, Index numSamples)
+{
+  if (auto const engine = pending.exchange(nullptr, std::memory_order_acq_rel)) {
+    activeForWorker.store(engine, std::memory_order_release);
+    if (active) {
+      // the worker deletes the replaced engine once it is done with it
+      active->nextRetired = retired.load(std::memory_order_relaxed);
+      while (!retired.compare_exchange_weak(active->nextRetired, active, std::memory_order_release)) {
+      }
+    }
+    active = engine;
+  }
+
+  auto const numConvolved = active ? std::min(numChannels, static_cast<Index>(active->channels.size())) : 0;
+  for (Index channel = numConvolved; channel < numChannels; ++channel) {
+    std::fill(output[channel], output[channel] + numSamples, 0.f);
+  }
+  if (numConvolved == 0) {
+    return;
+  }
+
+  auto& engine = *active;
+  Index processed = 0;
+  while (processed < numSamples) {
+    auto const numToProcess = std::min(numSamples - processed, engine.tailBlockSize - engine.tailPosition);
+    for (Index c = 0; c < numConvolved; ++c) {
+      auto& channel = *engine.channels[c];
+      auto const in = input[c] + processed;
+      auto const out = output[c] + processed;
+      if (channel.tail) {
+        std::copy(in, in + numToProcess, channel.tailInput.begin() + engine.tailPosition);
+      }
+      channel.head.process(in, out, numToProcess);
+      if (channel.tail) {
+        auto const tailOutput = channel.tailOutput + engine.tailPosition;
+        for (Index i = 0; i < numToProcess; ++i) {
+          out[i] += tailOutput[i];
+        }
+      }
+    }
+    engine.tailPosition += numToProcess;
+    engine.position += numToProcess;
+    processed += numToProcess;
+
+    if (engine.tailPosition == engine.tailBlockSize) {
+      engine.tailPosition = 0;
+      // only the channels being processed have a new input block
+      for (Index c = 0; c < numConvolved; ++c) {
+        if (engine.channels[c]->tail) {
+          exchangeTailBlock(engine, c);
+        }
+      }
+    }
+  }
+}
+
+void Convolution::exchangeTailBlock(Engine& engine, Index channelIndex)
+{
+  auto& channel = *engine.channels[channelIndex];
+  auto const numPostedBlocks = channel.numPostedBlocks.load(std::memory_order_relaxed);
+  auto const numDoneBlocks = channel.numDoneBlocks.load(std::memory_order_acquire);
+  // the block posted one block ago is needed now, if it was posted
+  if (channel.isLastBlockPosted && numDoneBlocks == numPostedBlocks) {
+    channel.tailOutput = channel.slots[(numPostedBlocks - 1) % Engine::Channel::numSlots].output.data();
+  }
+  else {
+    channel.tailOutput = engine.silence.data();
+    if (numPostedBlocks > 0) {
+      numMissedDeadlines.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  // a full queue means the worker is far behind, the block is dropped and its output will be silent
+  channel.isLastBlockPosted = numPostedBlocks - numDoneBlocks < Engine::Channel::numSlots;
+  if (!channel.isLastBlockPosted) {
+    return;
+  }
+  auto& slot = channel.slots[numPostedBlocks % Engine::Channel::numSlots];
+  std::copy(channel.tailInput.begin(), channel.tailInput.end(), slot.input.begin());
+  slot.deadline = engine.position + engine.tailBlockSize;
+  channel.numPostedBlocks.store(numPostedBlocks + 1, std::memory_order_release);
+}
+
+void Convolution::runWorker()
+{
+  // polling keeps the audio thread free of system calls to wake the worker
+  while (!isStopping.load(std::memory_order_acquire)) {
+    deleteRetiredEngines();
+    if (auto const engine = activeForWorker.load(std::memory_order_acquire)) {
+      runTailBlocks(*engine);
+    }
+    std::this_thread::sleep_for(workerPollPeriod);
+  }
+}
+
+void Convolution::runTailBlocks(Engine& engine)
+{
+  while (true) {
+    // earliest deadline first
+    Engine::Channel* earliest = nullptr;
+    auto earliestDeadline = std::numeric_limits<int64_t>::max();
+    for (auto& channel : engine.channels) {
+      auto const numDoneBlocks = channel->numDoneBlocks.load(std::memory_order_relaxed);
+      if (numDoneBlocks == channel->numPostedBlocks.load(std::memory_order_acquire)) {
+        continue;
+      }
+      auto const deadline = channel->slots[numDoneBlocks % Engine::Channel::numSlots].deadline;
+      if (deadline < earliestDeadline) {
+        earliest = channel.get();
+        earliestDeadline = deadline;
+      }
+    }
+    if (!earliest) {
+      return;
+    }
+    auto const numDoneBlocks = earliest->numDoneBlocks.load(std::memory_order_relaxed);
+    auto& slot = earliest->slots[numDoneBlocks % Engine::Channel::numSlots];
+    auto const start = std::chrono::steady_clock::now();
+    earliest->tail->process(slot.input.data(), slot.output.data(), engine.tailBlockSize);
+    earliest->numDoneBlocks.store(numDoneBlocks + 1, std::memory_order_release);
+    auto const elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    numWorkerNanoseconds.fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+  }
+}
+
+void Convolution::deleteRetiredEngines()
+{
+  // the worker only uses the engine that it loads from activeForWorker in the same run, so the retired ones are free
+  auto engine = retired.exchange(nullptr, std::memory_order_acquire);
+  while (engine) {
+    auto const next = engine->nextRetired;
+    delete engine;
+    engine = next;
+  }
+}
+
+} // namespace unplug
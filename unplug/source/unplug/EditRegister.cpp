@@ -12,30 +12,45 @@
 //------------------------------------------------------------------------
 
 #include "unplug/detail/EditRegister.hpp"
+#include <algorithm>
+#include <cassert>
 
 namespace unplug::detail {
 
-std::string ParameterEditRegister::getControllerEditingParameter(ParamIndex paramIndex) const
+ParameterEditRegister::ParameterEditRegister()
 {
-  auto it = paramsBeingEditedByControls.find(paramIndex);
-  if (it != paramsBeingEditedByControls.end())
-    return it->second;
+  std::fill(paramsBeingEditedByControls.begin(), paramsBeingEditedByControls.end(), noControl);
+}
+
+ControlId ParameterEditRegister::getControllerEditingParameter(ParamIndex paramIndex) const
+{
+  if (paramIndex < paramsBeingEditedByControls.size())
+    return paramsBeingEditedByControls[paramIndex];
   else
-    return {};
+    return noControl;
 }
 
 bool ParameterEditRegister::isParameterBeingEdited(ParamIndex paramIndex) const
 {
-  return paramsBeingEditedByControls.find(paramIndex) != paramsBeingEditedByControls.end();
+  return getControllerEditingParameter(paramIndex) != noControl;
 }
 
-void ParameterEditRegister::unregisterEdit(ParamIndex paramIndex)
+bool ParameterEditRegister::unregisterEdit(ParamIndex paramIndex)
 {
-  paramsBeingEditedByControls.erase(paramIndex);
+  if (paramIndex < paramsBeingEditedByControls.size()) {
+    paramsBeingEditedByControls[paramIndex] = noControl;
+    return true;
+  }
+  return false;
 }
 
-void ParameterEditRegister::registerEdit(ParamIndex paramIndex, std::string control)
+bool ParameterEditRegister::registerEdit(ParamIndex paramIndex, ControlId control)
 {
-  paramsBeingEditedByControls.emplace(paramIndex, std::move(control));
+  assert(control != noControl);
+  if (paramIndex < paramsBeingEditedByControls.size()) {
+    paramsBeingEditedByControls[paramIndex] = control;
+    return true;
+  }
+  return false;
 }
-} // namespace unplug::detail
\ No newline at end of file
+} // namespace unplug::detail
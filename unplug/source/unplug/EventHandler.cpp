@@ -13,6 +13,7 @@
 
 #include "unplug/detail/EventHandler.hpp"
 #include "pugl/gl.hpp"
+#include "unplug/Trace.hpp"
 #include "unplug/UserInterface.hpp"
 #include "unplug/detail/OpaqueGl.hpp"
 
@@ -41,6 +42,7 @@ void EventHandler::handleScroll(float dx, float dy)
   ImGuiIO& io = ImGui::GetIO();
   io.MouseWheelH += dx;
   io.MouseWheel += dy;
+  onUserInput();
   view.postRedisplay();
 }
 
@@ -57,6 +59,7 @@ void EventHandler::onAsciiKeyEvent(int key, bool isDown)
   io.KeysDown[key] = isDown;
   if (isDown)
     io.AddInputCharacterUTF16(key);
+  onUserInput();
 }
 
 void EventHandler::onNonAsciiKeyEvent(int virtualKeyCode, bool isDown)
@@ -66,6 +69,7 @@ void EventHandler::onNonAsciiKeyEvent(int virtualKeyCode, bool isDown)
   io.KeysDown[virtualKeyCode + 128] = isDown;
   if (virtualKeyCode == ImGuiKey_Space && isDown)
     io.AddInputCharacter(' ');
+  onUserInput();
 }
 
 void EventHandler::handleModifierKeys(ModifierKeys modifiers)
@@ -143,6 +147,7 @@ pugl::Status EventHandler::onEvent(const pugl::ConfigureEvent& event)
   setCurrentContext();
   ImGuiIO& io = ImGui::GetIO();
   io.DisplaySize = { (float)event.width, (float)event.height };
+  onUserInput();
   return pugl::Status::success;
 }
 
@@ -154,6 +159,7 @@ pugl::Status EventHandler::onEvent(const pugl::UpdateEvent& event)
 
 pugl::Status EventHandler::onEvent(const pugl::ExposeEvent& event)
 {
+  UNPLUG_TRACE_SCOPE("EventHandler::frame");
   setCurrentContext();
   ImGuiIO& io = ImGui::GetIO();
 
@@ -174,16 +180,22 @@ pugl::Status EventHandler::onEvent(const pugl::ExposeEvent& event)
 
   UserInterface::setupStyle();
   ImGui::NewFrame();
+  redrawConditions.clear();
   parameters.clearParameterRectangles();
   const ImGuiViewport* main_viewport = ImGui::GetMainViewport();
   ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_None);
   ImGui::SetNextWindowSize(main_viewport->Size, ImGuiCond_None);
   if (ImGui::Begin(UserInterface::getWindowName(), NULL, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove)) {
     // do not paint if the windows is collapsed - will probably never happen with plugins
+    // the edits are batched so that the host is notified at most once per parameter per frame
+    UNPLUG_TRACE_SCOPE("UserInterface::paint");
+    parameters.beginBatchEdit();
     UserInterface::paint();
+    parameters.endBatchEdit();
   }
   ImGui::End();
 
+  UNPLUG_TRACE_SCOPE("EventHandler::render");
   ImGui::Render();
 
   resizeAndClearViewport(io.DisplaySize.x, io.DisplaySize.y, UserInterface::getBackgroundColor());
@@ -209,6 +221,7 @@ pugl::Status EventHandler::onEvent(const pugl::ButtonPressEvent& event)
   ImGuiIO& io = ImGui::GetIO();
   auto imguiButtonCode = convertButtonCode(event.button);
   io.MouseDown[imguiButtonCode] = true;
+  onUserInput();
   view.postRedisplay();
   return pugl::Status::success;
 }
@@ -221,6 +234,7 @@ pugl::Status EventHandler::onEvent(const pugl::ButtonReleaseEvent& event)
   ImGuiIO& io = ImGui::GetIO();
   auto imguiButtonCode = convertButtonCode(event.button);
   io.MouseDown[imguiButtonCode] = false;
+  onUserInput();
   return pugl::Status::success;
 }
 
@@ -231,6 +245,7 @@ pugl::Status EventHandler::onEvent(const pugl::MotionEvent& event)
   setCurrentContext();
   ImGuiIO& io = ImGui::GetIO();
   io.MousePos = { (float)event.x, (float)event.y };
+  onUserInput();
   return pugl::Status::success;
 }
 
@@ -243,7 +258,9 @@ pugl::Status EventHandler::onEvent(const pugl::ScrollEvent& event)
 pugl::Status EventHandler::onEvent(const pugl::TimerEvent& event)
 {
   if (event.id == redrawTimerId) {
-    view.postRedisplay();
+    if (isRedrawNeeded()) {
+      view.postRedisplay();
+    }
     return pugl::Status::success;
   }
   else {
@@ -256,6 +273,7 @@ pugl::Status EventHandler::onEvent(const pugl::PointerInEvent& event)
 {
   isMouseCursorIn = true;
   setCurrentContext();
+  onUserInput();
   view.postRedisplay();
   return pugl::Status::success;
 }
@@ -264,6 +282,7 @@ pugl::Status EventHandler::onEvent(const pugl::PointerOutEvent& event)
 {
   isMouseCursorIn = false;
   setCurrentContext();
+  onUserInput();
   view.postRedisplay();
   return pugl::Status::success;
 }
@@ -296,6 +315,25 @@ void EventHandler::setCurrentContext()
     detail::setMeters(*meters);
   }
   custom->setCurrent();
+  detail::setRedrawConditions(redrawConditions);
+}
+
+void EventHandler::onUserInput()
+{
+  numFramesToRedraw = numFramesToRedrawAfterInput;
+}
+
+bool EventHandler::isRedrawNeeded()
+{
+  // the host can change the parameters without any user input: automation, presets and states
+  auto const numParameterChanges = parameters.getNumChanges();
+  bool const haveParametersChanged = numParameterChanges != lastNumParameterChanges;
+  lastNumParameterChanges = numParameterChanges;
+  if (numFramesToRedraw > 0) {
+    --numFramesToRedraw;
+    return true;
+  }
+  return haveParametersChanged || redrawConditions.isEmpty() || redrawConditions.isAnyMet();
 }
 
 int EventHandler::convertButtonCode(int code)
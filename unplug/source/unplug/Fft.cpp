@@ -0,0 +1,166 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/Fft.hpp"
+#include "unplug/SharedTableCache.hpp"
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+namespace unplug {
+
+struct Fft::Tables final
+{
+  std::vector<Index> bitReversed;
+  // twiddles of the half size complex transform, and of the split of the real spectrum
+  std::vector<float> cosines;
+  std::vector<float> sines;
+  std::vector<float> splitCosines;
+  std::vector<float> splitSines;
+
+  explicit Tables(Index size)
+  {
+    auto const halfSize = size / 2;
+    bitReversed.resize(halfSize);
+    Index numBits = 0;
+    while ((Index(1) << numBits) < halfSize) {
+      ++numBits;
+    }
+    for (Index i = 0; i < halfSize; ++i) {
+      Index reversed = 0;
+      for (Index bit = 0; bit < numBits; ++bit) {
+        reversed |= ((i >> bit) & 1) << (numBits - 1 - bit);
+      }
+      bitReversed[i] = reversed;
+    }
+    cosines.resize(halfSize / 2);
+    sines.resize(halfSize / 2);
+    for (Index i = 0; i < halfSize / 2; ++i) {
+      auto const angle = 2.0 * M_PI * static_cast<double>(i) / static_cast<double>(halfSize);
+      cosines[i] = static_cast<float>(std::cos(angle));
+      sines[i] = static_cast<float>(std::sin(angle));
+    }
+    splitCosines.resize(halfSize + 1);
+    splitSines.resize(halfSize + 1);
+    for (Index i = 0; i <= halfSize; ++i) {
+      auto const angle = 2.0 * M_PI * static_cast<double>(i) / static_cast<double>(size);
+      splitCosines[i] = static_cast<float>(std::cos(angle));
+      splitSines[i] = static_cast<float>(std::sin(angle));
+    }
+  }
+};
+
+Fft::Fft(Index size)
+  : size{ size }
+  , halfSize{ size / 2 }
+{
+  assert(size >= 4 && (size & (size - 1)) == 0);
+  tables = SharedTableCache<Index, Tables>::get(size, [size] { return Tables(size); });
+  bufferReal.resize(halfSize);
+  bufferImaginary.resize(halfSize);
+}
+
+void Fft::transform(bool isInverse)
+{
+  auto re = bufferReal.data();
+  auto im = bufferImaginary.data();
+  auto const& bitReversed = tables->bitReversed;
+  auto const& cosines = tables->cosines;
+  auto const& sines = tables->sines;
+  for (Index i = 0; i < halfSize; ++i) {
+    auto const j = bitReversed[i];
+    if (i < j) {
+      std::swap(re[i], re[j]);
+      std::swap(im[i], im[j]);
+    }
+  }
+  float const sign = isInverse ? 1.f : -1.f;
+  for (Index length = 2; length <= halfSize; length *= 2) {
+    auto const halfLength = length / 2;
+    auto const twiddleStride = halfSize / length;
+    for (Index start = 0; start < halfSize; start += length) {
+      for (Index k = 0; k < halfLength; ++k) {
+        auto const wr = cosines[k * twiddleStride];
+        auto const wi = sign * sines[k * twiddleStride];
+        auto const a = start + k;
+        auto const b = a + halfLength;
+        auto const tr = re[b] * wr - im[b] * wi;
+        auto const ti = re[b] * wi + im[b] * wr;
+        re[b] = re[a] - tr;
+        im[b] = im[a] - ti;
+        re[a] += tr;
+        im[a] += ti;
+      }
+    }
+  }
+}
+
+void Fft::forward(float const* input, float* real, float* imaginary)
+{
+  // the even samples are the real part and the odd samples the imaginary part of a signal of half the size
+  for (Index i = 0; i < halfSize; ++i) {
+    bufferReal[i] = input[2 * i];
+    bufferImaginary[i] = input[2 * i + 1];
+  }
+  transform(false);
+  auto const& splitCosines = tables->splitCosines;
+  auto const& splitSines = tables->splitSines;
+  // X[k] = E[k] + W^k O[k], with E[k] = (Z[k] + Z*[M - k]) / 2 and O[k] = (Z[k] - Z*[M - k]) / 2i
+  for (Index k = 0; k <= halfSize; ++k) {
+    auto const zr = bufferReal[k % halfSize];
+    auto const zi = bufferImaginary[k % halfSize];
+    auto const cr = bufferReal[(halfSize - k) % halfSize];
+    auto const ci = -bufferImaginary[(halfSize - k) % halfSize];
+    auto const er = 0.5f * (zr + cr);
+    auto const ei = 0.5f * (zi + ci);
+    auto const or_ = 0.5f * (zi - ci);
+    auto const oi = -0.5f * (zr - cr);
+    auto const wr = splitCosines[k];
+    auto const wi = -splitSines[k];
+    real[k] = er + or_ * wr - oi * wi;
+    imaginary[k] = ei + or_ * wi + oi * wr;
+  }
+}
+
+void Fft::inverse(float const* real, float const* imaginary, float* output)
+{
+  auto const& splitCosines = tables->splitCosines;
+  auto const& splitSines = tables->splitSines;
+  // E[k] = (X[k] + X*[M - k]) / 2, O[k] = (X[k] - X*[M - k]) / 2W^k, Z[k] = E[k] + i O[k]
+  for (Index k = 0; k < halfSize; ++k) {
+    auto const xr = real[k];
+    auto const xi = k == 0 ? 0.f : imaginary[k];
+    auto const cr = real[halfSize - k];
+    auto const ci = k == 0 ? 0.f : -imaginary[halfSize - k];
+    auto const er = 0.5f * (xr + cr);
+    auto const ei = 0.5f * (xi + ci);
+    auto const dr = 0.5f * (xr - cr);
+    auto const di = 0.5f * (xi - ci);
+    // dividing by W^k is multiplying by its conjugate
+    auto const wr = splitCosines[k];
+    auto const wi = splitSines[k];
+    auto const or_ = dr * wr - di * wi;
+    auto const oi = dr * wi + di * wr;
+    bufferReal[k] = er - oi;
+    bufferImaginary[k] = ei + or_;
+  }
+  transform(true);
+  auto const scale = 1.f / static_cast<float>(halfSize);
+  for (Index i = 0; i < halfSize; ++i) {
+    output[2 * i] = bufferReal[i] * scale;
+    output[2 * i + 1] = bufferImaginary[i] * scale;
+  }
+}
+
+} // namespace unplug
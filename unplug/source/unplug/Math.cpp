@@ -12,8 +12,8 @@
 //------------------------------------------------------------------------
 
 #include "unplug/Math.hpp"
-#include <iomanip>
-#include <sstream>
+#include <algorithm>
+#include <cstdio>
 
 namespace unplug {
 
@@ -23,13 +23,20 @@ std::string linearToDBAsText(float linear)
 }
 
 std::string linearToDBAsTextWithDecimalDigits(float linear, int numDecimalDigits)
+{
+  // short enough for the small string optimization, so usually no allocation happens here
+  char buffer[32];
+  auto const length = writeLinearToDBAsText(linear, buffer, sizeof(buffer), numDecimalDigits);
+  return { buffer, static_cast<std::size_t>(std::max(0, length)) };
+}
+
+int writeLinearToDBAsText(float linear, char* buffer, std::size_t bufferSize, int numDecimalDigits)
 {
   if (linear <= std::numeric_limits<float>::epsilon())
-    return { "-inf dB" };
+    return std::snprintf(buffer, bufferSize, "-inf dB");
   auto const db = unplug::linearToDB(linear);
-  std::stringstream s;
-  s << std::fixed << std::setprecision(numDecimalDigits) << db << " dB";
-  return s.str();
+  auto const length = std::snprintf(buffer, bufferSize, "%.*f dB", numDecimalDigits, db);
+  return std::min(length, static_cast<int>(bufferSize) - 1);
 }
 
-} // namespace unplug
\ No newline at end of file
+} // namespace unplug
@@ -12,6 +12,8 @@
 //------------------------------------------------------------------------
 
 #include "unplug/MidiMapping.hpp"
+#include "unplug/ParameterDescription.hpp"
+#include <algorithm>
 #include <cassert>
 
 namespace unplug {
@@ -30,6 +32,11 @@ void MidiMappingSingleChannel::mapParameter(ParamIndex paramIndex, int controlle
   midiMapping[static_cast<std::size_t>(controller)] = paramIndex;
 }
 
+void MidiMappingSingleChannel::unmapParameter(ParamIndex paramIndex)
+{
+  std::replace(midiMapping.begin(), midiMapping.end(), paramIndex, unmapped);
+}
+
 ParamIndex MidiMappingSingleChannel::getParameter(int controller) const
 {
   if (static_cast<std::size_t>(controller) < midiMapping.size()) {
@@ -55,6 +62,27 @@ void MidiMapping::mapParameter(ParamIndex paramIndex, int controller)
   }
 }
 
+void MidiMapping::mapDefaultMidiMapping(ParameterDescription const& description)
+{
+  auto const& mapping = description.defaultMidiMapping;
+  if (!mapping.isEnabled()) {
+    return;
+  }
+  if (mapping.listensToAllChannels()) {
+    mapParameter(description.index, mapping.control);
+  }
+  else {
+    mapParameter(description.index, mapping.control, mapping.channel);
+  }
+}
+
+void MidiMapping::unmapParameter(ParamIndex paramIndex)
+{
+  for (auto& channelMidiMapping : midiMappingByChannel) {
+    channelMidiMapping.unmapParameter(paramIndex);
+  }
+}
+
 ParamIndex MidiMapping::getParameter(int controller, int channel) const
 {
   assert(channel < midiMappingByChannel.size());
@@ -65,5 +93,19 @@ ParamIndex MidiMapping::getParameter(int controller, int channel) const
     return unmapped;
 }
 
+std::vector<MidiMapping::Assignment> MidiMapping::getAssignments() const
+{
+  auto assignments = std::vector<Assignment>{};
+  for (int channel = 0; channel < numChannels; ++channel) {
+    for (int controller = 0; controller < MidiMappingSingleChannel::numControllers; ++controller) {
+      auto const paramIndex = midiMappingByChannel[channel].getParameter(controller);
+      if (paramIndex != unmapped) {
+        assignments.push_back({ channel, controller, paramIndex });
+      }
+    }
+  }
+  return assignments;
+}
+
 } // namespace detail
 } // namespace unplug
\ No newline at end of file
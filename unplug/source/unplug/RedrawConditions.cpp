@@ -0,0 +1,35 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/detail/RedrawConditions.hpp"
+
+namespace unplug::detail {
+
+namespace {
+thread_local RedrawConditions* currentRedrawConditions = nullptr;
+}
+
+void setRedrawConditions(RedrawConditions& redrawConditions)
+{
+  currentRedrawConditions = &redrawConditions;
+}
+
+void addRedrawCondition(RedrawCondition condition)
+{
+  if (currentRedrawConditions) {
+    currentRedrawConditions->add(condition);
+  }
+}
+
+} // namespace unplug::detail
\ No newline at end of file
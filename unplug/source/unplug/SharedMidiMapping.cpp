@@ -0,0 +1,48 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/detail/SharedMidiMapping.hpp"
+#include <algorithm>
+
+namespace unplug::detail {
+
+SharedMidiMapping::SharedMidiMapping(MidiMapping const& mapping)
+{
+  publish(mapping);
+}
+
+void SharedMidiMapping::publish(MidiMapping const& mapping)
+{
+  auto table = std::make_unique<MidiMapping const>(mapping);
+  auto const lock = std::lock_guard{ mutex };
+  current.store(table.get(), std::memory_order_seq_cst);
+  tables.push_back(std::move(table));
+  // deferred reclamation: a replaced table can only be in use if the audio thread marked it before the swap
+  auto const currentTable = tables.back().get();
+  auto const readTable = reading.load(std::memory_order_seq_cst);
+  tables.erase(std::remove_if(tables.begin(),
+                              tables.end(),
+                              [&](auto const& candidate) {
+                                return candidate.get() != currentTable && candidate.get() != readTable;
+                              }),
+               tables.end());
+}
+
+MidiMapping SharedMidiMapping::getLatest() const
+{
+  auto const lock = std::lock_guard{ mutex };
+  return *tables.back();
+}
+
+} // namespace unplug::detail
@@ -0,0 +1,289 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/Trace.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace unplug::trace {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int maxNumThreads = 32;
+constexpr uint32_t numEventsPerThread = 8192;
+static_assert((numEventsPerThread & (numEventsPerThread - 1)) == 0);
+
+struct Event final
+{
+  const char* name;
+  int64_t timestamp;
+  double value;
+  // a thread that exits releases its buffer to the next thread, so the owner is stored in each event
+  int threadId;
+  char phase;
+};
+
+/**
+ * A single producer single consumer queue of events, written by the thread that claimed it and read by the flusher.
+ * */
+struct ThreadBuffer final
+{
+  std::atomic<bool> isClaimed{ false };
+  std::atomic<uint32_t> writeIndex{ 0 };
+  std::atomic<uint32_t> readIndex{ 0 };
+  std::atomic<uint64_t> numDroppedEvents{ 0 };
+  std::array<Event, numEventsPerThread> events;
+};
+
+struct Tracer final
+{
+  std::atomic<bool> isRunning{ false };
+  std::atomic<int> nextThreadId{ 0 };
+  Clock::time_point startTime;
+  // the buffers are allocated once and never freed, so that the threads can keep their slot across restarts
+  std::array<std::unique_ptr<ThreadBuffer>, maxNumThreads> buffers;
+  // the events of the threads that found no free buffer
+  std::atomic<uint64_t> numEventsWithoutBuffer{ 0 };
+
+  std::mutex mutex;
+  int numUsers{ 0 };
+  std::FILE* file{ nullptr };
+  bool isFirstEventInFile{ true };
+  std::thread flusher;
+  std::condition_variable stopCondition;
+  bool isStopRequested{ false };
+  // the events dropped by all the threads since start, reported as a counter
+  uint64_t numDroppedEvents{ 0 };
+
+  void writeEvent(const char* name, char phase, int64_t timestamp, int threadId)
+  {
+    std::fprintf(file,
+                 "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d",
+                 isFirstEventInFile ? "" : ",",
+                 name,
+                 phase,
+                 static_cast<double>(timestamp) * 1e-3,
+                 threadId);
+    isFirstEventInFile = false;
+  }
+
+  /**
+   * Writes the number of dropped events as a counter, so that the unbalanced scopes they leave are not mistaken for
+   * long ones.
+   * */
+  void writeNumDroppedEvents()
+  {
+    auto const timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - startTime);
+    writeEvent("dropped trace events", 'C', timestamp.count(), 0);
+    std::fprintf(file, ",\"args\":{\"value\":%llu}}", static_cast<unsigned long long>(numDroppedEvents));
+  }
+
+  void flush(bool isLastFlush = false)
+  {
+    uint64_t numNewDroppedEvents = 0;
+    for (int thread = 0; thread < maxNumThreads; ++thread) {
+      auto& buffer = buffers[thread];
+      // a released buffer may still hold the last events of the thread that exited
+      if (!buffer) {
+        continue;
+      }
+      auto const readIndex = buffer->readIndex.load(std::memory_order_relaxed);
+      auto const writeIndex = buffer->writeIndex.load(std::memory_order_acquire);
+      for (auto index = readIndex; index != writeIndex; ++index) {
+        auto const& event = buffer->events[index & (numEventsPerThread - 1)];
+        writeEvent(event.name, event.phase, event.timestamp, event.threadId);
+        if (event.phase == 'C') {
+          std::fprintf(file, ",\"args\":{\"value\":%g}", event.value);
+        }
+        std::fputs("}", file);
+      }
+      buffer->readIndex.store(writeIndex, std::memory_order_release);
+      numNewDroppedEvents += buffer->numDroppedEvents.exchange(0, std::memory_order_relaxed);
+    }
+    numNewDroppedEvents += numEventsWithoutBuffer.exchange(0, std::memory_order_relaxed);
+    numDroppedEvents += numNewDroppedEvents;
+    if (numNewDroppedEvents > 0 || isLastFlush) {
+      writeNumDroppedEvents();
+    }
+    std::fflush(file);
+  }
+
+  void runFlusher()
+  {
+    auto lock = std::unique_lock<std::mutex>(mutex);
+    while (!isStopRequested) {
+      stopCondition.wait_for(lock, std::chrono::milliseconds(100));
+      flush();
+    }
+  }
+};
+
+Tracer& getTracer()
+{
+  static Tracer tracer;
+  return tracer;
+}
+
+std::filesystem::path getTraceFilePath()
+{
+  if (auto const path = std::getenv("UNPLUG_TRACE_FILE")) {
+    return path;
+  }
+  auto const time = std::chrono::system_clock::now().time_since_epoch();
+  auto const milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(time).count();
+  auto error = std::error_code{};
+  auto const directory = std::filesystem::temp_directory_path(error);
+  return directory / ("unplug-trace-" + std::to_string(milliseconds) + ".json");
+}
+
+/**
+ * The buffer claimed by a thread. It is released when the thread exits, so that threads that come and go, such as the
+ * workers of an offline renderer, do not exhaust the buffers. The flusher keeps draining a released buffer, and the
+ * events it still holds carry the id of the thread that wrote them.
+ * */
+struct ThreadSlot final
+{
+  // -1: no slot yet, -2: no slot available
+  int index = -1;
+  int threadId = -1;
+
+  ~ThreadSlot()
+  {
+    if (index >= 0) {
+      getTracer().buffers[index]->isClaimed.store(false, std::memory_order_release);
+    }
+  }
+};
+
+ThreadBuffer* getThreadBuffer(Tracer& tracer, int& threadId)
+{
+  thread_local ThreadSlot slot;
+  if (slot.index == -1) {
+    slot.index = -2;
+    for (int thread = 0; thread < maxNumThreads; ++thread) {
+      bool isClaimed = false;
+      if (tracer.buffers[thread]->isClaimed.compare_exchange_strong(isClaimed, true, std::memory_order_acq_rel)) {
+        slot.index = thread;
+        slot.threadId = tracer.nextThreadId.fetch_add(1, std::memory_order_relaxed);
+        break;
+      }
+    }
+  }
+  threadId = slot.threadId;
+  return slot.index >= 0 ? tracer.buffers[slot.index].get() : nullptr;
+}
+
+void record(const char* name, char phase, double value = 0.0)
+{
+  auto& tracer = getTracer();
+  if (!tracer.isRunning.load(std::memory_order_acquire)) {
+    return;
+  }
+  int threadId = -1;
+  auto buffer = getThreadBuffer(tracer, threadId);
+  if (!buffer) {
+    tracer.numEventsWithoutBuffer.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  auto const writeIndex = buffer->writeIndex.load(std::memory_order_relaxed);
+  auto const readIndex = buffer->readIndex.load(std::memory_order_acquire);
+  if (writeIndex - readIndex == numEventsPerThread) {
+    buffer->numDroppedEvents.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  auto const timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - tracer.startTime);
+  buffer->events[writeIndex & (numEventsPerThread - 1)] = { name, timestamp.count(), value, threadId, phase };
+  buffer->writeIndex.store(writeIndex + 1, std::memory_order_release);
+}
+
+} // namespace
+
+void start()
+{
+  auto& tracer = getTracer();
+  auto lock = std::lock_guard<std::mutex>(tracer.mutex);
+  if (tracer.numUsers++ > 0) {
+    return;
+  }
+  tracer.file = std::fopen(getTraceFilePath().string().c_str(), "w");
+  if (!tracer.file) {
+    return;
+  }
+  std::fputs("[", tracer.file);
+  tracer.isFirstEventInFile = true;
+  for (auto& buffer : tracer.buffers) {
+    if (!buffer) {
+      buffer = std::make_unique<ThreadBuffer>();
+    }
+    buffer->readIndex.store(buffer->writeIndex.load(std::memory_order_acquire), std::memory_order_release);
+    buffer->numDroppedEvents.store(0, std::memory_order_relaxed);
+  }
+  tracer.numEventsWithoutBuffer.store(0, std::memory_order_relaxed);
+  tracer.numDroppedEvents = 0;
+  tracer.startTime = Clock::now();
+  tracer.isStopRequested = false;
+  tracer.isRunning.store(true, std::memory_order_release);
+  tracer.flusher = std::thread([&tracer] { tracer.runFlusher(); });
+}
+
+void stop()
+{
+  auto& tracer = getTracer();
+  {
+    auto lock = std::lock_guard<std::mutex>(tracer.mutex);
+    if (tracer.numUsers == 0 || --tracer.numUsers > 0 || !tracer.file) {
+      return;
+    }
+    tracer.isRunning.store(false, std::memory_order_release);
+    tracer.isStopRequested = true;
+  }
+  tracer.stopCondition.notify_one();
+  if (tracer.flusher.joinable()) {
+    tracer.flusher.join();
+  }
+  auto lock = std::lock_guard<std::mutex>(tracer.mutex);
+  tracer.flush(true);
+  std::fputs("\n]\n", tracer.file);
+  std::fclose(tracer.file);
+  tracer.file = nullptr;
+}
+
+void begin(const char* name)
+{
+  record(name, 'B');
+}
+
+void end(const char* name)
+{
+  record(name, 'E');
+}
+
+void counter(const char* name, double value)
+{
+  record(name, 'C', value);
+}
+
+} // namespace unplug::trace
@@ -0,0 +1,136 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/detail/UniformConvolver.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace unplug::detail {
+
+namespace {
+
+void multiplyAdd(float const* aReal,
+                 float const* aImaginary,
+                 float const* bReal,
+                 float const* bImaginary,
+                 float* real,
+                 float* imaginary,
+                 Index numBins)
+{
+  for (Index k = 0; k < numBins; ++k) {
+    real[k] += aReal[k] * bReal[k] - aImaginary[k] * bImaginary[k];
+    imaginary[k] += aReal[k] * bImaginary[k] + aImaginary[k] * bReal[k];
+  }
+}
+
+} // namespace
+
+UniformConvolver::UniformConvolver(Index blockSize, float const* impulseResponse, Index size)
+  : blockSize{ blockSize }
+  , numBins{ blockSize + 1 }
+  , numPartitions{ std::max(Index(1), (size + blockSize - 1) / blockSize) }
+  , fft(2 * blockSize)
+{
+  assert(blockSize > 0 && (blockSize & (blockSize - 1)) == 0);
+  partitionsReal.resize(numPartitions * numBins);
+  partitionsImaginary.resize(numPartitions * numBins);
+  segmentsReal.resize(numPartitions * numBins, 0.f);
+  segmentsImaginary.resize(numPartitions * numBins, 0.f);
+  accumulatedReal.resize(numBins, 0.f);
+  accumulatedImaginary.resize(numBins, 0.f);
+  convolvedReal.resize(numBins);
+  convolvedImaginary.resize(numBins);
+  inputBuffer.resize(2 * blockSize, 0.f);
+  outputBuffer.resize(2 * blockSize, 0.f);
+  overlap.resize(blockSize, 0.f);
+  for (Index partition = 0; partition < numPartitions; ++partition) {
+    auto const begin = partition * blockSize;
+    auto const length = std::clamp(size - begin, Index(0), blockSize);
+    std::fill(inputBuffer.begin(), inputBuffer.end(), 0.f);
+    std::copy(impulseResponse + begin, impulseResponse + begin + length, inputBuffer.begin());
+    fft.forward(inputBuffer.data(),
+                partitionsReal.data() + partition * numBins,
+                partitionsImaginary.data() + partition * numBins);
+  }
+  std::fill(inputBuffer.begin(), inputBuffer.end(), 0.f);
+}
+
+void UniformConvolver::process(float const* input, float* output, Index numSamples)
+{
+  Index processed = 0;
+  while (processed < numSamples) {
+    auto const isBlockStart = inputPosition == 0;
+    auto const numToProcess = std::min(numSamples - processed, blockSize - inputPosition);
+    std::copy(input + processed, input + processed + numToProcess, inputBuffer.begin() + inputPosition);
+
+    auto const currentReal = segmentsReal.data() + currentSegment * numBins;
+    auto const currentImaginary = segmentsImaginary.data() + currentSegment * numBins;
+    fft.forward(inputBuffer.data(), currentReal, currentImaginary);
+
+    // the older blocks do not change until the current one is complete
+    if (isBlockStart) {
+      std::fill(accumulatedReal.begin(), accumulatedReal.end(), 0.f);
+      std::fill(accumulatedImaginary.begin(), accumulatedImaginary.end(), 0.f);
+      for (Index partition = 1; partition < numPartitions; ++partition) {
+        auto const segment = (currentSegment + partition) % numPartitions;
+        multiplyAdd(partitionsReal.data() + partition * numBins,
+                    partitionsImaginary.data() + partition * numBins,
+                    segmentsReal.data() + segment * numBins,
+                    segmentsImaginary.data() + segment * numBins,
+                    accumulatedReal.data(),
+                    accumulatedImaginary.data(),
+                    numBins);
+      }
+    }
+
+    std::copy(accumulatedReal.begin(), accumulatedReal.end(), convolvedReal.begin());
+    std::copy(accumulatedImaginary.begin(), accumulatedImaginary.end(), convolvedImaginary.begin());
+    multiplyAdd(partitionsReal.data(),
+                partitionsImaginary.data(),
+                currentReal,
+                currentImaginary,
+                convolvedReal.data(),
+                convolvedImaginary.data(),
+                numBins);
+    fft.inverse(convolvedReal.data(), convolvedImaginary.data(), outputBuffer.data());
+
+    for (Index i = 0; i < numToProcess; ++i) {
+      output[processed + i] = outputBuffer[inputPosition + i] + overlap[inputPosition + i];
+    }
+
+    inputPosition += numToProcess;
+    processed += numToProcess;
+
+    if (inputPosition == blockSize) {
+      std::copy(outputBuffer.begin() + blockSize, outputBuffer.end(), overlap.begin());
+      std::fill(inputBuffer.begin(), inputBuffer.begin() + blockSize, 0.f);
+      inputPosition = 0;
+      currentSegment = (currentSegment == 0 ? numPartitions : currentSegment) - 1;
+    }
+  }
+}
+
+void UniformConvolver::reset()
+{
+  std::fill(segmentsReal.begin(), segmentsReal.end(), 0.f);
+  std::fill(segmentsImaginary.begin(), segmentsImaginary.end(), 0.f);
+  std::fill(accumulatedReal.begin(), accumulatedReal.end(), 0.f);
+  std::fill(accumulatedImaginary.begin(), accumulatedImaginary.end(), 0.f);
+  std::fill(inputBuffer.begin(), inputBuffer.end(), 0.f);
+  std::fill(overlap.begin(), overlap.end(), 0.f);
+  inputPosition = 0;
+  currentSegment = 0;
+}
+
+} // namespace unplug::detail
@@ -19,19 +19,44 @@
 #include "unplug/Widgets.hpp"
 #include "imgui_internal.h"
 #include "unplug/MeterStorage.hpp"
+#include <cstdio>
 
 namespace unplug {
 
 using namespace detail;
 
-static std::string makeLabel(ShowLabel showLabel, std::string const& parameterName, const char* controlSuffix)
+// a text composed in a fixed buffer, so that the controls do not allocate memory every frame
+struct ShortText final
 {
-  return showLabel == ShowLabel::yes ? parameterName + "##" + controlSuffix : "##" + parameterName + controlSuffix;
+  char text[256];
+
+  const char* c_str() const
+  {
+    return text;
+  }
+};
+
+static ShortText makeLabel(ShowLabel showLabel, std::string const& parameterName, const char* controlSuffix)
+{
+  ShortText label;
+  std::snprintf(label.text,
+                sizeof(label.text),
+                showLabel == ShowLabel::yes ? "%s##%s" : "##%s%s",
+                parameterName.c_str(),
+                controlSuffix);
+  return label;
 }
 
-static std::string makeFormat(ParameterData const& parameter, const char* format)
+static ShortText makeFormat(ParameterData const& parameter, const char* format)
 {
-  return !parameter.measureUnit.empty() ? format + (" " + parameter.measureUnit) : format;
+  ShortText formatWithUnit;
+  if (parameter.measureUnit.empty()) {
+    std::snprintf(formatWithUnit.text, sizeof(formatWithUnit.text), "%s", format);
+  }
+  else {
+    std::snprintf(formatWithUnit.text, sizeof(formatWithUnit.text), "%s %s", format, parameter.measureUnit.c_str());
+  }
+  return formatWithUnit;
 }
 
 bool Combo(ParamIndex paramIndex, ShowLabel showLabel)
@@ -47,9 +72,9 @@ bool Combo(ParamIndex paramIndex, ShowLabel showLabel)
 
   double const valueNormalized = parameters.getValueNormalized(paramIndex);
   double const value = parameters.valueFromNormalized(paramIndex, valueNormalized);
-  auto const parameterName = parameters.getName(paramIndex);
+  auto const& parameterName = parameters.getName(paramIndex);
 
-  auto const valueAsText = parameters.convertToText(paramIndex, valueNormalized);
+  auto const& valueAsText = parameters.getValueAsText(paramIndex);
 
   auto const numSteps = parameters.getNumSteps(paramIndex);
 
@@ -81,8 +106,7 @@ bool Combo(ParamIndex paramIndex, ShowLabel showLabel)
   EndCombo();
   if (hasValueChanged) {
     ImGuiContext const& g = *GImGui;
-    ImGuiWindow* window = g.CurrentWindow;
-    parameters.beginEdit(paramIndex, controlName);
+    parameters.beginEdit(paramIndex, GetID(controlName.c_str()));
     parameters.setValue(paramIndex, newValue);
     parameters.endEdit(paramIndex);
     MarkItemEdited(g.LastItemData.ID);
@@ -99,50 +123,58 @@ bool Checkbox(ParamIndex paramIndex, ShowLabel showLabel)
     auto isChecked = parameter.value != 0.0;
     auto const controlName = makeLabel(showLabel, parameter.name, "CHECKBOX");
     bool const isActive = ImGui::Checkbox(controlName.c_str(), &isChecked);
-    return ControlOutput{ controlName, isChecked ? 1.f : 0.f, isActive };
+    return ControlOutput{ ImGui::GetID(controlName.c_str()), isChecked ? 1.f : 0.f, isActive };
   });
 }
 
 void TextCentered(std::string const& text, float height)
+{
+  TextCentered(text.c_str(), height);
+}
+
+void TextCentered(const char* text, float height)
 {
   auto const bkgColor = ImGui::GetStyle().Colors[ImGuiCol_WindowBg];
   ImGui::PushStyleColor(ImGuiCol_Button, bkgColor);
   ImGui::PushStyleColor(ImGuiCol_ButtonHovered, bkgColor);
   ImGui::PushStyleColor(ImGuiCol_ButtonActive, bkgColor);
-  ImGui::Button(text.c_str(), { ImGui::CalcItemWidth(), height });
+  ImGui::Button(text, { ImGui::CalcItemWidth(), height });
   ImGui::PopStyleColor(3);
 }
 
 void NameLabel(ParamIndex paramIndex)
 {
   auto& parameters = getParameters();
-  auto const name = parameters.getName(paramIndex);
-  return ImGui::TextUnformatted(name.c_str());
+  auto const& name = parameters.getName(paramIndex);
+  return ImGui::TextUnformatted(name.c_str(), name.c_str() + name.size());
 }
 
 void NameLabelCentered(ParamIndex paramIndex, float height)
 {
   auto& parameters = getParameters();
-  auto const name = parameters.getName(paramIndex);
-  TextCentered(name + "##LABELCENTERED", height);
+  // the name is cached, only the id suffix is added, in a fixed buffer
+  ShortText label;
+  std::snprintf(label.text, sizeof(label.text), "%s##LABELCENTERED", parameters.getName(paramIndex).c_str());
+  TextCentered(label.c_str(), height);
 }
 
 void ValueLabel(ParamIndex paramIndex, ShowLabel showLabel)
 {
   auto& parameters = getParameters();
-  auto const valueAsText = parameters.getValueAsText(paramIndex);
-  auto const text = showLabel == ShowLabel::yes ? (parameters.getName(paramIndex) + ": " + valueAsText) : valueAsText;
-  return ImGui::TextUnformatted(text.c_str());
+  auto const& text = showLabel == ShowLabel::yes ? parameters.getNameAndValueAsText(paramIndex)
+                                                 : parameters.getValueAsText(paramIndex);
+  return ImGui::TextUnformatted(text.c_str(), text.c_str() + text.size());
 }
 
 void ValueLabelCentered(ParamIndex paramIndex, ShowLabel showLabel, float height)
 {
   auto& parameters = getParameters();
-  auto const valueAsText = parameters.getValueAsText(paramIndex);
-  auto const text =
-    (showLabel == ShowLabel::yes ? (parameters.getName(paramIndex) + ": " + valueAsText) : valueAsText) +
-    "##VALUUEASTEXTCENTERED";
-  TextCentered(text, height);
+  auto const& text = showLabel == ShowLabel::yes ? parameters.getNameAndValueAsText(paramIndex)
+                                                 : parameters.getValueAsText(paramIndex);
+  // both texts are cached, only the id suffix is added, in a fixed buffer
+  ShortText label;
+  std::snprintf(label.text, sizeof(label.text), "%s##VALUUEASTEXTCENTERED", text.c_str());
+  TextCentered(label.c_str(), height);
 }
 
 void MeterValueLabel(MeterIndex meterIndex, std::function<std::string(float)> const& toString)
@@ -174,24 +206,12 @@ ParameterData::ParameterData(ParameterAccess& parameters, ParamIndex paramIndex)
   , isBeingEdited(parameters.isBeingEdited(paramIndex))
 {}
 
-EditingState::EditingState(const ParameterData& parameterData, bool isControlActive, std::string controlName)
+EditingState::EditingState(const ParameterData& parameterData, bool isControlActive, ControlId controlId)
   : isParameterBeingEdited(parameterData.isBeingEdited)
   , isControlActive(isControlActive)
-  , controlName(std::move(controlName))
+  , controlId(controlId)
 {}
 
-bool Control(ParamIndex paramIndex, std::function<ControlOutput(ParameterData const& parameter)> const& control)
-{
-  auto& parameters = getParameters();
-  auto const parameter = ParameterData{ parameters, paramIndex };
-  auto const areaInfo = beginRegisterArea();
-  auto const output = control(parameter);
-  endRegisterArea(parameters, paramIndex, areaInfo);
-  auto const editingState = EditingState{ parameter, output.isActive, output.controlName };
-  applyRangedParameters(parameters, paramIndex, editingState, output.value);
-  return output.isActive;
-}
-
 bool ValueAsText(ParamIndex paramIndex, ShowLabel showLabel, const char* format, bool noHighlight)
 {
   return Control(paramIndex, [=](ParameterData const& parameter) {
@@ -200,7 +220,7 @@ bool ValueAsText(ParamIndex paramIndex, ShowLabel showLabel, const char* format,
     auto const formatWithUnit = makeFormat(parameter, format);
     bool const isActive = detail::EditableFloat(
       controlName.c_str(), &outputValue, parameter.minValue, parameter.maxValue, formatWithUnit.c_str(), noHighlight);
-    return ControlOutput{ controlName, outputValue, isActive };
+    return ControlOutput{ ImGui::GetID(controlName.c_str()), outputValue, isActive };
   });
 }
 
@@ -212,7 +232,7 @@ bool SliderFloat(ParamIndex paramIndex, ShowLabel showLabel, const char* format,
     auto const formatWithUnit = makeFormat(parameter, format);
     bool const isActive = ImGui::SliderFloat(
       controlName.c_str(), &outputValue, parameter.minValue, parameter.maxValue, formatWithUnit.c_str(), flags);
-    return ControlOutput{ controlName, outputValue, isActive };
+    return ControlOutput{ ImGui::GetID(controlName.c_str()), outputValue, isActive };
   });
 }
 
@@ -224,7 +244,7 @@ bool VSliderFloat(ParamIndex paramIndex, ImVec2 size, ShowLabel showLabel, const
     auto const formatWithUnit = makeFormat(parameter, format);
     bool const isActive = ImGui::VSliderFloat(
       controlName.c_str(), size, &outputValue, parameter.minValue, parameter.maxValue, formatWithUnit.c_str(), flags);
-    return ControlOutput{ controlName, outputValue, isActive };
+    return ControlOutput{ ImGui::GetID(controlName.c_str()), outputValue, isActive };
   });
 }
 
@@ -240,7 +260,7 @@ bool SliderInt(ParamIndex paramIndex, ShowLabel showLabel, const char* format, I
                                            static_cast<int>(parameter.maxValue),
                                            formatWithUnit.c_str(),
                                            flags);
-    return ControlOutput{ controlName, static_cast<float>(outputValue), isActive };
+    return ControlOutput{ ImGui::GetID(controlName.c_str()), static_cast<float>(outputValue), isActive };
   });
 }
 
@@ -257,7 +277,7 @@ bool VSliderInt(ParamIndex paramIndex, ImVec2 size, ShowLabel showLabel, const c
                                             static_cast<int>(parameter.maxValue),
                                             formatWithUnit.c_str(),
                                             flags);
-    return ControlOutput{ controlName, static_cast<float>(outputValue), isActive };
+    return ControlOutput{ ImGui::GetID(controlName.c_str()), static_cast<float>(outputValue), isActive };
   });
 }
 
@@ -276,7 +296,7 @@ bool DragFloat(ParamIndex paramIndex, ShowLabel showLabel, float speedCoef, cons
                                            parameter.maxValue,
                                            formatWithUnit.c_str(),
                                            flags);
-    return ControlOutput{ controlName, outputValue, isActive };
+    return ControlOutput{ ImGui::GetID(controlName.c_str()), outputValue, isActive };
   });
 }
 
@@ -297,14 +317,14 @@ void DrawSimpleKnob(KnobDrawData const& knob)
 bool Knob(ParamIndex paramIndex, float power, float angleOffset, std::function<void(KnobDrawData const&)> const& drawer)
 {
   return Control(paramIndex, [&](ParameterData const& parameter) {
-    auto controlName = parameter.name + "##KNOB";
+    auto const controlName = makeLabel(ShowLabel::yes, parameter.name, "KNOB");
     auto const scaledInput =
       std::pow((parameter.value - parameter.minValue) / (parameter.maxValue - parameter.minValue), 1.f / power);
     auto const knobOutput = Knob(controlName.c_str(), scaledInput, angleOffset);
     drawer(knobOutput.drawData);
     auto const outputValue = parameter.minValue + (parameter.maxValue - parameter.minValue) *
                                                     std::pow(static_cast<float>(knobOutput.value), power);
-    return ControlOutput{ controlName, outputValue, knobOutput.isActive };
+    return ControlOutput{ ImGui::GetID(controlName.c_str()), outputValue, knobOutput.isActive };
   });
 }
 
@@ -449,6 +469,17 @@ void LevelMeter(MeterIndex meterIndex,
   LevelMeterRaw(rawValue, name, size, settings, alignment);
 }
 
+void DspLoadMeter(std::string const& name, ImVec2 size, float maxLoad)
+{
+  auto const& meters = getMeters();
+  auto settings = LevelMeterSettings{};
+  settings.minValue = 0.f;
+  settings.maxValue = maxLoad;
+  settings.scaling = [](float load) { return load; };
+  LevelMeterRaw(meters.getDspLoad(), name, size, settings);
+  ImGui::Text("%s: %.0f%% (peak %.0f%%)", name.c_str(), 100.f * meters.getDspLoad(), 100.f * meters.getDspLoadPeak());
+}
+
 void DifferenceLevelMeterRaw(float rawValue,
                              std::string const& name,
                              ImVec2 size,
@@ -529,7 +560,7 @@ void applyRangedParameters(ParameterAccess& parameters, ParamIndex paramIndex, E
 {
   if (editingState.isParameterBeingEdited) {
     auto const controlDoingTheEditing = parameters.getEditingControl(paramIndex);
-    if (editingState.controlName != controlDoingTheEditing) {
+    if (editingState.controlId != controlDoingTheEditing) {
       return;
     }
     if (editingState.isControlActive) {
@@ -543,7 +574,7 @@ void applyRangedParameters(ParameterAccess& parameters, ParamIndex paramIndex, E
   }
   else {
     if (editingState.isControlActive) {
-      bool const beginEditOk = parameters.beginEdit(paramIndex, editingState.controlName);
+      bool const beginEditOk = parameters.beginEdit(paramIndex, editingState.controlId);
       assert(beginEditOk);
       bool const setValueOk = parameters.setValue(paramIndex, value);
       assert(setValueOk);
@@ -19,6 +19,7 @@
 #include "unplug/GetVersion.hpp"
 #include "unplug/Presets.hpp"
 #include "unplug/StringConversion.hpp"
+#include "unplug/Trace.hpp"
 #include "unplug/UserInterface.hpp"
 #include "unplug/detail/GetSortedParameterDescriptions.hpp"
 #include "unplug/detail/Vst3MessageIds.hpp"
@@ -103,20 +104,16 @@ tresult PLUGIN_API UnplugController::initialize(FUnknown* context)
       } break;
     }
 
-    if (description.defaultMidiMapping.isEnabled()) {
-      auto const& mapping = description.defaultMidiMapping;
-      if (description.defaultMidiMapping.listensToAllChannels()) {
-        midiMapping.mapParameter(description.index, mapping.control);
-      }
-      else {
-        midiMapping.mapParameter(description.index, description.defaultMidiMapping.control, mapping.channel);
-      }
-    }
+    midiMapping.mapDefaultMidiMapping(description);
 
     if (description.editPolicy != ParamEditPolicy::automatable) {
       notAutomatableParameters[description.index] = description.editPolicy;
+      if (description.editPolicy == ParamEditPolicy::notAutomatableAndMayChangeLatencyOnEdit) {
+        latencyParameters.push_back(description.index);
+      }
     }
   }
+  defaultMidiMapping = midiMapping;
 
   auto const& presets = Presets::get();
 
@@ -159,30 +156,117 @@ tresult PLUGIN_API UnplugController::initialize(FUnknown* context)
 
 tresult PLUGIN_API UnplugController::setComponentState(IBStream* state)
 {
+  UNPLUG_TRACE_SCOPE("UnplugController::setComponentState");
   // loads the dsp state
   if (!state)
     return kResultFalse;
   using namespace unplug::Serialization;
   IBStreamer ibStreamer(state, kLittleEndian);
-  auto streamer = Streamer<load>(ibStreamer);
   Version version;
-  if (!streamer(version.data(), version.size())) {
+  auto format = StateFormat::chunked;
+  if (!readStateHeader(ibStreamer, version, format)) {
     return kResultFalse;
   }
-  for (Index paramIndex = 0; paramIndex < NumParameters::value; ++paramIndex) {
-    double valueNormalized = 0;
-    if (!streamer(valueNormalized)) {
-      return kResultFalse;
+  auto values = std::vector<double>(NumParameters::value);
+  if (format == StateFormat::legacy) {
+    auto streamer = Streamer<load>(ibStreamer);
+    for (auto& value : values) {
+      if (!streamer(value)) {
+        return kResultFalse;
+      }
+    }
+    // legacy states have no midi mapping
+    auto restartFlags = loadParameters(values);
+    restartFlags |= loadMidiMapping(defaultMidiMapping);
+    if (restartFlags != 0) {
+      restart(restartFlags);
+    }
+    return kResultOk;
+  }
+  // the controller only needs the parameters and the midi mapping, the other chunks are skipped. The host is asked to
+  // restart the component once, after all the chunks are loaded.
+  int32 restartFlags = 0;
+  bool isMidiMappingLoaded = false;
+  bool const ok = readChunks(ibStreamer, [&](uint32_t tag, int64_t) {
+    switch (tag) {
+      case ChunkTag::parameters:
+        if (!readParameterBlock(ibStreamer, values)) {
+          return false;
+        }
+        restartFlags |= loadParameters(values);
+        return true;
+      case ChunkTag::midiMapping: {
+        // the processor has already published the same mapping
+        auto loadedMidiMapping = MidiMapping{};
+        if (!readMidiMappingBlock(ibStreamer, loadedMidiMapping, NumParameters::value)) {
+          return false;
+        }
+        restartFlags |= loadMidiMapping(loadedMidiMapping);
+        isMidiMappingLoaded = true;
+        return true;
+      }
+      default:
+        return true;
     }
+  });
+  // as the processor does, a state without a midi mapping restores the default one
+  if (ok && !isMidiMappingLoaded) {
+    restartFlags |= loadMidiMapping(defaultMidiMapping);
+  }
+  // also after a failure, as the chunks read before it have been loaded
+  if (restartFlags != 0) {
+    restart(restartFlags);
+  }
+  return ok ? kResultOk : kResultFalse;
+}
+
+int32 UnplugController::loadMidiMapping(MidiMapping const& loadedMidiMapping)
+{
+  if (loadedMidiMapping == midiMapping) {
+    return 0;
+  }
+  midiMapping = loadedMidiMapping;
+  return kMidiCCAssignmentChanged;
+}
+
+int32 UnplugController::loadParameters(std::vector<double> const& values)
+{
+  // the values are set directly, without going through setParamNormalized: the processor has already loaded the same
+  // state, so it only needs to know about the parameters that may change the latency, and the caller asks the host to
+  // restart the component at most once.
+  auto latencyParameterValues = std::vector<double>();
+  latencyParameterValues.reserve(latencyParameters.size());
+  for (auto tag : latencyParameters) {
+    latencyParameterValues.push_back(getParamNormalized(tag));
+  }
+  for (Index paramIndex = 0; paramIndex < values.size(); ++paramIndex) {
     auto parameter = parameters.getParameterByIndex(paramIndex);
     bool const isProgramChange = (parameter->getInfo().flags & ParameterInfo::kIsProgramChange) != 0;
     assert(!isProgramChange);
     if (!isProgramChange) {
-      auto const parameterTag = parameter->getInfo().id;
-      setParamNormalized(parameterTag, valueNormalized);
+      parameter->setNormalized(values[paramIndex]);
     }
   }
-  return kResultOk;
+  numParameterChanges.fetch_add(1, std::memory_order_acq_rel);
+  bool latencyMayHaveChanged = false;
+  for (std::size_t i = 0; i < latencyParameters.size(); ++i) {
+    auto const tag = latencyParameters[i];
+    auto const valueNormalized = getParamNormalized(tag);
+    if (valueNormalized != latencyParameterValues[i]) {
+      sendLatencyUpdate(tag, normalizedParamToPlain(tag, valueNormalized));
+      latencyMayHaveChanged = true;
+    }
+  }
+  return latencyMayHaveChanged ? kLatencyChanged : 0;
+}
+
+void UnplugController::sendLatencyUpdate(ParamID tag, ParamValue plainValue)
+{
+  auto message = owned(allocateMessage());
+  message->setMessageID(vst3::messageId::updateLatencyId);
+  message->getAttributes()->setInt(vst3::messageId::updateLatencyParamChangedTagId, (int64)tag);
+  message->getAttributes()->setFloat(vst3::messageId::updateLatencyParamChangedValueId, plainValue);
+  sendMessage(message);
 }
 
 template<unplug::Serialization::Action action>
@@ -201,6 +285,7 @@ bool UnplugController::serialization(IBStreamer& ibStreamer)
 
 tresult PLUGIN_API UnplugController::setState(IBStream* state)
 {
+  UNPLUG_TRACE_SCOPE("UnplugController::setState");
   if (!state)
     return kResultFalse;
   IBStreamer streamer(state, kLittleEndian);
@@ -252,9 +337,44 @@ tresult UnplugController::getMidiControllerAssignment(int32 busIndex,
   return kResultFalse;
 }
 
+tresult UnplugController::onLiveMIDIControllerInput(int32 busIndex, int16 channel, CtrlNumber midiCC)
+{
+  if (busIndex != 0 || midiLearnParameter == MidiMapping::unmapped) {
+    return kResultFalse;
+  }
+  midiMapping.unmapParameter(midiLearnParameter);
+  if (isMidiLearnOnAllChannels) {
+    midiMapping.mapParameter(midiLearnParameter, static_cast<int>(midiCC));
+  }
+  else {
+    midiMapping.mapParameter(midiLearnParameter, static_cast<int>(midiCC), channel);
+  }
+  stopMidiLearn();
+  onMidiMappingChanged();
+  return kResultTrue;
+}
+
+void UnplugController::startMidiLearn(ParamID paramIndex, bool listensToAllChannels)
+{
+  assert(paramIndex < NumParameters::value);
+  midiLearnParameter = paramIndex < NumParameters::value ? paramIndex : MidiMapping::unmapped;
+  isMidiLearnOnAllChannels = listensToAllChannels;
+}
+
+void UnplugController::onMidiMappingChanged()
+{
+  if (sharedMidiMapping) {
+    sharedMidiMapping->publish(midiMapping);
+  }
+  restart(kMidiCCAssignmentChanged);
+  // the mapping is saved with the state of the processor
+  setDirty(true);
+}
+
 tresult UnplugController::setParamNormalized(ParamID tag, ParamValue value)
 {
   if (Parameter* parameter = getParameterObject(tag)) {
+    numParameterChanges.fetch_add(1, std::memory_order_acq_rel);
 
     auto const maybeNotAutomatable = notAutomatableParameters.find(tag);
     if (maybeNotAutomatable != notAutomatableParameters.end()) {
@@ -263,11 +383,7 @@ tresult UnplugController::setParamNormalized(ParamID tag, ParamValue value)
         auto const plainValue = parameter->toPlain(value);
         parameter->setNormalized(value);
         if (maybeNotAutomatable->second == ParamEditPolicy::notAutomatableAndMayChangeLatencyOnEdit) {
-          auto message = owned(allocateMessage());
-          message->setMessageID(vst3::messageId::updateLatencyId);
-          message->getAttributes()->setInt(vst3::messageId::updateLatencyParamChangedTagId, (int64)tag);
-          message->getAttributes()->setFloat(vst3::messageId::updateLatencyParamChangedValueId, plainValue);
-          sendMessage(message);
+          sendLatencyUpdate(tag, plainValue);
           restart();
         }
       }
@@ -288,6 +404,7 @@ tresult UnplugController::setParamNormalized(ParamID tag, ParamValue value)
 
 void UnplugController::applyPreset(int presetIndex)
 {
+  UNPLUG_TRACE_SCOPE("UnplugController::applyPreset");
   if (Presets::get().size() > presetIndex) {
     auto& preset = Presets::get()[presetIndex];
     for (auto [parameterTag, value] : preset.parameterValues) {
@@ -305,6 +422,7 @@ void UnplugController::applyPreset(int presetIndex)
 
 tresult PLUGIN_API UnplugController::notify(IMessage* message)
 {
+  UNPLUG_TRACE_SCOPE("UnplugController::notify");
   using namespace vst3::messageId;
   if (!message)
     return kInvalidArgument;
@@ -321,6 +439,8 @@ tresult PLUGIN_API UnplugController::notify(IMessage* message)
     };
     meters = *reinterpret_cast<std::shared_ptr<MeterStorage>*>(getAddress(meterStorageId));
     sharedData = *reinterpret_cast<std::shared_ptr<SharedDataWrapped>*>(getAddress(sharedDataStorageId));
+    sharedMidiMapping =
+      *reinterpret_cast<std::shared_ptr<detail::SharedMidiMapping>*>(getAddress(midiMappingStorageId));
     return kResultOk;
   }
   else if (FIDStringsEqual(message->getMessageID(), updateLatencyId)) {
@@ -344,11 +464,11 @@ bool UnplugController::onNotify(IMessage* message)
   return EditControllerEx1::notify(message) == kResultOk;
 }
 
-void UnplugController::restart()
+void UnplugController::restart(int32 flags)
 {
   auto handler = getComponentHandler();
   if (handler) {
-    handler->restartComponent(kLatencyChanged);
+    handler->restartComponent(flags);
   }
   else {
     // no handler? it happens in the VST3 tests.
@@ -14,6 +14,7 @@
 #include "unplug/UnplugProcessor.hpp"
 #include "unplug/GetVersion.hpp"
 #include "unplug/Presets.hpp"
+#include "unplug/Trace.hpp"
 #include "unplug/UserInterface.hpp"
 #include "unplug/detail/GetSortedParameterDescriptions.hpp"
 #include "unplug/detail/Vst3MessageIds.hpp"
@@ -36,6 +37,7 @@ void UnplugProcessor::onInitialization()
 
 tresult PLUGIN_API UnplugProcessor::initialize(FUnknown* context)
 {
+  UNPLUG_TRACE_START();
   tresult result = AudioEffect::initialize(context);
   if (result != kResultOk) {
     return result;
@@ -43,6 +45,11 @@ tresult PLUGIN_API UnplugProcessor::initialize(FUnknown* context)
 
   auto const parameterDescriptions = detail::getSortedParameterDescriptions();
   pluginState.parameters.initialize(parameterDescriptions);
+  defaultMidiMapping = detail::MidiMapping{};
+  for (auto const& description : parameterDescriptions) {
+    defaultMidiMapping.mapDefaultMidiMapping(description);
+  }
+  midiMapping = std::make_shared<detail::SharedMidiMapping>(defaultMidiMapping);
 
   ioCache.resize(1, 1);
 
@@ -58,101 +65,141 @@ tresult PLUGIN_API UnplugProcessor::initialize(FUnknown* context)
 tresult PLUGIN_API UnplugProcessor::terminate()
 {
   onTermination();
+  UNPLUG_TRACE_STOP();
   return AudioEffect::terminate();
 }
 
 void UnplugProcessor::updateNotAutomatableParameters(ProcessData& data)
 {
-  if (pluginState.parameters.getNumNotAutomatableParameters() == 0)
-    return;
-  if (data.inputParameterChanges) {
-    int32 numParamsChanged = data.inputParameterChanges->getParameterCount();
-    for (int32 index = 0; index < numParamsChanged; index++) {
-      if (auto* paramQueue = data.inputParameterChanges->getParameterData(index)) {
-        int32 numPoints = paramQueue->getPointCount();
-        if (numPoints > 0) {
-          ParamValue value;
-          int32 sampleOffset;
-          paramQueue->getPoint(numPoints - 1, sampleOffset, value);
-          auto const parameterTag = paramQueue->getParameterId();
-          auto const isAutomatable = pluginState.parameters.isParameterAutomatable(parameterTag);
-          if (!isAutomatable) {
-            pluginState.parameters.setNormalized(static_cast<ParamIndex>(parameterTag), value);
-          }
-        }
-      }
-    }
-  }
+  processingEngine.updateNotAutomatableParameters(Vst3ParameterChangesReader(data.inputParameterChanges));
 }
+
 void UnplugProcessor::updateParametersToLastPoint(ProcessData& data)
 {
-  if (data.inputParameterChanges) {
-    int32 numParamsChanged = data.inputParameterChanges->getParameterCount();
-    for (int32 index = 0; index < numParamsChanged; index++) {
-      if (auto* paramQueue = data.inputParameterChanges->getParameterData(index)) {
-        int32 numPoints = paramQueue->getPointCount();
-        if (numPoints > 0) {
-          ParamValue value;
-          int32 sampleOffset;
-          paramQueue->getPoint(numPoints - 1, sampleOffset, value);
-          auto const parameterTag = paramQueue->getParameterId();
-          pluginState.parameters.setNormalized(static_cast<ParamIndex>(parameterTag), value);
-        }
-      }
+  processingEngine.updateParametersToLastPoint(Vst3ParameterChangesReader(data.inputParameterChanges));
+}
+
+bool UnplugProcessor::saveState(IBStreamer& ibStreamer)
+{
+  using namespace unplug::Serialization;
+  if (!writeStateHeader(ibStreamer, getVersion())) {
+    return false;
+  }
+  bool const parametersOk = writeChunk(ibStreamer, ChunkTag::parameters, [&] {
+    auto values = std::vector<double>(NumParameters::value);
+    for (ParamIndex i = 0; i < NumParameters::value; ++i) {
+      values[i] = pluginState.parameters.getNormalized(i);
     }
+    return writeParameterBlock(ibStreamer, values);
+  });
+  if (!parametersOk) {
+    return false;
   }
+  bool const sharedDataOk = writeChunk(ibStreamer, ChunkTag::sharedData, [&] {
+    auto streamer = Streamer<save>(ibStreamer);
+    return pluginState.sharedData->template serialization<save>(streamer);
+  });
+  if (!sharedDataOk) {
+    return false;
+  }
+  bool const midiMappingOk = writeChunk(
+    ibStreamer, ChunkTag::midiMapping, [&] { return writeMidiMappingBlock(ibStreamer, midiMapping->getLatest()); });
+  if (!midiMappingOk) {
+    return false;
+  }
+  bool const userOk = writeChunk(ibStreamer, ChunkTag::user, [&] { return onGetState(ibStreamer); });
+  if (!userOk) {
+    return false;
+  }
+  return writeEndChunk(ibStreamer);
 }
 
-template<unplug::Serialization::Action action>
-bool UnplugProcessor::serialization(IBStreamer& ibStreamer)
+bool UnplugProcessor::loadState(IBStreamer& ibStreamer)
 {
   using namespace unplug::Serialization;
-  auto streamer = Streamer<action>(ibStreamer);
   Version version;
-  if (!streamer(version.data(), version.size())) {
+  auto format = StateFormat::chunked;
+  if (!readStateHeader(ibStreamer, version, format)) {
     return false;
   }
-  for (int i = 0; i < NumParameters::value; ++i) {
-    if constexpr (action == save) {
-      double value = pluginState.parameters.getNormalized(i);
-      if (!streamer(value)) {
-        return false;
+  if (format == StateFormat::legacy) {
+    // legacy states have no midi mapping
+    midiMapping->publish(defaultMidiMapping);
+    return loadLegacyState(ibStreamer);
+  }
+  bool isMidiMappingLoaded = false;
+  bool const ok = readChunks(ibStreamer, [&](uint32_t tag, int64_t) {
+    switch (tag) {
+      case ChunkTag::parameters: {
+        auto values = std::vector<double>(NumParameters::value);
+        if (!readParameterBlock(ibStreamer, values)) {
+          return false;
+        }
+        // parameters added after the state was saved keep their current value
+        for (ParamIndex i = 0; i < values.size(); ++i) {
+          pluginState.parameters.setNormalized(i, values[i]);
+        }
+        return true;
       }
-    }
-    else {
-      double value = 0;
-      if (!streamer(value)) {
-        return false;
+      case ChunkTag::sharedData: {
+        auto streamer = Streamer<load>(ibStreamer);
+        return pluginState.sharedData->template serialization<load>(streamer);
       }
-      pluginState.parameters.setNormalized(i, value);
+      case ChunkTag::midiMapping: {
+        auto loadedMidiMapping = detail::MidiMapping{};
+        if (!readMidiMappingBlock(ibStreamer, loadedMidiMapping, NumParameters::value)) {
+          return false;
+        }
+        midiMapping->publish(loadedMidiMapping);
+        isMidiMappingLoaded = true;
+        return true;
+      }
+      case ChunkTag::user:
+        return onSetState(ibStreamer);
+      default:
+        return true;
     }
+  });
+  // a state without a midi mapping replaces the current one, which may have been learned, with the default one
+  if (ok && !isMidiMappingLoaded) {
+    midiMapping->publish(defaultMidiMapping);
   }
-  auto const ok = pluginState.sharedData->template serialization<action>(streamer);
   return ok;
 }
 
+bool UnplugProcessor::loadLegacyState(IBStreamer& ibStreamer)
+{
+  using namespace unplug::Serialization;
+  auto streamer = Streamer<load>(ibStreamer);
+  for (ParamIndex i = 0; i < NumParameters::value; ++i) {
+    double value = 0;
+    if (!streamer(value)) {
+      return false;
+    }
+    pluginState.parameters.setNormalized(i, value);
+  }
+  if (!pluginState.sharedData->template serialization<load>(streamer)) {
+    return false;
+  }
+  return onSetState(ibStreamer);
+}
+
 tresult PLUGIN_API UnplugProcessor::setState(IBStream* state)
 {
+  UNPLUG_TRACE_SCOPE("UnplugProcessor::setState");
   if (!state)
     return kResultFalse;
-  using namespace unplug::Serialization;
   IBStreamer streamer(state, kLittleEndian);
-  auto const success = serialization<load>(streamer);
-  if (!success)
-    return kResultFalse;
-  return onSetState(streamer) ? kResultOk : kResultFalse;
+  return loadState(streamer) ? kResultOk : kResultFalse;
 }
 
 tresult PLUGIN_API UnplugProcessor::getState(IBStream* state)
 {
+  UNPLUG_TRACE_SCOPE("UnplugProcessor::getState");
   if (!state)
     return kResultFalse;
-  using namespace unplug::Serialization;
   IBStreamer streamer(state, kLittleEndian);
-  auto const success = serialization<save>(streamer);
-  if (!success)
-    return kResultFalse;
-  return onGetState(streamer) ? kResultOk : kResultFalse;
+  return saveState(streamer) ? kResultOk : kResultFalse;
 }
 
 tresult PLUGIN_API UnplugProcessor::canProcessSampleSize(int32 symbolicSampleSize)
@@ -168,6 +215,7 @@ tresult PLUGIN_API UnplugProcessor::canProcessSampleSize(int32 symbolicSampleSiz
 
 tresult PLUGIN_API UnplugProcessor::notify(IMessage* message)
 {
+  UNPLUG_TRACE_SCOPE("UnplugProcessor::notify");
   using namespace vst3::messageId;
   if (!message)
     return kInvalidArgument;
@@ -220,14 +268,20 @@ tresult PLUGIN_API UnplugProcessor::notify(IMessage* message)
 
 tresult UnplugProcessor::setActive(TBool state)
 {
+  UNPLUG_TRACE_SCOPE("UnplugProcessor::setActive");
   if (state) {
     contextInfo.sampleRate = static_cast<float>(processSetup.sampleRate);
+    dspLoad.setSampleRate(processSetup.sampleRate);
     contextInfo.userInterfaceRefreshRate = UserInterface::getRefreshRate();
-    contextInfo.maxAudioBlockSize = processSetup.maxSamplesPerBlock;
+    contextInfo.maxAudioBlockSize = blockAdapter.getMaxBlockSize(processSetup.maxSamplesPerBlock);
     contextInfo.numIO = updateNumIO();
     contextInfo.precision =
       processSetup.symbolicSampleSize == kSample64 ? FloatingPointPrecision::float64 : FloatingPointPrecision::float32;
+    contextInfo.processMode = processSetup.processMode == kOffline    ? ProcessMode::offline
+                              : processSetup.processMode == kPrefetch ? ProcessMode::prefetch
+                                                                      : ProcessMode::realtime;
     setup();
+    setupBlockAdapter();
   }
   onSetActive(state);
   return AudioEffect::setActive(state);
@@ -331,6 +385,9 @@ void UnplugProcessor::sendSharedDataToController()
   auto const sharedDataAddress = reinterpret_cast<uintptr_t>(&sharedDataWrapped);
   message->getAttributes()->setBinary(
     vst3::messageId::sharedDataStorageId, &sharedDataAddress, sizeof(sharedDataAddress));
+  auto const midiMappingAddress = reinterpret_cast<uintptr_t>(&midiMapping);
+  message->getAttributes()->setBinary(
+    vst3::messageId::midiMappingStorageId, &midiMappingAddress, sizeof(midiMappingAddress));
   sendMessage(message);
 }
 
@@ -349,6 +406,21 @@ bool UnplugProcessor::setup()
   return onSetup(contextInfo);
 }
 
+void UnplugProcessor::setupBlockAdapter()
+{
+  auto const getNumChannels = [](auto& buses) {
+    auto numChannels = std::vector<int32>(buses.size());
+    for (std::size_t bus = 0; bus < buses.size(); ++bus) {
+      BusInfo info{};
+      if (buses[bus]->getInfo(info)) {
+        numChannels[bus] = info.channelCount;
+      }
+    }
+    return numChannels;
+  };
+  blockAdapter.setup(getNumChannels(audioInputs), getNumChannels(audioOutputs), contextInfo.precision);
+}
+
 void UnplugProcessor::setLatency(uint32_t value)
 {
   if (latency != value) {
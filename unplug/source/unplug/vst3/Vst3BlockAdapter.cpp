@@ -0,0 +1,377 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/detail/Vst3BlockAdapter.hpp"
+#include <cassert>
+
+namespace Steinberg::Vst {
+
+namespace {
+
+ParamValue interpolate(int64 position, int64 firstPosition, ParamValue firstValue, int64 lastPosition, ParamValue lastValue)
+{
+  auto const alpha = static_cast<ParamValue>(position - firstPosition) / static_cast<ParamValue>(lastPosition - firstPosition);
+  return firstValue + alpha * (lastValue - firstValue);
+}
+
+bool canBeInterpolated(ParamID id, unplug::ParameterStorage const& parameters)
+{
+  return id < unplug::NumParameters::value && parameters.isParameterAutomatable(id);
+}
+
+// these events point to memory owned by the host, which is only valid during the call to process
+bool canBeDelayed(Event const& event)
+{
+  switch (event.type) {
+    case Event::kDataEvent:
+    case Event::kNoteExpressionTextEvent:
+    case Event::kChordEvent:
+    case Event::kScaleEvent:
+      return false;
+    default:
+      return true;
+  }
+}
+
+} // namespace
+
+void BlockAdapter::setMode(Mode mode_, unplug::Index blockSize_, int32 maxNumPoints_, int32 maxNumEvents_)
+{
+  assert(mode_ == Mode::none || blockSize_ > 0);
+  mode = blockSize_ > 0 ? mode_ : Mode::none;
+  blockSize = blockSize_;
+  maxNumPoints = maxNumPoints_;
+  maxNumEvents = maxNumEvents_;
+}
+
+unplug::Index BlockAdapter::getMaxBlockSize(unplug::Index hostMaxBlockSize) const
+{
+  switch (mode) {
+    case Mode::maxBlockSize:
+      return std::min(hostMaxBlockSize, blockSize);
+    case Mode::fixedBlockSize:
+      return blockSize;
+    default:
+      return hostMaxBlockSize;
+  }
+}
+
+void BlockAdapter::setup(std::vector<int32> const& numInputChannels,
+                         std::vector<int32> const& numOutputChannels,
+                         unplug::FloatingPointPrecision precision_)
+{
+  precision = precision_;
+  int32 numChannels = 0;
+  auto const setupLayout = [&](std::vector<int32> const& numBusChannels, std::vector<BusLayout>& layout) {
+    layout.resize(numBusChannels.size());
+    for (std::size_t bus = 0; bus < numBusChannels.size(); ++bus) {
+      layout[bus] = { numBusChannels[bus], numChannels };
+      numChannels += numBusChannels[bus];
+    }
+  };
+  setupLayout(numInputChannels, inputLayout);
+  setupLayout(numOutputChannels, outputLayout);
+  inputs.assign(inputLayout.size(), AudioBusBuffers{});
+  outputs.assign(outputLayout.size(), AudioBusBuffers{});
+  channels32.assign(numChannels, nullptr);
+  channels64.assign(numChannels, nullptr);
+
+  bool const isFixed = mode == Mode::fixedBlockSize;
+  bool const isDoublePrecision = precision == unplug::FloatingPointPrecision::float64;
+  fifo32.assign(isFixed && !isDoublePrecision ? numChannels * blockSize : 0, 0.f);
+  fifo64.assign(isFixed && isDoublePrecision ? numChannels * blockSize : 0, 0.0);
+  pendingPoints.resize(isFixed ? maxNumPoints : 0);
+  changes.setCapacity(static_cast<int32>(unplug::NumParameters::value), maxNumPoints);
+  pendingEvents.resize(isFixed ? maxNumEvents : 0);
+  events.setCapacity(mode == Mode::none ? 0 : maxNumEvents);
+  if (isFixed) {
+    setFifoBuffers();
+  }
+  reset();
+}
+
+void BlockAdapter::setFifoBuffers()
+{
+  auto const setBuses = [&](std::vector<BusLayout> const& layout, std::vector<AudioBusBuffers>& buses) {
+    for (std::size_t bus = 0; bus < layout.size(); ++bus) {
+      auto const firstChannel = layout[bus].firstChannel;
+      for (int32 channel = 0; channel < layout[bus].numChannels; ++channel) {
+        auto const offset = (firstChannel + channel) * blockSize;
+        if (precision == unplug::FloatingPointPrecision::float64) {
+          channels64[firstChannel + channel] = fifo64.data() + offset;
+        }
+        else {
+          channels32[firstChannel + channel] = fifo32.data() + offset;
+        }
+      }
+      buses[bus].numChannels = layout[bus].numChannels;
+      if (precision == unplug::FloatingPointPrecision::float64) {
+        setBuffer<double>(buses[bus], channels64.data() + firstChannel);
+      }
+      else {
+        setBuffer<float>(buses[bus], channels32.data() + firstChannel);
+      }
+    }
+  };
+  setBuses(inputLayout, inputs);
+  setBuses(outputLayout, outputs);
+}
+
+void BlockAdapter::reset()
+{
+  std::fill(fifo32.begin(), fifo32.end(), 0.f);
+  std::fill(fifo64.begin(), fifo64.end(), 0.0);
+  fifoPosition = 0;
+  streamPosition = 0;
+  numPendingPoints = 0;
+  numReceivedPoints = 0;
+  changes.clear();
+  numPendingEvents = 0;
+  events.clear();
+}
+
+bool BlockAdapter::isSetUpFor(ProcessData const& data) const
+{
+  if (data.numInputs > static_cast<int32>(inputLayout.size()) ||
+      data.numOutputs > static_cast<int32>(outputLayout.size()))
+  {
+    return false;
+  }
+  for (int32 bus = 0; bus < data.numInputs; ++bus) {
+    if (data.inputs[bus].numChannels > inputLayout[bus].numChannels) {
+      return false;
+    }
+  }
+  for (int32 bus = 0; bus < data.numOutputs; ++bus) {
+    if (data.outputs[bus].numChannels > outputLayout[bus].numChannels) {
+      return false;
+    }
+  }
+  if (mode == Mode::fixedBlockSize) {
+    bool const isDoublePrecision = data.symbolicSampleSize == kSample64;
+    return isDoublePrecision == (precision == unplug::FloatingPointPrecision::float64);
+  }
+  return true;
+}
+
+ProcessContext* BlockAdapter::offsetProcessContext(ProcessContext* source, int64 offset)
+{
+  if (!source) {
+    return nullptr;
+  }
+  context = *source;
+  if (offset == 0) {
+    return &context;
+  }
+  context.projectTimeSamples += offset;
+  if (context.state & ProcessContext::kContTimeValid) {
+    context.continousTimeSamples += offset;
+  }
+  bool const canOffsetMusicTime = (context.state & ProcessContext::kProjectTimeMusicValid) &&
+                                  (context.state & ProcessContext::kTempoValid) && context.sampleRate > 0.0;
+  if (canOffsetMusicTime) {
+    context.projectTimeMusic += static_cast<double>(offset) / context.sampleRate * context.tempo / 60.0;
+  }
+  else {
+    context.state &= ~ProcessContext::kProjectTimeMusicValid;
+  }
+  // the distance to the next MIDI clock is not tracked across blocks
+  context.state &= ~ProcessContext::kClockValid;
+  return &context;
+}
+
+void BlockAdapter::prepareSubBlockEvents(IEventList& source,
+                                         int32 start,
+                                         int32 end,
+                                         bool isLastSubBlock,
+                                         int32& nextEvent)
+{
+  events.clear();
+  int32 const numEvents = source.getEventCount();
+  for (; nextEvent < numEvents; ++nextEvent) {
+    Event event{};
+    if (source.getEvent(nextEvent, event) != kResultTrue) {
+      continue;
+    }
+    if (event.sampleOffset >= end && !isLastSubBlock) {
+      break;
+    }
+    event.sampleOffset = std::max(event.sampleOffset - start, int32(0));
+    bool const addOk = events.addEvent(event) == kResultTrue;
+    assert(addOk);
+  }
+}
+
+void BlockAdapter::enqueueEvents(IEventList& source, int64 blockPosition)
+{
+  int32 const numEvents = source.getEventCount();
+  for (int32 i = 0; i < numEvents; ++i) {
+    Event event{};
+    if (source.getEvent(i, event) != kResultTrue || !canBeDelayed(event)) {
+      continue;
+    }
+    assert(numPendingEvents < static_cast<int32>(pendingEvents.size()));
+    if (numPendingEvents == static_cast<int32>(pendingEvents.size())) {
+      return;
+    }
+    pendingEvents[numPendingEvents++] = { event, blockPosition + event.sampleOffset };
+  }
+}
+
+void BlockAdapter::prepareFixedBlockEvents(int64 blockStart)
+{
+  events.clear();
+  auto const blockEnd = blockStart + static_cast<int64>(blockSize);
+  for (int32 i = 0; i < numPendingEvents; ++i) {
+    auto& pendingEvent = pendingEvents[i];
+    if (pendingEvent.position >= blockEnd) {
+      continue;
+    }
+    auto event = pendingEvent.event;
+    event.sampleOffset = static_cast<int32>(std::max(pendingEvent.position - blockStart, int64(0)));
+    bool const addOk = events.addEvent(event) == kResultTrue;
+    assert(addOk);
+  }
+  auto const firstPending = pendingEvents.begin();
+  auto const lastPending = std::remove_if(
+    firstPending, firstPending + numPendingEvents, [&](auto const& event) { return event.position < blockEnd; });
+  numPendingEvents = static_cast<int32>(lastPending - firstPending);
+}
+
+void BlockAdapter::prepareSubBlockChanges(IParameterChanges& source,
+                                          int32 start,
+                                          int32 end,
+                                          bool includeEnd,
+                                          unplug::ParameterStorage const& parameters)
+{
+  changes.clear();
+  int32 const numSourceQueues = source.getParameterCount();
+  for (int32 sourceIndex = 0; sourceIndex < numSourceQueues; ++sourceIndex) {
+    auto sourceQueue = source.getParameterData(sourceIndex);
+    if (!sourceQueue) {
+      continue;
+    }
+    auto const id = sourceQueue->getParameterId();
+    auto queue = changes.addQueue(id);
+    assert(queue);
+    if (!queue) {
+      return;
+    }
+    // the storage holds the value at the end of the previous sub-block
+    bool const interpolated = canBeInterpolated(id, parameters);
+    int32 previousOffset = start;
+    ParamValue previousValue = interpolated ? parameters.getNormalized(id) : 0.0;
+    int32 const numPoints = sourceQueue->getPointCount();
+    int32 index = 0;
+    for (int32 point = 0; point < numPoints; ++point) {
+      int32 offset = 0;
+      ParamValue value = 0.0;
+      if (sourceQueue->getPoint(point, offset, value) != kResultTrue || offset < start) {
+        continue;
+      }
+      if (offset < end || (includeEnd && offset == end)) {
+        queue->addPoint(offset - start, value, index);
+        previousOffset = offset;
+        previousValue = value;
+        continue;
+      }
+      if (interpolated) {
+        queue->addPoint(end - start, interpolate(end, previousOffset, previousValue, offset, value), index);
+      }
+      break;
+    }
+    changes.removeLastQueueIfEmpty();
+  }
+}
+
+void BlockAdapter::enqueueChanges(IParameterChanges& source, int64 blockPosition)
+{
+  int32 const numSourceQueues = source.getParameterCount();
+  for (int32 sourceIndex = 0; sourceIndex < numSourceQueues; ++sourceIndex) {
+    auto sourceQueue = source.getParameterData(sourceIndex);
+    if (!sourceQueue) {
+      continue;
+    }
+    auto const id = sourceQueue->getParameterId();
+    int32 const numPoints = sourceQueue->getPointCount();
+    for (int32 point = 0; point < numPoints; ++point) {
+      int32 offset = 0;
+      ParamValue value = 0.0;
+      if (sourceQueue->getPoint(point, offset, value) != kResultTrue) {
+        continue;
+      }
+      assert(numPendingPoints < static_cast<int32>(pendingPoints.size()));
+      if (numPendingPoints == static_cast<int32>(pendingPoints.size())) {
+        return;
+      }
+      pendingPoints[numPendingPoints++] = { id, blockPosition + offset, value, numReceivedPoints++ };
+    }
+  }
+  // the points already pending are sorted and come before the new ones, but sorting them all is simpler and does not
+  // allocate
+  std::sort(pendingPoints.begin(), pendingPoints.begin() + numPendingPoints, [](auto const& a, auto const& b) {
+    if (a.id != b.id) {
+      return a.id < b.id;
+    }
+    return a.position != b.position ? a.position < b.position : a.order < b.order;
+  });
+}
+
+void BlockAdapter::prepareFixedBlockChanges(int64 blockStart, unplug::ParameterStorage const& parameters)
+{
+  changes.clear();
+  auto const blockEnd = blockStart + static_cast<int64>(blockSize);
+  int32 nextParameterPoint = 0;
+  for (int32 firstPoint = 0; firstPoint < numPendingPoints; firstPoint = nextParameterPoint) {
+    // the pending points are sorted by parameter
+    auto const id = pendingPoints[firstPoint].id;
+    nextParameterPoint = firstPoint + 1;
+    while (nextParameterPoint < numPendingPoints && pendingPoints[nextParameterPoint].id == id) {
+      ++nextParameterPoint;
+    }
+    auto queue = changes.addQueue(id);
+    assert(queue);
+    if (!queue) {
+      break;
+    }
+    // the storage holds the value at the end of the previous block
+    bool const interpolated = canBeInterpolated(id, parameters);
+    int64 previousPosition = blockStart;
+    ParamValue previousValue = interpolated ? parameters.getNormalized(id) : 0.0;
+    int32 index = 0;
+    for (int32 j = firstPoint; j < nextParameterPoint; ++j) {
+      auto const& point = pendingPoints[j];
+      if (point.position < blockEnd) {
+        auto const offset = static_cast<int32>(std::max(point.position - blockStart, int64(0)));
+        queue->addPoint(offset, point.value, index);
+        previousPosition = std::max(point.position, blockStart);
+        previousValue = point.value;
+        continue;
+      }
+      if (interpolated) {
+        auto const value = interpolate(blockEnd, previousPosition, previousValue, point.position, point.value);
+        queue->addPoint(static_cast<int32>(blockSize), value, index);
+      }
+      break;
+    }
+    changes.removeLastQueueIfEmpty();
+  }
+  // remove the points consumed by this block
+  auto const firstPending = pendingPoints.begin();
+  auto const lastPending = std::remove_if(
+    firstPending, firstPending + numPendingPoints, [&](auto const& point) { return point.position < blockEnd; });
+  numPendingPoints = static_cast<int32>(lastPending - firstPending);
+}
+
+} // namespace Steinberg::Vst
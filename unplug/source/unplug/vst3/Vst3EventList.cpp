@@ -0,0 +1,51 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/detail/Vst3EventList.hpp"
+
+namespace Steinberg::Vst {
+
+void PreallocatedEventList::setCapacity(int32 maxNumEvents)
+{
+  events.resize(maxNumEvents);
+  clear();
+}
+
+tresult PreallocatedEventList::getEvent(int32 index, Event& e)
+{
+  if (index < 0 || index >= numEvents) {
+    return kResultFalse;
+  }
+  e = events[index];
+  return kResultTrue;
+}
+
+tresult PreallocatedEventList::addEvent(Event& e)
+{
+  if (numEvents == static_cast<int32>(events.size())) {
+    return kResultFalse;
+  }
+  events[numEvents++] = e;
+  return kResultTrue;
+}
+
+tresult PreallocatedEventList::queryInterface(const TUID iid, void** obj)
+{
+  QUERY_INTERFACE(iid, obj, FUnknown::iid, IEventList)
+  QUERY_INTERFACE(iid, obj, IEventList::iid, IEventList)
+  *obj = nullptr;
+  return kNoInterface;
+}
+
+} // namespace Steinberg::Vst
@@ -14,7 +14,6 @@
 #include "unplug/detail/Vst3ParameterAccess.hpp"
 #include "unplug/UnplugController.hpp"
 #include <cassert>
-#include <utility>
 
 namespace unplug::vst3 {
 
@@ -30,6 +29,7 @@ ParameterAccess::ParameterAccess(UnplugController& controller, MidiMapping& midi
   , midiMapping(midiMapping)
 {
   controller.addRef();
+  batchedEditsOrder.reserve(batchedEdits.size());
 }
 
 ParameterAccess::~ParameterAccess()
@@ -44,6 +44,9 @@ double ParameterAccess::normalizeValue(ParamIndex index, double value)
 
 double ParameterAccess::getValueNormalized(ParamIndex index)
 {
+  if (batchDepth > 0 && index < batchedEdits.size() && batchedEdits[index].isPending) {
+    return batchedEdits[index].valueNormalized;
+  }
   return controller.getParamNormalized(index);
 }
 
@@ -145,6 +148,21 @@ bool ParameterAccess::setValueNormalized(ParamIndex index, double value)
     assert(false);
     return false;
   }
+  if (batchDepth > 0 && index < batchedEdits.size()) {
+    auto& batchedEdit = batchedEdits[index];
+    batchedEdit.valueNormalized = value;
+    batchedEdit.isPending = true;
+    if (!batchedEdit.isListed) {
+      batchedEdit.isListed = true;
+      batchedEditsOrder.push_back(index);
+    }
+    return true;
+  }
+  return applyValueNormalized(index, value);
+}
+
+bool ParameterAccess::applyValueNormalized(ParamIndex index, double value)
+{
   bool const setOk = controller.setParamNormalized(index, value) == kResultTrue;
   if (setOk) {
     return controller.performEdit(index, value) == kResultTrue;
@@ -154,7 +172,41 @@ bool ParameterAccess::setValueNormalized(ParamIndex index, double value)
   }
 }
 
-bool ParameterAccess::beginEdit(ParamIndex index, std::string control)
+void ParameterAccess::beginBatchEdit()
+{
+  ++batchDepth;
+}
+
+void ParameterAccess::endBatchEdit()
+{
+  assert(batchDepth > 0);
+  if (batchDepth == 0 || --batchDepth > 0) {
+    return;
+  }
+  for (auto index : batchedEditsOrder) {
+    if (batchedEdits[index].isPending) {
+      bool const flushOk = flushBatchedEdit(index);
+      assert(flushOk);
+    }
+    batchedEdits[index].isListed = false;
+  }
+  batchedEditsOrder.clear();
+}
+
+bool ParameterAccess::flushBatchedEdit(ParamIndex index)
+{
+  auto& batchedEdit = batchedEdits[index];
+  batchedEdit.isPending = false;
+  // endEdit flushes the pending value before closing the gesture, so a pending value always has one open
+  bool const isBeingEdited = editRegister.isParameterBeingEdited(index);
+  if (!isBeingEdited) {
+    assert(false);
+    return false;
+  }
+  return applyValueNormalized(index, batchedEdit.valueNormalized);
+}
+
+bool ParameterAccess::beginEdit(ParamIndex index, ControlId control)
 {
   bool const isBeingEdited = editRegister.isParameterBeingEdited(index);
   if (isBeingEdited) {
@@ -162,8 +214,8 @@ bool ParameterAccess::beginEdit(ParamIndex index, std::string control)
     return false;
   }
   if (controller.beginEdit(index) == kResultTrue) {
-    auto const value = getValue(index);
-    editRegister.registerEdit(index, std::move(control));
+    bool const registerOk = editRegister.registerEdit(index, control);
+    assert(registerOk);
     return true;
   }
   else {
@@ -178,15 +230,28 @@ bool ParameterAccess::endEdit(ParamIndex index)
     assert(false);
     return false;
   }
+  // the host has to receive the last value before the end of the edit gesture
+  if (index < batchedEdits.size() && batchedEdits[index].isPending) {
+    flushBatchedEdit(index);
+  }
   editRegister.unregisterEdit(index);
   return controller.endEdit(index) == kResultTrue;
 }
 
+// same conversion as ToUtf8, but reusing the memory already owned by the result
+static void assignString128(std::string& result, String128 const text)
+{
+  result.clear();
+  for (auto character = text; *character != 0; ++character) {
+    result.push_back(static_cast<char>(*character));
+  }
+}
+
 bool ParameterAccess::convertToText(ParamIndex index, double valueNormalized, std::string& result)
 {
   String128 text;
   if (controller.getParamStringByValue(index, valueNormalized, text) == kResultTrue) {
-    result = ToUtf8{}(text);
+    assignString128(result, text);
     return true;
   }
   else {
@@ -202,10 +267,40 @@ std::string ParameterAccess::convertToText(ParamIndex index, double valueNormali
   return text;
 }
 
-std::string ParameterAccess::getValueAsText(ParamIndex index)
+std::string const& ParameterAccess::getValueAsText(ParamIndex index)
 {
   auto const valueNormalized = getValueNormalized(index);
-  return convertToText(index, valueNormalized);
+  if (index < valueTextCache.size()) {
+    auto& cache = valueTextCache[index];
+    if (cache.valueNormalized != valueNormalized) {
+      bool const ok = convertToText(index, valueNormalized, cache.text);
+      assert(ok);
+      cache.valueNormalized = valueNormalized;
+    }
+    return cache.text;
+  }
+  bool const ok = convertToText(index, valueNormalized, uncachedValueText);
+  assert(ok);
+  return uncachedValueText;
+}
+
+std::string const& ParameterAccess::getNameAndValueAsText(ParamIndex index)
+{
+  auto const valueNormalized = getValueNormalized(index);
+  if (index < valueTextCache.size()) {
+    auto& cache = valueTextCache[index];
+    if (cache.nameAndValueNormalized != valueNormalized) {
+      cache.nameAndText = getName(index);
+      cache.nameAndText += ": ";
+      cache.nameAndText += getValueAsText(index);
+      cache.nameAndValueNormalized = valueNormalized;
+    }
+    return cache.nameAndText;
+  }
+  auto text = getName(index) + ": ";
+  text += getValueAsText(index);
+  uncachedValueText = std::move(text);
+  return uncachedValueText;
 }
 
 bool ParameterAccess::convertFromText(ParamIndex index, double& value, const std::string& text)
@@ -240,12 +335,20 @@ bool ParameterAccess::getName(ParamIndex index, std::string& result)
   }
 }
 
-std::string ParameterAccess::getName(ParamIndex index)
+std::string const& ParameterAccess::getName(ParamIndex index)
 {
-  std::string text;
-  bool const ok = getName(index, text);
+  if (index < valueTextCache.size()) {
+    auto& cache = valueTextCache[index];
+    if (!cache.isNameCached) {
+      bool const ok = getName(index, cache.name);
+      assert(ok);
+      cache.isNameCached = ok;
+    }
+    return cache.name;
+  }
+  bool const ok = getName(index, uncachedName);
   assert(ok);
-  return text;
+  return uncachedName;
 }
 
 bool ParameterAccess::getMeasureUnit(ParamIndex index, std::string& result)
@@ -260,12 +363,20 @@ bool ParameterAccess::getMeasureUnit(ParamIndex index, std::string& result)
   }
 }
 
-std::string ParameterAccess::getMeasureUnit(ParamIndex index)
+std::string const& ParameterAccess::getMeasureUnit(ParamIndex index)
 {
-  std::string text;
-  bool const ok = getMeasureUnit(index, text);
+  if (index < valueTextCache.size()) {
+    auto& cache = valueTextCache[index];
+    if (!cache.isMeasureUnitCached) {
+      bool const ok = getMeasureUnit(index, cache.measureUnit);
+      assert(ok);
+      cache.isMeasureUnitCached = ok;
+    }
+    return cache.measureUnit;
+  }
+  bool const ok = getMeasureUnit(index, uncachedMeasureUnit);
   assert(ok);
-  return text;
+  return uncachedMeasureUnit;
 }
 
 bool ParameterAccess::getNumSteps(ParamIndex index, int& result)
@@ -373,7 +484,7 @@ bool ParameterAccess::isBeingEdited(ParamIndex index) const
   return editRegister.isParameterBeingEdited(index);
 }
 
-std::string ParameterAccess::getEditingControl(ParamIndex index) const
+ControlId ParameterAccess::getEditingControl(ParamIndex index) const
 {
   return editRegister.getControllerEditingParameter(index);
 }
@@ -381,21 +492,34 @@ std::string ParameterAccess::getEditingControl(ParamIndex index) const
 void ParameterAccess::setMidiMapping(ParamIndex index, int midiControl, int channel)
 {
   midiMapping.mapParameter(index, midiControl, channel);
-  auto handler = controller.getComponentHandler();
-  assert(handler);
-  if (handler) {
-    handler->restartComponent(Steinberg::Vst::kMidiCCAssignmentChanged);
-  }
+  controller.onMidiMappingChanged();
 }
 
 void ParameterAccess::setMidiMapping(ParamIndex index, int midiControl)
 {
   midiMapping.mapParameter(index, midiControl);
-  auto handler = controller.getComponentHandler();
-  assert(handler);
-  if (handler) {
-    handler->restartComponent(Steinberg::Vst::kMidiCCAssignmentChanged);
-  }
+  controller.onMidiMappingChanged();
+}
+
+void ParameterAccess::removeMidiMapping(ParamIndex index)
+{
+  midiMapping.unmapParameter(index);
+  controller.onMidiMappingChanged();
+}
+
+void ParameterAccess::startMidiLearn(ParamIndex index, bool listensToAllChannels)
+{
+  controller.startMidiLearn(static_cast<Steinberg::Vst::ParamID>(index), listensToAllChannels);
+}
+
+void ParameterAccess::stopMidiLearn()
+{
+  controller.stopMidiLearn();
+}
+
+bool ParameterAccess::isMidiLearning(ParamIndex index) const
+{
+  return controller.getMidiLearnParameter() == index;
 }
 
 bool ParameterAccess::findParameterFromUserInterfaceCoordinates(int xPos, int yPos, ParamIndex& index)
@@ -418,6 +542,11 @@ void ParameterAccess::setDirty()
   controller.setDirty(true);
 }
 
+uint32_t ParameterAccess::getNumChanges() const
+{
+  return controller.getNumParameterChanges();
+}
+
 namespace {
 thread_local ParameterAccess* currentParameterAccess = nullptr;
 }
@@ -0,0 +1,133 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2021 Dario Mambro.
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+//------------------------------------------------------------------------
+
+
+#include "unplug/detail/Vst3ParameterChanges.hpp"
+#include <cassert>
+
+namespace Steinberg::Vst {
+
+tresult PreallocatedParameterChanges::Queue::getPoint(int32 index, int32& sampleOffset, ParamValue& value)
+{
+  if (index < 0 || index >= numPoints) {
+    return kResultFalse;
+  }
+  auto const& point = owner->points[firstPoint + index];
+  sampleOffset = point.sampleOffset;
+  value = point.value;
+  return kResultTrue;
+}
+
+tresult PreallocatedParameterChanges::Queue::addPoint(int32 sampleOffset, ParamValue value, int32& index)
+{
+  bool const isLastQueue = owner->numQueues > 0 && &owner->queues[owner->numQueues - 1] == this;
+  assert(isLastQueue);
+  if (!isLastQueue) {
+    return kResultFalse;
+  }
+  if (numPoints > 0) {
+    auto& lastPoint = owner->points[firstPoint + numPoints - 1];
+    if (lastPoint.sampleOffset == sampleOffset) {
+      lastPoint.value = value;
+      index = numPoints - 1;
+      return kResultTrue;
+    }
+  }
+  if (owner->numPoints == static_cast<int32>(owner->points.size())) {
+    if (numPoints == 0) {
+      return kResultFalse;
+    }
+    owner->points[firstPoint + numPoints - 1] = { sampleOffset, value };
+    index = numPoints - 1;
+    return kResultFalse;
+  }
+  owner->points[owner->numPoints++] = { sampleOffset, value };
+  index = numPoints++;
+  return kResultTrue;
+}
+
+tresult PreallocatedParameterChanges::Queue::queryInterface(const TUID iid, void** obj)
+{
+  QUERY_INTERFACE(iid, obj, FUnknown::iid, IParamValueQueue)
+  QUERY_INTERFACE(iid, obj, IParamValueQueue::iid, IParamValueQueue)
+  *obj = nullptr;
+  return kNoInterface;
+}
+
+void PreallocatedParameterChanges::setCapacity(int32 maxNumQueues, int32 maxNumPoints)
+{
+  queues.resize(maxNumQueues);
+  for (auto& queue : queues) {
+    queue.owner = this;
+  }
+  points.resize(maxNumPoints);
+  clear();
+}
+
+void PreallocatedParameterChanges::clear()
+{
+  numQueues = 0;
+  numPoints = 0;
+}
+
+PreallocatedParameterChanges::Queue* PreallocatedParameterChanges::addQueue(ParamID id)
+{
+  if (numQueues == static_cast<int32>(queues.size())) {
+    return nullptr;
+  }
+  auto& queue = queues[numQueues++];
+  queue.id = id;
+  queue.firstPoint = numPoints;
+  queue.numPoints = 0;
+  return &queue;
+}
+
+void PreallocatedParameterChanges::removeLastQueueIfEmpty()
+{
+  if (numQueues > 0 && queues[numQueues - 1].numPoints == 0) {
+    --numQueues;
+  }
+}
+
+IParamValueQueue* PreallocatedParameterChanges::getParameterData(int32 index)
+{
+  if (index < 0 || index >= numQueues) {
+    return nullptr;
+  }
+  return &queues[index];
+}
+
+IParamValueQueue* PreallocatedParameterChanges::addParameterData(const ParamID& id, int32& index)
+{
+  for (int32 i = 0; i < numQueues; ++i) {
+    if (queues[i].id == id) {
+      index = i;
+      return &queues[i];
+    }
+  }
+  auto queue = addQueue(id);
+  if (queue) {
+    index = numQueues - 1;
+  }
+  return queue;
+}
+
+tresult PreallocatedParameterChanges::queryInterface(const TUID iid, void** obj)
+{
+  QUERY_INTERFACE(iid, obj, FUnknown::iid, IParameterChanges)
+  QUERY_INTERFACE(iid, obj, IParameterChanges::iid, IParameterChanges)
+  *obj = nullptr;
+  return kNoInterface;
+}
+
+} // namespace Steinberg::Vst